@@ -3,11 +3,72 @@ target_sources(ndn-lite PUBLIC
   ${DIR_ADAPTATION}/udp/udp-face.h
   ${DIR_ADAPTATION}/unix-socket/unix-face.h
   ${DIR_ADAPTATION}/security/ndn-lite-rng-posix-crypto-impl.h
+  ${DIR_ADAPTATION}/security/verify-cache.h
+  ${DIR_ADAPTATION}/security/crypto-pool.h
+  ${DIR_ADAPTATION}/security/aes-kernels.h
+  ${DIR_ADAPTATION}/security/sha256-kernels.h
+  ${DIR_ADAPTATION}/security/manifest.h
+  ${DIR_ADAPTATION}/security/key-store.h
+  ${DIR_ADAPTATION}/security/compiled-schema.h
+  ${DIR_ADAPTATION}/forwarder/pkt-peek.h
+  ${DIR_ADAPTATION}/forwarder/cs-mmap.h
+  ${DIR_ADAPTATION}/forwarder/dead-nonce-list.h
+  ${DIR_ADAPTATION}/forwarder/ingress.h
+  ${DIR_ADAPTATION}/forwarder/pktbuf.h
+  ${DIR_ADAPTATION}/forwarder/face-slab.h
+  ${DIR_ADAPTATION}/forwarder/strategy-face.h
+  ${DIR_ADAPTATION}/forwarder/status.h
+  ${DIR_ADAPTATION}/forwarder/submit-queue.h
+  ${DIR_ADAPTATION}/forwarder/traffic-class.h
+  ${DIR_ADAPTATION}/forwarder/nack.h
+  ${DIR_ADAPTATION}/forwarder/pkt-view.h
+  ${DIR_ADAPTATION}/forwarder/compact-name.h
+  ${DIR_ADAPTATION}/forwarder/data-template.h
+  ${DIR_ADAPTATION}/forwarder/name-kernels.h
 )
 target_sources(ndn-lite PRIVATE
   ${DIR_ADAPTATION}/uniform-time.c
   ${DIR_ADAPTATION}/udp/udp-face.c
   ${DIR_ADAPTATION}/unix-socket/unix-face.c
   ${DIR_ADAPTATION}/security/ndn-lite-rng-posix-crypto-impl.c
+  ${DIR_ADAPTATION}/security/verify-cache.c
+  ${DIR_ADAPTATION}/security/crypto-pool.c
+  ${DIR_ADAPTATION}/security/aes-kernels.c
+  ${DIR_ADAPTATION}/security/sha256-kernels.c
+  ${DIR_ADAPTATION}/security/manifest.c
+  ${DIR_ADAPTATION}/security/key-store.c
+  ${DIR_ADAPTATION}/security/compiled-schema.c
+  ${DIR_ADAPTATION}/forwarder/pkt-peek.c
+  ${DIR_ADAPTATION}/forwarder/cs-mmap.c
+  ${DIR_ADAPTATION}/forwarder/dead-nonce-list.c
+  ${DIR_ADAPTATION}/forwarder/ingress.c
+  ${DIR_ADAPTATION}/forwarder/pktbuf.c
+  ${DIR_ADAPTATION}/forwarder/face-slab.c
+  ${DIR_ADAPTATION}/forwarder/strategy-face.c
+  ${DIR_ADAPTATION}/forwarder/status.c
+  ${DIR_ADAPTATION}/forwarder/submit-queue.c
+  ${DIR_ADAPTATION}/forwarder/traffic-class.c
+  ${DIR_ADAPTATION}/forwarder/nack.c
+  ${DIR_ADAPTATION}/forwarder/pkt-view.c
+  ${DIR_ADAPTATION}/forwarder/compact-name.c
+  ${DIR_ADAPTATION}/forwarder/data-template.c
+  ${DIR_ADAPTATION}/forwarder/name-kernels.c
   ${DIR_ADAPTATION}/ndn-lite.c
 )
+
+# Crypto worker pool
+find_package(Threads REQUIRED)
+target_link_libraries(ndn-lite Threads::Threads)
+
+# OpenSSL security backend
+if(OPENSSL_BACKEND)
+  find_package(OpenSSL REQUIRED)
+  target_sources(ndn-lite PUBLIC
+    ${DIR_ADAPTATION}/security/ndn-lite-openssl-crypto-impl.h
+  )
+  target_sources(ndn-lite PRIVATE
+    ${DIR_ADAPTATION}/security/ndn-lite-openssl-crypto-impl.c
+  )
+  target_compile_definitions(ndn-lite PRIVATE NDN_LITE_OPENSSL_BACKEND)
+  target_link_libraries(ndn-lite OpenSSL::Crypto)
+endif()
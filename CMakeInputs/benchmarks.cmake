@@ -0,0 +1,27 @@
+set(DIR_BENCHMARKS "${PROJECT_SOURCE_DIR}/benchmarks")
+set(DIR_BENCHMARKS_OUTPUT "${PROJECT_BINARY_DIR}/benchmarks")
+
+# Single-file benchmarks
+set(LIST_BENCHMARKS
+  "codec-bench"
+  "name-bench"
+  "sha256-bench"
+  "aes-bench"
+  "compiled-schema-bench"
+  "status-bench"
+  "crypto-pool-bench"
+)
+foreach(BENCH_NAME IN LISTS LIST_BENCHMARKS)
+  add_executable(${BENCH_NAME} "${DIR_BENCHMARKS}/${BENCH_NAME}.c")
+  target_link_libraries(${BENCH_NAME} ndn-lite)
+  set_target_properties(${BENCH_NAME} PROPERTIES RUNTIME_OUTPUT_DIRECTORY ${DIR_BENCHMARKS_OUTPUT})
+endforeach()
+unset(LIST_BENCHMARKS)
+
+# sha256-bench checks the OpenSSL backend against the default one
+if(OPENSSL_BACKEND)
+  target_compile_definitions(sha256-bench PRIVATE NDN_LITE_OPENSSL_BACKEND)
+endif()
+
+unset(DIR_BENCHMARKS_OUTPUT)
+unset(DIR_BENCHMARKS)
@@ -10,6 +10,10 @@
 
 #define NDN_UDP_FACE_SOCKET_ERROR 1
 #define NDN_UNIX_FACE_SOCKET_ERROR 2
+#define NDN_CS_MMAP_FILE_ERROR 3
+#define NDN_CS_MMAP_OVERSIZE 4
+#define NDN_CS_MMAP_NOT_FOUND 5
+#define NDN_NAME_URI_ERROR 6
 
 #define NDN_NFD_DEFAULT_ADDR "/var/run/nfd.sock"
 
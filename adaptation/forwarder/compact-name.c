@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "compact-name.h"
+#include "pkt-peek.h"
+#include "ndn-lite/ndn-enums.h"
+#include "ndn-lite/ndn-error-code.h"
+
+// The component index follows the TLV, aligned for uint16_t
+#define COMPACT_NAME_INDEX_OFFSET(size) (((size) + 1u) & ~1u)
+#define COMPACT_NAME_FOOTPRINT(name) \
+  (COMPACT_NAME_INDEX_OFFSET((name)->size) + (name)->components_size * sizeof(uint16_t))
+
+static int
+ndn_name_arena_reserve(ndn_name_arena_t* self, uint32_t size);
+
+static inline const uint16_t*
+compact_name_index(const ndn_name_arena_t* arena, const ndn_compact_name_t* name);
+
+static int
+compact_name_commit(ndn_name_arena_t* arena, ndn_compact_name_t* name, uint32_t size);
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+static inline const uint16_t*
+compact_name_index(const ndn_name_arena_t* arena, const ndn_compact_name_t* name){
+  return (const uint16_t*)(arena->buf + name->offset + COMPACT_NAME_INDEX_OFFSET(name->size));
+}
+
+void
+ndn_name_arena_init(ndn_name_arena_t* self){
+  self->buf = NULL;
+  self->capacity = 0;
+  self->used = 0;
+  self->wasted = 0;
+}
+
+void
+ndn_name_arena_destroy(ndn_name_arena_t* self){
+  free(self->buf);
+  ndn_name_arena_init(self);
+}
+
+static int
+ndn_name_arena_reserve(ndn_name_arena_t* self, uint32_t size){
+  uint32_t capacity;
+  uint8_t* buf;
+
+  if(self->used + size <= self->capacity){
+    return NDN_SUCCESS;
+  }
+  capacity = self->capacity > 0 ? self->capacity : NDN_NAME_ARENA_MIN_CAPACITY;
+  while(capacity < self->used + size){
+    capacity *= 2;
+  }
+  buf = (uint8_t*)realloc(self->buf, capacity);
+  if(buf == NULL){
+    return NDN_FWD_NO_MEM;
+  }
+  self->buf = buf;
+  self->capacity = capacity;
+  return NDN_SUCCESS;
+}
+
+int
+ndn_name_arena_compact(ndn_name_arena_t* self, ndn_compact_name_t* names[], int count){
+  uint8_t* buf;
+  uint32_t used = 0, footprint;
+  int i;
+
+  if(self->wasted == 0){
+    return NDN_SUCCESS;
+  }
+  buf = (uint8_t*)malloc(self->capacity);
+  if(buf == NULL){
+    return NDN_FWD_NO_MEM;
+  }
+  for(i = 0; i < count; i ++){
+    footprint = COMPACT_NAME_FOOTPRINT(names[i]);
+    memcpy(buf + used, self->buf + names[i]->offset, footprint);
+    names[i]->offset = used;
+    used += footprint;
+  }
+  free(self->buf);
+  self->buf = buf;
+  self->used = used;
+  self->wasted = 0;
+  return NDN_SUCCESS;
+}
+
+/**
+ * Index the Name TLV written at the end of the arena and keep it.
+ */
+static int
+compact_name_commit(ndn_name_arena_t* arena, ndn_compact_name_t* name, uint32_t size){
+  const uint8_t* wire = arena->buf + arena->used;
+  ndn_name_iter_t iter;
+  ndn_component_view_t comp;
+  uint16_t offsets[NDN_COMPACT_NAME_MAX_COMPONENTS];
+  uint32_t count = 0;
+  int ret;
+
+  ret = ndn_name_iter_init(&iter, wire, size);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  while(iter.pos < iter.end){
+    if(count >= NDN_COMPACT_NAME_MAX_COMPONENTS){
+      return NDN_OVERSIZE;
+    }
+    offsets[count] = (uint16_t)(iter.pos - wire);
+    if(!ndn_name_iter_next(&iter, &comp)){
+      return NDN_WRONG_TLV_LENGTH;
+    }
+    count ++;
+  }
+
+  name->size = (uint16_t)size;
+  name->components_size = (uint8_t)count;
+  // The arena may move: only offsets are kept past this point
+  ret = ndn_name_arena_reserve(arena, COMPACT_NAME_FOOTPRINT(name));
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  name->offset = arena->used;
+  memcpy(arena->buf + name->offset + COMPACT_NAME_INDEX_OFFSET(size), offsets, count * sizeof(uint16_t));
+  arena->used += COMPACT_NAME_FOOTPRINT(name);
+  return NDN_SUCCESS;
+}
+
+int
+ndn_compact_name_from_wire(ndn_name_arena_t* arena, ndn_compact_name_t* name,
+                           const uint8_t* wire, uint32_t size){
+  int ret;
+
+  if(size > NDN_COMPACT_NAME_MAX_SIZE){
+    return NDN_OVERSIZE;
+  }
+  ret = ndn_name_arena_reserve(arena, size);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  memcpy(arena->buf + arena->used, wire, size);
+  return compact_name_commit(arena, name, size);
+}
+
+int
+ndn_compact_name_from_name(ndn_name_arena_t* arena, ndn_compact_name_t* name, const ndn_name_t* src){
+  ndn_encoder_t encoder;
+  uint32_t size;
+  int ret;
+
+  // Encode straight into the arena rather than through a worst-case buffer
+  size = ndn_name_probe_block_size(src);
+  if(size > NDN_COMPACT_NAME_MAX_SIZE){
+    return NDN_OVERSIZE;
+  }
+  ret = ndn_name_arena_reserve(arena, size);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  encoder_init(&encoder, arena->buf + arena->used, size);
+  ret = ndn_name_tlv_encode(&encoder, src);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  return compact_name_commit(arena, name, encoder.offset);
+}
+
+int
+ndn_compact_name_to_name(const ndn_name_arena_t* arena, const ndn_compact_name_t* name, ndn_name_t* dst){
+  return ndn_name_from_block(dst, ndn_compact_name_wire(arena, name), name->size);
+}
+
+void
+ndn_compact_name_free(ndn_name_arena_t* arena, ndn_compact_name_t* name){
+  uint32_t footprint = COMPACT_NAME_FOOTPRINT(name);
+
+  if(name->offset + footprint == arena->used){
+    arena->used -= footprint;
+  }else{
+    arena->wasted += footprint;
+  }
+  name->size = 0;
+  name->components_size = 0;
+}
+
+int
+ndn_compact_name_component(const ndn_name_arena_t* arena, const ndn_compact_name_t* name,
+                           int index, ndn_component_view_t* comp){
+  const uint8_t *wire, *val;
+  uint16_t offset;
+
+  if(index < 0){
+    index += name->components_size;
+  }
+  if(index < 0 || index >= name->components_size){
+    return NDN_OVERSIZE;
+  }
+  wire = ndn_compact_name_wire(arena, name);
+  offset = compact_name_index(arena, name)[index];
+  val = ndn_pkt_read_tl(wire + offset, wire + name->size, &comp->type, &comp->size);
+  if(val == NULL){
+    return NDN_WRONG_TLV_LENGTH;
+  }
+  comp->value = val;
+  return NDN_SUCCESS;
+}
+
+bool
+ndn_compact_name_equals(const ndn_name_arena_t* arena, const ndn_compact_name_t* name,
+                        const uint8_t* wire, uint32_t size){
+  return name->size == size && memcmp(ndn_compact_name_wire(arena, name), wire, size) == 0;
+}
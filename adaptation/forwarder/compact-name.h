@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#ifndef NDN_COMPACT_NAME_H_
+#define NDN_COMPACT_NAME_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ndn-lite/encode/name.h"
+#include "pkt-view.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Smallest buffer allocated by an arena
+#define NDN_NAME_ARENA_MIN_CAPACITY 256
+#define NDN_COMPACT_NAME_MAX_COMPONENTS 255
+// Longest Name TLV, including its type and length
+#define NDN_COMPACT_NAME_MAX_SIZE UINT16_MAX
+
+/**
+ * Storage shared by the names of one table.
+ * Names refer to it by offset, so the buffer may grow or be compacted.
+ */
+typedef struct ndn_name_arena {
+  uint8_t* buf;
+  uint32_t capacity;
+  uint32_t used;
+  /**
+   * Bytes held by freed names that are not at the end of the buffer.
+   */
+  uint32_t wasted;
+} ndn_name_arena_t;
+
+/**
+ * A name stored in an arena: the Name TLV, followed by the offset of every
+ * component in it. Takes as much memory as the name actually needs,
+ * where ndn_name_t always reserves room for the largest name.
+ */
+typedef struct ndn_compact_name {
+  uint32_t offset;
+  uint16_t size;
+  uint8_t components_size;
+} ndn_compact_name_t;
+
+void
+ndn_name_arena_init(ndn_name_arena_t* self);
+
+void
+ndn_name_arena_destroy(ndn_name_arena_t* self);
+
+/**
+ * Move the given live names to the front, dropping the wasted bytes.
+ */
+int
+ndn_name_arena_compact(ndn_name_arena_t* self, ndn_compact_name_t* names[], int count);
+
+/**
+ * Store a Name TLV.
+ */
+int
+ndn_compact_name_from_wire(ndn_name_arena_t* arena, ndn_compact_name_t* name,
+                           const uint8_t* wire, uint32_t size);
+
+int
+ndn_compact_name_from_name(ndn_name_arena_t* arena, ndn_compact_name_t* name, const ndn_name_t* src);
+
+int
+ndn_compact_name_to_name(const ndn_name_arena_t* arena, const ndn_compact_name_t* name, ndn_name_t* dst);
+
+void
+ndn_compact_name_free(ndn_name_arena_t* arena, ndn_compact_name_t* name);
+
+/**
+ * The Name TLV. Invalidated when the arena grows or is compacted.
+ */
+static inline const uint8_t*
+ndn_compact_name_wire(const ndn_name_arena_t* arena, const ndn_compact_name_t* name){
+  return arena->buf + name->offset;
+}
+
+/**
+ * Get a component in constant time.
+ */
+int
+ndn_compact_name_component(const ndn_name_arena_t* arena, const ndn_compact_name_t* name,
+                           int index, ndn_component_view_t* comp);
+
+bool
+ndn_compact_name_equals(const ndn_name_arena_t* arena, const ndn_compact_name_t* name,
+                        const uint8_t* wire, uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
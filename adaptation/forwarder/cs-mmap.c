@@ -0,0 +1,529 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include "cs-mmap.h"
+#include "pkt-peek.h"
+#include "pkt-view.h"
+#include "ingress.h"
+#include "ndn-lite/forwarder/forwarder.h"
+#include "ndn-lite/util/uniform-time.h"
+#include "ndn-lite/ndn-enums.h"
+#include "ndn-lite/ndn-error-code.h"
+
+// "NDNCS003"; version 2 changed the name hash stored in records,
+// version 3 added the arrival time and freshness period
+#define NDN_CS_MMAP_MAGIC 0x333030534E444E4EULL
+#define NDN_CS_MMAP_RECORD_MAGIC 0x41544144U
+#define NDN_CS_MMAP_HEADER_SIZE 64
+#define NDN_CS_MMAP_MIN_INDEX 16
+
+/**
+ * File header. The record area starts at NDN_CS_MMAP_HEADER_SIZE.
+ * Live records are [head, tail) if wrap is 0, otherwise [head, wrap) + [0, tail).
+ */
+typedef struct cs_mmap_header {
+  uint64_t magic;
+  uint64_t capacity;
+  uint64_t head;
+  uint64_t tail;
+  uint64_t wrap;
+  uint64_t seq;
+} cs_mmap_header_t;
+
+/**
+ * Record header, followed by the Data wire and padded to 8 bytes.
+ * The magic is written last so a torn record is never recovered.
+ * The arrival time is wall-clock, so freshness survives a restart.
+ */
+typedef struct cs_mmap_record {
+  uint32_t magic;
+  uint32_t size;
+  uint64_t name_hash;
+  uint64_t seq;
+  uint64_t arrival;
+  uint64_t freshness_period;
+} cs_mmap_record_t;
+
+static inline cs_mmap_header_t*
+cs_mmap_header(ndn_cs_mmap_t* self);
+
+static inline cs_mmap_record_t*
+cs_mmap_record(ndn_cs_mmap_t* self, uint64_t offset);
+
+static inline uint64_t
+cs_mmap_record_size(uint32_t data_size);
+
+static struct ndn_cs_mmap_slot*
+cs_mmap_index_find(ndn_cs_mmap_t* self, uint64_t name_hash);
+
+static void
+cs_mmap_index_insert(ndn_cs_mmap_t* self, uint64_t name_hash, uint64_t offset);
+
+static void
+cs_mmap_index_remove(ndn_cs_mmap_t* self, struct ndn_cs_mmap_slot* slot);
+
+static bool
+cs_mmap_evict_head(ndn_cs_mmap_t* self);
+
+static int
+cs_mmap_reserve(ndn_cs_mmap_t* self, uint64_t total);
+
+static void
+cs_mmap_format(ndn_cs_mmap_t* self, size_t capacity);
+
+static bool
+cs_mmap_recover(ndn_cs_mmap_t* self, size_t capacity);
+
+static bool
+cs_mmap_record_satisfies(ndn_cs_mmap_t* self, uint64_t offset, const ndn_interest_view_t* interest,
+                         ndn_time_ms_t now);
+
+static int
+cs_mmap_on_interest(const uint8_t* interest, uint32_t interest_size, void* userdata);
+
+static void
+cs_mmap_on_ingress(ndn_face_intf_t* face, const uint8_t* packet, uint32_t size,
+                   const ndn_pkt_peek_t* peek, void* userdata);
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+static inline cs_mmap_header_t*
+cs_mmap_header(ndn_cs_mmap_t* self){
+  return (cs_mmap_header_t*)self->map;
+}
+
+static inline cs_mmap_record_t*
+cs_mmap_record(ndn_cs_mmap_t* self, uint64_t offset){
+  return (cs_mmap_record_t*)(self->map + NDN_CS_MMAP_HEADER_SIZE + offset);
+}
+
+static inline uint64_t
+cs_mmap_record_size(uint32_t data_size){
+  return (sizeof(cs_mmap_record_t) + data_size + 7) & ~(uint64_t)7;
+}
+
+static struct ndn_cs_mmap_slot*
+cs_mmap_index_find(ndn_cs_mmap_t* self, uint64_t name_hash){
+  uint32_t i;
+
+  for(i = name_hash & self->index_mask; self->index[i].offset != 0; i = (i + 1) & self->index_mask){
+    if(self->index[i].name_hash == name_hash){
+      return &self->index[i];
+    }
+  }
+  return NULL;
+}
+
+static void
+cs_mmap_index_insert(ndn_cs_mmap_t* self, uint64_t name_hash, uint64_t offset){
+  uint32_t i;
+
+  for(i = name_hash & self->index_mask; self->index[i].offset != 0; i = (i + 1) & self->index_mask){
+    if(self->index[i].name_hash == name_hash){
+      self->index[i].offset = offset + 1;
+      return;
+    }
+  }
+  self->index[i].name_hash = name_hash;
+  self->index[i].offset = offset + 1;
+  self->count ++;
+}
+
+static void
+cs_mmap_index_remove(ndn_cs_mmap_t* self, struct ndn_cs_mmap_slot* slot){
+  uint32_t i = (uint32_t)(slot - self->index);
+  uint32_t j = i, home;
+
+  // Backward shift deletion keeps probe sequences intact without tombstones
+  while(true){
+    j = (j + 1) & self->index_mask;
+    if(self->index[j].offset == 0){
+      break;
+    }
+    home = self->index[j].name_hash & self->index_mask;
+    if((i <= j) ? (i < home && home <= j) : (i < home || home <= j)){
+      continue;
+    }
+    self->index[i] = self->index[j];
+    i = j;
+  }
+  self->index[i].offset = 0;
+  self->count --;
+}
+
+static bool
+cs_mmap_evict_head(ndn_cs_mmap_t* self){
+  cs_mmap_header_t* hdr = cs_mmap_header(self);
+  cs_mmap_record_t* rec;
+  struct ndn_cs_mmap_slot* slot;
+
+  if(hdr->wrap == 0 && hdr->head == hdr->tail){
+    return false;
+  }
+  rec = cs_mmap_record(self, hdr->head);
+  slot = cs_mmap_index_find(self, rec->name_hash);
+  if(slot != NULL && slot->offset == hdr->head + 1){
+    cs_mmap_index_remove(self, slot);
+  }
+  self->evictions ++;
+
+  hdr->head += cs_mmap_record_size(rec->size);
+  if(hdr->wrap != 0 && hdr->head >= hdr->wrap){
+    hdr->head = 0;
+    hdr->wrap = 0;
+  }
+  if(hdr->wrap == 0 && hdr->head == hdr->tail){
+    hdr->head = hdr->tail = 0;
+  }
+  return true;
+}
+
+static int
+cs_mmap_reserve(ndn_cs_mmap_t* self, uint64_t total){
+  cs_mmap_header_t* hdr = cs_mmap_header(self);
+
+  if(total > hdr->capacity){
+    return NDN_CS_MMAP_OVERSIZE;
+  }
+  while(true){
+    if(hdr->wrap == 0){
+      if(hdr->capacity - hdr->tail >= total){
+        return NDN_SUCCESS;
+      }
+      hdr->wrap = hdr->tail;
+      hdr->tail = 0;
+    }else{
+      if(hdr->head - hdr->tail >= total){
+        return NDN_SUCCESS;
+      }
+      cs_mmap_evict_head(self);
+    }
+  }
+}
+
+static void
+cs_mmap_format(ndn_cs_mmap_t* self, size_t capacity){
+  cs_mmap_header_t* hdr = cs_mmap_header(self);
+
+  hdr->magic = 0;
+  hdr->capacity = capacity;
+  hdr->head = hdr->tail = hdr->wrap = 0;
+  hdr->seq = 0;
+  hdr->magic = NDN_CS_MMAP_MAGIC;
+  memset(self->index, 0, sizeof(*self->index) * (self->index_mask + 1));
+  self->count = 0;
+}
+
+static bool
+cs_mmap_recover(ndn_cs_mmap_t* self, size_t capacity){
+  cs_mmap_header_t* hdr = cs_mmap_header(self);
+  cs_mmap_record_t* rec;
+  uint64_t offset, end, limit;
+  bool wrapped = (hdr->wrap != 0);
+
+  if(hdr->magic != NDN_CS_MMAP_MAGIC || hdr->capacity != capacity ||
+     hdr->head > capacity || hdr->tail > capacity || hdr->wrap > capacity){
+    return false;
+  }
+
+  limit = (self->index_mask + 1) / 4 * 3;
+  offset = hdr->head;
+  end = wrapped ? hdr->wrap : hdr->tail;
+  while(true){
+    while(offset < end){
+      rec = cs_mmap_record(self, offset);
+      if(rec->magic != NDN_CS_MMAP_RECORD_MAGIC || offset + cs_mmap_record_size(rec->size) > end){
+        return false;
+      }
+      // Keep the newest records: evict from the head as the index fills up
+      while(self->count >= limit && hdr->head != offset){
+        cs_mmap_evict_head(self);
+      }
+      cs_mmap_index_insert(self, rec->name_hash, offset);
+      offset += cs_mmap_record_size(rec->size);
+    }
+    if(!wrapped){
+      break;
+    }
+    wrapped = false;
+    offset = 0;
+    end = hdr->tail;
+  }
+  self->evictions = 0;
+  return true;
+}
+
+ndn_cs_mmap_t*
+ndn_cs_mmap_open(const char* path, size_t capacity, uint32_t index_size){
+  ndn_cs_mmap_t* ret;
+  struct stat st;
+  uint32_t slots = NDN_CS_MMAP_MIN_INDEX;
+
+  ret = (ndn_cs_mmap_t*)malloc(sizeof(ndn_cs_mmap_t));
+  if(!ret){
+    return NULL;
+  }
+  memset(ret, 0, sizeof(ndn_cs_mmap_t));
+
+  // Keep the load factor under 3/4
+  capacity = (capacity + 7) & ~(size_t)7;
+  while(slots / 4 * 3 < index_size){
+    slots <<= 1;
+  }
+  ret->index_mask = slots - 1;
+  ret->index = calloc(slots, sizeof(*ret->index));
+  if(!ret->index){
+    free(ret);
+    return NULL;
+  }
+
+  ret->map_size = NDN_CS_MMAP_HEADER_SIZE + capacity;
+  ret->fd = open(path, O_RDWR | O_CREAT, 0644);
+  if(ret->fd == -1){
+    goto fail;
+  }
+  if(fstat(ret->fd, &st) == -1){
+    goto fail;
+  }
+  if((size_t)st.st_size != ret->map_size && ftruncate(ret->fd, ret->map_size) == -1){
+    goto fail;
+  }
+  ret->map = mmap(NULL, ret->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, ret->fd, 0);
+  if(ret->map == MAP_FAILED){
+    ret->map = NULL;
+    goto fail;
+  }
+
+  if(!cs_mmap_recover(ret, capacity)){
+    cs_mmap_format(ret, capacity);
+  }
+  return ret;
+
+fail:
+  if(ret->fd != -1){
+    close(ret->fd);
+  }
+  free(ret->index);
+  free(ret);
+  return NULL;
+}
+
+void
+ndn_cs_mmap_close(ndn_cs_mmap_t* self){
+  if(self->prefix_size > 0){
+    ndn_ingress_remove_observer(cs_mmap_on_ingress, self);
+  }
+  ndn_cs_mmap_sync(self);
+  munmap(self->map, self->map_size);
+  close(self->fd);
+  free(self->index);
+  free(self);
+}
+
+int
+ndn_cs_mmap_put(ndn_cs_mmap_t* self, const uint8_t* data, uint32_t size){
+  cs_mmap_header_t* hdr = cs_mmap_header(self);
+  cs_mmap_record_t* rec;
+  ndn_data_view_t view;
+  uint64_t total, name_hash, freshness_period;
+  int ret;
+
+  ret = ndn_data_view_parse(&view, data, size);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  // Without a FreshnessPeriod, Data is stale as soon as it arrives
+  if(ndn_data_view_get_freshness_period(&view, &freshness_period) != NDN_SUCCESS){
+    freshness_period = 0;
+  }
+  name_hash = ndn_pkt_name_hash(view.name, view.name_size);
+
+  // Make room in the index before reserving: eviction resets an emptied ring
+  if(cs_mmap_index_find(self, name_hash) == NULL){
+    while(self->count >= (self->index_mask + 1) / 4 * 3){
+      if(!cs_mmap_evict_head(self)){
+        break;
+      }
+    }
+  }
+  total = cs_mmap_record_size(size);
+  ret = cs_mmap_reserve(self, total);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+
+  rec = cs_mmap_record(self, hdr->tail);
+  rec->magic = 0;
+  rec->size = size;
+  rec->name_hash = name_hash;
+  rec->seq = hdr->seq ++;
+  rec->arrival = ndn_time_now_ms();
+  rec->freshness_period = freshness_period;
+  memcpy(rec + 1, data, size);
+  rec->magic = NDN_CS_MMAP_RECORD_MAGIC;
+
+  cs_mmap_index_insert(self, name_hash, hdr->tail);
+  hdr->tail += total;
+  return NDN_SUCCESS;
+}
+
+int
+ndn_cs_mmap_find(ndn_cs_mmap_t* self, const uint8_t* name, uint32_t name_size,
+                 const uint8_t** data, uint32_t* size){
+  struct ndn_cs_mmap_slot* slot;
+  cs_mmap_record_t* rec;
+  ndn_pkt_peek_t peek;
+
+  slot = cs_mmap_index_find(self, ndn_pkt_name_hash(name, name_size));
+  if(slot == NULL){
+    self->misses ++;
+    return NDN_CS_MMAP_NOT_FOUND;
+  }
+  rec = cs_mmap_record(self, slot->offset - 1);
+
+  // Rule out hash collisions
+  if(ndn_pkt_peek((uint8_t*)(rec + 1), rec->size, &peek) != NDN_SUCCESS ||
+     peek.name_size != name_size || memcmp(peek.name, name, name_size) != 0){
+    self->misses ++;
+    return NDN_CS_MMAP_NOT_FOUND;
+  }
+  self->hits ++;
+  *data = (uint8_t*)(rec + 1);
+  *size = rec->size;
+  return NDN_SUCCESS;
+}
+
+static bool
+cs_mmap_record_satisfies(ndn_cs_mmap_t* self, uint64_t offset, const ndn_interest_view_t* interest,
+                         ndn_time_ms_t now){
+  cs_mmap_record_t* rec = cs_mmap_record(self, offset);
+  ndn_pkt_peek_t peek;
+
+  if(interest->must_be_fresh && rec->arrival + rec->freshness_period <= now){
+    return false;
+  }
+  if(ndn_pkt_peek((uint8_t*)(rec + 1), rec->size, &peek) != NDN_SUCCESS){
+    return false;
+  }
+  if(interest->can_be_prefix){
+    return ndn_pkt_name_is_prefix(interest->name, interest->name_size, peek.name, peek.name_size);
+  }
+  return peek.name_size == interest->name_size &&
+         memcmp(peek.name, interest->name, interest->name_size) == 0;
+}
+
+int
+ndn_cs_mmap_match(ndn_cs_mmap_t* self, const uint8_t* interest, uint32_t interest_size,
+                  const uint8_t** data, uint32_t* size){
+  cs_mmap_header_t* hdr = cs_mmap_header(self);
+  struct ndn_cs_mmap_slot* slot;
+  ndn_interest_view_t view;
+  ndn_time_ms_t now = ndn_time_now_ms();
+  uint64_t offset, end, found = 0;
+  bool wrapped = (hdr->wrap != 0);
+  cs_mmap_record_t* rec;
+
+  if(ndn_interest_view_parse(&view, interest, interest_size) != NDN_SUCCESS){
+    return NDN_CS_MMAP_NOT_FOUND;
+  }
+
+  // The exact name is tried first; it also satisfies CanBePrefix
+  slot = cs_mmap_index_find(self, ndn_pkt_name_hash(view.name, view.name_size));
+  if(slot != NULL && cs_mmap_record_satisfies(self, slot->offset - 1, &view, now)){
+    found = slot->offset;
+  }
+
+  // Otherwise keep the newest record under the name. Records only link
+  // forward, so walk them oldest first and keep the last match.
+  // Shadowed records are skipped: their name maps to a newer one.
+  if(found == 0 && view.can_be_prefix){
+    offset = hdr->head;
+    end = wrapped ? hdr->wrap : hdr->tail;
+    while(true){
+      for(; offset < end; offset += cs_mmap_record_size(rec->size)){
+        rec = cs_mmap_record(self, offset);
+        slot = cs_mmap_index_find(self, rec->name_hash);
+        if(slot != NULL && slot->offset == offset + 1 &&
+           cs_mmap_record_satisfies(self, offset, &view, now)){
+          found = offset + 1;
+        }
+      }
+      if(!wrapped){
+        break;
+      }
+      wrapped = false;
+      offset = 0;
+      end = hdr->tail;
+    }
+  }
+
+  if(found == 0){
+    self->misses ++;
+    return NDN_CS_MMAP_NOT_FOUND;
+  }
+  self->hits ++;
+  rec = cs_mmap_record(self, found - 1);
+  *data = (uint8_t*)(rec + 1);
+  *size = rec->size;
+  return NDN_SUCCESS;
+}
+
+int
+ndn_cs_mmap_sync(ndn_cs_mmap_t* self){
+  if(msync(self->map, self->map_size, MS_SYNC) == -1){
+    return NDN_CS_MMAP_FILE_ERROR;
+  }
+  return NDN_SUCCESS;
+}
+
+static int
+cs_mmap_on_interest(const uint8_t* interest, uint32_t interest_size, void* userdata){
+  ndn_cs_mmap_t* self = (ndn_cs_mmap_t*)userdata;
+  const uint8_t* data;
+  uint32_t size;
+
+  if(ndn_cs_mmap_match(self, interest, interest_size, &data, &size) != NDN_SUCCESS){
+    return NDN_FWD_STRATEGY_MULTICAST;
+  }
+  ndn_forwarder_put_data((uint8_t*)data, size);
+  return NDN_FWD_STRATEGY_SUPPRESS;
+}
+
+static void
+cs_mmap_on_ingress(ndn_face_intf_t* face, const uint8_t* packet, uint32_t size,
+                   const ndn_pkt_peek_t* peek, void* userdata){
+  ndn_cs_mmap_t* self = (ndn_cs_mmap_t*)userdata;
+
+  if(face->type != NDN_FACE_TYPE_NET || peek->type != TLV_Data || peek->is_nack ||
+     !ndn_pkt_name_is_prefix(self->prefix, self->prefix_size, peek->name, peek->name_size)){
+    return;
+  }
+  ndn_cs_mmap_put(self, peek->packet, peek->packet_size);
+}
+
+int
+ndn_cs_mmap_serve(ndn_cs_mmap_t* self, uint8_t* prefix, size_t length){
+  int ret;
+
+  if(length > sizeof(self->prefix) || self->prefix_size > 0){
+    return NDN_OVERSIZE;
+  }
+  ret = ndn_forwarder_register_prefix(prefix, length, cs_mmap_on_interest, self);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  memcpy(self->prefix, prefix, length);
+  self->prefix_size = (uint32_t)length;
+  return ndn_ingress_add_observer(cs_mmap_on_ingress, self);
+}
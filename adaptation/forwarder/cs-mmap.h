@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#ifndef NDN_CS_MMAP_H_
+#define NDN_CS_MMAP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../adapt-consts.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Longest Name TLV ndn_cs_mmap_serve accepts
+#define NDN_CS_MMAP_PREFIX_SIZE 256
+
+/**
+ * Persistent Content Store tier.
+ *
+ * Data packets are appended to a memory-mapped segment file used as a ring:
+ * when the segment is full, the oldest records are evicted.
+ * An in-memory open-addressing index maps name hashes to record offsets.
+ * The index is rebuilt on open by walking the record headers only,
+ * so a restarted process serves its previous Data without re-signing.
+ * Each record keeps its wall-clock arrival time and FreshnessPeriod, so
+ * MustBeFresh is honoured across restarts too.
+ */
+typedef struct ndn_cs_mmap {
+  int fd;
+  uint8_t* map;
+  size_t map_size;
+
+  /**
+   * Index slots. A slot with offset 0 is empty; offsets are biased by 1.
+   */
+  struct ndn_cs_mmap_slot {
+    uint64_t name_hash;
+    uint64_t offset;
+  }* index;
+  uint32_t index_mask;
+  uint32_t count;
+
+  /**
+   * Prefix given to ndn_cs_mmap_serve, empty until then.
+   */
+  uint8_t prefix[NDN_CS_MMAP_PREFIX_SIZE];
+  uint32_t prefix_size;
+
+  /**
+   * Statistics.
+   */
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+} ndn_cs_mmap_t;
+
+/**
+ * Open or create a segment file and recover its index.
+ * @param path The segment file.
+ * @param capacity Size of the record area in bytes.
+ *  An existing file created with a different capacity is discarded.
+ * @param index_size Maximum number of indexed Data. Rounded up to a power of 2.
+ * @return The store, or NULL on failure.
+ */
+ndn_cs_mmap_t*
+ndn_cs_mmap_open(const char* path, size_t capacity, uint32_t index_size);
+
+/**
+ * Flush and close the store.
+ */
+void
+ndn_cs_mmap_close(ndn_cs_mmap_t* self);
+
+/**
+ * Append a Data packet, evicting the oldest records if needed.
+ * A previous Data with the same name is shadowed.
+ * @return NDN_SUCCESS, or NDN_CS_MMAP_OVERSIZE if it can never fit.
+ */
+int
+ndn_cs_mmap_put(ndn_cs_mmap_t* self, const uint8_t* data, uint32_t size);
+
+/**
+ * Look up the Data with exactly the given name.
+ * @param name Name TLV, including type and length.
+ * @param[out] data Points into the mapping. Valid until the next put.
+ * @return NDN_SUCCESS, or NDN_CS_MMAP_NOT_FOUND.
+ */
+int
+ndn_cs_mmap_find(ndn_cs_mmap_t* self, const uint8_t* name, uint32_t name_size,
+                 const uint8_t** data, uint32_t* size);
+
+/**
+ * Look up the newest Data satisfying an Interest: its name, CanBePrefix and
+ * MustBeFresh. Data without a FreshnessPeriod never satisfies MustBeFresh.
+ * Only the exact name is found through the index; CanBePrefix Interests
+ * whose exact name is absent walk the records.
+ * @param[out] data Points into the mapping. Valid until the next put.
+ * @return NDN_SUCCESS, or NDN_CS_MMAP_NOT_FOUND.
+ */
+int
+ndn_cs_mmap_match(ndn_cs_mmap_t* self, const uint8_t* interest, uint32_t interest_size,
+                  const uint8_t** data, uint32_t* size);
+
+/**
+ * Synchronously write dirty pages back to the file.
+ */
+int
+ndn_cs_mmap_sync(ndn_cs_mmap_t* self);
+
+/**
+ * Answer Interests under a prefix from the store, and store the Data under
+ * it that arrives from network faces. Can be called once per store.
+ * Misses are passed on with NDN_FWD_STRATEGY_MULTICAST.
+ * @param prefix Name TLV of the prefix.
+ * @return NDN_SUCCESS, NDN_OVERSIZE if the prefix is too long or already set,
+ *  or an error from the forwarder or the ingress observers.
+ */
+int
+ndn_cs_mmap_serve(ndn_cs_mmap_t* self, uint8_t* prefix, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
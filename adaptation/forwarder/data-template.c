@@ -0,0 +1,539 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "data-template.h"
+#include "pkt-peek.h"
+#include "ndn-lite/ndn-enums.h"
+#include "ndn-lite/ndn-error-code.h"
+#include "ndn-lite/security/ndn-lite-sha.h"
+#include "../security/sha256-kernels.h"
+
+// A segment component: generic component with the 0x00 marker
+#define TEMPLATE_SEGMENT_MARKER 0x00
+#define TEMPLATE_SEGMENT_MAX_SIZE 12
+#define TEMPLATE_NAME_BUFFER_SIZE (NDN_DATA_TEMPLATE_NAME_SIZE + 8)
+// Type and length of Data
+#define TEMPLATE_DATA_HEADER_MAX_SIZE 6
+// Type and length of SignatureValue, as signatures are shorter than 253
+#define TEMPLATE_SIG_HEADER_SIZE 2
+
+static uint32_t
+template_var_size(uint64_t value);
+
+static uint32_t
+template_write_tl(uint8_t* buf, uint32_t type, uint32_t length);
+
+static uint32_t
+template_write_segment(uint8_t* buf, uint64_t segno);
+
+static int
+template_encode_name(const ndn_name_t* name, uint8_t* buf, uint32_t size, uint32_t* used);
+
+static int
+template_set_signer(ndn_data_template_t* self, uint8_t signature_type, const ndn_name_t* key_name);
+
+static uint32_t
+template_head_size(const ndn_data_template_t* self, uint32_t name_size, bool has_segno,
+                   uint64_t segno, uint32_t content_size);
+
+static uint32_t
+template_write_head(const ndn_data_template_t* self, uint8_t* buf,
+                    const uint8_t* name, uint32_t name_size, bool has_segno, uint64_t segno,
+                    uint32_t content_size);
+
+static int
+template_sign(const ndn_data_template_t* self, const struct iovec* parts, int count,
+              uint8_t* signature, uint32_t* sig_size);
+
+static int
+template_encode(const ndn_data_template_t* self, uint8_t* buf, uint32_t size,
+                const uint8_t* name, uint32_t name_size, bool has_segno, uint64_t segno,
+                const uint8_t* content, uint32_t content_size,
+                uint32_t* header, struct iovec* signed_portion);
+
+static uint32_t
+template_seal(uint8_t* buf, uint32_t header, const struct iovec* signed_portion,
+              const uint8_t* signature, uint32_t sig_size);
+
+static int
+template_make(const ndn_data_template_t* self, uint8_t* buf, uint32_t size,
+              const uint8_t* name, uint32_t name_size, bool has_segno, uint64_t segno,
+              const uint8_t* content, uint32_t content_size, uint32_t* used);
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+static uint32_t
+template_var_size(uint64_t value){
+  return value < 253 ? 1 : value <= 0xFFFF ? 3 : value <= 0xFFFFFFFFu ? 5 : 9;
+}
+
+static uint32_t
+template_write_tl(uint8_t* buf, uint32_t type, uint32_t length){
+  uint32_t ret = ndn_pkt_write_var(buf, type);
+  return ret + ndn_pkt_write_var(buf + ret, length);
+}
+
+static uint32_t
+template_write_segment(uint8_t* buf, uint64_t segno){
+  uint8_t value[NDN_DATA_TEMPLATE_SEGMENT_VALUE_SIZE];
+  uint32_t size, ret;
+
+  size = ndn_data_template_write_segment_value(value, segno);
+  ret = template_write_tl(buf, TLV_GenericNameComponent, size);
+  memcpy(buf + ret, value, size);
+  return ret + size;
+}
+
+uint32_t
+ndn_data_template_write_segment_value(uint8_t* value, uint64_t segno){
+  uint8_t num[TEMPLATE_SEGMENT_MAX_SIZE];
+  uint32_t num_size;
+
+  // Reuse the integer encoder and replace its type and length with the marker
+  num_size = ndn_pkt_write_uint(num, 0, segno);
+  value[0] = TEMPLATE_SEGMENT_MARKER;
+  memcpy(value + 1, num + 2, num_size - 2);
+  return num_size - 1;
+}
+
+static int
+template_encode_name(const ndn_name_t* name, uint8_t* buf, uint32_t size, uint32_t* used){
+  uint8_t wire[TEMPLATE_NAME_BUFFER_SIZE];
+  ndn_encoder_t encoder;
+  const uint8_t* val;
+  uint32_t type, length;
+  int ret;
+
+  encoder_init(&encoder, wire, sizeof(wire));
+  ret = ndn_name_tlv_encode(&encoder, name);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  val = ndn_pkt_read_tl(wire, wire + encoder.offset, &type, &length);
+  if(val == NULL){
+    return NDN_WRONG_TLV_LENGTH;
+  }
+  if(length > size){
+    return NDN_OVERSIZE;
+  }
+  memcpy(buf, val, length);
+  *used = length;
+  return NDN_SUCCESS;
+}
+
+int
+ndn_data_template_init(ndn_data_template_t* self, const ndn_name_t* prefix,
+                       uint8_t content_type, uint64_t freshness_period){
+  int ret;
+
+  memset(self, 0, sizeof(ndn_data_template_t));
+  if(prefix != NULL){
+    ret = template_encode_name(prefix, self->name, sizeof(self->name), &self->name_size);
+    if(ret != NDN_SUCCESS){
+      return ret;
+    }
+  }
+  if(content_type != NDN_CONTENT_TYPE_BLOB){
+    self->meta_info_size += ndn_pkt_write_uint(self->meta_info + self->meta_info_size,
+                                               TLV_ContentType, content_type);
+  }
+  if(freshness_period != 0){
+    self->meta_info_size += ndn_pkt_write_uint(self->meta_info + self->meta_info_size,
+                                               TLV_FreshnessPeriod, freshness_period);
+  }
+  return template_set_signer(self, NDN_SIG_TYPE_DIGEST_SHA256, NULL);
+}
+
+void
+ndn_data_template_set_final_block_id(ndn_data_template_t* self, uint64_t segno){
+  self->has_final_block_id = true;
+  self->final_block_id = segno;
+}
+
+static int
+template_set_signer(ndn_data_template_t* self, uint8_t signature_type, const ndn_name_t* key_name){
+  uint8_t fields[NDN_DATA_TEMPLATE_SIGNATURE_INFO_SIZE];
+  uint8_t key[TEMPLATE_NAME_BUFFER_SIZE];
+  uint32_t fields_size, key_size = 0;
+  int ret;
+
+  fields_size = ndn_pkt_write_uint(fields, TLV_SignatureType, signature_type);
+  if(key_name != NULL){
+    ret = template_encode_name(key_name, key, sizeof(key), &key_size);
+    if(ret != NDN_SUCCESS){
+      return ret;
+    }
+    if(fields_size + key_size + 16 > sizeof(fields)){
+      return NDN_OVERSIZE;
+    }
+    fields_size += template_write_tl(fields + fields_size, TLV_KeyLocator,
+                                     key_size + template_var_size(TLV_Name) + template_var_size(key_size));
+    fields_size += template_write_tl(fields + fields_size, TLV_Name, key_size);
+    memcpy(fields + fields_size, key, key_size);
+    fields_size += key_size;
+  }
+
+  self->signature_info_size = template_write_tl(self->signature_info, TLV_SignatureInfo, fields_size);
+  if(self->signature_info_size + fields_size > sizeof(self->signature_info)){
+    return NDN_OVERSIZE;
+  }
+  memcpy(self->signature_info + self->signature_info_size, fields, fields_size);
+  self->signature_info_size += fields_size;
+  self->signature_type = signature_type;
+  return NDN_SUCCESS;
+}
+
+int
+ndn_data_template_set_hmac_signer(ndn_data_template_t* self, const ndn_hmac_key_t* key,
+                                  const ndn_name_t* key_name){
+  self->hmac_key = key;
+  return template_set_signer(self, NDN_SIG_TYPE_HMAC_SHA256, key_name);
+}
+
+int
+ndn_data_template_set_ecdsa_signer(ndn_data_template_t* self, const ndn_ecc_prv_t* key,
+                                   const ndn_name_t* key_name){
+  self->ecc_key = key;
+  return template_set_signer(self, NDN_SIG_TYPE_ECDSA_SHA256, key_name);
+}
+
+static uint32_t
+template_head_size(const ndn_data_template_t* self, uint32_t name_size, bool has_segno,
+                   uint64_t segno, uint32_t content_size){
+  uint8_t segment[TEMPLATE_SEGMENT_MAX_SIZE];
+  uint32_t name_len, meta_len;
+
+  name_len = name_size + (has_segno ? template_write_segment(segment, segno) : 0);
+  meta_len = self->meta_info_size;
+  if(self->has_final_block_id){
+    meta_len += 2 + template_write_segment(segment, self->final_block_id);
+  }
+  return template_var_size(name_len) + 1 + name_len +
+         (meta_len > 0 ? template_var_size(meta_len) + 1 + meta_len : 0) +
+         template_var_size(content_size) + 1;
+}
+
+static uint32_t
+template_write_head(const ndn_data_template_t* self, uint8_t* buf,
+                    const uint8_t* name, uint32_t name_size, bool has_segno, uint64_t segno,
+                    uint32_t content_size){
+  uint8_t segment[TEMPLATE_SEGMENT_MAX_SIZE];
+  uint8_t final_block_id[TEMPLATE_SEGMENT_MAX_SIZE + 2];
+  uint32_t segment_size = 0, final_block_id_size = 0, meta_len;
+  uint8_t* ptr = buf;
+
+  if(has_segno){
+    segment_size = template_write_segment(segment, segno);
+  }
+  if(self->has_final_block_id){
+    final_block_id_size = template_write_segment(final_block_id + 2, self->final_block_id);
+    final_block_id[0] = TLV_FinalBlockId;
+    final_block_id[1] = (uint8_t)final_block_id_size;
+    final_block_id_size += 2;
+  }
+  meta_len = self->meta_info_size + final_block_id_size;
+
+  ptr += template_write_tl(ptr, TLV_Name, name_size + segment_size);
+  memcpy(ptr, name, name_size);
+  ptr += name_size;
+  memcpy(ptr, segment, segment_size);
+  ptr += segment_size;
+  if(meta_len > 0){
+    ptr += template_write_tl(ptr, TLV_MetaInfo, meta_len);
+    memcpy(ptr, self->meta_info, self->meta_info_size);
+    ptr += self->meta_info_size;
+    memcpy(ptr, final_block_id, final_block_id_size);
+    ptr += final_block_id_size;
+  }
+  ptr += template_write_tl(ptr, TLV_Content, content_size);
+  return (uint32_t)(ptr - buf);
+}
+
+static int
+template_sign(const ndn_data_template_t* self, const struct iovec* parts, int count,
+              uint8_t* signature, uint32_t* sig_size){
+  ndn_sha256_state_t state;
+  uint8_t *gathered, *ptr;
+  uint32_t total = 0;
+  int i, ret;
+
+  if(self->signature_type == NDN_SIG_TYPE_DIGEST_SHA256){
+    ndn_sha256_init(&state);
+    for(i = 0; i < count; i ++){
+      ndn_sha256_update(&state, (const uint8_t*)parts[i].iov_base, parts[i].iov_len);
+    }
+    *sig_size = NDN_SEC_SHA256_HASH_SIZE;
+    return ndn_sha256_finish(&state, signature);
+  }
+
+  // HMAC and ECDSA take one buffer
+  if(count == 1){
+    gathered = (uint8_t*)parts[0].iov_base;
+    total = parts[0].iov_len;
+  }else{
+    for(i = 0; i < count; i ++){
+      total += parts[i].iov_len;
+    }
+    gathered = (uint8_t*)malloc(total);
+    if(gathered == NULL){
+      return NDN_FWD_NO_MEM;
+    }
+    for(i = 0, ptr = gathered; i < count; ptr += parts[i].iov_len, i ++){
+      memcpy(ptr, parts[i].iov_base, parts[i].iov_len);
+    }
+  }
+  if(self->signature_type == NDN_SIG_TYPE_HMAC_SHA256){
+    ret = ndn_hmac_sign(gathered, total, signature, NDN_DATA_TEMPLATE_MAX_SIGNATURE_SIZE,
+                        self->hmac_key, sig_size);
+  }else{
+    ret = ndn_ecdsa_sign(gathered, total, signature, NDN_DATA_TEMPLATE_MAX_SIGNATURE_SIZE,
+                         self->ecc_key, sig_size);
+  }
+  if(count != 1){
+    free(gathered);
+  }
+  return ret;
+}
+
+// Write everything but the signature; the signed portion starts at buf + header
+static int
+template_encode(const ndn_data_template_t* self, uint8_t* buf, uint32_t size,
+                const uint8_t* name, uint32_t name_size, bool has_segno, uint64_t segno,
+                const uint8_t* content, uint32_t content_size,
+                uint32_t* header, struct iovec* signed_portion){
+  uint32_t sig_size, inner;
+  uint8_t *ptr, *signed_start;
+
+  // ECDSA signatures vary in length; assume the largest and fix up later
+  sig_size = (self->signature_type == NDN_SIG_TYPE_ECDSA_SHA256) ?
+             NDN_DATA_TEMPLATE_MAX_SIGNATURE_SIZE : NDN_SEC_SHA256_HASH_SIZE;
+  inner = template_head_size(self, name_size, has_segno, segno, content_size) + content_size +
+          self->signature_info_size + template_var_size(sig_size) + 1 + sig_size;
+  *header = 1 + template_var_size(inner);
+  if(*header + inner > size){
+    return NDN_OVERSIZE;
+  }
+
+  // Name, MetaInfo, Content and SignatureInfo are copied behind the header
+  ptr = signed_start = buf + *header;
+  ptr += template_write_head(self, ptr, name, name_size, has_segno, segno, content_size);
+  if(content_size > 0){
+    memcpy(ptr, content, content_size);
+  }
+  ptr += content_size;
+  memcpy(ptr, self->signature_info, self->signature_info_size);
+  ptr += self->signature_info_size;
+
+  signed_portion->iov_base = signed_start;
+  signed_portion->iov_len = (size_t)(ptr - signed_start);
+  return NDN_SUCCESS;
+}
+
+// Append the signature and write the outer TL; returns the packet size
+static uint32_t
+template_seal(uint8_t* buf, uint32_t header, const struct iovec* signed_portion,
+              const uint8_t* signature, uint32_t sig_size){
+  uint8_t* signed_start = (uint8_t*)signed_portion->iov_base;
+  uint8_t* ptr = signed_start + signed_portion->iov_len;
+  uint32_t inner, actual_header;
+
+  ptr += template_write_tl(ptr, TLV_SignatureValue, sig_size);
+  memcpy(ptr, signature, sig_size);
+  ptr += sig_size;
+
+  // A shorter signature may shorten the outer length field
+  inner = (uint32_t)(ptr - signed_start);
+  actual_header = 1 + template_var_size(inner);
+  if(actual_header < header){
+    memmove(buf + actual_header, signed_start, inner);
+  }
+  template_write_tl(buf, TLV_Data, inner);
+  return actual_header + inner;
+}
+
+static int
+template_make(const ndn_data_template_t* self, uint8_t* buf, uint32_t size,
+              const uint8_t* name, uint32_t name_size, bool has_segno, uint64_t segno,
+              const uint8_t* content, uint32_t content_size, uint32_t* used){
+  uint8_t signature[NDN_DATA_TEMPLATE_MAX_SIGNATURE_SIZE];
+  struct iovec signed_portion;
+  uint32_t header, sig_size;
+  int ret;
+
+  ret = template_encode(self, buf, size, name, name_size, has_segno, segno, content, content_size,
+                        &header, &signed_portion);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  ret = template_sign(self, &signed_portion, 1, signature, &sig_size);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  *used = template_seal(buf, header, &signed_portion, signature, sig_size);
+  return NDN_SUCCESS;
+}
+
+int
+ndn_data_template_make_segment(const ndn_data_template_t* self, uint8_t* buf, uint32_t size,
+                               uint64_t segno, const uint8_t* content, uint32_t content_size,
+                               uint32_t* used){
+  return template_make(self, buf, size, self->name, self->name_size, true, segno,
+                       content, content_size, used);
+}
+
+int
+ndn_data_template_make_segments(const ndn_data_template_t* self, uint8_t* const* bufs, uint32_t size,
+                                uint64_t first_segno, const uint8_t* const* contents,
+                                const uint32_t* content_sizes, uint32_t count, uint32_t* used){
+  uint8_t digests[NDN_DATA_TEMPLATE_BATCH_SIZE][NDN_SEC_SHA256_HASH_SIZE];
+  uint8_t* digest_ptrs[NDN_DATA_TEMPLATE_BATCH_SIZE];
+  const uint8_t* portions[NDN_DATA_TEMPLATE_BATCH_SIZE];
+  uint32_t portion_sizes[NDN_DATA_TEMPLATE_BATCH_SIZE];
+  uint32_t headers[NDN_DATA_TEMPLATE_BATCH_SIZE];
+  struct iovec signed_portions[NDN_DATA_TEMPLATE_BATCH_SIZE];
+  uint32_t i, j, n;
+  int ret;
+
+  // Only digests are computed side by side
+  if(self->signature_type != NDN_SIG_TYPE_DIGEST_SHA256){
+    for(i = 0; i < count; i ++){
+      ret = ndn_data_template_make_segment(self, bufs[i], size, first_segno + i,
+                                           contents[i], content_sizes[i], &used[i]);
+      if(ret != NDN_SUCCESS){
+        return ret;
+      }
+    }
+    return NDN_SUCCESS;
+  }
+
+  for(i = 0; i < NDN_DATA_TEMPLATE_BATCH_SIZE; i ++){
+    digest_ptrs[i] = digests[i];
+  }
+  for(i = 0; i < count; i += n){
+    n = (count - i < NDN_DATA_TEMPLATE_BATCH_SIZE) ? count - i : NDN_DATA_TEMPLATE_BATCH_SIZE;
+    for(j = 0; j < n; j ++){
+      ret = template_encode(self, bufs[i + j], size, self->name, self->name_size, true,
+                            first_segno + i + j, contents[i + j], content_sizes[i + j],
+                            &headers[j], &signed_portions[j]);
+      if(ret != NDN_SUCCESS){
+        return ret;
+      }
+      portions[j] = (const uint8_t*)signed_portions[j].iov_base;
+      portion_sizes[j] = (uint32_t)signed_portions[j].iov_len;
+    }
+    ndn_sha256_kernels_digest_many(portions, portion_sizes, digest_ptrs, n);
+    for(j = 0; j < n; j ++){
+      used[i + j] = template_seal(bufs[i + j], headers[j], &signed_portions[j],
+                                  digests[j], NDN_SEC_SHA256_HASH_SIZE);
+    }
+  }
+  return NDN_SUCCESS;
+}
+
+int
+ndn_data_template_make_named(const ndn_data_template_t* self, uint8_t* buf, uint32_t size,
+                             const uint8_t* name, uint32_t name_size,
+                             const uint8_t* content, uint32_t content_size, uint32_t* used){
+  const uint8_t* val;
+  uint32_t type, length;
+
+  val = ndn_pkt_read_tl(name, name + name_size, &type, &length);
+  if(val == NULL || type != TLV_Name){
+    return NDN_WRONG_TLV_TYPE;
+  }
+  return template_make(self, buf, size, val, length, false, 0, content, content_size, used);
+}
+
+int
+ndn_data_template_make_iov(const ndn_data_template_t* self, ndn_data_iov_buf_t* scratch,
+                           uint64_t segno, const struct iovec* content, int content_count,
+                           struct iovec* iov, int* iov_count){
+  uint8_t *head, *ptr;
+  uint32_t content_size = 0, head_size, sig_size, inner, data_header;
+  int i, ret;
+
+  if(content_count + NDN_DATA_TEMPLATE_IOV_EXTRA > *iov_count){
+    return NDN_OVERSIZE;
+  }
+  for(i = 0; i < content_count; i ++){
+    content_size += content[i].iov_len;
+  }
+
+  // Leave room for the Data header, known only after signing
+  head = scratch->head + TEMPLATE_DATA_HEADER_MAX_SIZE;
+  head_size = template_write_head(self, head, self->name, self->name_size, true, segno, content_size);
+  iov[0].iov_base = head;
+  iov[0].iov_len = head_size;
+  for(i = 0; i < content_count; i ++){
+    iov[i + 1] = content[i];
+  }
+  memcpy(scratch->tail, self->signature_info, self->signature_info_size);
+  iov[content_count + 1].iov_base = scratch->tail;
+  iov[content_count + 1].iov_len = self->signature_info_size;
+
+  // The signature covers the iovecs in place
+  ptr = scratch->tail + self->signature_info_size;
+  ret = template_sign(self, iov, content_count + 2, ptr + TEMPLATE_SIG_HEADER_SIZE, &sig_size);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  template_write_tl(ptr, TLV_SignatureValue, sig_size);
+  iov[content_count + 1].iov_len += TEMPLATE_SIG_HEADER_SIZE + sig_size;
+
+  inner = head_size + content_size + iov[content_count + 1].iov_len;
+  data_header = 1 + template_var_size(inner);
+  template_write_tl(head - data_header, TLV_Data, inner);
+  iov[0].iov_base = head - data_header;
+  iov[0].iov_len = head_size + data_header;
+  *iov_count = content_count + 2;
+  return NDN_SUCCESS;
+}
+
+int
+ndn_data_build(const ndn_data_fields_t* fields, uint8_t* buf, uint32_t size, uint32_t* used){
+  ndn_data_template_t tpl;
+  const uint8_t* name;
+  uint32_t type, name_size;
+  int ret;
+
+  if((fields->name == NULL) == (fields->name_block == NULL) ||
+     (fields->hmac_key != NULL && fields->ecc_key != NULL)){
+    return NDN_INVALID_POINTER;
+  }
+  ret = ndn_data_template_init(&tpl, fields->name, fields->content_type, fields->freshness_period);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  if(fields->final_block_id != NULL){
+    ndn_data_template_set_final_block_id(&tpl, *fields->final_block_id);
+  }
+  if(fields->hmac_key != NULL){
+    ret = ndn_data_template_set_hmac_signer(&tpl, fields->hmac_key, fields->key_name);
+  }else if(fields->ecc_key != NULL){
+    ret = ndn_data_template_set_ecdsa_signer(&tpl, fields->ecc_key, fields->key_name);
+  }
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+
+  if(fields->name_block != NULL){
+    name = ndn_pkt_read_tl(fields->name_block, fields->name_block + fields->name_block_size,
+                           &type, &name_size);
+    if(name == NULL || type != TLV_Name){
+      return NDN_WRONG_TLV_TYPE;
+    }
+  }else{
+    name = tpl.name;
+    name_size = tpl.name_size;
+  }
+  return template_make(&tpl, buf, size, name, name_size,
+                       fields->segno != NULL, (fields->segno != NULL) ? *fields->segno : 0,
+                       fields->content, fields->content_size, used);
+}
@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#ifndef NDN_DATA_TEMPLATE_H_
+#define NDN_DATA_TEMPLATE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/uio.h>
+#include "ndn-lite/encode/name.h"
+#include "ndn-lite/security/ndn-lite-hmac.h"
+#include "ndn-lite/security/ndn-lite-ecc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Encoded name prefix, without the Name TLV header
+#define NDN_DATA_TEMPLATE_NAME_SIZE 256
+#define NDN_DATA_TEMPLATE_META_INFO_SIZE 32
+#define NDN_DATA_TEMPLATE_SIGNATURE_INFO_SIZE 320
+// Largest DER-encoded ECDSA P-256 signature
+#define NDN_DATA_TEMPLATE_MAX_SIGNATURE_SIZE 72
+// iovecs added by ndn_data_template_make_iov around the content
+#define NDN_DATA_TEMPLATE_IOV_EXTRA 2
+// Segments digested together by ndn_data_template_make_segments
+#define NDN_DATA_TEMPLATE_BATCH_SIZE 16
+// Marker and an 8-byte segment number
+#define NDN_DATA_TEMPLATE_SEGMENT_VALUE_SIZE 9
+
+/**
+ * The parts of a Data shared by all packets of a producer, encoded once.
+ *
+ * ndn_data_template_make only copies them, writes the segment number,
+ * FinalBlockId and content, computes the lengths, and signs.
+ */
+typedef struct ndn_data_template {
+  uint8_t name[NDN_DATA_TEMPLATE_NAME_SIZE];
+  uint32_t name_size;
+  uint8_t meta_info[NDN_DATA_TEMPLATE_META_INFO_SIZE];
+  uint32_t meta_info_size;
+  bool has_final_block_id;
+  uint64_t final_block_id;
+  uint8_t signature_info[NDN_DATA_TEMPLATE_SIGNATURE_INFO_SIZE];
+  uint32_t signature_info_size;
+  uint8_t signature_type;
+  const ndn_hmac_key_t* hmac_key;
+  const ndn_ecc_prv_t* ecc_key;
+} ndn_data_template_t;
+
+/**
+ * Fields of a Data made by ndn_data_build.
+ * Leave out a field to omit it; use NDN_DATA_BUILD to name the fields given.
+ * Optional numbers are pointers, so that leaving one out is told apart
+ * from 0.
+ */
+typedef struct ndn_data_fields {
+  /**
+   * Either a name, or a whole Name TLV such as the name of an Interest view.
+   */
+  const ndn_name_t* name;
+  const uint8_t* name_block;
+  uint32_t name_block_size;
+  /**
+   * Appended to the name as a segment number.
+   */
+  const uint64_t* segno;
+  uint8_t content_type;
+  /**
+   * In ms; 0 leaves it out.
+   */
+  uint64_t freshness_period;
+  const uint64_t* final_block_id;
+  const uint8_t* content;
+  uint32_t content_size;
+  /**
+   * At most one key. DigestSha256 is used without a key.
+   */
+  const ndn_hmac_key_t* hmac_key;
+  const ndn_ecc_prv_t* ecc_key;
+  const ndn_name_t* key_name;
+} ndn_data_fields_t;
+
+/**
+ * Headers written by ndn_data_template_make_iov.
+ * Must stay alive until the iovecs are sent.
+ */
+typedef struct ndn_data_iov_buf {
+  uint8_t head[NDN_DATA_TEMPLATE_NAME_SIZE + NDN_DATA_TEMPLATE_META_INFO_SIZE + 64];
+  uint8_t tail[NDN_DATA_TEMPLATE_SIGNATURE_INFO_SIZE + NDN_DATA_TEMPLATE_MAX_SIGNATURE_SIZE + 8];
+} ndn_data_iov_buf_t;
+
+/**
+ * Start a template signed with DigestSha256.
+ * @param prefix Name prefix of the packets. NULL for an empty prefix.
+ * @param freshness_period In ms; 0 leaves it out.
+ */
+int
+ndn_data_template_init(ndn_data_template_t* self, const ndn_name_t* prefix,
+                       uint8_t content_type, uint64_t freshness_period);
+
+void
+ndn_data_template_set_final_block_id(ndn_data_template_t* self, uint64_t segno);
+
+/**
+ * Sign with HMAC-SHA256. The key must outlive the template.
+ */
+int
+ndn_data_template_set_hmac_signer(ndn_data_template_t* self, const ndn_hmac_key_t* key,
+                                  const ndn_name_t* key_name);
+
+/**
+ * Sign with ECDSA-SHA256. The key must outlive the template.
+ */
+int
+ndn_data_template_set_ecdsa_signer(ndn_data_template_t* self, const ndn_ecc_prv_t* key,
+                                   const ndn_name_t* key_name);
+
+/**
+ * Write the value of the component naming segment @p segno: a generic
+ * component with the 0x00 marker, as the segments of a template are named.
+ * @param value At least NDN_DATA_TEMPLATE_SEGMENT_VALUE_SIZE bytes.
+ * @return The size of the value.
+ */
+uint32_t
+ndn_data_template_write_segment_value(uint8_t* value, uint64_t segno);
+
+/**
+ * Make the Data of segment @p segno, named prefix/<segno>.
+ * @param[out] used The size of the packet.
+ */
+int
+ndn_data_template_make_segment(const ndn_data_template_t* self, uint8_t* buf, uint32_t size,
+                               uint64_t segno, const uint8_t* content, uint32_t content_size,
+                               uint32_t* used);
+
+/**
+ * Make segments first_segno, first_segno + 1, ... at once.
+ * With DigestSha256 the digests are computed side by side with
+ * ndn_sha256_kernels_digest_many; other signers make them one by one.
+ * @param bufs @p count buffers of @p size bytes each.
+ * @param[out] used @p count sizes of the packets.
+ */
+int
+ndn_data_template_make_segments(const ndn_data_template_t* self, uint8_t* const* bufs, uint32_t size,
+                                uint64_t first_segno, const uint8_t* const* contents,
+                                const uint32_t* content_sizes, uint32_t count, uint32_t* used);
+
+/**
+ * Make a Data with the given name, e.g. the name of an Interest.
+ * The prefix of the template is not used.
+ * @param name Whole Name TLV.
+ */
+int
+ndn_data_template_make_named(const ndn_data_template_t* self, uint8_t* buf, uint32_t size,
+                             const uint8_t* name, uint32_t name_size,
+                             const uint8_t* content, uint32_t content_size, uint32_t* used);
+
+/**
+ * Make the Data of segment @p segno without copying its content.
+ *
+ * The headers are written into @p scratch, and @p iov is filled with
+ * head, the content iovecs, and tail. Data answering an Interest must go
+ * through the forwarder to satisfy its PIT entry, which takes one buffer:
+ * ndn_pktbuf_gather then copies the content once, into the pktbuf the
+ * faces share.
+ * A DigestSha256 is computed over the iovecs in place; HMAC and ECDSA
+ * signers need one buffer, so the signed portion is gathered for them.
+ * @param[in,out] iov_count Capacity of @p iov, at least
+ *   content_count + NDN_DATA_TEMPLATE_IOV_EXTRA; set to the number used.
+ */
+int
+ndn_data_template_make_iov(const ndn_data_template_t* self, ndn_data_iov_buf_t* scratch,
+                           uint64_t segno, const struct iovec* content, int content_count,
+                           struct iovec* iov, int* iov_count);
+
+/**
+ * Encode and sign a single Data.
+ * Producers making many packets with the same prefix and signer should keep
+ * a template instead, which encodes the shared parts once.
+ * @param[out] used The size of the packet.
+ */
+int
+ndn_data_build(const ndn_data_fields_t* fields, uint8_t* buf, uint32_t size, uint32_t* used);
+
+/**
+ * ndn_data_build with designated initializers, e.g.
+ *
+ *   NDN_DATA_BUILD(buf, sizeof(buf), &used, .name = &name, .segno = &segno,
+ *                  .content = content, .content_size = content_size);
+ *
+ * A misspelled field does not compile. Values are converted as in an
+ * assignment: a pointer of the wrong type is only a warning
+ * (-Wincompatible-pointer-types), and a number of another width is
+ * converted silently.
+ * C only: C++ has no compound literals. Fill a ndn_data_fields_t there.
+ */
+#ifndef __cplusplus
+#define NDN_DATA_BUILD(buf, size, used, ...) \
+  ndn_data_build(&(const ndn_data_fields_t){__VA_ARGS__}, (buf), (size), (used))
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
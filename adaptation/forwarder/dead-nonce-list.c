@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "dead-nonce-list.h"
+#include "ndn-lite/ndn-enums.h"
+#include "ndn-lite/ndn-error-code.h"
+#include "ndn-lite/forwarder/forwarder.h"
+
+#define NDN_DNL_MIN_SLOTS 16
+
+static ndn_dead_nonce_list_t dnl_instance;
+static bool dnl_instance_ready = false;
+
+static void
+dnl_rotate(ndn_dead_nonce_list_t* self, ndn_time_ms_t now);
+
+static bool
+dnl_contains(const uint32_t* table, uint32_t mask, uint64_t mix, uint32_t fp);
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+int
+ndn_dead_nonce_list_init(ndn_dead_nonce_list_t* self, size_t size, ndn_time_ms_t lifetime){
+  uint32_t slots = NDN_DNL_MIN_SLOTS;
+
+  while((size_t)slots * 2 * 2 * sizeof(uint32_t) <= size){
+    slots <<= 1;
+  }
+  self->tables[0] = (uint32_t*)calloc(slots, sizeof(uint32_t));
+  self->tables[1] = (uint32_t*)calloc(slots, sizeof(uint32_t));
+  if(self->tables[0] == NULL || self->tables[1] == NULL){
+    free(self->tables[0]);
+    free(self->tables[1]);
+    return NDN_FWD_NO_MEM;
+  }
+  self->mask = slots - 1;
+  self->count = 0;
+  self->current = 0;
+  self->lifetime = lifetime;
+  self->rotated_at = ndn_time_now_ms();
+  self->suppressed = 0;
+  return NDN_SUCCESS;
+}
+
+void
+ndn_dead_nonce_list_destroy(ndn_dead_nonce_list_t* self){
+  free(self->tables[0]);
+  free(self->tables[1]);
+  self->tables[0] = self->tables[1] = NULL;
+}
+
+ndn_dead_nonce_list_t*
+ndn_dead_nonce_list_get_instance(void){
+  if(!dnl_instance_ready){
+    if(ndn_dead_nonce_list_init(&dnl_instance, NDN_DEAD_NONCE_LIST_DEFAULT_SIZE,
+                                NDN_DEAD_NONCE_LIST_DEFAULT_LIFETIME) != NDN_SUCCESS){
+      return NULL;
+    }
+    dnl_instance_ready = true;
+  }
+  return &dnl_instance;
+}
+
+static void
+dnl_rotate(ndn_dead_nonce_list_t* self, ndn_time_ms_t now){
+  self->current ^= 1;
+  memset(self->tables[self->current], 0, sizeof(uint32_t) * (self->mask + 1));
+  self->count = 0;
+  self->rotated_at = now;
+}
+
+static bool
+dnl_contains(const uint32_t* table, uint32_t mask, uint64_t mix, uint32_t fp){
+  uint32_t i;
+
+  for(i = mix & mask; table[i] != 0; i = (i + 1) & mask){
+    if(table[i] == fp){
+      return true;
+    }
+  }
+  return false;
+}
+
+bool
+ndn_dead_nonce_list_insert(ndn_dead_nonce_list_t* self, uint64_t name_hash, uint32_t nonce){
+  ndn_time_ms_t now = ndn_time_now_ms();
+  uint64_t mix = name_hash ^ (nonce * 0x9E3779B97F4A7C15ULL);
+  uint32_t fp = (uint32_t)(mix >> 32) | 1;
+  uint32_t* table;
+  uint32_t i;
+
+  if(now - self->rotated_at >= self->lifetime / 2 || self->count >= (self->mask + 1) / 4 * 3){
+    dnl_rotate(self, now);
+  }
+  if(dnl_contains(self->tables[self->current ^ 1], self->mask, mix, fp)){
+    return true;
+  }
+
+  table = self->tables[self->current];
+  for(i = mix & self->mask; table[i] != 0; i = (i + 1) & self->mask){
+    if(table[i] == fp){
+      return true;
+    }
+  }
+  table[i] = fp;
+  self->count ++;
+  return false;
+}
+
+bool
+ndn_dead_nonce_list_filter(ndn_dead_nonce_list_t* self, const ndn_pkt_peek_t* peek){
+  if(peek->type != TLV_Interest || !peek->has_nonce){
+    return false;
+  }
+  if(ndn_dead_nonce_list_insert(self, ndn_pkt_name_hash(peek->name, peek->name_size), peek->nonce)){
+    self->suppressed ++;
+    return true;
+  }
+  return false;
+}
+
+void
+ndn_dead_nonce_list_record(ndn_dead_nonce_list_t* self, const uint8_t* packet, uint32_t size){
+  ndn_pkt_peek_t peek;
+
+  if(ndn_pkt_peek(packet, size, &peek) != NDN_SUCCESS || peek.type != TLV_Interest || !peek.has_nonce){
+    return;
+  }
+  ndn_dead_nonce_list_insert(self, ndn_pkt_name_hash(peek.name, peek.name_size), peek.nonce);
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#ifndef NDN_DEAD_NONCE_LIST_H_
+#define NDN_DEAD_NONCE_LIST_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "ndn-lite/util/uniform-time.h"
+#include "pkt-peek.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Default memory budget and how long a (Name, Nonce) pair is remembered
+#define NDN_DEAD_NONCE_LIST_DEFAULT_SIZE 16384
+#define NDN_DEAD_NONCE_LIST_DEFAULT_LIFETIME 6000
+
+/**
+ * Time-bounded set of (Name, Nonce) pairs of recently seen Interests.
+ *
+ * Two open-addressing tables of 32-bit fingerprints are rotated every
+ * half lifetime, or earlier when the current one is 3/4 full. An entry is
+ * remembered for up to one lifetime. Lookup and insertion are O(1) and
+ * never allocate. A fingerprint collision drops a fresh Interest with a
+ * probability of about load / 2^32.
+ */
+typedef struct ndn_dead_nonce_list {
+  uint32_t* tables[2];
+  uint32_t mask;
+  uint32_t count;
+  uint8_t current;
+  ndn_time_ms_t lifetime;
+  ndn_time_ms_t rotated_at;
+
+  /**
+   * Number of duplicate or looping Interests detected.
+   */
+  uint64_t suppressed;
+} ndn_dead_nonce_list_t;
+
+/**
+ * Allocate the tables.
+ * @param size Memory budget in bytes for both tables.
+ * @param lifetime How long an entry is remembered, in ms.
+ */
+int
+ndn_dead_nonce_list_init(ndn_dead_nonce_list_t* self, size_t size, ndn_time_ms_t lifetime);
+
+void
+ndn_dead_nonce_list_destroy(ndn_dead_nonce_list_t* self);
+
+/**
+ * Process-wide list shared by all network faces, so that loops across
+ * different faces are detected. Allocated with default size on first use.
+ */
+ndn_dead_nonce_list_t*
+ndn_dead_nonce_list_get_instance(void);
+
+/**
+ * Record a (Name, Nonce) pair.
+ * @return true if the pair was already present.
+ */
+bool
+ndn_dead_nonce_list_insert(ndn_dead_nonce_list_t* self, uint64_t name_hash, uint32_t nonce);
+
+/**
+ * Check an incoming packet by its peeked header.
+ * @return true if it is an Interest whose (Name, Nonce) has been seen,
+ *  i.e. a duplicate or a looping Interest to be dropped.
+ *  Otherwise the pair is recorded and false is returned.
+ */
+bool
+ndn_dead_nonce_list_filter(ndn_dead_nonce_list_t* self, const ndn_pkt_peek_t* peek);
+
+/**
+ * Record an outgoing packet, so it is dropped if it loops back.
+ */
+void
+ndn_dead_nonce_list_record(ndn_dead_nonce_list_t* self, const uint8_t* packet, uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "face-slab.h"
+
+// Free list terminator. Slot 0 is reserved so that handle 0 stays invalid.
+#define FACE_SLAB_FREE_END 0
+
+static ndn_face_slab_t face_slab_instance;
+
+static int
+ndn_face_slab_grow(ndn_face_slab_t* self);
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+ndn_face_slab_t*
+ndn_face_slab_get_instance(void){
+  return &face_slab_instance;
+}
+
+static int
+ndn_face_slab_grow(ndn_face_slab_t* self){
+  ndn_face_slot_t** chunks;
+  ndn_face_slot_t* chunk;
+  uint32_t base = self->chunk_count * NDN_FACE_SLAB_CHUNK_SIZE;
+  uint32_t i;
+
+  if(base + NDN_FACE_SLAB_CHUNK_SIZE > NDN_FACE_SLAB_MAX_SLOTS){
+    return -1;
+  }
+
+  // Only the chunk directory is reallocated; slots never move.
+  chunks = (ndn_face_slot_t**)realloc(self->chunks, (self->chunk_count + 1) * sizeof(ndn_face_slot_t*));
+  if(chunks == NULL){
+    return -1;
+  }
+  self->chunks = chunks;
+
+  chunk = (ndn_face_slot_t*)calloc(NDN_FACE_SLAB_CHUNK_SIZE, sizeof(ndn_face_slot_t));
+  if(chunk == NULL){
+    return -1;
+  }
+  chunks[self->chunk_count] = chunk;
+  self->chunk_count ++;
+
+  for(i = NDN_FACE_SLAB_CHUNK_SIZE; i > 0; i --){
+    if(base + i - 1 == 0){
+      continue;
+    }
+    chunk[i - 1].generation = 1;
+    chunk[i - 1].next_free = self->free_head;
+    self->free_head = base + i - 1;
+  }
+  return 0;
+}
+
+ndn_face_handle_t
+ndn_face_slab_insert(ndn_face_slab_t* self, ndn_face_intf_t* face){
+  ndn_face_slot_t* slot;
+  uint32_t index;
+
+  if(self->free_head == FACE_SLAB_FREE_END){
+    if(ndn_face_slab_grow(self) != 0 || self->free_head == FACE_SLAB_FREE_END){
+      return NDN_FACE_HANDLE_INVALID;
+    }
+  }
+
+  index = self->free_head;
+  slot = ndn_face_slab_slot(self, index);
+  self->free_head = slot->next_free;
+  slot->face = face;
+  memset(&slot->counters, 0, sizeof(slot->counters));
+  self->live ++;
+  self->registrations ++;
+  return ((uint32_t)slot->generation << 16) | index;
+}
+
+void
+ndn_face_slab_remove(ndn_face_slab_t* self, ndn_face_handle_t handle){
+  uint32_t index = handle & 0xFFFF;
+  ndn_face_slot_t* slot = ndn_face_slab_lookup(self, handle);
+
+  if(slot == NULL){
+    return;
+  }
+  slot->face = NULL;
+  slot->generation ++;
+  if(slot->generation == 0){
+    slot->generation = 1;
+  }
+  slot->next_free = self->free_head;
+  self->free_head = index;
+  self->live --;
+  self->unregistrations ++;
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#ifndef NDN_FACE_SLAB_H_
+#define NDN_FACE_SLAB_H_
+
+#include <stdint.h>
+#include "ndn-lite/forwarder/face.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Slots per chunk. The slab grows one chunk at a time.
+#define NDN_FACE_SLAB_CHUNK_SIZE 32
+#define NDN_FACE_SLAB_MAX_SLOTS 0x10000
+
+/**
+ * Generation-tagged face id: slot index in the low 16 bits,
+ * slot generation in the high 16 bits. 0 is never a valid handle.
+ */
+typedef uint32_t ndn_face_handle_t;
+
+#define NDN_FACE_HANDLE_INVALID 0
+
+/**
+ * Traffic counters of a face, kept in its slot.
+ * A slot never moves, so a face may keep a pointer to its counters.
+ */
+typedef struct ndn_face_counters {
+  uint64_t rx_packets;
+  uint64_t rx_bytes;
+  uint64_t tx_packets;
+  uint64_t tx_bytes;
+  uint64_t tx_dropped;
+  uint64_t tx_marked;
+  uint32_t queue_depth;
+} ndn_face_counters_t;
+
+typedef struct ndn_face_slot {
+  ndn_face_intf_t* face;
+  uint16_t generation;
+  uint16_t next_free;
+  ndn_face_counters_t counters;
+} ndn_face_slot_t;
+
+/**
+ * Table of the faces created by the POSIX adaptation.
+ *
+ * Slots live in fixed-size chunks that are never moved, so growing the
+ * table does not invalidate slot pointers, and the capacity is not fixed
+ * at compile time. A stale handle of a removed face never resolves to the
+ * face that reuses its slot, because the slot generation is bumped.
+ */
+typedef struct ndn_face_slab {
+  ndn_face_slot_t** chunks;
+  uint32_t chunk_count;
+  uint32_t free_head;
+  uint32_t live;
+
+  /**
+   * Statistics.
+   */
+  uint64_t registrations;
+  uint64_t unregistrations;
+} ndn_face_slab_t;
+
+ndn_face_slab_t*
+ndn_face_slab_get_instance(void);
+
+/**
+ * Add a face, growing the slab if needed.
+ * @return The handle, or NDN_FACE_HANDLE_INVALID if out of memory.
+ */
+ndn_face_handle_t
+ndn_face_slab_insert(ndn_face_slab_t* self, ndn_face_intf_t* face);
+
+/**
+ * Remove a face. Stale handles are ignored.
+ */
+void
+ndn_face_slab_remove(ndn_face_slab_t* self, ndn_face_handle_t handle);
+
+/**
+ * Get a slot by index, in [0, chunk_count * NDN_FACE_SLAB_CHUNK_SIZE).
+ */
+static inline ndn_face_slot_t*
+ndn_face_slab_slot(ndn_face_slab_t* self, uint32_t index){
+  return &self->chunks[index / NDN_FACE_SLAB_CHUNK_SIZE][index % NDN_FACE_SLAB_CHUNK_SIZE];
+}
+
+/**
+ * O(1) lookup.
+ * @return The slot, or NULL if the handle is stale.
+ */
+static inline ndn_face_slot_t*
+ndn_face_slab_lookup(ndn_face_slab_t* self, ndn_face_handle_t handle){
+  uint32_t index = handle & 0xFFFF;
+  ndn_face_slot_t* slot;
+
+  if(index >= self->chunk_count * NDN_FACE_SLAB_CHUNK_SIZE){
+    return NULL;
+  }
+  slot = ndn_face_slab_slot(self, index);
+  if(slot->generation != (handle >> 16) || slot->face == NULL){
+    return NULL;
+  }
+  return slot;
+}
+
+static inline ndn_face_intf_t*
+ndn_face_slab_get(ndn_face_slab_t* self, ndn_face_handle_t handle){
+  ndn_face_slot_t* slot = ndn_face_slab_lookup(self, handle);
+  return slot != NULL ? slot->face : NULL;
+}
+
+static inline ndn_face_counters_t*
+ndn_face_slab_get_counters(ndn_face_slab_t* self, ndn_face_handle_t handle){
+  ndn_face_slot_t* slot = ndn_face_slab_lookup(self, handle);
+  return slot != NULL ? &slot->counters : NULL;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
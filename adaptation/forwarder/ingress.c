@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include "ingress.h"
+#include "nack.h"
+#include "ndn-lite/ndn-enums.h"
+#include "ndn-lite/ndn-error-code.h"
+
+static struct {
+  ndn_ingress_observer_t func;
+  void* userdata;
+} ingress_observers[NDN_INGRESS_MAX_OBSERVERS];
+
+static int ingress_observer_count = 0;
+
+static ndn_dead_nonce_list_t* ingress_dnl = NULL;
+static bool ingress_dnl_set = false;
+static bool ingress_duplicate_nack = false;
+static bool ingress_nack_claimed = false;
+static ndn_face_intf_t* ingress_current_face = NULL;
+static uint64_t ingress_current_mark = 0;
+
+static inline void
+ingress_notify(ndn_face_intf_t* face, const uint8_t* packet, uint32_t size, const ndn_pkt_peek_t* peek);
+
+static int
+ingress_dispatch(ndn_face_intf_t* face, uint8_t* packets[], uint32_t sizes[],
+                 ndn_pktbuf_t* bufs[], int count, bool multicast);
+
+static int
+ingress_receive_pktbufs(ndn_face_intf_t* face, ndn_pktbuf_t* bufs[], int count, bool multicast);
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+static inline void
+ingress_notify(ndn_face_intf_t* face, const uint8_t* packet, uint32_t size, const ndn_pkt_peek_t* peek){
+  int i;
+
+  for(i = 0; i < ingress_observer_count; i ++){
+    ingress_observers[i].func(face, packet, size, peek, ingress_observers[i].userdata);
+  }
+}
+
+int
+ndn_ingress_add_observer(ndn_ingress_observer_t observer, void* userdata){
+  if(ingress_observer_count >= NDN_INGRESS_MAX_OBSERVERS){
+    return NDN_FWD_NO_MEM;
+  }
+  ingress_observers[ingress_observer_count].func = observer;
+  ingress_observers[ingress_observer_count].userdata = userdata;
+  ingress_observer_count ++;
+  return NDN_SUCCESS;
+}
+
+void
+ndn_ingress_remove_observer(ndn_ingress_observer_t observer, void* userdata){
+  int i;
+
+  for(i = 0; i < ingress_observer_count; i ++){
+    if(ingress_observers[i].func == observer && ingress_observers[i].userdata == userdata){
+      ingress_observer_count --;
+      ingress_observers[i] = ingress_observers[ingress_observer_count];
+      return;
+    }
+  }
+}
+
+void
+ndn_ingress_set_dead_nonce_list(ndn_dead_nonce_list_t* dnl){
+  ingress_dnl = dnl;
+  ingress_dnl_set = true;
+}
+
+ndn_dead_nonce_list_t*
+ndn_ingress_get_dead_nonce_list(void){
+  if(!ingress_dnl_set){
+    ingress_dnl = ndn_dead_nonce_list_get_instance();
+    ingress_dnl_set = true;
+  }
+  return ingress_dnl;
+}
+
+void
+ndn_ingress_set_duplicate_nack(bool enabled){
+  ingress_duplicate_nack = enabled;
+}
+
+void
+ndn_ingress_claim_nack(void){
+  ingress_nack_claimed = true;
+}
+
+ndn_face_intf_t*
+ndn_ingress_get_current_face(void){
+  return ingress_current_face;
+}
+
+uint64_t
+ndn_ingress_get_congestion_mark(void){
+  return ingress_current_mark;
+}
+
+int
+ndn_ingress_receive(ndn_face_intf_t* face, uint8_t* packet, uint32_t size){
+  return ndn_ingress_receive_batch(face, &packet, &size, 1);
+}
+
+int
+ndn_ingress_receive_batch(ndn_face_intf_t* face, uint8_t* packets[], uint32_t sizes[], int count){
+  return ingress_dispatch(face, packets, sizes, NULL, count, false);
+}
+
+int
+ndn_ingress_receive_pktbufs(ndn_face_intf_t* face, ndn_pktbuf_t* bufs[], int count){
+  return ingress_receive_pktbufs(face, bufs, count, false);
+}
+
+int
+ndn_ingress_receive_multicast_pktbufs(ndn_face_intf_t* face, ndn_pktbuf_t* bufs[], int count){
+  return ingress_receive_pktbufs(face, bufs, count, true);
+}
+
+static int
+ingress_receive_pktbufs(ndn_face_intf_t* face, ndn_pktbuf_t* bufs[], int count, bool multicast){
+  uint8_t* packets[NDN_INGRESS_BATCH_SIZE];
+  uint32_t sizes[NDN_INGRESS_BATCH_SIZE];
+  int i, j, n, ret, result = NDN_SUCCESS;
+
+  for(i = 0; i < count; i += n){
+    n = (count - i < NDN_INGRESS_BATCH_SIZE) ? count - i : NDN_INGRESS_BATCH_SIZE;
+    for(j = 0; j < n; j ++){
+      packets[j] = bufs[i + j]->data;
+      sizes[j] = bufs[i + j]->size;
+    }
+    ret = ingress_dispatch(face, packets, sizes, &bufs[i], n, multicast);
+    if(ret != NDN_SUCCESS && result == NDN_SUCCESS){
+      result = ret;
+    }
+  }
+  return result;
+}
+
+static int
+ingress_dispatch(ndn_face_intf_t* face, uint8_t* packets[], uint32_t sizes[],
+                 ndn_pktbuf_t* bufs[], int count, bool multicast){
+  ndn_pkt_peek_t peeks[NDN_INGRESS_BATCH_SIZE];
+  uint8_t* pkts[NDN_INGRESS_BATCH_SIZE];
+  uint32_t lens[NDN_INGRESS_BATCH_SIZE];
+  bool valid[NDN_INGRESS_BATCH_SIZE];
+  bool drop[NDN_INGRESS_BATCH_SIZE];
+  ndn_dead_nonce_list_t* dnl = NULL;
+  ndn_face_intf_t* outer_face;
+  ndn_pktbuf_t* outer_buf;
+  uint64_t outer_mark;
+  int i, j, n, ret, result = NDN_SUCCESS;
+
+  if(face->type == NDN_FACE_TYPE_NET){
+    dnl = ndn_ingress_get_dead_nonce_list();
+  }
+  // Restored like the face: this batch may be received from inside a send
+  // of a packet of an outer batch, which still refers to its buffer
+  outer_buf = ndn_pktbuf_get_current();
+
+  for(i = 0; i < count; i += n){
+    n = (count - i < NDN_INGRESS_BATCH_SIZE) ? count - i : NDN_INGRESS_BATCH_SIZE;
+
+    // Decode all headers first. NDNLPv2 headers are stripped here.
+    for(j = 0; j < n; j ++){
+      valid[j] = (ndn_pkt_peek(packets[i + j], sizes[i + j], &peeks[j]) == NDN_SUCCESS);
+      pkts[j] = valid[j] ? (uint8_t*)peeks[j].packet : packets[i + j];
+      lens[j] = valid[j] ? peeks[j].packet_size : sizes[i + j];
+    }
+
+    // Drop duplicates and notify observers. Malformed packets are still
+    // given to the forwarder, which owns the decision to drop them.
+    for(j = 0; j < n; j ++){
+      drop[j] = false;
+      if(!valid[j]){
+        continue;
+      }
+      // A Nack carries our own Interest back, so it must skip the DNL
+      if(peeks[j].is_nack){
+        drop[j] = true;
+        ingress_nack_claimed = false;
+        ingress_notify(face, pkts[j], lens[j], &peeks[j]);
+        if(!ingress_nack_claimed){
+          ndn_nack_return(&peeks[j], peeks[j].nack_reason, face);
+        }
+        continue;
+      }
+      // On a multicast face, this also drops our own Interests looped back
+      // to us, whose nonces the face recorded when sending them
+      if(dnl != NULL && ndn_dead_nonce_list_filter(dnl, &peeks[j])){
+        drop[j] = true;
+        // Other members of the group got the Interest too; never Nack them
+        if(ingress_duplicate_nack && !multicast && peeks[j].type == TLV_Interest){
+          ndn_nack_send(face, pkts[j], lens[j], NDN_NACK_DUPLICATE);
+        }
+        continue;
+      }
+      ingress_notify(face, pkts[j], lens[j], &peeks[j]);
+    }
+
+    // Run the forwarder pipeline back-to-back
+    for(j = 0; j < n; j ++){
+      if(drop[j]){
+        continue;
+      }
+      if(bufs != NULL){
+        ndn_pktbuf_set_current(bufs[i + j]);
+      }
+      // Restored rather than cleared: a face may receive from inside a send
+      outer_face = ingress_current_face;
+      outer_mark = ingress_current_mark;
+      ingress_current_face = face;
+      ingress_current_mark = valid[j] ? peeks[j].congestion_mark : 0;
+      if(valid[j] && !multicast){
+        ndn_nack_record_downstream(face, &peeks[j]);
+      }
+      ret = ndn_forwarder_receive(face, pkts[j], lens[j]);
+      ingress_current_face = outer_face;
+      ingress_current_mark = outer_mark;
+      if(ret == NDN_FWD_NO_ROUTE && valid[j]){
+        ndn_nack_return(&peeks[j], NDN_NACK_NO_ROUTE, NULL);
+      }
+      if(bufs != NULL){
+        ndn_pktbuf_set_current(outer_buf);
+      }
+      if(ret != NDN_SUCCESS && result == NDN_SUCCESS){
+        result = ret;
+      }
+    }
+  }
+  return result;
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#ifndef NDN_INGRESS_H_
+#define NDN_INGRESS_H_
+
+#include "ndn-lite/forwarder/forwarder.h"
+#include "pkt-peek.h"
+#include "dead-nonce-list.h"
+#include "pktbuf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NDN_INGRESS_MAX_OBSERVERS 4
+// Packets processed per pipeline stage by ndn_ingress_receive_batch
+#define NDN_INGRESS_BATCH_SIZE 32
+
+/**
+ * Called for every well-formed packet a POSIX face hands to the forwarder,
+ * before the forwarder processes it.
+ */
+typedef void (*ndn_ingress_observer_t)(ndn_face_intf_t* face,
+                                       const uint8_t* packet, uint32_t size,
+                                       const ndn_pkt_peek_t* peek, void* userdata);
+
+int
+ndn_ingress_add_observer(ndn_ingress_observer_t observer, void* userdata);
+
+void
+ndn_ingress_remove_observer(ndn_ingress_observer_t observer, void* userdata);
+
+/**
+ * Set the dead-nonce list checked for packets from network faces.
+ * Defaults to ndn_dead_nonce_list_get_instance(); NULL disables the check.
+ */
+void
+ndn_ingress_set_dead_nonce_list(ndn_dead_nonce_list_t* dnl);
+
+ndn_dead_nonce_list_t*
+ndn_ingress_get_dead_nonce_list(void);
+
+/**
+ * Reply with a Nack (Duplicate) to looping Interests dropped by the dead-nonce
+ * list, so that the downstream can try another path immediately.
+ * Never done on multicast faces. Defaults to false.
+ */
+void
+ndn_ingress_set_duplicate_nack(bool enabled);
+
+/**
+ * Called by an observer that retries the Interest of a Nack elsewhere,
+ * so that the Nack is not delivered to the local consumer.
+ */
+void
+ndn_ingress_claim_nack(void);
+
+/**
+ * Face of the packet the forwarder is processing, or NULL outside of the
+ * ndn_ingress_receive functions. Lets a face tell where an Interest it is
+ * asked to send came from.
+ */
+ndn_face_intf_t*
+ndn_ingress_get_current_face(void);
+
+/**
+ * CongestionMark of the packet the forwarder is processing, or 0 if it has
+ * none. A consumer calls it from its on_data callback to learn that the Data
+ * left a congested queue, and slows down.
+ */
+uint64_t
+ndn_ingress_get_congestion_mark(void);
+
+/**
+ * Pass a received packet to the forwarder, notifying observers first.
+ * Nacks are not given to the forwarder: unless an observer claims them,
+ * they are delivered to the Interests expressed in this process by
+ * ndn_nack_express_interest, and sent to the faces the Interest came from.
+ * An Interest the forwarder has no route for is Nacked (NoRoute).
+ * Faces in adaptation/ call this instead of ndn_forwarder_receive.
+ */
+int
+ndn_ingress_receive(ndn_face_intf_t* face, uint8_t* packet, uint32_t size);
+
+/**
+ * Pass several packets received on one face to the forwarder.
+ *
+ * Each stage runs over the whole batch before the next one starts:
+ * all headers are decoded, then duplicates are dropped and observers run,
+ * then the packets are handed to the forwarder back-to-back. Faces that
+ * receive in bulk (recvmmsg, a stream buffer holding several packets) use
+ * it to amortise per-packet setup.
+ * @return NDN_SUCCESS, or the first error reported by the forwarder.
+ */
+int
+ndn_ingress_receive_batch(ndn_face_intf_t* face, uint8_t* packets[], uint32_t sizes[], int count);
+
+/**
+ * Same as ndn_ingress_receive_batch, for packets held in pktbufs.
+ * Faces that forward a packet can then keep a reference instead of a copy.
+ */
+int
+ndn_ingress_receive_pktbufs(ndn_face_intf_t* face, ndn_pktbuf_t* bufs[], int count);
+
+/**
+ * Same as ndn_ingress_receive_pktbufs, for a face on a shared medium.
+ * No Nack is ever sent on it: other members of the group may have received
+ * the same Interest, and a duplicate may be our own Interest looped back.
+ */
+int
+ndn_ingress_receive_multicast_pktbufs(ndn_face_intf_t* face, ndn_pktbuf_t* bufs[], int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
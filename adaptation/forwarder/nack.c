@@ -0,0 +1,273 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "nack.h"
+#include "ndn-lite/encode/interest.h"
+#include "ndn-lite/ndn-enums.h"
+#include "ndn-lite/ndn-error-code.h"
+#include "ndn-lite/util/uniform-time.h"
+
+/**
+ * Owned by the PIT entry of the Interest, and freed by its on_data or
+ * on_timeout, which still comes after a Nack.
+ */
+typedef struct ndn_nack_pending {
+  // Index in nack_pending, or -1 once Nacked
+  int slot;
+  bool nacked;
+  bool has_nonce;
+  uint32_t nonce;
+  uint64_t name_hash;
+  ndn_on_data_func on_data;
+  ndn_on_timeout_func on_timeout;
+  ndn_on_nack_func on_nack;
+  void* userdata;
+} ndn_nack_pending_t;
+
+typedef struct ndn_nack_downstream {
+  ndn_face_intf_t* face;
+  bool has_nonce;
+  uint32_t nonce;
+  uint64_t name_hash;
+  ndn_time_ms_t expire_at;
+} ndn_nack_downstream_t;
+
+// Interests that may still be Nacked
+static ndn_nack_pending_t* nack_pending[NDN_NACK_PENDING_SIZE];
+static ndn_nack_downstream_t nack_downstream[NDN_NACK_DOWNSTREAM_SIZE];
+static uint32_t nack_downstream_cursor = 0;
+static uint64_t nack_downstream_overflows = 0;
+
+static void
+ndn_nack_on_data(const uint8_t* data, uint32_t data_size, void* userdata);
+
+static void
+ndn_nack_on_timeout(void* userdata);
+
+static void
+ndn_nack_release(ndn_nack_pending_t* entry);
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+static void
+ndn_nack_release(ndn_nack_pending_t* entry){
+  if(entry->slot >= 0){
+    nack_pending[entry->slot] = NULL;
+  }
+  free(entry);
+}
+
+static void
+ndn_nack_on_data(const uint8_t* data, uint32_t data_size, void* userdata){
+  ndn_nack_pending_t* entry = (ndn_nack_pending_t*)userdata;
+  ndn_on_data_func on_data = entry->nacked ? NULL : entry->on_data;
+  void* app_userdata = entry->userdata;
+
+  // Released first: the callback may express the next Interest
+  ndn_nack_release(entry);
+  if(on_data != NULL){
+    on_data(data, data_size, app_userdata);
+  }
+}
+
+static void
+ndn_nack_on_timeout(void* userdata){
+  ndn_nack_pending_t* entry = (ndn_nack_pending_t*)userdata;
+  ndn_on_timeout_func on_timeout = entry->nacked ? NULL : entry->on_timeout;
+  void* app_userdata = entry->userdata;
+
+  // The PIT entry outlives a Nack; its timeout then only frees the record
+  ndn_nack_release(entry);
+  if(on_timeout != NULL){
+    on_timeout(app_userdata);
+  }
+}
+
+int
+ndn_nack_express_interest(uint8_t* interest, size_t length,
+                          ndn_on_data_func on_data, ndn_on_timeout_func on_timeout,
+                          ndn_on_nack_func on_nack, void* userdata)
+{
+  ndn_nack_pending_t* entry;
+  ndn_pkt_peek_t peek;
+  int i, ret;
+
+  if(ndn_pkt_peek(interest, length, &peek) != NDN_SUCCESS || peek.type != TLV_Interest){
+    return ndn_forwarder_express_interest(interest, length, on_data, on_timeout, userdata);
+  }
+  for(i = 0; i < NDN_NACK_PENDING_SIZE; i ++){
+    if(nack_pending[i] == NULL){
+      break;
+    }
+  }
+  if(i == NDN_NACK_PENDING_SIZE){
+    return NDN_FWD_NO_MEM;
+  }
+  entry = (ndn_nack_pending_t*)malloc(sizeof(ndn_nack_pending_t));
+  if(entry == NULL){
+    return NDN_FWD_NO_MEM;
+  }
+
+  entry->slot = i;
+  entry->nacked = false;
+  entry->has_nonce = peek.has_nonce;
+  entry->nonce = peek.nonce;
+  entry->name_hash = ndn_pkt_name_hash(peek.name, peek.name_size);
+  entry->on_data = on_data;
+  entry->on_timeout = on_timeout;
+  entry->on_nack = on_nack;
+  entry->userdata = userdata;
+  nack_pending[i] = entry;
+  ret = ndn_forwarder_express_interest(interest, length, ndn_nack_on_data, ndn_nack_on_timeout, entry);
+  if(ret != NDN_SUCCESS){
+    ndn_nack_release(entry);
+  }
+  return ret;
+}
+
+int
+ndn_nack_express_interest_struct(ndn_interest_t* interest,
+                                 ndn_on_data_func on_data, ndn_on_timeout_func on_timeout,
+                                 ndn_on_nack_func on_nack, void* userdata)
+{
+  uint8_t buf[NDN_NACK_INTEREST_SIZE];
+  ndn_encoder_t encoder;
+  int ret;
+
+  encoder_init(&encoder, buf, sizeof(buf));
+  ret = ndn_interest_tlv_encode(&encoder, interest);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  return ndn_nack_express_interest(buf, encoder.offset, on_data, on_timeout, on_nack, userdata);
+}
+
+void
+ndn_nack_deliver(const ndn_pkt_peek_t* interest, uint32_t reason){
+  ndn_nack_pending_t* entry;
+  uint64_t name_hash;
+  int i;
+
+  if(interest->type != TLV_Interest){
+    return;
+  }
+  name_hash = ndn_pkt_name_hash(interest->name, interest->name_size);
+  for(i = 0; i < NDN_NACK_PENDING_SIZE; i ++){
+    entry = nack_pending[i];
+    if(entry == NULL || entry->name_hash != name_hash){
+      continue;
+    }
+    if(entry->has_nonce && interest->has_nonce && entry->nonce != interest->nonce){
+      continue;
+    }
+    // The slot is free for the next Interest; the PIT entry frees the record
+    nack_pending[i] = NULL;
+    entry->slot = -1;
+    entry->nacked = true;
+    if(entry->on_nack != NULL){
+      entry->on_nack(reason, entry->userdata);
+    }
+  }
+}
+
+void
+ndn_nack_record_downstream(ndn_face_intf_t* face, const ndn_pkt_peek_t* interest){
+  ndn_nack_downstream_t* entry;
+  ndn_time_ms_t now;
+  uint32_t i;
+
+  if(interest->type != TLV_Interest){
+    return;
+  }
+  // A free or expired record is taken first, starting from the oldest
+  now = ndn_time_now_ms();
+  for(i = 0; i < NDN_NACK_DOWNSTREAM_SIZE; i ++){
+    entry = &nack_downstream[(nack_downstream_cursor + i) % NDN_NACK_DOWNSTREAM_SIZE];
+    if(entry->face == NULL || entry->expire_at <= now){
+      break;
+    }
+  }
+  if(i == NDN_NACK_DOWNSTREAM_SIZE){
+    // Overwrites the oldest record; its Interest is then left to time out
+    i = 0;
+    nack_downstream_overflows ++;
+  }
+  entry = &nack_downstream[(nack_downstream_cursor + i) % NDN_NACK_DOWNSTREAM_SIZE];
+  nack_downstream_cursor = (nack_downstream_cursor + i + 1) % NDN_NACK_DOWNSTREAM_SIZE;
+  entry->face = face;
+  entry->has_nonce = interest->has_nonce;
+  entry->nonce = interest->nonce;
+  entry->name_hash = ndn_pkt_name_hash(interest->name, interest->name_size);
+  entry->expire_at = now + interest->lifetime;
+}
+
+uint64_t
+ndn_nack_get_downstream_overflows(void){
+  return nack_downstream_overflows;
+}
+
+void
+ndn_nack_return(const ndn_pkt_peek_t* interest, uint32_t reason, ndn_face_intf_t* upstream){
+  ndn_nack_downstream_t* entry;
+  ndn_face_intf_t* face;
+  ndn_time_ms_t now;
+  uint64_t name_hash;
+  int i;
+
+  if(interest->type != TLV_Interest){
+    return;
+  }
+  name_hash = ndn_pkt_name_hash(interest->name, interest->name_size);
+  now = ndn_time_now_ms();
+  for(i = 0; i < NDN_NACK_DOWNSTREAM_SIZE; i ++){
+    entry = &nack_downstream[i];
+    if(entry->face == NULL || entry->name_hash != name_hash){
+      continue;
+    }
+    if(entry->expire_at <= now){
+      entry->face = NULL;
+      continue;
+    }
+    if(entry->has_nonce && interest->has_nonce && entry->nonce != interest->nonce){
+      continue;
+    }
+    // Cleared first: the send may reach the ingress again
+    face = entry->face;
+    entry->face = NULL;
+    if(face != upstream){
+      ndn_nack_send(face, interest->packet, interest->packet_size, reason);
+    }
+  }
+  ndn_nack_deliver(interest, reason);
+}
+
+void
+ndn_nack_forget_face(ndn_face_intf_t* face){
+  int i;
+
+  for(i = 0; i < NDN_NACK_DOWNSTREAM_SIZE; i ++){
+    if(nack_downstream[i].face == face){
+      nack_downstream[i].face = NULL;
+    }
+  }
+}
+
+int
+ndn_nack_send(ndn_face_intf_t* face, const uint8_t* interest, uint32_t size, uint32_t reason){
+  uint8_t buf[NDN_LP_HEADER_MAX_SIZE + NDN_NACK_INTEREST_SIZE];
+  uint32_t offset;
+
+  if(size > NDN_NACK_INTEREST_SIZE){
+    return NDN_OVERSIZE;
+  }
+  offset = ndn_pkt_write_lp_nack(buf, size, reason);
+  memcpy(buf + offset, interest, size);
+  return ndn_face_send(face, buf, offset + size);
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#ifndef NDN_NACK_H_
+#define NDN_NACK_H_
+
+#include "ndn-lite/forwarder/forwarder.h"
+#include "pkt-peek.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * NDNLPv2 NackReason values.
+ */
+#define NDN_NACK_NONE 0
+#define NDN_NACK_CONGESTION 50
+#define NDN_NACK_DUPLICATE 100
+#define NDN_NACK_NO_ROUTE 150
+
+// Outstanding Interests expressed with an on_nack callback
+#define NDN_NACK_PENDING_SIZE 64
+// Largest Interest that can be Nacked or encoded from a struct
+#define NDN_NACK_INTEREST_SIZE 1024
+// Interests received from other nodes, remembered to return their Nacks
+#define NDN_NACK_DOWNSTREAM_SIZE 64
+
+typedef void (*ndn_on_nack_func)(uint32_t reason, void* userdata);
+
+/**
+ * Express an Interest like ndn_forwarder_express_interest, and get
+ * on_nack instead of waiting for the lifetime if it is rejected.
+ * After on_nack, neither on_data nor on_timeout is called.
+ * A Nacked Interest no longer counts against NDN_NACK_PENDING_SIZE.
+ * @return NDN_FWD_NO_MEM if NDN_NACK_PENDING_SIZE Interests with on_nack
+ *         are outstanding; the Interest is then not expressed.
+ */
+int
+ndn_nack_express_interest(uint8_t* interest, size_t length,
+                          ndn_on_data_func on_data, ndn_on_timeout_func on_timeout,
+                          ndn_on_nack_func on_nack, void* userdata);
+
+int
+ndn_nack_express_interest_struct(ndn_interest_t* interest,
+                                 ndn_on_data_func on_data, ndn_on_timeout_func on_timeout,
+                                 ndn_on_nack_func on_nack, void* userdata);
+
+/**
+ * Reject an Interest expressed in this process.
+ * Does nothing if it was not expressed with an on_nack callback.
+ */
+void
+ndn_nack_deliver(const ndn_pkt_peek_t* interest, uint32_t reason);
+
+/**
+ * Remember the face an Interest came from, so that ndn_nack_return can send
+ * a Nack for it back there. Called by the ingress for every Interest.
+ */
+void
+ndn_nack_record_downstream(ndn_face_intf_t* face, const ndn_pkt_peek_t* interest);
+
+/**
+ * Number of received Interests forgotten before they expired because
+ * NDN_NACK_DOWNSTREAM_SIZE others were recorded since. They time out
+ * downstream instead of being Nacked.
+ */
+uint64_t
+ndn_nack_get_downstream_overflows(void);
+
+/**
+ * Reject an Interest: deliver the Nack to the local consumer, if any, and
+ * send it to every face the Interest was received from, except @p upstream.
+ * A downstream Interest with another Nonce, aggregated with this one, is
+ * left to time out.
+ * @param interest Peek of the Interest itself, without NDNLPv2 header.
+ * @param upstream Face the Nack came from, or NULL.
+ */
+void
+ndn_nack_return(const ndn_pkt_peek_t* interest, uint32_t reason, ndn_face_intf_t* upstream);
+
+/**
+ * Forget the Interests received from a face. Called when it is destroyed.
+ */
+void
+ndn_nack_forget_face(ndn_face_intf_t* face);
+
+/**
+ * Send a Nack for an Interest back to the face it came from.
+ */
+int
+ndn_nack_send(ndn_face_intf_t* face, const uint8_t* interest, uint32_t size, uint32_t reason);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,450 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "name-kernels.h"
+#include "pkt-peek.h"
+#include "ndn-lite/ndn-enums.h"
+#include "ndn-lite/ndn-error-code.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define NAME_KERNELS_X86
+#endif
+#if defined(__ARM_FEATURE_CRC32) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#include <arm_acle.h>
+#define NAME_KERNELS_ARM_CRC
+#endif
+
+// Reflected CRC32C (Castagnoli) polynomial, as computed by SSE4.2 and ARMv8
+#define CRC32C_POLY 0x82F63B78u
+#define HASH_SEED_A 0xFFFFFFFFu
+#define HASH_SEED_B 0x9E3779B9u
+// Room for the Name TLV type and length, moved down when shorter
+#define URI_HEADER_MAX_SIZE 6
+
+typedef uint64_t (*name_hash_func)(const uint8_t* buf, uint32_t size);
+typedef uint32_t (*name_mismatch_func)(const uint8_t* a, const uint8_t* b, uint32_t size);
+typedef const uint8_t* (*name_find_func)(const uint8_t* pos, const uint8_t* end);
+
+typedef struct name_kernels {
+  int level;
+  name_hash_func hash;
+  name_mismatch_func mismatch;
+  /**
+   * Find the next '/' or '%' of a URI, or @c end.
+   */
+  name_find_func find_special;
+} name_kernels_t;
+
+static uint32_t crc32c_table[256];
+static name_kernels_t kernels;
+
+static uint64_t
+hash_scalar(const uint8_t* buf, uint32_t size);
+
+static uint32_t
+mismatch_scalar(const uint8_t* a, const uint8_t* b, uint32_t size);
+
+static const uint8_t*
+find_special_scalar(const uint8_t* pos, const uint8_t* end);
+
+static int
+name_kernels_best_level(void);
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+static inline uint32_t
+crc32c_byte(uint32_t crc, uint8_t value){
+  return (crc >> 8) ^ crc32c_table[(crc ^ value) & 0xFF];
+}
+
+/*
+ * The hash runs two CRC32C streams so they overlap in the pipeline:
+ * 16-byte blocks feed their first word to A and second to B, a remaining
+ * word goes to A, and remaining bytes go to B. Every level must follow this.
+ */
+static uint64_t
+hash_scalar(const uint8_t* buf, uint32_t size){
+  uint32_t a = HASH_SEED_A, b = HASH_SEED_B, i, j;
+
+  for(i = 0; i + 16 <= size; i += 16){
+    for(j = 0; j < 8; j ++){
+      a = crc32c_byte(a, buf[i + j]);
+      b = crc32c_byte(b, buf[i + 8 + j]);
+    }
+  }
+  if(i + 8 <= size){
+    for(j = 0; j < 8; j ++){
+      a = crc32c_byte(a, buf[i + j]);
+    }
+    i += 8;
+  }
+  for(; i < size; i ++){
+    b = crc32c_byte(b, buf[i]);
+  }
+  return ((uint64_t)~a << 32) | (uint32_t)~b;
+}
+
+static uint32_t
+mismatch_scalar(const uint8_t* a, const uint8_t* b, uint32_t size){
+  uint64_t wa, wb;
+  uint32_t i;
+
+  for(i = 0; i + 8 <= size; i += 8){
+    memcpy(&wa, a + i, 8);
+    memcpy(&wb, b + i, 8);
+    if(wa != wb){
+      break;
+    }
+  }
+  for(; i < size; i ++){
+    if(a[i] != b[i]){
+      return i;
+    }
+  }
+  return size;
+}
+
+static const uint8_t*
+find_special_scalar(const uint8_t* pos, const uint8_t* end){
+  while(pos < end && *pos != '/' && *pos != '%'){
+    pos ++;
+  }
+  return pos;
+}
+
+#ifdef NAME_KERNELS_ARM_CRC
+static uint64_t
+hash_arm(const uint8_t* buf, uint32_t size){
+  uint32_t a = HASH_SEED_A, b = HASH_SEED_B, i;
+  uint64_t w0, w1;
+
+  for(i = 0; i + 16 <= size; i += 16){
+    memcpy(&w0, buf + i, 8);
+    memcpy(&w1, buf + i + 8, 8);
+    a = __crc32cd(a, w0);
+    b = __crc32cd(b, w1);
+  }
+  if(i + 8 <= size){
+    memcpy(&w0, buf + i, 8);
+    a = __crc32cd(a, w0);
+    i += 8;
+  }
+  for(; i < size; i ++){
+    b = __crc32cb(b, buf[i]);
+  }
+  return ((uint64_t)~a << 32) | (uint32_t)~b;
+}
+#endif
+
+#ifdef NAME_KERNELS_X86
+__attribute__((target("sse4.2")))
+static uint64_t
+hash_sse42(const uint8_t* buf, uint32_t size){
+  uint64_t a = HASH_SEED_A, b = HASH_SEED_B, w0, w1;
+  uint32_t i;
+
+  for(i = 0; i + 16 <= size; i += 16){
+    memcpy(&w0, buf + i, 8);
+    memcpy(&w1, buf + i + 8, 8);
+    a = _mm_crc32_u64(a, w0);
+    b = _mm_crc32_u64(b, w1);
+  }
+  if(i + 8 <= size){
+    memcpy(&w0, buf + i, 8);
+    a = _mm_crc32_u64(a, w0);
+    i += 8;
+  }
+  for(; i < size; i ++){
+    b = _mm_crc32_u8((uint32_t)b, buf[i]);
+  }
+  return ((uint64_t)~(uint32_t)a << 32) | (uint32_t)~(uint32_t)b;
+}
+
+__attribute__((target("sse4.2")))
+static uint32_t
+mismatch_sse42(const uint8_t* a, const uint8_t* b, uint32_t size){
+  __m128i va, vb;
+  uint32_t i, mask;
+
+  for(i = 0; i + 16 <= size; i += 16){
+    va = _mm_loadu_si128((const __m128i*)(a + i));
+    vb = _mm_loadu_si128((const __m128i*)(b + i));
+    mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) ^ 0xFFFF;
+    if(mask != 0){
+      return i + (uint32_t)__builtin_ctz(mask);
+    }
+  }
+  return i + mismatch_scalar(a + i, b + i, size - i);
+}
+
+__attribute__((target("sse4.2")))
+static const uint8_t*
+find_special_sse42(const uint8_t* pos, const uint8_t* end){
+  const __m128i slash = _mm_set1_epi8('/');
+  const __m128i percent = _mm_set1_epi8('%');
+  __m128i v;
+  uint32_t mask;
+
+  for(; end - pos >= 16; pos += 16){
+    v = _mm_loadu_si128((const __m128i*)pos);
+    mask = (uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, slash),
+                                                    _mm_cmpeq_epi8(v, percent)));
+    if(mask != 0){
+      return pos + __builtin_ctz(mask);
+    }
+  }
+  return find_special_scalar(pos, end);
+}
+
+__attribute__((target("avx2")))
+static uint32_t
+mismatch_avx2(const uint8_t* a, const uint8_t* b, uint32_t size){
+  __m256i va, vb;
+  uint32_t i, mask;
+
+  for(i = 0; i + 32 <= size; i += 32){
+    va = _mm256_loadu_si256((const __m256i*)(a + i));
+    vb = _mm256_loadu_si256((const __m256i*)(b + i));
+    mask = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb));
+    if(mask != 0){
+      return i + (uint32_t)__builtin_ctz(mask);
+    }
+  }
+  // Stay in VEX encoding; calling the SSE kernel here would stall on the transition
+  if(i + 16 <= size){
+    mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(a + i)),
+                                                      _mm_loadu_si128((const __m128i*)(b + i)))) ^ 0xFFFF;
+    if(mask != 0){
+      return i + (uint32_t)__builtin_ctz(mask);
+    }
+    i += 16;
+  }
+  return i + mismatch_scalar(a + i, b + i, size - i);
+}
+
+__attribute__((target("avx2")))
+static const uint8_t*
+find_special_avx2(const uint8_t* pos, const uint8_t* end){
+  const __m256i slash = _mm256_set1_epi8('/');
+  const __m256i percent = _mm256_set1_epi8('%');
+  __m256i v;
+  uint32_t mask;
+
+  for(; end - pos >= 32; pos += 32){
+    v = _mm256_loadu_si256((const __m256i*)pos);
+    mask = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, slash),
+                                                          _mm256_cmpeq_epi8(v, percent)));
+    if(mask != 0){
+      return pos + __builtin_ctz(mask);
+    }
+  }
+  return find_special_scalar(pos, end);
+}
+#endif
+
+static int
+name_kernels_best_level(void){
+#ifdef NAME_KERNELS_X86
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("sse4.2")){
+    return NDN_NAME_KERNELS_AVX2;
+  }
+  if(__builtin_cpu_supports("sse4.2")){
+    return NDN_NAME_KERNELS_SSE42;
+  }
+#endif
+  return NDN_NAME_KERNELS_SCALAR;
+}
+
+int
+ndn_name_kernels_select(int level){
+  int best = name_kernels_best_level();
+
+  if(level > best){
+    level = best;
+  }
+  kernels.level = NDN_NAME_KERNELS_SCALAR;
+  kernels.hash = hash_scalar;
+#ifdef NAME_KERNELS_ARM_CRC
+  // Part of the base ISA when the compiler targets it
+  kernels.hash = hash_arm;
+#endif
+  kernels.mismatch = mismatch_scalar;
+  kernels.find_special = find_special_scalar;
+#ifdef NAME_KERNELS_X86
+  if(level >= NDN_NAME_KERNELS_SSE42){
+    kernels.level = NDN_NAME_KERNELS_SSE42;
+    kernels.hash = hash_sse42;
+    kernels.mismatch = mismatch_sse42;
+    kernels.find_special = find_special_sse42;
+  }
+  if(level >= NDN_NAME_KERNELS_AVX2){
+    // CRC32C has no wider form; AVX2 only widens the byte scans
+    kernels.level = NDN_NAME_KERNELS_AVX2;
+    kernels.mismatch = mismatch_avx2;
+    kernels.find_special = find_special_avx2;
+  }
+#endif
+  return kernels.level;
+}
+
+__attribute__((constructor))
+static void
+name_kernels_init(void){
+  uint32_t i, j, crc;
+
+  for(i = 0; i < 256; i ++){
+    crc = i;
+    for(j = 0; j < 8; j ++){
+      crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLY : 0);
+    }
+    crc32c_table[i] = crc;
+  }
+  ndn_name_kernels_select(NDN_NAME_KERNELS_AVX2);
+}
+
+int
+ndn_name_kernels_get_level(void){
+  return kernels.level;
+}
+
+uint64_t
+ndn_name_kernels_hash(const uint8_t* buf, uint32_t size){
+  return kernels.hash(buf, size);
+}
+
+uint32_t
+ndn_name_kernels_mismatch(const uint8_t* a, const uint8_t* b, uint32_t size){
+  return kernels.mismatch(a, b, size);
+}
+
+int
+ndn_name_kernels_common_prefix(const uint8_t* a, uint32_t a_size, const uint8_t* b, uint32_t b_size){
+  const uint8_t *aval, *bval, *ptr, *val, *end;
+  uint32_t type, alen, blen, length, same;
+  int count = 0;
+
+  aval = ndn_pkt_read_tl(a, a + a_size, &type, &alen);
+  bval = ndn_pkt_read_tl(b, b + b_size, &type, &blen);
+  if(aval == NULL || bval == NULL){
+    return NDN_WRONG_TLV_LENGTH;
+  }
+  // Components are self-delimiting, so every component ending within the
+  // equal bytes is a common one
+  same = kernels.mismatch(aval, bval, (alen < blen) ? alen : blen);
+  end = aval + same;
+  for(ptr = aval; ptr < end; ptr = val + length){
+    val = ndn_pkt_read_tl(ptr, aval + alen, &type, &length);
+    if(val == NULL){
+      return NDN_WRONG_TLV_LENGTH;
+    }
+    if(val + length > end){
+      break;
+    }
+    count ++;
+  }
+  return count;
+}
+
+static inline int
+uri_hex(uint8_t c){
+  if(c >= '0' && c <= '9'){
+    return c - '0';
+  }
+  c |= 0x20;
+  if(c >= 'a' && c <= 'f'){
+    return c - 'a' + 10;
+  }
+  return -1;
+}
+
+int
+ndn_name_kernels_parse_uri(const char* uri, uint32_t length, uint8_t* buf, uint32_t size,
+                           uint32_t* used){
+  const uint8_t *pos = (const uint8_t*)uri, *end = pos + length, *run;
+  uint8_t *out, *val, *limit = buf + size;
+  uint32_t vlen, n, inner, header;
+  uint8_t head[URI_HEADER_MAX_SIZE];
+  int hi, lo;
+
+  if(size < URI_HEADER_MAX_SIZE){
+    return NDN_OVERSIZE;
+  }
+  if(length >= 4 && memcmp(pos, "ndn:", 4) == 0){
+    pos += 4;
+  }
+
+  out = buf + URI_HEADER_MAX_SIZE;
+  while(pos < end){
+    if(*pos == '/'){
+      pos ++;
+      continue;
+    }
+    // Reserve a one-byte length; widen it once the value is known
+    val = out + 2;
+    vlen = 0;
+    while(pos < end && *pos != '/'){
+      run = kernels.find_special(pos, end);
+      n = (uint32_t)(run - pos);
+      if(val + vlen + n + 2 > limit){
+        return NDN_OVERSIZE;
+      }
+      memcpy(val + vlen, pos, n);
+      vlen += n;
+      pos = run;
+      if(pos < end && *pos == '%'){
+        hi = (end - pos >= 3) ? uri_hex(pos[1]) : -1;
+        lo = (end - pos >= 3) ? uri_hex(pos[2]) : -1;
+        if(hi < 0 || lo < 0){
+          return NDN_NAME_URI_ERROR;
+        }
+        if(val + vlen + 1 + 2 > limit){
+          return NDN_OVERSIZE;
+        }
+        val[vlen ++] = (uint8_t)((hi << 4) | lo);
+        pos += 3;
+      }
+    }
+    if(vlen > 0xFFFF){
+      return NDN_OVERSIZE;
+    }
+    out[0] = TLV_GenericNameComponent;
+    if(vlen < 253){
+      out[1] = (uint8_t)vlen;
+    }else{
+      memmove(val + 2, val, vlen);
+      ndn_pkt_write_var(out + 1, vlen);
+      val += 2;
+    }
+    out = val + vlen;
+  }
+
+  inner = (uint32_t)(out - buf - URI_HEADER_MAX_SIZE);
+  header = ndn_pkt_write_var(head, TLV_Name);
+  header += ndn_pkt_write_var(head + header, inner);
+  memmove(buf + header, buf + URI_HEADER_MAX_SIZE, inner);
+  memcpy(buf, head, header);
+  *used = header + inner;
+  return NDN_SUCCESS;
+}
+
+int
+ndn_name_kernels_from_uri(ndn_name_t* name, const char* uri, uint32_t length){
+  uint8_t wire[NDN_NAME_KERNELS_URI_BUFFER_SIZE];
+  uint32_t used;
+  int ret;
+
+  ret = ndn_name_kernels_parse_uri(uri, length, wire, sizeof(wire), &used);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  return ndn_name_from_block(name, wire, used);
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#ifndef NDN_NAME_KERNELS_H_
+#define NDN_NAME_KERNELS_H_
+
+#include <stdint.h>
+#include "ndn-lite/encode/name.h"
+#include "../adapt-consts.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Instruction sets of the name kernels.
+ * The best one supported by the CPU is selected at startup.
+ */
+#define NDN_NAME_KERNELS_SCALAR 0
+#define NDN_NAME_KERNELS_SSE42 1
+#define NDN_NAME_KERNELS_AVX2 2
+
+// Large enough for any name ndn_name_t can hold
+#define NDN_NAME_KERNELS_URI_BUFFER_SIZE 512
+
+/**
+ * Select the kernels, e.g. to compare them.
+ * @return The level in use, which is lower than @p level if the CPU lacks it.
+ */
+int
+ndn_name_kernels_select(int level);
+
+int
+ndn_name_kernels_get_level(void);
+
+/**
+ * Hash name bytes with two interleaved CRC32C streams.
+ * All levels give the same result, so hashes may be stored.
+ */
+uint64_t
+ndn_name_kernels_hash(const uint8_t* buf, uint32_t size);
+
+/**
+ * @return Offset of the first differing byte, or @p size if equal.
+ */
+uint32_t
+ndn_name_kernels_mismatch(const uint8_t* a, const uint8_t* b, uint32_t size);
+
+/**
+ * Number of leading components two Name TLVs have in common.
+ * @return The count, or NDN_WRONG_TLV_LENGTH if a name is malformed.
+ */
+int
+ndn_name_kernels_common_prefix(const uint8_t* a, uint32_t a_size, const uint8_t* b, uint32_t b_size);
+
+/**
+ * Encode a URI such as "/ndn/edu/a%2Fb" into a Name TLV.
+ * An "ndn:" scheme and empty components are skipped; all components are
+ * generic and percent-encoded bytes are decoded.
+ * @param[out] used The size of the Name TLV.
+ * @return NDN_SUCCESS, NDN_OVERSIZE, or NDN_NAME_URI_ERROR for a bad escape.
+ */
+int
+ndn_name_kernels_parse_uri(const char* uri, uint32_t length, uint8_t* buf, uint32_t size,
+                           uint32_t* used);
+
+/**
+ * ndn_name_from_string through ndn_name_kernels_parse_uri.
+ */
+int
+ndn_name_kernels_from_uri(ndn_name_t* name, const char* uri, uint32_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,329 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "pkt-peek.h"
+#include "name-kernels.h"
+#include "ndn-lite/ndn-enums.h"
+#include "ndn-lite/ndn-error-code.h"
+
+// Interest elements kept by ndn_pkt_peek
+enum {
+  PEEK_CAN_BE_PREFIX,
+  PEEK_NONCE,
+  PEEK_LIFETIME,
+  PEEK_PARAMETERS,
+  PEEK_ELEMS
+};
+
+static const uint8_t peek_slots[NDN_PKT_SCAN_TYPES] = {
+  [TLV_CanBePrefix] = PEEK_CAN_BE_PREFIX + 1,
+  [TLV_Nonce] = PEEK_NONCE + 1,
+  [TLV_InterestLifetime] = PEEK_LIFETIME + 1,
+  // Everything after parameters is signed portion
+  [TLV_ApplicationParameters] = PEEK_PARAMETERS + 1,
+};
+
+const uint8_t*
+ndn_pkt_read_var(const uint8_t* buf, const uint8_t* end, uint64_t* value){
+  uint32_t first, len;
+
+  if(buf >= end){
+    return NULL;
+  }
+  first = *buf;
+  if(first < 253){
+    *value = first;
+    return buf + 1;
+  }
+  // 253, 254 and 255 are followed by 2, 4 and 8 bytes
+  len = 2u << (first - 253);
+  if((uint64_t)(end - buf) <= len){
+    return NULL;
+  }
+  if(first == 253){
+    *value = ndn_pkt_load_be16(buf + 1);
+  }else if(first == 254){
+    *value = ndn_pkt_load_be32(buf + 1);
+  }else{
+    *value = ndn_pkt_load_be64(buf + 1);
+  }
+  return buf + 1 + len;
+}
+
+const uint8_t*
+ndn_pkt_read_tl(const uint8_t* buf, const uint8_t* end, uint32_t* type, uint32_t* length){
+  uint64_t t, l;
+
+  // Every Interest and Data field but a large Content has one-byte type and length
+  if(end - buf >= 2 && buf[0] < 253 && buf[1] < 253){
+    if(buf[1] > end - buf - 2){
+      return NULL;
+    }
+    *type = buf[0];
+    *length = buf[1];
+    return buf + 2;
+  }
+  buf = ndn_pkt_read_var(buf, end, &t);
+  if(buf == NULL){
+    return NULL;
+  }
+  buf = ndn_pkt_read_var(buf, end, &l);
+  if(buf == NULL || l > (uint64_t)(end - buf)){
+    return NULL;
+  }
+  *type = (uint32_t)t;
+  *length = (uint32_t)l;
+  return buf;
+}
+
+bool
+ndn_pkt_read_uint(const uint8_t* value, uint32_t size, uint64_t* result){
+  switch(size){
+    case 1:
+      *result = value[0];
+      return true;
+    case 2:
+      *result = ndn_pkt_load_be16(value);
+      return true;
+    case 4:
+      *result = ndn_pkt_load_be32(value);
+      return true;
+    case 8:
+      *result = ndn_pkt_load_be64(value);
+      return true;
+  }
+  return false;
+}
+
+int
+ndn_pkt_scan(const uint8_t* buf, const uint8_t* end, const uint8_t* slots, uint8_t stop,
+             ndn_pkt_elem_t* elems){
+  const uint8_t* val;
+  uint32_t type, length, slot;
+
+  for(; buf < end; buf = val + length){
+    val = ndn_pkt_read_tl(buf, end, &type, &length);
+    if(val == NULL){
+      return NDN_WRONG_TLV_LENGTH;
+    }
+    slot = (type < NDN_PKT_SCAN_TYPES) ? slots[type] : 0;
+    if(slot == 0){
+      continue;
+    }
+    elems[slot - 1].value = val;
+    elems[slot - 1].size = length;
+    if(slot == stop){
+      break;
+    }
+  }
+  return NDN_SUCCESS;
+}
+
+uint32_t
+ndn_pkt_write_var(uint8_t* buf, uint64_t value){
+  if(value < 253){
+    buf[0] = (uint8_t)value;
+    return 1;
+  }
+  if(value <= 0xFFFF){
+    buf[0] = 253;
+    ndn_pkt_store_be16(buf + 1, (uint16_t)value);
+    return 3;
+  }
+  if(value <= 0xFFFFFFFFu){
+    buf[0] = 254;
+    ndn_pkt_store_be32(buf + 1, (uint32_t)value);
+    return 5;
+  }
+  buf[0] = 255;
+  ndn_pkt_store_be64(buf + 1, value);
+  return 9;
+}
+
+uint32_t
+ndn_pkt_write_uint(uint8_t* buf, uint32_t type, uint64_t value){
+  uint32_t ret;
+
+  ret = ndn_pkt_write_var(buf, type);
+  // Non-negative integers are 1, 2, 4 or 8 bytes long
+  if(value <= 0xFF){
+    buf[ret] = 1;
+    buf[ret + 1] = (uint8_t)value;
+    return ret + 2;
+  }
+  if(value <= 0xFFFF){
+    buf[ret] = 2;
+    ndn_pkt_store_be16(buf + ret + 1, (uint16_t)value);
+    return ret + 3;
+  }
+  if(value <= 0xFFFFFFFFu){
+    buf[ret] = 4;
+    ndn_pkt_store_be32(buf + ret + 1, (uint32_t)value);
+    return ret + 5;
+  }
+  buf[ret] = 8;
+  ndn_pkt_store_be64(buf + ret + 1, value);
+  return ret + 9;
+}
+
+static uint32_t
+ndn_pkt_write_lp(uint8_t* buf, uint32_t fragment_size, uint64_t congestion_mark, bool nack, uint32_t reason){
+  uint8_t fields[NDN_LP_HEADER_MAX_SIZE];
+  uint8_t nack_fields[8];
+  uint32_t fields_size = 0, nack_size, ret;
+
+  if(nack){
+    nack_size = ndn_pkt_write_uint(nack_fields, NDN_LP_NACK_REASON, reason);
+    fields_size += ndn_pkt_write_var(fields + fields_size, NDN_LP_NACK);
+    fields_size += ndn_pkt_write_var(fields + fields_size, nack_size);
+    memcpy(fields + fields_size, nack_fields, nack_size);
+    fields_size += nack_size;
+  }
+  if(congestion_mark != 0){
+    fields_size += ndn_pkt_write_uint(fields + fields_size, NDN_LP_CONGESTION_MARK, congestion_mark);
+  }
+  fields_size += ndn_pkt_write_var(fields + fields_size, NDN_LP_FRAGMENT);
+  fields_size += ndn_pkt_write_var(fields + fields_size, fragment_size);
+
+  ret = ndn_pkt_write_var(buf, NDN_LP_PACKET);
+  ret += ndn_pkt_write_var(buf + ret, fields_size + fragment_size);
+  memcpy(buf + ret, fields, fields_size);
+  return ret + fields_size;
+}
+
+uint32_t
+ndn_pkt_write_lp_header(uint8_t* buf, uint32_t fragment_size, uint64_t congestion_mark){
+  return ndn_pkt_write_lp(buf, fragment_size, congestion_mark, false, 0);
+}
+
+uint32_t
+ndn_pkt_write_lp_nack(uint8_t* buf, uint32_t fragment_size, uint32_t reason){
+  return ndn_pkt_write_lp(buf, fragment_size, 0, true, reason);
+}
+
+int
+ndn_pkt_peek(const uint8_t* packet, uint32_t size, ndn_pkt_peek_t* peek){
+  const uint8_t *ptr, *val, *end, *reason;
+  uint32_t type, length, nack_length;
+  ndn_pkt_elem_t elems[PEEK_ELEMS];
+  uint64_t num;
+  int ret;
+
+  peek->packet = packet;
+  peek->packet_size = size;
+  peek->congestion_mark = 0;
+  peek->is_nack = false;
+  peek->nack_reason = 0;
+  peek->name = NULL;
+  peek->name_size = 0;
+  peek->can_be_prefix = false;
+  peek->has_nonce = false;
+  peek->nonce = 0;
+  peek->lifetime = NDN_PKT_PEEK_DEFAULT_LIFETIME;
+
+  ptr = ndn_pkt_read_tl(packet, packet + size, &peek->type, &length);
+  if(ptr == NULL){
+    return NDN_WRONG_TLV_LENGTH;
+  }
+  if(peek->type == NDN_LP_PACKET){
+    // Unknown header fields are ignored; no fragmentation support
+    peek->packet = NULL;
+    end = ptr + length;
+    for(; ptr < end; ptr = val + length){
+      val = ndn_pkt_read_tl(ptr, end, &type, &length);
+      if(val == NULL){
+        return NDN_WRONG_TLV_LENGTH;
+      }
+      if(type == NDN_LP_CONGESTION_MARK && ndn_pkt_read_uint(val, length, &num)){
+        peek->congestion_mark = num;
+      }else if(type == NDN_LP_NACK){
+        peek->is_nack = true;
+        // NackReason is optional; a missing one means None (0)
+        reason = ndn_pkt_read_tl(val, val + length, &type, &nack_length);
+        if(reason != NULL && type == NDN_LP_NACK_REASON &&
+           ndn_pkt_read_uint(reason, nack_length, &num) && num <= 0xFFFFFFFFu){
+          peek->nack_reason = (uint32_t)num;
+        }
+      }else if(type == NDN_LP_FRAGMENT){
+        peek->packet = val;
+        peek->packet_size = length;
+      }
+    }
+    if(peek->packet == NULL){
+      // IDLE packet
+      return NDN_WRONG_TLV_TYPE;
+    }
+    ptr = ndn_pkt_read_tl(peek->packet, peek->packet + peek->packet_size, &peek->type, &length);
+    if(ptr == NULL){
+      return NDN_WRONG_TLV_LENGTH;
+    }
+  }
+  if(peek->type != TLV_Interest && peek->type != TLV_Data){
+    return NDN_WRONG_TLV_TYPE;
+  }
+  end = ptr + length;
+
+  // Name is always the first element
+  val = ndn_pkt_read_tl(ptr, end, &type, &length);
+  if(val == NULL || type != TLV_Name){
+    return NDN_WRONG_TLV_TYPE;
+  }
+  peek->name = ptr;
+  peek->name_size = (uint32_t)(val + length - ptr);
+  if(peek->type == TLV_Data){
+    return NDN_SUCCESS;
+  }
+
+  memset(elems, 0, sizeof(elems));
+  ret = ndn_pkt_scan(val + length, end, peek_slots, PEEK_PARAMETERS + 1, elems);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  peek->can_be_prefix = (elems[PEEK_CAN_BE_PREFIX].value != NULL);
+  if(elems[PEEK_NONCE].size == 4){
+    peek->has_nonce = true;
+    peek->nonce = ndn_pkt_load_be32(elems[PEEK_NONCE].value);
+  }
+  if(elems[PEEK_LIFETIME].value != NULL &&
+     ndn_pkt_read_uint(elems[PEEK_LIFETIME].value, elems[PEEK_LIFETIME].size, &num)){
+    peek->lifetime = num;
+  }
+
+  return NDN_SUCCESS;
+}
+
+bool
+ndn_pkt_name_is_prefix(const uint8_t* prefix, uint32_t prefix_size,
+                       const uint8_t* name, uint32_t name_size){
+  const uint8_t *pval, *nval;
+  uint32_t type, plen = 0, nlen = 0;
+
+  pval = ndn_pkt_read_tl(prefix, prefix + prefix_size, &type, &plen);
+  nval = ndn_pkt_read_tl(name, name + name_size, &type, &nlen);
+  if(pval == NULL || nval == NULL || plen > nlen){
+    return false;
+  }
+  // Components are self-delimiting, so a byte prefix ends on a component boundary
+  return ndn_name_kernels_mismatch(pval, nval, plen) == plen;
+}
+
+uint64_t
+ndn_pkt_name_hash(const uint8_t* name, uint32_t size){
+  const uint8_t *val, *end = name + size;
+  uint32_t type, length;
+
+  // Hash the value only, so non-minimal length encodings do not matter
+  val = ndn_pkt_read_tl(name, end, &type, &length);
+  if(val == NULL){
+    val = name;
+    length = size;
+  }
+  return ndn_name_kernels_hash(val, length);
+}
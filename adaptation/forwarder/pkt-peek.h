@@ -0,0 +1,232 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#ifndef NDN_PKT_PEEK_H_
+#define NDN_PKT_PEEK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Default InterestLifetime in ms when the field is absent
+#define NDN_PKT_PEEK_DEFAULT_LIFETIME 4000
+
+// NDNLPv2 TLV types
+#define NDN_LP_PACKET 0x64
+#define NDN_LP_FRAGMENT 0x50
+#define NDN_LP_NACK 0x0320
+#define NDN_LP_NACK_REASON 0x0321
+#define NDN_LP_CONGESTION_MARK 0x0340
+// Maximum size of the header written by ndn_pkt_write_lp_header
+#define NDN_LP_HEADER_MAX_SIZE 24
+// Types dispatched by ndn_pkt_scan; larger ones are skipped
+#define NDN_PKT_SCAN_TYPES 256
+
+/**
+ * Header fields of an Interest or Data, pointing into the wire buffer.
+ * Filled by ndn_pkt_peek without decoding the whole packet.
+ */
+typedef struct ndn_pkt_peek {
+  /**
+   * Network layer packet. Points into the Fragment of an LpPacket.
+   */
+  const uint8_t* packet;
+  uint32_t packet_size;
+
+  /**
+   * NDNLPv2 CongestionMark, 0 if absent.
+   */
+  uint64_t congestion_mark;
+
+  /**
+   * NDNLPv2 Nack. The packet is the Interest being rejected.
+   */
+  bool is_nack;
+  uint32_t nack_reason;
+
+  /**
+   * TLV type of the network layer packet (TLV_Interest or TLV_Data).
+   */
+  uint32_t type;
+
+  /**
+   * Whole Name TLV, including its type and length.
+   */
+  const uint8_t* name;
+  uint32_t name_size;
+
+  /**
+   * Interest only: CanBePrefix, Nonce and InterestLifetime.
+   */
+  bool can_be_prefix;
+  bool has_nonce;
+  uint32_t nonce;
+  uint64_t lifetime;
+} ndn_pkt_peek_t;
+
+/**
+ * An element found by ndn_pkt_scan. @c value is NULL if absent.
+ */
+typedef struct ndn_pkt_elem {
+  const uint8_t* value;
+  uint32_t size;
+} ndn_pkt_elem_t;
+
+/**
+ * Unaligned big-endian loads and stores.
+ */
+static inline uint16_t
+ndn_pkt_load_be16(const uint8_t* buf){
+  uint16_t ret;
+  memcpy(&ret, buf, sizeof(ret));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  ret = __builtin_bswap16(ret);
+#endif
+  return ret;
+}
+
+static inline uint32_t
+ndn_pkt_load_be32(const uint8_t* buf){
+  uint32_t ret;
+  memcpy(&ret, buf, sizeof(ret));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  ret = __builtin_bswap32(ret);
+#endif
+  return ret;
+}
+
+static inline uint64_t
+ndn_pkt_load_be64(const uint8_t* buf){
+  uint64_t ret;
+  memcpy(&ret, buf, sizeof(ret));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  ret = __builtin_bswap64(ret);
+#endif
+  return ret;
+}
+
+static inline void
+ndn_pkt_store_be16(uint8_t* buf, uint16_t value){
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  value = __builtin_bswap16(value);
+#endif
+  memcpy(buf, &value, sizeof(value));
+}
+
+static inline void
+ndn_pkt_store_be32(uint8_t* buf, uint32_t value){
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  value = __builtin_bswap32(value);
+#endif
+  memcpy(buf, &value, sizeof(value));
+}
+
+static inline void
+ndn_pkt_store_be64(uint8_t* buf, uint64_t value){
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  value = __builtin_bswap64(value);
+#endif
+  memcpy(buf, &value, sizeof(value));
+}
+
+/**
+ * Read a TLV variable-length number.
+ * @return Pointer after the number, or NULL if it exceeds @c end.
+ */
+const uint8_t*
+ndn_pkt_read_var(const uint8_t* buf, const uint8_t* end, uint64_t* value);
+
+/**
+ * Read the type and length of a TLV element.
+ * @return Pointer to the value, or NULL if the element exceeds @c end.
+ */
+const uint8_t*
+ndn_pkt_read_tl(const uint8_t* buf, const uint8_t* end, uint32_t* type, uint32_t* length);
+
+/**
+ * Read the value of a non-negative integer TLV.
+ * @return false unless @c size is 1, 2, 4 or 8.
+ */
+bool
+ndn_pkt_read_uint(const uint8_t* value, uint32_t size, uint64_t* result);
+
+/**
+ * Scan a sequence of TLV elements with a type-indexed dispatch table,
+ * so the cost per element does not depend on how many types are wanted.
+ * @param slots Maps each type below NDN_PKT_SCAN_TYPES to its slot plus 1,
+ *   or to 0 if the element is skipped.
+ * @param stop The scan ends after the element of this slot plus 1, if not 0.
+ * @param elems Cleared by the caller. A repeated element overwrites its slot.
+ * @return NDN_SUCCESS, or NDN_WRONG_TLV_LENGTH if an element is truncated.
+ */
+int
+ndn_pkt_scan(const uint8_t* buf, const uint8_t* end, const uint8_t* slots, uint8_t stop,
+             ndn_pkt_elem_t* elems);
+
+/**
+ * Write a TLV variable-length number.
+ * @return Number of bytes written, at most 9.
+ */
+uint32_t
+ndn_pkt_write_var(uint8_t* buf, uint64_t value);
+
+/**
+ * Write a TLV holding a non-negative integer.
+ * @return Number of bytes written, at most 18.
+ */
+uint32_t
+ndn_pkt_write_uint(uint8_t* buf, uint32_t type, uint64_t value);
+
+/**
+ * Write the header of an LpPacket whose Fragment is the next
+ * @c fragment_size bytes, so the packet itself needs not be copied.
+ * @param congestion_mark CongestionMark field, omitted if 0.
+ * @param buf At least NDN_LP_HEADER_MAX_SIZE bytes.
+ * @return Header size.
+ */
+uint32_t
+ndn_pkt_write_lp_header(uint8_t* buf, uint32_t fragment_size, uint64_t congestion_mark);
+
+/**
+ * Write the header of a Nack whose Fragment is the next @c fragment_size bytes.
+ * @param buf At least NDN_LP_HEADER_MAX_SIZE bytes.
+ * @return Header size.
+ */
+uint32_t
+ndn_pkt_write_lp_nack(uint8_t* buf, uint32_t fragment_size, uint32_t reason);
+
+/**
+ * Peek the header fields of a packet.
+ * An LpPacket is unwrapped, and its fields recognized by this module are kept.
+ * @return NDN_SUCCESS if the packet is a well-formed Interest or Data.
+ */
+int
+ndn_pkt_peek(const uint8_t* packet, uint32_t size, ndn_pkt_peek_t* peek);
+
+/**
+ * Check whether a Name TLV is a prefix of another one.
+ */
+bool
+ndn_pkt_name_is_prefix(const uint8_t* prefix, uint32_t prefix_size,
+                       const uint8_t* name, uint32_t name_size);
+
+/**
+ * Hash a Name TLV. Equal names always have equal hashes.
+ */
+uint64_t
+ndn_pkt_name_hash(const uint8_t* name, uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,382 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "pkt-view.h"
+#include "pkt-peek.h"
+#include "ndn-lite/ndn-enums.h"
+#include "ndn-lite/ndn-error-code.h"
+
+enum {
+  INTEREST_CAN_BE_PREFIX,
+  INTEREST_MUST_BE_FRESH,
+  INTEREST_NONCE,
+  INTEREST_LIFETIME,
+  INTEREST_HOP_LIMIT,
+  INTEREST_PARAMETERS,
+  INTEREST_ELEMS
+};
+
+static const uint8_t interest_slots[NDN_PKT_SCAN_TYPES] = {
+  [TLV_CanBePrefix] = INTEREST_CAN_BE_PREFIX + 1,
+  [TLV_MustBeFresh] = INTEREST_MUST_BE_FRESH + 1,
+  [TLV_Nonce] = INTEREST_NONCE + 1,
+  [TLV_InterestLifetime] = INTEREST_LIFETIME + 1,
+  [TLV_HopLimit] = INTEREST_HOP_LIMIT + 1,
+  // The rest is the signature of a signed Interest
+  [TLV_ApplicationParameters] = INTEREST_PARAMETERS + 1,
+};
+
+enum {
+  DATA_META_INFO,
+  DATA_CONTENT,
+  DATA_SIGNATURE_INFO,
+  DATA_SIGNATURE_VALUE,
+  DATA_ELEMS
+};
+
+static const uint8_t data_slots[NDN_PKT_SCAN_TYPES] = {
+  [TLV_MetaInfo] = DATA_META_INFO + 1,
+  [TLV_Content] = DATA_CONTENT + 1,
+  [TLV_SignatureInfo] = DATA_SIGNATURE_INFO + 1,
+  [TLV_SignatureValue] = DATA_SIGNATURE_VALUE + 1,
+};
+
+static int
+view_find(const uint8_t* block, uint32_t size, uint32_t type, const uint8_t** value, uint32_t* length);
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+static int
+view_find(const uint8_t* block, uint32_t size, uint32_t type, const uint8_t** value, uint32_t* length){
+  const uint8_t *ptr, *val, *end = block + size;
+  uint32_t t, l;
+
+  if(block == NULL){
+    return NDN_WRONG_TLV_TYPE;
+  }
+  for(ptr = block; ptr < end; ptr = val + l){
+    val = ndn_pkt_read_tl(ptr, end, &t, &l);
+    if(val == NULL){
+      return NDN_WRONG_TLV_LENGTH;
+    }
+    if(t == type){
+      *value = val;
+      *length = l;
+      return NDN_SUCCESS;
+    }
+  }
+  return NDN_WRONG_TLV_TYPE;
+}
+
+int
+ndn_interest_view_parse(ndn_interest_view_t* view, const uint8_t* wire, uint32_t size){
+  const uint8_t *ptr, *val, *end;
+  uint32_t type, length;
+  ndn_pkt_elem_t elems[INTEREST_ELEMS];
+  int ret;
+
+  view->wire = wire;
+  view->wire_size = size;
+  view->can_be_prefix = false;
+  view->must_be_fresh = false;
+  view->has_nonce = false;
+  view->nonce = 0;
+  view->lifetime = NDN_PKT_PEEK_DEFAULT_LIFETIME;
+  view->has_hop_limit = false;
+  view->hop_limit = 0;
+  view->parameters = NULL;
+  view->parameters_size = 0;
+
+  ptr = ndn_pkt_read_tl(wire, wire + size, &type, &length);
+  if(ptr == NULL){
+    return NDN_WRONG_TLV_LENGTH;
+  }
+  if(type != TLV_Interest){
+    return NDN_WRONG_TLV_TYPE;
+  }
+  end = ptr + length;
+
+  val = ndn_pkt_read_tl(ptr, end, &type, &length);
+  if(val == NULL || type != TLV_Name){
+    return NDN_WRONG_TLV_TYPE;
+  }
+  view->name = ptr;
+  view->name_size = (uint32_t)(val + length - ptr);
+
+  memset(elems, 0, sizeof(elems));
+  ret = ndn_pkt_scan(val + length, end, interest_slots, INTEREST_PARAMETERS + 1, elems);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  view->can_be_prefix = (elems[INTEREST_CAN_BE_PREFIX].value != NULL);
+  view->must_be_fresh = (elems[INTEREST_MUST_BE_FRESH].value != NULL);
+  if(elems[INTEREST_NONCE].value != NULL){
+    if(elems[INTEREST_NONCE].size != 4){
+      return NDN_WRONG_TLV_LENGTH;
+    }
+    view->has_nonce = true;
+    view->nonce = ndn_pkt_load_be32(elems[INTEREST_NONCE].value);
+  }
+  if(elems[INTEREST_LIFETIME].value != NULL){
+    if(!ndn_pkt_read_uint(elems[INTEREST_LIFETIME].value, elems[INTEREST_LIFETIME].size, &view->lifetime)){
+      return NDN_WRONG_TLV_LENGTH;
+    }
+  }
+  if(elems[INTEREST_HOP_LIMIT].value != NULL){
+    if(elems[INTEREST_HOP_LIMIT].size != 1){
+      return NDN_WRONG_TLV_LENGTH;
+    }
+    view->has_hop_limit = true;
+    view->hop_limit = elems[INTEREST_HOP_LIMIT].value[0];
+  }
+  view->parameters = elems[INTEREST_PARAMETERS].value;
+  view->parameters_size = elems[INTEREST_PARAMETERS].size;
+  return NDN_SUCCESS;
+}
+
+int
+ndn_data_view_parse(ndn_data_view_t* view, const uint8_t* wire, uint32_t size){
+  const uint8_t *ptr, *val, *end;
+  uint32_t type, length;
+  ndn_pkt_elem_t elems[DATA_ELEMS];
+  int ret;
+
+  view->wire = wire;
+  view->wire_size = size;
+  view->meta_info = NULL;
+  view->meta_info_size = 0;
+  view->content = NULL;
+  view->content_size = 0;
+  view->signature_info = NULL;
+  view->signature_info_size = 0;
+  view->signature_value = NULL;
+  view->signature_value_size = 0;
+  view->signed_portion = NULL;
+  view->signed_portion_size = 0;
+
+  ptr = ndn_pkt_read_tl(wire, wire + size, &type, &length);
+  if(ptr == NULL){
+    return NDN_WRONG_TLV_LENGTH;
+  }
+  if(type != TLV_Data){
+    return NDN_WRONG_TLV_TYPE;
+  }
+  end = ptr + length;
+
+  val = ndn_pkt_read_tl(ptr, end, &type, &length);
+  if(val == NULL || type != TLV_Name){
+    return NDN_WRONG_TLV_TYPE;
+  }
+  view->name = ptr;
+  view->name_size = (uint32_t)(val + length - ptr);
+  view->signed_portion = ptr;
+
+  memset(elems, 0, sizeof(elems));
+  ret = ndn_pkt_scan(val + length, end, data_slots, 0, elems);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  view->meta_info = elems[DATA_META_INFO].value;
+  view->meta_info_size = elems[DATA_META_INFO].size;
+  view->content = elems[DATA_CONTENT].value;
+  view->content_size = elems[DATA_CONTENT].size;
+  view->signature_info = elems[DATA_SIGNATURE_INFO].value;
+  view->signature_info_size = elems[DATA_SIGNATURE_INFO].size;
+  view->signature_value = elems[DATA_SIGNATURE_VALUE].value;
+  view->signature_value_size = elems[DATA_SIGNATURE_VALUE].size;
+  if(view->signature_info != NULL){
+    view->signed_portion_size = (uint32_t)(view->signature_info + view->signature_info_size -
+                                           view->signed_portion);
+  }
+  return NDN_SUCCESS;
+}
+
+int
+ndn_name_iter_init(ndn_name_iter_t* iter, const uint8_t* name, uint32_t name_size){
+  uint32_t type, length;
+  const uint8_t* val;
+
+  val = ndn_pkt_read_tl(name, name + name_size, &type, &length);
+  if(val == NULL){
+    return NDN_WRONG_TLV_LENGTH;
+  }
+  if(type != TLV_Name){
+    return NDN_WRONG_TLV_TYPE;
+  }
+  iter->pos = val;
+  iter->end = val + length;
+  return NDN_SUCCESS;
+}
+
+bool
+ndn_name_iter_next(ndn_name_iter_t* iter, ndn_component_view_t* comp){
+  const uint8_t* val;
+
+  if(iter->pos >= iter->end){
+    return false;
+  }
+  val = ndn_pkt_read_tl(iter->pos, iter->end, &comp->type, &comp->size);
+  if(val == NULL){
+    iter->pos = iter->end;
+    return false;
+  }
+  comp->value = val;
+  iter->pos = val + comp->size;
+  return true;
+}
+
+int
+ndn_name_view_count(const uint8_t* name, uint32_t name_size){
+  ndn_name_iter_t iter;
+  ndn_component_view_t comp;
+  int ret, count = 0;
+
+  ret = ndn_name_iter_init(&iter, name, name_size);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  while(ndn_name_iter_next(&iter, &comp)){
+    count ++;
+  }
+  return count;
+}
+
+int
+ndn_name_view_component(const uint8_t* name, uint32_t name_size, int index, ndn_component_view_t* comp){
+  ndn_name_iter_t iter;
+  int ret, count;
+
+  if(index < 0){
+    count = ndn_name_view_count(name, name_size);
+    if(count < 0){
+      return count;
+    }
+    index += count;
+    if(index < 0){
+      return NDN_OVERSIZE;
+    }
+  }
+  ret = ndn_name_iter_init(&iter, name, name_size);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  while(ndn_name_iter_next(&iter, comp)){
+    if(index == 0){
+      return NDN_SUCCESS;
+    }
+    index --;
+  }
+  return NDN_OVERSIZE;
+}
+
+int
+ndn_name_view_segment(const uint8_t* name, uint32_t name_size, uint64_t* segno){
+  ndn_name_iter_t iter;
+  ndn_component_view_t comp, last;
+  int ret;
+
+  ret = ndn_name_iter_init(&iter, name, name_size);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  last.value = NULL;
+  while(ndn_name_iter_next(&iter, &comp)){
+    last = comp;
+  }
+  if(last.value == NULL){
+    return NDN_WRONG_TLV_TYPE;
+  }
+  return ndn_component_view_segment(&last, segno);
+}
+
+int
+ndn_component_view_segment(const ndn_component_view_t* comp, uint64_t* segno){
+  uint32_t i;
+
+  if(comp->type == NDN_PKT_VIEW_SEGMENT_COMPONENT){
+    return ndn_pkt_read_uint(comp->value, comp->size, segno) ? NDN_SUCCESS : NDN_WRONG_TLV_LENGTH;
+  }
+  if(comp->type != TLV_GenericNameComponent || comp->size == 0 || comp->size > 9 ||
+     comp->value[0] != NDN_PKT_VIEW_SEGMENT_MARKER){
+    return NDN_WRONG_TLV_TYPE;
+  }
+  *segno = 0;
+  for(i = 1; i < comp->size; i ++){
+    *segno = (*segno << 8) | comp->value[i];
+  }
+  return NDN_SUCCESS;
+}
+
+int
+ndn_data_view_get_content_type(const ndn_data_view_t* view, uint8_t* content_type){
+  const uint8_t* val;
+  uint32_t length;
+  uint64_t num;
+  int ret;
+
+  ret = view_find(view->meta_info, view->meta_info_size, TLV_ContentType, &val, &length);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  if(!ndn_pkt_read_uint(val, length, &num) || num > 0xFF){
+    return NDN_WRONG_TLV_LENGTH;
+  }
+  *content_type = (uint8_t)num;
+  return NDN_SUCCESS;
+}
+
+int
+ndn_data_view_get_freshness_period(const ndn_data_view_t* view, uint64_t* freshness_period){
+  const uint8_t* val;
+  uint32_t length;
+  int ret;
+
+  ret = view_find(view->meta_info, view->meta_info_size, TLV_FreshnessPeriod, &val, &length);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  return ndn_pkt_read_uint(val, length, freshness_period) ? NDN_SUCCESS : NDN_WRONG_TLV_LENGTH;
+}
+
+int
+ndn_data_view_get_final_block_id(const ndn_data_view_t* view, ndn_component_view_t* final_block_id){
+  const uint8_t *val, *comp;
+  uint32_t length;
+  int ret;
+
+  ret = view_find(view->meta_info, view->meta_info_size, TLV_FinalBlockId, &val, &length);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  comp = ndn_pkt_read_tl(val, val + length, &final_block_id->type, &final_block_id->size);
+  if(comp == NULL){
+    return NDN_WRONG_TLV_LENGTH;
+  }
+  final_block_id->value = comp;
+  return NDN_SUCCESS;
+}
+
+int
+ndn_data_view_get_signature_type(const ndn_data_view_t* view, uint8_t* signature_type){
+  const uint8_t* val;
+  uint32_t length;
+  uint64_t num;
+  int ret;
+
+  ret = view_find(view->signature_info, view->signature_info_size, TLV_SignatureType, &val, &length);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  if(!ndn_pkt_read_uint(val, length, &num) || num > 0xFF){
+    return NDN_WRONG_TLV_LENGTH;
+  }
+  *signature_type = (uint8_t)num;
+  return NDN_SUCCESS;
+}
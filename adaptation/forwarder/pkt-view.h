@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#ifndef NDN_PKT_VIEW_H_
+#define NDN_PKT_VIEW_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Typed name components not in ndn-enums.h
+#define NDN_PKT_VIEW_SEGMENT_COMPONENT 50
+// Marker of a segment number in a generic component
+#define NDN_PKT_VIEW_SEGMENT_MARKER 0x00
+
+/**
+ * A name component, pointing into the wire buffer.
+ */
+typedef struct ndn_component_view {
+  uint32_t type;
+  const uint8_t* value;
+  uint32_t size;
+} ndn_component_view_t;
+
+/**
+ * Iterates over the components of a Name TLV.
+ */
+typedef struct ndn_name_iter {
+  const uint8_t* pos;
+  const uint8_t* end;
+} ndn_name_iter_t;
+
+/**
+ * An Interest, pointing into the wire buffer.
+ *
+ * Unlike ndn_interest_t, nothing is copied: the view is valid as long as
+ * the buffer is. Name components are decoded when they are iterated.
+ * Use ndn_name_from_block on the name for APIs that still need ndn_name_t.
+ */
+typedef struct ndn_interest_view {
+  const uint8_t* wire;
+  uint32_t wire_size;
+
+  /**
+   * Whole Name TLV, including its type and length.
+   */
+  const uint8_t* name;
+  uint32_t name_size;
+
+  bool can_be_prefix;
+  bool must_be_fresh;
+  bool has_nonce;
+  uint32_t nonce;
+  uint64_t lifetime;
+  bool has_hop_limit;
+  uint8_t hop_limit;
+
+  /**
+   * Value of ApplicationParameters, NULL if absent.
+   */
+  const uint8_t* parameters;
+  uint32_t parameters_size;
+} ndn_interest_view_t;
+
+/**
+ * A Data, pointing into the wire buffer.
+ * MetaInfo and SignatureInfo are decoded by the getters below.
+ */
+typedef struct ndn_data_view {
+  const uint8_t* wire;
+  uint32_t wire_size;
+
+  /**
+   * Whole Name TLV, including its type and length.
+   */
+  const uint8_t* name;
+  uint32_t name_size;
+
+  /**
+   * Values of the elements; NULL if absent.
+   */
+  const uint8_t* meta_info;
+  uint32_t meta_info_size;
+  const uint8_t* content;
+  uint32_t content_size;
+  const uint8_t* signature_info;
+  uint32_t signature_info_size;
+  const uint8_t* signature_value;
+  uint32_t signature_value_size;
+
+  /**
+   * The bytes covered by the signature: Name to SignatureInfo.
+   */
+  const uint8_t* signed_portion;
+  uint32_t signed_portion_size;
+} ndn_data_view_t;
+
+int
+ndn_interest_view_parse(ndn_interest_view_t* view, const uint8_t* wire, uint32_t size);
+
+int
+ndn_data_view_parse(ndn_data_view_t* view, const uint8_t* wire, uint32_t size);
+
+/**
+ * Start iterating over a Name TLV.
+ */
+int
+ndn_name_iter_init(ndn_name_iter_t* iter, const uint8_t* name, uint32_t name_size);
+
+/**
+ * @return true if a component is read; false at the end or on malformed input.
+ */
+bool
+ndn_name_iter_next(ndn_name_iter_t* iter, ndn_component_view_t* comp);
+
+/**
+ * @return Number of components, or a negative error code.
+ */
+int
+ndn_name_view_count(const uint8_t* name, uint32_t name_size);
+
+/**
+ * Get a component. A negative index counts from the end.
+ */
+int
+ndn_name_view_component(const uint8_t* name, uint32_t name_size, int index, ndn_component_view_t* comp);
+
+/**
+ * Decode the segment number in the last component, either a
+ * SegmentNameComponent or a generic component with the 0x00 marker.
+ */
+int
+ndn_name_view_segment(const uint8_t* name, uint32_t name_size, uint64_t* segno);
+
+/**
+ * Decode the segment number in one component, e.g. a FinalBlockId.
+ */
+int
+ndn_component_view_segment(const ndn_component_view_t* comp, uint64_t* segno);
+
+int
+ndn_data_view_get_content_type(const ndn_data_view_t* view, uint8_t* content_type);
+
+int
+ndn_data_view_get_freshness_period(const ndn_data_view_t* view, uint64_t* freshness_period);
+
+int
+ndn_data_view_get_final_block_id(const ndn_data_view_t* view, ndn_component_view_t* final_block_id);
+
+int
+ndn_data_view_get_signature_type(const ndn_data_view_t* view, uint8_t* signature_type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
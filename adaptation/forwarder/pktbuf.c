@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "pktbuf.h"
+#include "ndn-lite/forwarder/forwarder.h"
+
+static ndn_pktbuf_t* pktbuf_pool = NULL;
+static uint32_t pktbuf_pool_size = 0;
+static ndn_pktbuf_t* pktbuf_current = NULL;
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+ndn_pktbuf_t*
+ndn_pktbuf_alloc(uint32_t capacity){
+  ndn_pktbuf_t* ret;
+
+  if(capacity <= NDN_PKTBUF_SIZE && pktbuf_pool != NULL){
+    ret = pktbuf_pool;
+    pktbuf_pool = ret->next;
+    pktbuf_pool_size --;
+  }else{
+    if(capacity < NDN_PKTBUF_SIZE){
+      capacity = NDN_PKTBUF_SIZE;
+    }
+    ret = (ndn_pktbuf_t*)malloc(sizeof(ndn_pktbuf_t) + capacity);
+    if(ret == NULL){
+      return NULL;
+    }
+    ret->capacity = capacity;
+  }
+  ret->refcount = 1;
+  ret->size = 0;
+  ret->next = NULL;
+  return ret;
+}
+
+void
+ndn_pktbuf_unref(ndn_pktbuf_t* self){
+  if(-- self->refcount > 0){
+    return;
+  }
+  if(self->capacity == NDN_PKTBUF_SIZE && pktbuf_pool_size < NDN_PKTBUF_POOL_MAX){
+    self->next = pktbuf_pool;
+    pktbuf_pool = self;
+    pktbuf_pool_size ++;
+  }else{
+    free(self);
+  }
+}
+
+void
+ndn_pktbuf_set_current(ndn_pktbuf_t* self){
+  pktbuf_current = self;
+}
+
+ndn_pktbuf_t*
+ndn_pktbuf_get_current(void){
+  return pktbuf_current;
+}
+
+ndn_pktbuf_t*
+ndn_pktbuf_acquire(const uint8_t* packet, uint32_t size){
+  ndn_pktbuf_t* ret;
+
+  if(pktbuf_current != NULL && packet >= pktbuf_current->data &&
+     packet + size <= pktbuf_current->data + pktbuf_current->size){
+    return ndn_pktbuf_ref(pktbuf_current);
+  }
+
+  ret = ndn_pktbuf_alloc(size);
+  if(ret == NULL){
+    return NULL;
+  }
+  memcpy(ret->data, packet, size);
+  ret->size = size;
+  return ret;
+}
+
+int
+ndn_pktbuf_put_data(ndn_pktbuf_t* data){
+  ndn_pktbuf_t* prev = pktbuf_current;
+  int ret;
+
+  pktbuf_current = data;
+  ret = ndn_forwarder_put_data(data->data, data->size);
+  pktbuf_current = prev;
+  return ret;
+}
+
+ndn_pktbuf_t*
+ndn_pktbuf_gather(const struct iovec* iov, int count){
+  uint32_t size = ndn_iov_size(iov, count);
+  ndn_pktbuf_t* ret;
+
+  ret = ndn_pktbuf_alloc(size);
+  if(ret == NULL){
+    return NULL;
+  }
+  ret->size = ndn_iov_gather(iov, count, ret->data, size);
+  return ret;
+}
+
+uint32_t
+ndn_iov_size(const struct iovec* iov, int count){
+  uint32_t ret = 0;
+  int i;
+
+  for(i = 0; i < count; i ++){
+    ret += iov[i].iov_len;
+  }
+  return ret;
+}
+
+uint32_t
+ndn_iov_gather(const struct iovec* iov, int count, uint8_t* buf, uint32_t size){
+  uint32_t ret = 0;
+  int i;
+
+  for(i = 0; i < count; i ++){
+    if(ret + iov[i].iov_len > size){
+      return 0;
+    }
+    memcpy(buf + ret, iov[i].iov_base, iov[i].iov_len);
+    ret += iov[i].iov_len;
+  }
+  return ret;
+}
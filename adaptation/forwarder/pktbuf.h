@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#ifndef NDN_PKTBUF_H_
+#define NDN_PKTBUF_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/uio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Payload size of pooled buffers. Larger packets get a dedicated allocation.
+#define NDN_PKTBUF_SIZE 4096
+// Maximum number of idle buffers kept for reuse
+#define NDN_PKTBUF_POOL_MAX 256
+
+/**
+ * Reference-counted packet buffer.
+ *
+ * A packet received by a face is stored in a pktbuf and handed to the
+ * forwarder in place. A face that cannot transmit immediately keeps a
+ * reference instead of copying, so a Data fanned out to several faces
+ * is held once by all their transmit queues.
+ * Buffers belong to the forwarder thread; the count is not atomic.
+ */
+typedef struct ndn_pktbuf {
+  uint32_t refcount;
+  uint32_t size;
+  uint32_t capacity;
+  struct ndn_pktbuf* next;
+  uint8_t data[];
+} ndn_pktbuf_t;
+
+/**
+ * Allocate a buffer with one reference.
+ * @param capacity Minimum payload capacity.
+ */
+ndn_pktbuf_t*
+ndn_pktbuf_alloc(uint32_t capacity);
+
+static inline ndn_pktbuf_t*
+ndn_pktbuf_ref(ndn_pktbuf_t* self){
+  self->refcount ++;
+  return self;
+}
+
+/**
+ * Drop a reference. The buffer returns to the pool at zero.
+ */
+void
+ndn_pktbuf_unref(ndn_pktbuf_t* self);
+
+/**
+ * Mark the buffer being dispatched by the forwarder.
+ * Set around a synchronous forwarder call, then set back to what
+ * ndn_pktbuf_get_current returned before, as such calls may nest.
+ */
+void
+ndn_pktbuf_set_current(ndn_pktbuf_t* self);
+
+ndn_pktbuf_t*
+ndn_pktbuf_get_current(void);
+
+/**
+ * Get a reference to a packet given to a face's send().
+ * If the packet lies in the buffer being dispatched, that buffer is shared.
+ * Otherwise, the packet is copied into a new buffer.
+ * @return The buffer, or NULL if out of memory.
+ */
+ndn_pktbuf_t*
+ndn_pktbuf_acquire(const uint8_t* packet, uint32_t size);
+
+/**
+ * Publish a Data packet encoded in a pktbuf.
+ * Faces that queue it share the buffer instead of copying it.
+ */
+int
+ndn_pktbuf_put_data(ndn_pktbuf_t* data);
+
+/**
+ * Copy a packet held in several buffers into a new pktbuf,
+ * for paths that need it contiguous, such as ndn_pktbuf_put_data.
+ */
+ndn_pktbuf_t*
+ndn_pktbuf_gather(const struct iovec* iov, int count);
+
+uint32_t
+ndn_iov_size(const struct iovec* iov, int count);
+
+/**
+ * Copy iovecs into one buffer.
+ * @return The size copied, or 0 if it does not fit.
+ */
+uint32_t
+ndn_iov_gather(const struct iovec* iov, int count, uint8_t* buf, uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,550 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "status.h"
+#include "face-slab.h"
+#include "ingress.h"
+#include "pkt-view.h"
+#include "data-template.h"
+#include "name-kernels.h"
+#include "../unix-socket/unix-face.h"
+#include "ndn-lite/encode/name.h"
+#include "ndn-lite/encode/forwarder-helper.h"
+#include "ndn-lite/util/uniform-time.h"
+
+// Version and segment components use the marker convention of ndn-putchunks
+#define STATUS_VERSION_MARKER 0xFD
+// Encoded NextHop entry: five numbers of at most 10 bytes each
+#define STATUS_NEXTHOP_ENTRY_SIZE 64
+
+/**
+ * The segments of one version of the dataset.
+ */
+typedef struct ndn_status_version {
+  ndn_name_t versioned_name;
+  ndn_time_ms_t version;
+  ndn_time_ms_t last_fetch;
+  // segment_capacity packets of NDN_STATUS_DATA_SIZE bytes each
+  uint8_t* segments;
+  uint32_t* segment_sizes;
+  uint32_t segment_capacity;
+  uint32_t segment_count;
+} ndn_status_version_t;
+
+typedef struct status_field {
+  uint32_t type;
+  uint64_t value;
+} status_field_t;
+
+typedef struct ndn_status {
+  ndn_name_t prefix;
+
+  ndn_cs_mmap_t* cs;
+  ndn_strategy_face_t* strategies[NDN_STATUS_MAX_STRATEGIES];
+  uint8_t strategy_count;
+
+  // Grown until the dataset fits, and kept for the next snapshot
+  uint8_t* dataset;
+  uint32_t dataset_capacity;
+  /**
+   * The current version and the previous one, which consumers may still be
+   * fetching.
+   */
+  ndn_status_version_t versions[2];
+  uint8_t current;
+} ndn_status_t;
+
+static ndn_status_t status_instance;
+
+static int
+ndn_status_append_uint(ndn_encoder_t* encoder, uint32_t type, uint64_t value);
+
+static int
+ndn_status_append_block(ndn_encoder_t* encoder, uint32_t type, const ndn_encoder_t* inner);
+
+static int
+ndn_status_append_fields(ndn_encoder_t* encoder, const status_field_t* fields, int count);
+
+static int
+ndn_status_encode_general(ndn_encoder_t* encoder);
+
+static int
+ndn_status_encode_face(ndn_encoder_t* encoder, ndn_face_handle_t handle, ndn_face_slot_t* slot);
+
+static int
+ndn_status_encode_cs(ndn_encoder_t* encoder, ndn_cs_mmap_t* cs);
+
+static int
+ndn_status_encode_prefix(ndn_encoder_t* encoder, ndn_strategy_face_t* face, ndn_strategy_prefix_t* prefix);
+
+static int
+ndn_status_encode_dataset(ndn_status_t* self, uint32_t* used);
+
+static int
+ndn_status_reserve_segments(ndn_status_version_t* self, uint32_t count);
+
+static int
+ndn_status_snapshot(ndn_status_t* self, ndn_status_version_t* out);
+
+static ndn_status_version_t*
+ndn_status_find_version(ndn_status_t* self, const ndn_component_view_t* comp);
+
+static int
+ndn_status_on_interest(const uint8_t* interest, uint32_t interest_size, void* userdata);
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+static int
+ndn_status_append_uint(ndn_encoder_t* encoder, uint32_t type, uint64_t value){
+  int ret;
+
+  ret = encoder_append_type(encoder, type);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  ret = encoder_append_length(encoder, encoder_probe_uint_length(value));
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  return encoder_append_uint_value(encoder, value);
+}
+
+static int
+ndn_status_append_block(ndn_encoder_t* encoder, uint32_t type, const ndn_encoder_t* inner){
+  int ret;
+
+  ret = encoder_append_type(encoder, type);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  ret = encoder_append_length(encoder, inner->offset);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  return encoder_append_raw_buffer_value(encoder, inner->output_value, inner->offset);
+}
+
+static int
+ndn_status_append_fields(ndn_encoder_t* encoder, const status_field_t* fields, int count){
+  int i, ret;
+
+  for(i = 0; i < count; i ++){
+    ret = ndn_status_append_uint(encoder, fields[i].type, fields[i].value);
+    if(ret != NDN_SUCCESS){
+      return ret;
+    }
+  }
+  return NDN_SUCCESS;
+}
+
+static int
+ndn_status_encode_general(ndn_encoder_t* encoder){
+  ndn_face_slab_t* slab = ndn_face_slab_get_instance();
+  ndn_dead_nonce_list_t* dnl = ndn_ingress_get_dead_nonce_list();
+  const status_field_t fields[] = {
+    {TLV_STATUS_Timestamp, ndn_time_now_ms()},
+    {TLV_STATUS_LiveFaces, slab->live},
+    {TLV_STATUS_FaceRegistrations, slab->registrations},
+    {TLV_STATUS_FaceUnregistrations, slab->unregistrations},
+    {TLV_STATUS_PendingConnections, ndn_unix_face_get_pending()},
+    // Only with a dead-nonce list
+    {TLV_STATUS_DeadNonceEntries, dnl != NULL ? dnl->count : 0},
+    {TLV_STATUS_DeadNonceSuppressed, dnl != NULL ? dnl->suppressed : 0},
+  };
+  uint8_t buf[128];
+  ndn_encoder_t inner;
+  int ret;
+
+  encoder_init(&inner, buf, sizeof(buf));
+  ret = ndn_status_append_fields(&inner, fields, dnl != NULL ? 7 : 5);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  return ndn_status_append_block(encoder, TLV_STATUS_General, &inner);
+}
+
+static int
+ndn_status_encode_face(ndn_encoder_t* encoder, ndn_face_handle_t handle, ndn_face_slot_t* slot){
+  ndn_face_counters_t* counters = &slot->counters;
+  const status_field_t fields[] = {
+    {TLV_STATUS_FaceHandle, handle},
+    {TLV_STATUS_FaceId, slot->face->face_id},
+    {TLV_STATUS_FaceType, slot->face->type},
+    {TLV_STATUS_FaceState, slot->face->state},
+    {TLV_STATUS_RxPackets, counters->rx_packets},
+    {TLV_STATUS_RxBytes, counters->rx_bytes},
+    {TLV_STATUS_TxPackets, counters->tx_packets},
+    {TLV_STATUS_TxBytes, counters->tx_bytes},
+    {TLV_STATUS_TxDropped, counters->tx_dropped},
+    {TLV_STATUS_QueueDepth, counters->queue_depth},
+    {TLV_STATUS_CongestionMarks, counters->tx_marked},
+  };
+  uint8_t buf[128];
+  ndn_encoder_t inner;
+  int ret;
+
+  encoder_init(&inner, buf, sizeof(buf));
+  ret = ndn_status_append_fields(&inner, fields, sizeof(fields) / sizeof(fields[0]));
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  return ndn_status_append_block(encoder, TLV_STATUS_Face, &inner);
+}
+
+static int
+ndn_status_encode_cs(ndn_encoder_t* encoder, ndn_cs_mmap_t* cs){
+  const status_field_t fields[] = {
+    {TLV_STATUS_Entries, cs->count},
+    {TLV_STATUS_Hits, cs->hits},
+    {TLV_STATUS_Misses, cs->misses},
+    {TLV_STATUS_Evictions, cs->evictions},
+  };
+  uint8_t buf[64];
+  ndn_encoder_t inner;
+  int ret;
+
+  encoder_init(&inner, buf, sizeof(buf));
+  ret = ndn_status_append_fields(&inner, fields, sizeof(fields) / sizeof(fields[0]));
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  return ndn_status_append_block(encoder, TLV_STATUS_ContentStore, &inner);
+}
+
+static int
+ndn_status_encode_prefix(ndn_encoder_t* encoder, ndn_strategy_face_t* face, ndn_strategy_prefix_t* prefix){
+  // Only the numbers are staged. The name is copied from the arena, so a
+  // prefix of any size a compact name can hold is encoded.
+  uint8_t hop_bufs[NDN_STRATEGY_MAX_NEXTHOPS][STATUS_NEXTHOP_ENTRY_SIZE];
+  uint8_t failovers_buf[16];
+  ndn_encoder_t hops[NDN_STRATEGY_MAX_NEXTHOPS], failovers;
+  uint32_t length;
+  int ret;
+  uint8_t i;
+
+  encoder_init(&failovers, failovers_buf, sizeof(failovers_buf));
+  ret = ndn_status_append_uint(&failovers, TLV_STATUS_Failovers, face->failovers);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  length = prefix->name.size + failovers.offset;
+  for(i = 0; i < face->nexthop_count; i ++){
+    const ndn_strategy_stats_t* stats = &prefix->stats[i];
+    const status_field_t fields[] = {
+      {TLV_STATUS_FaceId, face->nexthops[i]->face_id},
+      {TLV_STATUS_Srtt, stats->srtt},
+      {TLV_STATUS_Rttvar, stats->rttvar},
+      {TLV_STATUS_Samples, stats->samples},
+      {TLV_STATUS_Timeouts, stats->timeouts},
+    };
+    encoder_init(&hops[i], hop_bufs[i], sizeof(hop_bufs[i]));
+    ret = ndn_status_append_fields(&hops[i], fields, sizeof(fields) / sizeof(fields[0]));
+    if(ret != NDN_SUCCESS){
+      return ret;
+    }
+    length += encoder_probe_block_size(TLV_STATUS_NextHop, hops[i].offset);
+  }
+
+  ret = encoder_append_type(encoder, TLV_STATUS_Prefix);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  ret = encoder_append_length(encoder, length);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  ret = encoder_append_raw_buffer_value(encoder, ndn_compact_name_wire(&face->names, &prefix->name),
+                                        prefix->name.size);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  ret = encoder_append_raw_buffer_value(encoder, failovers.output_value, failovers.offset);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  for(i = 0; i < face->nexthop_count; i ++){
+    ret = ndn_status_append_block(encoder, TLV_STATUS_NextHop, &hops[i]);
+    if(ret != NDN_SUCCESS){
+      return ret;
+    }
+  }
+  return NDN_SUCCESS;
+}
+
+int
+ndn_status_encode(uint8_t* buf, uint32_t size, uint32_t* used){
+  ndn_status_t* self = &status_instance;
+  ndn_face_slab_t* slab = ndn_face_slab_get_instance();
+  ndn_face_slot_t* slot;
+  ndn_encoder_t encoder;
+  ndn_strategy_face_t* face;
+  uint32_t i;
+  uint8_t j;
+  int ret;
+
+  encoder_init(&encoder, buf, size);
+  ret = ndn_status_encode_general(&encoder);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  for(i = 0; i < slab->chunk_count * NDN_FACE_SLAB_CHUNK_SIZE; i ++){
+    slot = ndn_face_slab_slot(slab, i);
+    if(slot->face == NULL){
+      continue;
+    }
+    ret = ndn_status_encode_face(&encoder, ((uint32_t)slot->generation << 16) | i, slot);
+    if(ret != NDN_SUCCESS){
+      return ret;
+    }
+  }
+  if(self->cs != NULL){
+    ret = ndn_status_encode_cs(&encoder, self->cs);
+    if(ret != NDN_SUCCESS){
+      return ret;
+    }
+  }
+  for(j = 0; j < self->strategy_count; j ++){
+    face = self->strategies[j];
+    for(i = 0; i < face->prefix_count; i ++){
+      ret = ndn_status_encode_prefix(&encoder, face, &face->prefixes[i]);
+      if(ret != NDN_SUCCESS){
+        return ret;
+      }
+    }
+  }
+
+  *used = encoder.offset;
+  return NDN_SUCCESS;
+}
+
+static int
+ndn_status_encode_dataset(ndn_status_t* self, uint32_t* used){
+  uint8_t* dataset;
+  uint32_t capacity;
+  int ret;
+
+  if(self->dataset != NULL){
+    ret = ndn_status_encode(self->dataset, self->dataset_capacity, used);
+    if(ret != NDN_OVERSIZE){
+      return ret;
+    }
+  }
+  // A large face table does not fit: grow the buffer and start over
+  capacity = self->dataset_capacity;
+  do{
+    capacity = (capacity > 0) ? capacity * 2 : NDN_STATUS_INITIAL_SEGMENTS * NDN_STATUS_SEGMENT_SIZE;
+    dataset = (uint8_t*)realloc(self->dataset, capacity);
+    if(dataset == NULL){
+      return NDN_FWD_NO_MEM;
+    }
+    self->dataset = dataset;
+    self->dataset_capacity = capacity;
+    ret = ndn_status_encode(self->dataset, self->dataset_capacity, used);
+  }while(ret == NDN_OVERSIZE);
+  return ret;
+}
+
+static int
+ndn_status_reserve_segments(ndn_status_version_t* self, uint32_t count){
+  uint8_t* segments;
+  uint32_t* sizes;
+  uint32_t capacity;
+
+  if(count <= self->segment_capacity){
+    return NDN_SUCCESS;
+  }
+  capacity = (self->segment_capacity > 0) ? self->segment_capacity : NDN_STATUS_INITIAL_SEGMENTS;
+  while(capacity < count){
+    capacity *= 2;
+  }
+  segments = (uint8_t*)realloc(self->segments, (size_t)capacity * NDN_STATUS_DATA_SIZE);
+  if(segments == NULL){
+    return NDN_FWD_NO_MEM;
+  }
+  self->segments = segments;
+  sizes = (uint32_t*)realloc(self->segment_sizes, capacity * sizeof(uint32_t));
+  if(sizes == NULL){
+    return NDN_FWD_NO_MEM;
+  }
+  self->segment_sizes = sizes;
+  self->segment_capacity = capacity;
+  return NDN_SUCCESS;
+}
+
+static int
+ndn_status_snapshot(ndn_status_t* self, ndn_status_version_t* out){
+  name_component_t* comp;
+  uint32_t size, offset, cursz, i;
+  uint64_t version, segno, final_block_id;
+  int ret;
+
+  out->segment_count = 0;
+  if(self->prefix.components_size >= NDN_NAME_COMPONENTS_SIZE){
+    return NDN_OVERSIZE;
+  }
+  ret = ndn_status_encode_dataset(self, &size);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  final_block_id = (size > 0 ? (size + NDN_STATUS_SEGMENT_SIZE - 1) / NDN_STATUS_SEGMENT_SIZE : 1) - 1;
+  ret = ndn_status_reserve_segments(out, (uint32_t)final_block_id + 1);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+
+  out->version = ndn_time_now_ms();
+  out->last_fetch = out->version;
+  out->versioned_name = self->prefix;
+  comp = &out->versioned_name.components[out->versioned_name.components_size];
+  out->versioned_name.components_size ++;
+  comp->type = TLV_GenericNameComponent;
+  comp->size = 9;
+  comp->value[0] = STATUS_VERSION_MARKER;
+  version = out->version;
+  for(i = 8; i > 0; i --){
+    comp->value[i] = (uint8_t)(version % 0x100);
+    version /= 0x100;
+  }
+
+  for(i = 0, offset = 0; i <= final_block_id; i ++, offset += cursz){
+    cursz = size - offset;
+    if(cursz > NDN_STATUS_SEGMENT_SIZE){
+      cursz = NDN_STATUS_SEGMENT_SIZE;
+    }
+    segno = i;
+    ret = NDN_DATA_BUILD(out->segments + (size_t)i * NDN_STATUS_DATA_SIZE, NDN_STATUS_DATA_SIZE,
+                         &out->segment_sizes[i],
+                         .name = &out->versioned_name,
+                         .segno = &segno,
+                         .freshness_period = NDN_STATUS_FRESHNESS,
+                         .final_block_id = &final_block_id,
+                         .content = self->dataset + offset,
+                         .content_size = cursz);
+    if(ret != NDN_SUCCESS){
+      return ret;
+    }
+  }
+  out->segment_count = (uint32_t)final_block_id + 1;
+  return NDN_SUCCESS;
+}
+
+static ndn_status_version_t*
+ndn_status_find_version(ndn_status_t* self, const ndn_component_view_t* comp){
+  name_component_t* version;
+  int i;
+
+  for(i = 0; i < 2; i ++){
+    if(self->versions[i].segment_count == 0){
+      continue;
+    }
+    version = &self->versions[i].versioned_name.components[self->prefix.components_size];
+    if(comp->size == version->size && memcmp(comp->value, version->value, comp->size) == 0){
+      return &self->versions[i];
+    }
+  }
+  return NULL;
+}
+
+static int
+ndn_status_on_interest(const uint8_t* interest, uint32_t interest_size, void* userdata){
+  ndn_status_t* self = (ndn_status_t*)userdata;
+  ndn_status_version_t *current, *previous;
+  ndn_interest_view_t view;
+  ndn_component_view_t comp;
+  ndn_time_ms_t now = ndn_time_now_ms();
+  uint64_t segno;
+  ndn_face_intf_t* face = ndn_ingress_get_current_face();
+  int depth = self->prefix.components_size;
+  int count;
+
+  // /localhost scope: never answered on a network face
+  if(face != NULL && face->type == NDN_FACE_TYPE_NET){
+    return NDN_FWD_STRATEGY_SUPPRESS;
+  }
+  if(ndn_interest_view_parse(&view, interest, interest_size) != NDN_SUCCESS){
+    return NDN_FWD_STRATEGY_SUPPRESS;
+  }
+  count = ndn_name_view_count(view.name, view.name_size);
+
+  if(count == depth){
+    current = &self->versions[self->current];
+    previous = &self->versions[self->current ^ 1];
+    // The new version replaces the previous one, so wait until nobody
+    // has fetched the previous one for a while
+    if((current->segment_count == 0 || now - current->version >= NDN_STATUS_MIN_INTERVAL) &&
+       (previous->segment_count == 0 || now - previous->last_fetch >= NDN_STATUS_IDLE_TIME)){
+      if(ndn_status_snapshot(self, previous) == NDN_SUCCESS){
+        self->current ^= 1;
+        current = previous;
+      }
+    }
+    if(current->segment_count == 0){
+      return NDN_FWD_STRATEGY_SUPPRESS;
+    }
+    current->last_fetch = now;
+    ndn_forwarder_put_data(current->segments, current->segment_sizes[0]);
+    return NDN_FWD_STRATEGY_SUPPRESS;
+  }
+
+  // Segments of the current and the previous version are served
+  if(count != depth + 2 ||
+     ndn_name_view_component(view.name, view.name_size, depth, &comp) != NDN_SUCCESS){
+    return NDN_FWD_STRATEGY_SUPPRESS;
+  }
+  current = ndn_status_find_version(self, &comp);
+  if(current == NULL || ndn_name_view_segment(view.name, view.name_size, &segno) != NDN_SUCCESS){
+    return NDN_FWD_STRATEGY_SUPPRESS;
+  }
+  if(segno < current->segment_count){
+    current->last_fetch = now;
+    ndn_forwarder_put_data(current->segments + (size_t)segno * NDN_STATUS_DATA_SIZE,
+                           current->segment_sizes[segno]);
+  }
+  return NDN_FWD_STRATEGY_SUPPRESS;
+}
+
+int
+ndn_status_serve(void){
+  ndn_status_t* self = &status_instance;
+  uint8_t buf[128];
+  ndn_encoder_t encoder;
+  int ret;
+
+  ret = ndn_name_kernels_from_uri(&self->prefix, NDN_STATUS_PREFIX, strlen(NDN_STATUS_PREFIX));
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  self->versions[0].segment_count = 0;
+  self->versions[1].segment_count = 0;
+  self->current = 0;
+
+  encoder_init(&encoder, buf, sizeof(buf));
+  ret = ndn_name_tlv_encode(&encoder, &self->prefix);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  return ndn_forwarder_register_prefix(encoder.output_value, encoder.offset, ndn_status_on_interest, self);
+}
+
+void
+ndn_status_set_cs_mmap(ndn_cs_mmap_t* cs){
+  status_instance.cs = cs;
+}
+
+int
+ndn_status_add_strategy_face(ndn_strategy_face_t* face){
+  ndn_status_t* self = &status_instance;
+
+  if(self->strategy_count >= NDN_STATUS_MAX_STRATEGIES){
+    return NDN_FWD_NO_MEM;
+  }
+  self->strategies[self->strategy_count ++] = face;
+  return NDN_SUCCESS;
+}
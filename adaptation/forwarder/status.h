@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#ifndef NDN_STATUS_H_
+#define NDN_STATUS_H_
+
+#include <stdint.h>
+#include "cs-mmap.h"
+#include "strategy-face.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NDN_STATUS_PREFIX "/localhost/ndn-lite/status"
+
+// Segments reserved at first; more are allocated when the dataset grows
+#define NDN_STATUS_INITIAL_SEGMENTS 16
+#define NDN_STATUS_SEGMENT_SIZE 1024
+#define NDN_STATUS_DATA_SIZE (NDN_STATUS_SEGMENT_SIZE + 256)
+#define NDN_STATUS_MAX_STRATEGIES 4
+// A new version is taken at most this often, in ms
+#define NDN_STATUS_MIN_INTERVAL 100
+#define NDN_STATUS_FRESHNESS 1000
+// The previous version is kept until no segment of it was fetched for this long, in ms
+#define NDN_STATUS_IDLE_TIME 1000
+
+/**
+ * Dataset TLV types.
+ * The dataset is a sequence of General, Face*, ContentStore? and Prefix*.
+ */
+#define TLV_STATUS_General                0x80
+#define TLV_STATUS_Timestamp              0x81
+#define TLV_STATUS_LiveFaces              0x82
+#define TLV_STATUS_FaceRegistrations      0x83
+#define TLV_STATUS_FaceUnregistrations    0x84
+#define TLV_STATUS_PendingConnections     0x85
+#define TLV_STATUS_DeadNonceEntries       0x86
+#define TLV_STATUS_DeadNonceSuppressed    0x87
+
+#define TLV_STATUS_Face                   0x90
+#define TLV_STATUS_FaceHandle             0x91
+#define TLV_STATUS_FaceId                 0x92
+#define TLV_STATUS_FaceType               0x93
+#define TLV_STATUS_FaceState              0x94
+#define TLV_STATUS_RxPackets              0x95
+#define TLV_STATUS_RxBytes                0x96
+#define TLV_STATUS_TxPackets              0x97
+#define TLV_STATUS_TxBytes                0x98
+#define TLV_STATUS_TxDropped              0x99
+#define TLV_STATUS_QueueDepth             0x9A
+#define TLV_STATUS_CongestionMarks        0x9B
+
+#define TLV_STATUS_ContentStore           0xA0
+#define TLV_STATUS_Entries                0xA1
+#define TLV_STATUS_Hits                   0xA2
+#define TLV_STATUS_Misses                 0xA3
+#define TLV_STATUS_Evictions              0xA4
+
+#define TLV_STATUS_Prefix                 0xB0
+#define TLV_STATUS_NextHop                0xB1
+#define TLV_STATUS_Srtt                   0xB2
+#define TLV_STATUS_Rttvar                 0xB3
+#define TLV_STATUS_Samples                0xB4
+#define TLV_STATUS_Timeouts               0xB5
+#define TLV_STATUS_Failovers              0xB6
+
+/**
+ * Serve the status dataset under NDN_STATUS_PREFIX.
+ *
+ * An Interest for the prefix itself (with CanBePrefix) takes a new snapshot
+ * and gets segment 0 of /prefix/<version>/<segment>. The other segments are
+ * fetched by their full names and are served from the same snapshot.
+ * The previous version stays available while it is being fetched: a new
+ * snapshot is only taken once it has been idle for NDN_STATUS_IDLE_TIME.
+ * The dataset is only served to local faces: Interests from network faces
+ * are dropped, as the /localhost scope requires.
+ */
+int
+ndn_status_serve(void);
+
+/**
+ * Include the statistics of a persistent Content Store.
+ */
+void
+ndn_status_set_cs_mmap(ndn_cs_mmap_t* cs);
+
+/**
+ * Include the per-prefix measurements of a strategy face.
+ */
+int
+ndn_status_add_strategy_face(ndn_strategy_face_t* face);
+
+/**
+ * Encode the current dataset.
+ * @param[out] used The encoded size.
+ * @return NDN_SUCCESS, or NDN_OVERSIZE if it does not fit. The dataset has
+ *         no size limit, so the caller retries with a larger buffer.
+ */
+int
+ndn_status_encode(uint8_t* buf, uint32_t size, uint32_t* used);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,477 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "strategy-face.h"
+#include "ingress.h"
+#include "pkt-peek.h"
+#include "nack.h"
+#include "ndn-lite/ndn-enums.h"
+#include "ndn-lite/ndn-error-code.h"
+#include "ndn-lite/ndn-constants.h"
+
+// Marks an Interest that matches none of the measured prefixes
+#define NDN_STRATEGY_NO_PREFIX 0xFF
+
+static int
+ndn_strategy_face_up(struct ndn_face_intf* self);
+
+static int
+ndn_strategy_face_down(struct ndn_face_intf* self);
+
+static void
+ndn_strategy_face_destroy(ndn_face_intf_t* self);
+
+static int
+ndn_strategy_face_send(ndn_face_intf_t* self, const uint8_t* packet, uint32_t size);
+
+static void
+ndn_strategy_face_timer(void *self, size_t param_len, void *param);
+
+static void
+ndn_strategy_face_on_receive(ndn_face_intf_t* face, const uint8_t* packet, uint32_t size,
+                             const ndn_pkt_peek_t* peek, void* userdata);
+
+static ndn_time_us_t
+strategy_now_us(void);
+
+static ndn_time_us_t
+strategy_rto(const ndn_strategy_stats_t* stats);
+
+static int
+strategy_select(ndn_strategy_face_t* self, uint8_t prefix, uint8_t exclude);
+
+static void
+strategy_send_to(ndn_strategy_face_t* self, ndn_strategy_pending_t* entry, int nexthop, ndn_time_us_t now);
+
+static ndn_strategy_pending_t*
+strategy_alloc_pending(ndn_strategy_face_t* self);
+
+static void
+strategy_on_nack(ndn_strategy_face_t* self, int nexthop, const ndn_pkt_peek_t* peek);
+
+static uint8_t
+strategy_outstanding(const ndn_strategy_pending_t* entry);
+
+static uint8_t
+strategy_in_face_mask(ndn_strategy_face_t* self);
+
+static bool
+strategy_data_matches(const ndn_strategy_pending_t* entry, const ndn_pkt_peek_t* peek);
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+static int
+ndn_strategy_face_up(struct ndn_face_intf* self){
+  ndn_strategy_face_t* ptr = container_of(self, ndn_strategy_face_t, intf);
+
+  if(self->state == NDN_FACE_STATE_UP){
+    return NDN_SUCCESS;
+  }
+  ptr->timer_event = ndn_msgqueue_post(ptr, ndn_strategy_face_timer, 0, NULL);
+  if(ptr->timer_event == NULL){
+    return NDN_FWD_MSGQUEUE_FULL;
+  }
+  self->state = NDN_FACE_STATE_UP;
+  return NDN_SUCCESS;
+}
+
+static int
+ndn_strategy_face_down(struct ndn_face_intf* self){
+  ndn_strategy_face_t* ptr = container_of(self, ndn_strategy_face_t, intf);
+
+  self->state = NDN_FACE_STATE_DOWN;
+  if(ptr->timer_event != NULL){
+    ndn_msgqueue_cancel(ptr->timer_event);
+    ptr->timer_event = NULL;
+  }
+  return NDN_SUCCESS;
+}
+
+static void
+ndn_strategy_face_destroy(ndn_face_intf_t* self){
+  ndn_strategy_face_t* ptr = container_of(self, ndn_strategy_face_t, intf);
+
+  ndn_face_down(self);
+  ndn_ingress_remove_observer(ndn_strategy_face_on_receive, ptr);
+  ndn_forwarder_unregister_face(self);
+  ndn_name_arena_destroy(&ptr->names);
+  free(ptr);
+}
+
+static ndn_time_us_t
+strategy_now_us(void){
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (ndn_time_us_t)now.tv_sec * 1000000 + (ndn_time_us_t)now.tv_nsec / 1000;
+}
+
+static ndn_time_us_t
+strategy_rto(const ndn_strategy_stats_t* stats){
+  ndn_time_us_t rto;
+
+  if(stats->samples == 0){
+    return NDN_STRATEGY_INITIAL_RTT * 2;
+  }
+  rto = stats->srtt + 4 * stats->rttvar;
+  return rto < NDN_STRATEGY_MIN_RTO ? NDN_STRATEGY_MIN_RTO : rto;
+}
+
+static int
+strategy_select(ndn_strategy_face_t* self, uint8_t prefix, uint8_t exclude){
+  const ndn_strategy_stats_t* stats;
+  ndn_time_us_t score, best_score = 0;
+  uint32_t backoff;
+  int i, best = -1;
+
+  for(i = 0; i < self->nexthop_count; i ++){
+    if((exclude & (1 << i)) || self->nexthops[i]->state != NDN_FACE_STATE_UP){
+      continue;
+    }
+    if(prefix == NDN_STRATEGY_NO_PREFIX){
+      return i;
+    }
+    stats = &self->prefixes[prefix].stats[i];
+    score = stats->samples > 0 ? stats->srtt : NDN_STRATEGY_INITIAL_RTT;
+    // Penalize next hops that keep timing out
+    backoff = stats->consecutive_timeouts < 8 ? stats->consecutive_timeouts : 8;
+    score <<= backoff;
+    if(best < 0 || score < best_score){
+      best = i;
+      best_score = score;
+    }
+  }
+  return best;
+}
+
+static void
+strategy_send_to(ndn_strategy_face_t* self, ndn_strategy_pending_t* entry, int nexthop, ndn_time_us_t now){
+  entry->tried |= (1 << nexthop);
+  entry->sent_at[nexthop] = now;
+  entry->last = nexthop;
+  ndn_face_send(self->nexthops[nexthop], entry->interest, entry->size);
+}
+
+static uint8_t
+strategy_outstanding(const ndn_strategy_pending_t* entry){
+  return entry->tried & ~entry->timed_out & ~entry->answered;
+}
+
+static uint8_t
+strategy_in_face_mask(ndn_strategy_face_t* self){
+  ndn_face_intf_t* in_face = ndn_ingress_get_current_face();
+  int i;
+
+  for(i = 0; i < self->nexthop_count; i ++){
+    if(self->nexthops[i] == in_face){
+      return (uint8_t)(1 << i);
+    }
+  }
+  return 0;
+}
+
+static bool
+strategy_data_matches(const ndn_strategy_pending_t* entry, const ndn_pkt_peek_t* peek){
+  const uint8_t* name = entry->interest + entry->name_offset;
+
+  if(entry->can_be_prefix){
+    return ndn_pkt_name_is_prefix(name, entry->name_size, peek->name, peek->name_size);
+  }
+  return entry->name_size == peek->name_size && memcmp(name, peek->name, peek->name_size) == 0;
+}
+
+// NULL if every entry is in use: an outstanding Interest is never dropped
+// from the table, or its next hops would miss their samples and timeouts
+static ndn_strategy_pending_t*
+strategy_alloc_pending(ndn_strategy_face_t* self){
+  int i;
+
+  for(i = 0; i < NDN_STRATEGY_PENDING_SIZE; i ++){
+    if(!self->pending[i].in_use){
+      return &self->pending[i];
+    }
+  }
+  return NULL;
+}
+
+static int
+ndn_strategy_face_send(ndn_face_intf_t* self, const uint8_t* packet, uint32_t size){
+  ndn_strategy_face_t* ptr = container_of(self, ndn_strategy_face_t, intf);
+  ndn_strategy_pending_t* entry;
+  ndn_strategy_prefix_t* prefix;
+  ndn_time_us_t now;
+  ndn_pkt_peek_t peek;
+  uint8_t matched = NDN_STRATEGY_NO_PREFIX;
+  uint32_t matched_size = 0;
+  uint8_t excluded;
+  int i, best, probe;
+
+  // Only Interests are routed to a strategy face
+  if(ndn_pkt_peek(packet, size, &peek) != NDN_SUCCESS || peek.type != TLV_Interest){
+    return NDN_SUCCESS;
+  }
+  for(i = 0; i < ptr->prefix_count; i ++){
+    prefix = &ptr->prefixes[i];
+    if(prefix->name.size > matched_size &&
+       ndn_pkt_name_is_prefix(ndn_compact_name_wire(&ptr->names, &prefix->name), prefix->name.size,
+                              peek.name, peek.name_size)){
+      matched = i;
+      matched_size = prefix->name.size;
+    }
+  }
+
+  excluded = strategy_in_face_mask(ptr);
+  best = strategy_select(ptr, matched, excluded);
+  if(best < 0){
+    ndn_nack_return(&peek, NDN_NACK_NO_ROUTE, NULL);
+    return NDN_FWD_NO_ROUTE;
+  }
+  entry = NULL;
+  if(size <= NDN_STRATEGY_INTEREST_SIZE && matched != NDN_STRATEGY_NO_PREFIX){
+    entry = strategy_alloc_pending(ptr);
+    if(entry == NULL){
+      ptr->pending_overflows ++;
+    }
+  }
+  if(entry == NULL){
+    // Forward without measurements
+    return ndn_face_send(ptr->nexthops[best], packet, size);
+  }
+
+  now = strategy_now_us();
+  entry->in_use = true;
+  entry->prefix = matched;
+  entry->tried = 0;
+  entry->timed_out = 0;
+  entry->answered = 0;
+  entry->excluded = excluded;
+  entry->can_be_prefix = peek.can_be_prefix;
+  entry->name_offset = (uint16_t)(peek.name - packet);
+  entry->name_size = (uint16_t)peek.name_size;
+  entry->expire_at = now + peek.lifetime * 1000;
+  entry->size = size;
+  memcpy(entry->interest, packet, size);
+  strategy_send_to(ptr, entry, best, now);
+
+  prefix = &ptr->prefixes[matched];
+  if(now - prefix->last_probe >= NDN_STRATEGY_PROBE_INTERVAL && ptr->nexthop_count > 1){
+    prefix->last_probe = now;
+    for(i = 1; i < ptr->nexthop_count; i ++){
+      probe = (prefix->probe_cursor + i) % ptr->nexthop_count;
+      if(probe != best && !(excluded & (1 << probe)) &&
+         ptr->nexthops[probe]->state == NDN_FACE_STATE_UP){
+        prefix->probe_cursor = probe;
+        strategy_send_to(ptr, entry, probe, now);
+        entry->last = best;
+        break;
+      }
+    }
+  }
+  return NDN_SUCCESS;
+}
+
+static void
+strategy_on_nack(ndn_strategy_face_t* self, int nexthop, const ndn_pkt_peek_t* peek){
+  ndn_strategy_pending_t* entry;
+  ndn_strategy_stats_t* stats;
+  int i, next;
+
+  for(i = 0; i < NDN_STRATEGY_PENDING_SIZE; i ++){
+    entry = &self->pending[i];
+    if(!entry->in_use || !(strategy_outstanding(entry) & (1 << nexthop)) ||
+       entry->name_size != peek->name_size ||
+       memcmp(entry->interest + entry->name_offset, peek->name, peek->name_size) != 0){
+      continue;
+    }
+    // Treat a Nack as an immediate timeout of that next hop
+    self->nacks ++;
+    entry->timed_out |= (1 << nexthop);
+    stats = &self->prefixes[entry->prefix].stats[nexthop];
+    stats->consecutive_timeouts ++;
+    if(entry->answered != 0){
+      // A probe lost to Data already returned; the consumer is satisfied
+      ndn_ingress_claim_nack();
+      entry->in_use = (strategy_outstanding(entry) != 0);
+      continue;
+    }
+    next = strategy_select(self, entry->prefix, entry->tried | entry->excluded);
+    if(next >= 0){
+      self->failovers ++;
+      ndn_ingress_claim_nack();
+      strategy_send_to(self, entry, next, strategy_now_us());
+    }else if(strategy_outstanding(entry) != 0){
+      // Another next hop may still answer
+      ndn_ingress_claim_nack();
+    }else{
+      entry->in_use = false;
+    }
+  }
+}
+
+static void
+ndn_strategy_face_on_receive(ndn_face_intf_t* face, const uint8_t* packet, uint32_t size,
+                             const ndn_pkt_peek_t* peek, void* userdata){
+  ndn_strategy_face_t* self = (ndn_strategy_face_t*)userdata;
+  ndn_strategy_pending_t* entry;
+  ndn_strategy_stats_t* stats;
+  ndn_time_us_t now, sample, delta;
+  int i, nexthop = -1;
+
+  if(peek->type != TLV_Data && !peek->is_nack){
+    return;
+  }
+  for(i = 0; i < self->nexthop_count; i ++){
+    if(self->nexthops[i] == face){
+      nexthop = i;
+      break;
+    }
+  }
+  if(nexthop < 0){
+    return;
+  }
+  if(peek->is_nack){
+    strategy_on_nack(self, nexthop, peek);
+    return;
+  }
+
+  now = strategy_now_us();
+  for(i = 0; i < NDN_STRATEGY_PENDING_SIZE; i ++){
+    entry = &self->pending[i];
+    if(!entry->in_use || !(strategy_outstanding(entry) & (1 << nexthop)) ||
+       !strategy_data_matches(entry, peek)){
+      continue;
+    }
+    // RFC 6298 estimator
+    stats = &self->prefixes[entry->prefix].stats[nexthop];
+    sample = now - entry->sent_at[nexthop];
+    if(stats->samples == 0){
+      stats->srtt = sample;
+      stats->rttvar = sample / 2;
+    }else{
+      delta = stats->srtt > sample ? stats->srtt - sample : sample - stats->srtt;
+      stats->rttvar = (3 * stats->rttvar + delta) / 4;
+      stats->srtt = (7 * stats->srtt + sample) / 8;
+    }
+    stats->samples ++;
+    stats->consecutive_timeouts = 0;
+    // Keep the entry until every other next hop tried answers or times out
+    entry->answered |= (1 << nexthop);
+    entry->in_use = (strategy_outstanding(entry) != 0);
+  }
+}
+
+static void
+ndn_strategy_face_timer(void *self, size_t param_len, void *param){
+  ndn_strategy_face_t* ptr = (ndn_strategy_face_t*)self;
+  ndn_strategy_pending_t* entry;
+  ndn_strategy_stats_t* stats;
+  ndn_time_us_t now = strategy_now_us();
+  uint8_t outstanding;
+  int i, n, next;
+
+  for(i = 0; i < NDN_STRATEGY_PENDING_SIZE; i ++){
+    entry = &ptr->pending[i];
+    if(!entry->in_use){
+      continue;
+    }
+    if(now >= entry->expire_at){
+      entry->in_use = false;
+      continue;
+    }
+    // Charge a timeout to every next hop that missed its RTO, probes included
+    outstanding = strategy_outstanding(entry);
+    for(n = 0; n < ptr->nexthop_count; n ++){
+      stats = &ptr->prefixes[entry->prefix].stats[n];
+      if(!(outstanding & (1 << n)) || now - entry->sent_at[n] < strategy_rto(stats)){
+        continue;
+      }
+      entry->timed_out |= (1 << n);
+      stats->timeouts ++;
+      stats->consecutive_timeouts ++;
+      // Fail over as soon as the RTO of the chosen next hop expires
+      if(n == entry->last && entry->answered == 0){
+        next = strategy_select(ptr, entry->prefix, entry->tried | entry->excluded);
+        if(next >= 0){
+          ptr->failovers ++;
+          strategy_send_to(ptr, entry, next, now);
+        }
+      }
+    }
+    if(entry->answered != 0 && strategy_outstanding(entry) == 0){
+      entry->in_use = false;
+    }
+  }
+
+  ptr->timer_event = ndn_msgqueue_post(self, ndn_strategy_face_timer, param_len, param);
+}
+
+ndn_strategy_face_t*
+ndn_strategy_face_construct(void){
+  ndn_strategy_face_t* ret;
+  int iret;
+
+  ret = (ndn_strategy_face_t*)malloc(sizeof(ndn_strategy_face_t));
+  if(!ret){
+    return NULL;
+  }
+  memset(ret, 0, sizeof(ndn_strategy_face_t));
+
+  ret->intf.face_id = NDN_INVALID_ID;
+  iret = ndn_forwarder_register_face(&ret->intf);
+  if(iret != NDN_SUCCESS){
+    free(ret);
+    return NULL;
+  }
+  if(ndn_ingress_add_observer(ndn_strategy_face_on_receive, ret) != NDN_SUCCESS){
+    ndn_forwarder_unregister_face(&ret->intf);
+    free(ret);
+    return NULL;
+  }
+
+  ret->intf.type = NDN_FACE_TYPE_NET;
+  ret->intf.state = NDN_FACE_STATE_DOWN;
+  ret->intf.up = ndn_strategy_face_up;
+  ret->intf.down = ndn_strategy_face_down;
+  ret->intf.send = ndn_strategy_face_send;
+  ret->intf.destroy = ndn_strategy_face_destroy;
+
+  ret->timer_event = NULL;
+  ndn_face_up(&ret->intf);
+
+  return ret;
+}
+
+int
+ndn_strategy_face_add_nexthop(ndn_strategy_face_t* self, ndn_face_intf_t* face){
+  if(self->nexthop_count >= NDN_STRATEGY_MAX_NEXTHOPS){
+    return NDN_FWD_NO_MEM;
+  }
+  self->nexthops[self->nexthop_count ++] = face;
+  return NDN_SUCCESS;
+}
+
+int
+ndn_strategy_face_add_route(ndn_strategy_face_t* self, uint8_t* prefix, size_t length){
+  ndn_strategy_prefix_t* entry;
+  int ret;
+
+  if(self->prefix_count >= NDN_STRATEGY_MAX_PREFIXES){
+    return NDN_FWD_NO_MEM;
+  }
+  entry = &self->prefixes[self->prefix_count];
+  memset(entry, 0, sizeof(ndn_strategy_prefix_t));
+  ret = ndn_compact_name_from_wire(&self->names, &entry->name, prefix, length);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  self->prefix_count ++;
+  return ndn_forwarder_add_route(&self->intf, prefix, length);
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#ifndef NDN_STRATEGY_FACE_H_
+#define NDN_STRATEGY_FACE_H_
+
+#include "ndn-lite/forwarder/forwarder.h"
+#include "ndn-lite/util/msg-queue.h"
+#include "ndn-lite/util/uniform-time.h"
+#include "compact-name.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NDN_STRATEGY_MAX_NEXTHOPS 4
+#define NDN_STRATEGY_MAX_PREFIXES 8
+#define NDN_STRATEGY_PENDING_SIZE 32
+#define NDN_STRATEGY_INTEREST_SIZE 1024
+
+// RTT estimator parameters, in us of CLOCK_MONOTONIC
+#define NDN_STRATEGY_INITIAL_RTT 100000
+#define NDN_STRATEGY_MIN_RTO 10000
+// Send a copy to an alternative next hop this often per prefix, in us
+#define NDN_STRATEGY_PROBE_INTERVAL 1000000
+
+/**
+ * Smoothed RTT and timeout statistics of one (prefix, next hop).
+ */
+typedef struct ndn_strategy_stats {
+  ndn_time_us_t srtt;
+  ndn_time_us_t rttvar;
+  uint32_t samples;
+  uint32_t timeouts;
+  uint32_t consecutive_timeouts;
+} ndn_strategy_stats_t;
+
+typedef struct ndn_strategy_prefix {
+  ndn_compact_name_t name;
+  ndn_strategy_stats_t stats[NDN_STRATEGY_MAX_NEXTHOPS];
+  ndn_time_us_t last_probe;
+  uint8_t probe_cursor;
+} ndn_strategy_prefix_t;
+
+/**
+ * An Interest sent through the strategy and not yet answered.
+ */
+typedef struct ndn_strategy_pending {
+  bool in_use;
+  uint8_t prefix;
+  /**
+   * Bitmaps of next hops: sent to, timed out or Nacked, answered with Data,
+   * and never to be used, i.e. the face the Interest came from.
+   */
+  uint8_t tried;
+  uint8_t timed_out;
+  uint8_t answered;
+  uint8_t excluded;
+  uint8_t last;
+  // Data may then have a longer name than the Interest
+  bool can_be_prefix;
+  uint16_t name_offset;
+  uint16_t name_size;
+  // CLOCK_MONOTONIC, so that a change of the wall clock is no RTT sample
+  ndn_time_us_t sent_at[NDN_STRATEGY_MAX_NEXTHOPS];
+  ndn_time_us_t expire_at;
+  uint32_t size;
+  uint8_t interest[NDN_STRATEGY_INTEREST_SIZE];
+} ndn_strategy_pending_t;
+
+/**
+ * Adaptive multipath strategy face.
+ *
+ * A virtual face that is the only FIB next hop of its prefixes and spreads
+ * Interests over several real next hops. New Interests go to the next hop
+ * with the lowest smoothed RTT, and a copy is sent to an alternative one
+ * once per probe interval to keep its measurement fresh. If no Data comes
+ * back within the RTO of the chosen next hop, the Interest is retried on
+ * the next best one without waiting for the InterestLifetime.
+ * An Interest is never sent back to the face it came from.
+ *
+ * Every next hop an Interest was sent to is measured: each one that
+ * answers gives an RTT sample, and each one that does not answer within
+ * its RTO counts a timeout, whether or not another one answered first.
+ */
+typedef struct ndn_strategy_face {
+  /**
+   * The inherited interface.
+   */
+  ndn_face_intf_t intf;
+
+  ndn_face_intf_t* nexthops[NDN_STRATEGY_MAX_NEXTHOPS];
+  uint8_t nexthop_count;
+
+  ndn_strategy_prefix_t prefixes[NDN_STRATEGY_MAX_PREFIXES];
+  uint8_t prefix_count;
+  ndn_name_arena_t names;
+
+  ndn_strategy_pending_t pending[NDN_STRATEGY_PENDING_SIZE];
+  struct ndn_msg* timer_event;
+
+  /**
+   * Number of Interests retried on another next hop after an RTO expired.
+   */
+  uint64_t failovers;
+
+  /**
+   * Number of Nacks received from next hops.
+   */
+  uint64_t nacks;
+
+  /**
+   * Number of Interests forwarded without measurements because every
+   * pending entry was in use.
+   */
+  uint64_t pending_overflows;
+} ndn_strategy_face_t;
+
+ndn_strategy_face_t*
+ndn_strategy_face_construct(void);
+
+/**
+ * Add a real face as a candidate next hop.
+ * The face should not be routed for the same prefixes directly.
+ */
+int
+ndn_strategy_face_add_nexthop(ndn_strategy_face_t* self, ndn_face_intf_t* face);
+
+/**
+ * Route a prefix to the strategy and start keeping measurements for it.
+ * @param prefix Name TLV of the prefix.
+ */
+int
+ndn_strategy_face_add_route(ndn_strategy_face_t* self, uint8_t* prefix, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,452 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+#include "submit-queue.h"
+#include "ndn-lite/util/msg-queue.h"
+
+enum {
+  NDN_SUBMIT_EXPRESS,
+  NDN_SUBMIT_PUT,
+  NDN_SUBMIT_REGISTER,
+  NDN_COMPLETE_DATA,
+  NDN_COMPLETE_TIMEOUT,
+};
+
+/**
+ * A submitted operation, or a completion on its way back.
+ */
+typedef struct ndn_submit_op {
+  uint8_t type;
+  ndn_on_data_func on_data;
+  ndn_on_timeout_func on_timeout;
+  ndn_on_interest_func on_interest;
+  void* userdata;
+  ndn_completion_queue_t* cq;
+  size_t size;
+  uint8_t data[];
+} ndn_submit_op_t;
+
+typedef struct ndn_submit_queue {
+  ndn_mpsc_ring_t ring;
+  atomic_bool signaled;
+  int fd;
+  int wake_fd;
+  struct ndn_msg* process_event;
+} ndn_submit_queue_t;
+
+static ndn_submit_queue_t submit_queue = {.fd = -1, .wake_fd = -1};
+
+static ndn_submit_op_t*
+ndn_submit_op_create(uint8_t type, const uint8_t* data, size_t size);
+
+static int
+ndn_submit(ndn_submit_op_t* op);
+
+static void
+ndn_submit_complete(ndn_submit_op_t* op, uint8_t type, const uint8_t* data, size_t size);
+
+static void
+ndn_submit_on_data(const uint8_t* data, uint32_t data_size, void* userdata);
+
+static void
+ndn_submit_on_timeout(void* userdata);
+
+static void
+ndn_submit_execute(ndn_submit_op_t* op);
+
+static void
+ndn_submit_queue_drain(void *self, size_t param_len, void *param);
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+int
+ndn_mpsc_ring_init(ndn_mpsc_ring_t* self, size_t size){
+  size_t i;
+
+  self->slots = (ndn_mpsc_slot_t*)malloc(size * sizeof(ndn_mpsc_slot_t));
+  if(self->slots == NULL){
+    return NDN_FWD_NO_MEM;
+  }
+  for(i = 0; i < size; i ++){
+    atomic_init(&self->slots[i].seq, i);
+    self->slots[i].item = NULL;
+  }
+  self->mask = size - 1;
+  atomic_init(&self->head, 0);
+  self->tail = 0;
+  return NDN_SUCCESS;
+}
+
+void
+ndn_mpsc_ring_destroy(ndn_mpsc_ring_t* self){
+  free(self->slots);
+  self->slots = NULL;
+}
+
+bool
+ndn_mpsc_ring_push(ndn_mpsc_ring_t* self, void* item){
+  size_t pos = atomic_load_explicit(&self->head, memory_order_relaxed);
+  ndn_mpsc_slot_t* slot;
+  size_t seq;
+  intptr_t diff;
+
+  while(true){
+    slot = &self->slots[pos & self->mask];
+    seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+    diff = (intptr_t)seq - (intptr_t)pos;
+    if(diff == 0){
+      // The slot is free: claim it
+      if(atomic_compare_exchange_weak_explicit(&self->head, &pos, pos + 1,
+                                               memory_order_relaxed, memory_order_relaxed)){
+        break;
+      }
+    }else if(diff < 0){
+      // The consumer has not released this slot yet: full
+      return false;
+    }else{
+      pos = atomic_load_explicit(&self->head, memory_order_relaxed);
+    }
+  }
+
+  slot->item = item;
+  atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+  return true;
+}
+
+void*
+ndn_mpsc_ring_pop(ndn_mpsc_ring_t* self){
+  ndn_mpsc_slot_t* slot = &self->slots[self->tail & self->mask];
+  void* item;
+
+  if(atomic_load_explicit(&slot->seq, memory_order_acquire) != self->tail + 1){
+    return NULL;
+  }
+  item = slot->item;
+  atomic_store_explicit(&slot->seq, self->tail + self->mask + 1, memory_order_release);
+  self->tail ++;
+  return item;
+}
+
+int
+ndn_wakeup_fd_open(int fds[2]){
+#ifdef __linux__
+  fds[0] = fds[1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  return fds[0] == -1 ? -1 : 0;
+#else
+  if(pipe(fds) == -1){
+    return -1;
+  }
+  fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL, 0) | O_NONBLOCK);
+  fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL, 0) | O_NONBLOCK);
+  return 0;
+#endif
+}
+
+void
+ndn_wakeup_fd_close(int fd, int wake_fd){
+  close(fd);
+  if(wake_fd != fd){
+    close(wake_fd);
+  }
+}
+
+void
+ndn_wakeup_signal(atomic_bool* signaled, int fd){
+  uint64_t one = 1;
+  ssize_t ret;
+
+  // One write per wakeup, however many producers pushed meanwhile
+  if(!atomic_exchange(signaled, true)){
+    ret = write(fd, &one, sizeof(one));
+    (void)ret;
+  }
+}
+
+void
+ndn_wakeup_clear(atomic_bool* signaled, int fd){
+  uint64_t value;
+
+  // Clear before draining, so a push after this point signals again
+  if(atomic_exchange(signaled, false)){
+    while(read(fd, &value, sizeof(value)) > 0);
+  }
+}
+
+static ndn_submit_op_t*
+ndn_submit_op_create(uint8_t type, const uint8_t* data, size_t size){
+  ndn_submit_op_t* op;
+
+  op = (ndn_submit_op_t*)malloc(sizeof(ndn_submit_op_t) + size);
+  if(op == NULL){
+    return NULL;
+  }
+  memset(op, 0, sizeof(ndn_submit_op_t));
+  op->type = type;
+  op->size = size;
+  if(size > 0){
+    memcpy(op->data, data, size);
+  }
+  return op;
+}
+
+static int
+ndn_submit(ndn_submit_op_t* op){
+  if(submit_queue.fd == -1){
+    free(op);
+    return NDN_FWD_MSGQUEUE_FULL;
+  }
+  if(!ndn_mpsc_ring_push(&submit_queue.ring, op)){
+    free(op);
+    return NDN_FWD_MSGQUEUE_FULL;
+  }
+  ndn_wakeup_signal(&submit_queue.signaled, submit_queue.wake_fd);
+  return NDN_SUCCESS;
+}
+
+int
+ndn_submit_express_interest(const uint8_t* interest, size_t length,
+                            ndn_on_data_func on_data, ndn_on_timeout_func on_timeout,
+                            void* userdata, ndn_completion_queue_t* cq)
+{
+  ndn_submit_op_t* op;
+  int ret;
+
+  // Reserve the slot of the completion now, so that it is never dropped
+  if(cq != NULL && atomic_fetch_add(&cq->outstanding, 1) >= NDN_COMPLETION_QUEUE_SIZE){
+    atomic_fetch_sub(&cq->outstanding, 1);
+    return NDN_FWD_MSGQUEUE_FULL;
+  }
+  op = ndn_submit_op_create(NDN_SUBMIT_EXPRESS, interest, length);
+  if(op == NULL){
+    ret = NDN_FWD_NO_MEM;
+  }else{
+    op->on_data = on_data;
+    op->on_timeout = on_timeout;
+    op->userdata = userdata;
+    op->cq = cq;
+    ret = ndn_submit(op);
+  }
+  if(ret != NDN_SUCCESS && cq != NULL){
+    atomic_fetch_sub(&cq->outstanding, 1);
+  }
+  return ret;
+}
+
+int
+ndn_submit_put_data(const uint8_t* data, size_t length){
+  ndn_submit_op_t* op = ndn_submit_op_create(NDN_SUBMIT_PUT, data, length);
+
+  if(op == NULL){
+    return NDN_FWD_NO_MEM;
+  }
+  return ndn_submit(op);
+}
+
+int
+ndn_submit_register_prefix(const uint8_t* prefix, size_t length,
+                           ndn_on_interest_func on_interest, void* userdata)
+{
+  ndn_submit_op_t* op = ndn_submit_op_create(NDN_SUBMIT_REGISTER, prefix, length);
+
+  if(op == NULL){
+    return NDN_FWD_NO_MEM;
+  }
+  op->on_interest = on_interest;
+  op->userdata = userdata;
+  return ndn_submit(op);
+}
+
+static void
+ndn_submit_complete(ndn_submit_op_t* op, uint8_t type, const uint8_t* data, size_t size){
+  ndn_submit_op_t* completion = NULL;
+  ndn_completion_queue_t* cq = op->cq;
+
+  if(type == NDN_COMPLETE_DATA){
+    completion = ndn_submit_op_create(type, data, size);
+  }
+  if(completion != NULL){
+    completion->on_data = op->on_data;
+    completion->on_timeout = op->on_timeout;
+    completion->userdata = op->userdata;
+    free(op);
+  }else{
+    // A timeout carries nothing, so the op itself is delivered. So is Data
+    // that cannot be copied: the application sees it as a timeout.
+    op->type = NDN_COMPLETE_TIMEOUT;
+    op->size = 0;
+    completion = op;
+  }
+
+  // Cannot fail: the slot was reserved when the Interest was submitted
+  ndn_mpsc_ring_push(&cq->ring, completion);
+  ndn_wakeup_signal(&cq->signaled, cq->wake_fd);
+}
+
+static void
+ndn_submit_on_data(const uint8_t* data, uint32_t data_size, void* userdata){
+  ndn_submit_complete((ndn_submit_op_t*)userdata, NDN_COMPLETE_DATA, data, data_size);
+}
+
+static void
+ndn_submit_on_timeout(void* userdata){
+  ndn_submit_complete((ndn_submit_op_t*)userdata, NDN_COMPLETE_TIMEOUT, NULL, 0);
+}
+
+static void
+ndn_submit_execute(ndn_submit_op_t* op){
+  int ret;
+
+  switch(op->type){
+  case NDN_SUBMIT_EXPRESS:
+    if(op->cq != NULL){
+      // The op is kept as the context of the callbacks
+      ret = ndn_forwarder_express_interest(op->data, op->size,
+                                           ndn_submit_on_data, ndn_submit_on_timeout, op);
+      if(ret != NDN_SUCCESS){
+        ndn_submit_on_timeout(op);
+      }
+      return;
+    }
+    ret = ndn_forwarder_express_interest(op->data, op->size, op->on_data, op->on_timeout, op->userdata);
+    if(ret != NDN_SUCCESS && op->on_timeout != NULL){
+      // The submitter cannot see the return value
+      op->on_timeout(op->userdata);
+    }
+    break;
+
+  case NDN_SUBMIT_PUT:
+    ret = ndn_forwarder_put_data(op->data, op->size);
+    break;
+
+  case NDN_SUBMIT_REGISTER:
+    ret = ndn_forwarder_register_prefix(op->data, op->size, op->on_interest, op->userdata);
+    break;
+  }
+  free(op);
+}
+
+static void
+ndn_submit_queue_drain(void *self, size_t param_len, void *param){
+  ndn_submit_queue_t* queue = (ndn_submit_queue_t*)self;
+  ndn_submit_op_t* op;
+  int i;
+
+  queue->process_event = NULL;
+  ndn_wakeup_clear(&queue->signaled, queue->fd);
+
+  for(i = 0; i < NDN_SUBMIT_BATCH_SIZE; i ++){
+    op = (ndn_submit_op_t*)ndn_mpsc_ring_pop(&queue->ring);
+    if(op == NULL){
+      break;
+    }
+    ndn_submit_execute(op);
+  }
+  if(i == NDN_SUBMIT_BATCH_SIZE){
+    // More left for the next iteration; keep the fd readable
+    ndn_wakeup_signal(&queue->signaled, queue->wake_fd);
+  }
+
+  queue->process_event = ndn_msgqueue_post(self, ndn_submit_queue_drain, param_len, param);
+}
+
+int
+ndn_submit_queue_init(void){
+  int fds[2];
+  int ret;
+
+  if(submit_queue.fd != -1){
+    return NDN_SUCCESS;
+  }
+  ret = ndn_mpsc_ring_init(&submit_queue.ring, NDN_SUBMIT_QUEUE_SIZE);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  if(ndn_wakeup_fd_open(fds) == -1){
+    ndn_mpsc_ring_destroy(&submit_queue.ring);
+    return NDN_FWD_NO_MEM;
+  }
+  atomic_init(&submit_queue.signaled, false);
+  submit_queue.process_event = ndn_msgqueue_post(&submit_queue, ndn_submit_queue_drain, 0, NULL);
+  if(submit_queue.process_event == NULL){
+    ndn_wakeup_fd_close(fds[0], fds[1]);
+    ndn_mpsc_ring_destroy(&submit_queue.ring);
+    return NDN_FWD_MSGQUEUE_FULL;
+  }
+  submit_queue.fd = fds[0];
+  submit_queue.wake_fd = fds[1];
+  return NDN_SUCCESS;
+}
+
+int
+ndn_submit_queue_get_fd(void){
+  return submit_queue.fd;
+}
+
+ndn_completion_queue_t*
+ndn_completion_queue_create(void){
+  ndn_completion_queue_t* ret;
+  int fds[2];
+
+  ret = (ndn_completion_queue_t*)malloc(sizeof(ndn_completion_queue_t));
+  if(ret == NULL){
+    return NULL;
+  }
+  if(ndn_mpsc_ring_init(&ret->ring, NDN_COMPLETION_QUEUE_SIZE) != NDN_SUCCESS){
+    free(ret);
+    return NULL;
+  }
+  if(ndn_wakeup_fd_open(fds) == -1){
+    ndn_mpsc_ring_destroy(&ret->ring);
+    free(ret);
+    return NULL;
+  }
+  atomic_init(&ret->signaled, false);
+  atomic_init(&ret->outstanding, 0);
+  ret->fd = fds[0];
+  ret->wake_fd = fds[1];
+  return ret;
+}
+
+int
+ndn_completion_queue_destroy(ndn_completion_queue_t* self){
+  // Each outstanding Interest still refers to the queue in the PIT
+  if(atomic_load(&self->outstanding) != 0){
+    return NDN_FWD_MSGQUEUE_FULL;
+  }
+  ndn_mpsc_ring_destroy(&self->ring);
+  ndn_wakeup_fd_close(self->fd, self->wake_fd);
+  free(self);
+  return NDN_SUCCESS;
+}
+
+int
+ndn_completion_queue_process(ndn_completion_queue_t* self){
+  ndn_submit_op_t* op;
+  int count = 0;
+
+  ndn_wakeup_clear(&self->signaled, self->fd);
+  while((op = (ndn_submit_op_t*)ndn_mpsc_ring_pop(&self->ring)) != NULL){
+    if(op->type == NDN_COMPLETE_DATA && op->on_data != NULL){
+      op->on_data(op->data, op->size, op->userdata);
+    }else if(op->type == NDN_COMPLETE_TIMEOUT && op->on_timeout != NULL){
+      op->on_timeout(op->userdata);
+    }
+    free(op);
+    atomic_fetch_sub(&self->outstanding, 1);
+    count ++;
+  }
+  return count;
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#ifndef NDN_SUBMIT_QUEUE_H_
+#define NDN_SUBMIT_QUEUE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "ndn-lite/forwarder/forwarder.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Ring sizes, must be powers of 2
+#define NDN_SUBMIT_QUEUE_SIZE 1024
+#define NDN_COMPLETION_QUEUE_SIZE 256
+// Operations executed per forwarder loop iteration
+#define NDN_SUBMIT_BATCH_SIZE 64
+
+typedef struct ndn_mpsc_slot {
+  atomic_size_t seq;
+  void* item;
+} ndn_mpsc_slot_t;
+
+/**
+ * Bounded lock-free ring of pointers.
+ * Any number of threads may push; only one thread may pop.
+ */
+typedef struct ndn_mpsc_ring {
+  ndn_mpsc_slot_t* slots;
+  size_t mask;
+  atomic_size_t head;
+  size_t tail;
+} ndn_mpsc_ring_t;
+
+int
+ndn_mpsc_ring_init(ndn_mpsc_ring_t* self, size_t size);
+
+void
+ndn_mpsc_ring_destroy(ndn_mpsc_ring_t* self);
+
+/**
+ * Push from any thread.
+ * @return false if the ring is full.
+ */
+bool
+ndn_mpsc_ring_push(ndn_mpsc_ring_t* self, void* item);
+
+/**
+ * Pop from the consumer thread.
+ * @return The item, or NULL if the ring is empty.
+ */
+void*
+ndn_mpsc_ring_pop(ndn_mpsc_ring_t* self);
+
+/**
+ * Open a wakeup fd pair: fds[0] is polled and drained, fds[1] is written.
+ * With eventfd they are the same.
+ */
+int
+ndn_wakeup_fd_open(int fds[2]);
+
+void
+ndn_wakeup_fd_close(int fd, int wake_fd);
+
+/**
+ * Make the fd readable, once however many producers signal meanwhile.
+ */
+void
+ndn_wakeup_signal(atomic_bool* signaled, int fd);
+
+/**
+ * Drain the fd. Call before popping, so a later push signals again.
+ */
+void
+ndn_wakeup_clear(atomic_bool* signaled, int fd);
+
+/**
+ * Callbacks of a thread that wants its completions delivered back to itself.
+ * The owner waits on the fd and calls ndn_completion_queue_process.
+ */
+typedef struct ndn_completion_queue {
+  ndn_mpsc_ring_t ring;
+  /**
+   * Interests submitted and not yet completed, each holding a ring slot.
+   */
+  atomic_uint outstanding;
+  atomic_bool signaled;
+  int fd;
+  int wake_fd;
+} ndn_completion_queue_t;
+
+/**
+ * Start draining submissions on the forwarder thread.
+ * Call once from the forwarder thread, after ndn_forwarder_init.
+ */
+int
+ndn_submit_queue_init(void);
+
+/**
+ * The fd readable when submissions are waiting.
+ * A forwarder loop may poll it instead of sleeping.
+ */
+int
+ndn_submit_queue_get_fd(void);
+
+/**
+ * Thread-safe ndn_forwarder_express_interest.
+ * The Interest is copied.
+ * @param cq If not NULL, on_data and on_timeout run on the thread owning cq.
+ *   Otherwise, they run on the forwarder thread.
+ * @return NDN_SUCCESS, after which exactly one of on_data and on_timeout
+ *   runs, or NDN_FWD_MSGQUEUE_FULL if either queue is full, e.g. when
+ *   NDN_COMPLETION_QUEUE_SIZE Interests of cq are still outstanding.
+ */
+int
+ndn_submit_express_interest(const uint8_t* interest, size_t length,
+                            ndn_on_data_func on_data, ndn_on_timeout_func on_timeout,
+                            void* userdata, ndn_completion_queue_t* cq);
+
+/**
+ * Thread-safe ndn_forwarder_put_data. The Data is copied.
+ */
+int
+ndn_submit_put_data(const uint8_t* data, size_t length);
+
+/**
+ * Thread-safe ndn_forwarder_register_prefix. The prefix is copied.
+ * A registration that fails on the forwarder thread is not reported.
+ * @remark on_interest runs on the forwarder thread, since its return value
+ *   decides the forwarding strategy of the Interest.
+ */
+int
+ndn_submit_register_prefix(const uint8_t* prefix, size_t length,
+                           ndn_on_interest_func on_interest, void* userdata);
+
+ndn_completion_queue_t*
+ndn_completion_queue_create(void);
+
+/**
+ * Free the queue on the thread owning it.
+ * Every Interest submitted with the queue must have completed first, since
+ * the forwarder thread delivers to the queue until then: call
+ * ndn_completion_queue_process until outstanding is 0.
+ * @return NDN_SUCCESS, or NDN_FWD_MSGQUEUE_FULL if Interests are still
+ *   outstanding, in which case the queue is left as is.
+ */
+int
+ndn_completion_queue_destroy(ndn_completion_queue_t* self);
+
+/**
+ * Run the pending completions on the calling thread.
+ * @return Number of callbacks run.
+ */
+int
+ndn_completion_queue_process(ndn_completion_queue_t* self);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
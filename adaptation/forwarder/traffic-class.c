@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include "traffic-class.h"
+#include "pkt-peek.h"
+#include "compact-name.h"
+#include "ndn-lite/ndn-error-code.h"
+
+typedef struct ndn_traffic_class_rule {
+  ndn_compact_name_t prefix;
+  uint8_t traffic_class;
+} ndn_traffic_class_rule_t;
+
+static ndn_traffic_class_rule_t traffic_class_rules[NDN_TRAFFIC_CLASS_MAX_RULES];
+static int traffic_class_rule_count = 0;
+static ndn_name_arena_t traffic_class_names;
+
+static const uint32_t traffic_class_quanta[NDN_TRAFFIC_CLASS_COUNT] = {
+  0,
+  NDN_TRAFFIC_CLASS_DEFAULT_QUANTUM,
+  NDN_TRAFFIC_CLASS_BULK_QUANTUM,
+};
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+int
+ndn_traffic_class_add(const uint8_t* prefix, uint32_t length, uint8_t traffic_class){
+  ndn_traffic_class_rule_t* rule = NULL;
+  int i, ret;
+
+  if(traffic_class >= NDN_TRAFFIC_CLASS_COUNT){
+    return NDN_OVERSIZE;
+  }
+  for(i = 0; i < traffic_class_rule_count; i ++){
+    if(ndn_compact_name_equals(&traffic_class_names, &traffic_class_rules[i].prefix, prefix, length)){
+      rule = &traffic_class_rules[i];
+      break;
+    }
+  }
+  if(rule == NULL){
+    if(traffic_class_rule_count >= NDN_TRAFFIC_CLASS_MAX_RULES){
+      return NDN_FWD_NO_MEM;
+    }
+    rule = &traffic_class_rules[traffic_class_rule_count];
+    ret = ndn_compact_name_from_wire(&traffic_class_names, &rule->prefix, prefix, length);
+    if(ret != NDN_SUCCESS){
+      return ret;
+    }
+    traffic_class_rule_count ++;
+  }
+  rule->traffic_class = traffic_class;
+  return NDN_SUCCESS;
+}
+
+void
+ndn_traffic_class_remove(const uint8_t* prefix, uint32_t length){
+  ndn_compact_name_t* names[NDN_TRAFFIC_CLASS_MAX_RULES];
+  int i;
+
+  for(i = 0; i < traffic_class_rule_count; i ++){
+    if(ndn_compact_name_equals(&traffic_class_names, &traffic_class_rules[i].prefix, prefix, length)){
+      ndn_compact_name_free(&traffic_class_names, &traffic_class_rules[i].prefix);
+      traffic_class_rule_count --;
+      traffic_class_rules[i] = traffic_class_rules[traffic_class_rule_count];
+      break;
+    }
+  }
+  if(traffic_class_names.wasted > traffic_class_names.used / 2){
+    for(i = 0; i < traffic_class_rule_count; i ++){
+      names[i] = &traffic_class_rules[i].prefix;
+    }
+    ndn_name_arena_compact(&traffic_class_names, names, traffic_class_rule_count);
+  }
+}
+
+uint8_t
+ndn_traffic_class_of(const uint8_t* packet, uint32_t size){
+  ndn_traffic_class_rule_t* rule;
+  ndn_pkt_peek_t peek;
+  uint8_t ret = NDN_TRAFFIC_CLASS_DEFAULT;
+  uint32_t best = 0;
+  int i;
+
+  if(traffic_class_rule_count == 0 || ndn_pkt_peek(packet, size, &peek) != NDN_SUCCESS){
+    return ret;
+  }
+  for(i = 0; i < traffic_class_rule_count; i ++){
+    rule = &traffic_class_rules[i];
+    if(rule->prefix.size > best &&
+       ndn_pkt_name_is_prefix(ndn_compact_name_wire(&traffic_class_names, &rule->prefix), rule->prefix.size,
+                              peek.name, peek.name_size)){
+      best = rule->prefix.size;
+      ret = rule->traffic_class;
+    }
+  }
+  return ret;
+}
+
+uint32_t
+ndn_traffic_class_quantum(uint8_t traffic_class){
+  return traffic_class < NDN_TRAFFIC_CLASS_COUNT ? traffic_class_quanta[traffic_class] : 0;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#ifndef NDN_TRAFFIC_CLASS_H_
+#define NDN_TRAFFIC_CLASS_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Transmit classes. CONTROL is served with strict priority;
+ * the others share the remaining capacity by deficit round robin.
+ */
+#define NDN_TRAFFIC_CLASS_CONTROL 0
+#define NDN_TRAFFIC_CLASS_DEFAULT 1
+#define NDN_TRAFFIC_CLASS_BULK 2
+#define NDN_TRAFFIC_CLASS_COUNT 3
+
+// DRR quantum in bytes per round
+#define NDN_TRAFFIC_CLASS_DEFAULT_QUANTUM 8192
+#define NDN_TRAFFIC_CLASS_BULK_QUANTUM 2048
+
+#define NDN_TRAFFIC_CLASS_MAX_RULES 16
+
+/**
+ * Map a name prefix to a class. The longest matching prefix wins.
+ * Unmatched packets are in NDN_TRAFFIC_CLASS_DEFAULT.
+ * @param prefix Name TLV of the prefix.
+ */
+int
+ndn_traffic_class_add(const uint8_t* prefix, uint32_t length, uint8_t traffic_class);
+
+void
+ndn_traffic_class_remove(const uint8_t* prefix, uint32_t length);
+
+/**
+ * Classify a packet by its name. The packet may be wrapped in an LpPacket.
+ */
+uint8_t
+ndn_traffic_class_of(const uint8_t* packet, uint32_t size);
+
+uint32_t
+ndn_traffic_class_quantum(uint8_t traffic_class);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
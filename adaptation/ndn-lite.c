@@ -1,12 +1,30 @@
 #include "ndn-lite.h"
 #include "security/ndn-lite-rng-posix-crypto-impl.h"
+#include "security/aes-kernels.h"
+#include "security/sha256-kernels.h"
+#include "security/verify-cache.h"
 #include <ndn-lite/security/ndn-lite-sec-config.h>
+#ifdef NDN_LITE_OPENSSL_BACKEND
+#include "security/ndn-lite-openssl-crypto-impl.h"
+#endif
+
+static void
+ndn_lite_posix_security_init(void)
+{
+  ndn_lite_posix_rng_load_backend();
+  ndn_aes_kernels_load_backend();
+  ndn_sha256_kernels_load_backend();
+#ifdef NDN_LITE_OPENSSL_BACKEND
+  ndn_lite_openssl_load_backend();
+#endif
+}
 
 // Temporarily put the helper func here
 void
 ndn_lite_startup()
 {
-  register_platform_security_init(ndn_lite_posix_rng_load_backend);
+  register_platform_security_init(ndn_lite_posix_security_init);
   ndn_security_init();
   ndn_forwarder_init();
+  ndn_verify_cache_startup();
 }
@@ -0,0 +1,752 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include <string.h>
+#include "aes-kernels.h"
+#include "../forwarder/pkt-peek.h"
+#include "ndn-lite/ndn-error-code.h"
+#include "ndn-lite/security/ndn-lite-aes.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define AES_KERNELS_X86
+#endif
+#if defined(__aarch64__) && (defined(__ARM_FEATURE_AES) || defined(__ARM_FEATURE_CRYPTO))
+#include <arm_neon.h>
+#ifdef __linux__
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#define AES_KERNELS_ARM
+#endif
+
+#define BLOCK NDN_AES_KERNELS_BLOCK_SIZE
+#define ROUNDS NDN_AES_KERNELS_ROUNDS
+#define CCM_MAX_AAD_HEADER 6
+
+typedef void (*aes_cbc_func)(const ndn_aes_kernels_key_t* key, uint8_t* chain,
+                             const uint8_t* in, uint8_t* out, uint32_t blocks);
+typedef void (*aes_ctr_func)(const ndn_aes_kernels_key_t* key, uint8_t* counter,
+                             const uint8_t* in, uint8_t* out, uint32_t blocks);
+
+typedef struct aes_kernels {
+  int level;
+  /**
+   * @p out may be NULL to compute a CBC-MAC in @p chain only.
+   */
+  aes_cbc_func cbc_encrypt;
+  aes_cbc_func cbc_decrypt;
+  aes_ctr_func ctr;
+} aes_kernels_t;
+
+/**
+ * CBC-MAC of CCM over byte strings that are not block aligned.
+ */
+typedef struct ccm_mac {
+  uint8_t chain[BLOCK];
+  uint8_t block[BLOCK];
+  uint32_t used;
+} ccm_mac_t;
+
+static aes_kernels_t kernels;
+static ndn_aes_cbc_encrypt_impl default_cbc_encrypt;
+static ndn_aes_cbc_decrypt_impl default_cbc_decrypt;
+
+static uint8_t
+gf_mul(uint8_t a, uint8_t b);
+
+static void
+inv_mix_columns(const uint8_t* in, uint8_t* out);
+
+static void
+cbc_encrypt_software(const ndn_aes_kernels_key_t* key, uint8_t* chain,
+                     const uint8_t* in, uint8_t* out, uint32_t blocks);
+
+static void
+cbc_decrypt_software(const ndn_aes_kernels_key_t* key, uint8_t* chain,
+                     const uint8_t* in, uint8_t* out, uint32_t blocks);
+
+static void
+ctr_software(const ndn_aes_kernels_key_t* key, uint8_t* counter,
+             const uint8_t* in, uint8_t* out, uint32_t blocks);
+
+static int
+aes_kernels_best_level(void);
+
+static void
+ccm_mac_update(const ndn_aes_kernels_key_t* key, ccm_mac_t* mac, const uint8_t* data, uint32_t size);
+
+static void
+ccm_mac_pad(const ndn_aes_kernels_key_t* key, ccm_mac_t* mac);
+
+static int
+ccm_start(const ndn_aes_kernels_key_t* key, const uint8_t* nonce, uint32_t nonce_size,
+          const uint8_t* aad, uint32_t aad_size, uint32_t size, uint32_t tag_size,
+          ccm_mac_t* mac, uint8_t* counter);
+
+static int
+aes_kernels_backend_encrypt(const uint8_t* input_value, uint32_t input_size,
+                            uint8_t* output_value, uint32_t output_size,
+                            const uint8_t* aes_iv, const abstract_aes_key_t* aes_key);
+
+static int
+aes_kernels_backend_decrypt(const uint8_t* input_value, uint32_t input_size,
+                            uint8_t* output_value, uint32_t output_size,
+                            const uint8_t* aes_iv, const abstract_aes_key_t* aes_key);
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+static inline void
+xor_block(uint8_t* out, const uint8_t* a, const uint8_t* b){
+  int i;
+
+  for(i = 0; i < BLOCK; i ++){
+    out[i] = a[i] ^ b[i];
+  }
+}
+
+static inline void
+ctr_increment(uint8_t* counter){
+  ndn_pkt_store_be32(counter + BLOCK - 4, ndn_pkt_load_be32(counter + BLOCK - 4) + 1);
+}
+
+static uint8_t
+gf_mul(uint8_t a, uint8_t b){
+  uint8_t ret = 0;
+
+  while(b != 0){
+    if(b & 1){
+      ret ^= a;
+    }
+    a = (uint8_t)((a << 1) ^ ((a & 0x80) ? 0x1B : 0));
+    b >>= 1;
+  }
+  return ret;
+}
+
+static void
+inv_mix_columns(const uint8_t* in, uint8_t* out){
+  const uint8_t* a;
+  int c;
+
+  for(c = 0; c < 4; c ++){
+    a = in + 4 * c;
+    out[4 * c + 0] = gf_mul(a[0], 14) ^ gf_mul(a[1], 11) ^ gf_mul(a[2], 13) ^ gf_mul(a[3], 9);
+    out[4 * c + 1] = gf_mul(a[0], 9) ^ gf_mul(a[1], 14) ^ gf_mul(a[2], 11) ^ gf_mul(a[3], 13);
+    out[4 * c + 2] = gf_mul(a[0], 13) ^ gf_mul(a[1], 9) ^ gf_mul(a[2], 14) ^ gf_mul(a[3], 11);
+    out[4 * c + 3] = gf_mul(a[0], 11) ^ gf_mul(a[1], 13) ^ gf_mul(a[2], 9) ^ gf_mul(a[3], 14);
+  }
+}
+
+int
+ndn_aes_kernels_set_key(ndn_aes_kernels_key_t* key, const uint8_t* value, uint32_t size){
+  int r, i;
+
+  if(size != NDN_AES_KERNELS_KEY_SIZE){
+    return NDN_SEC_CRYPTO_ALGO_FAILURE;
+  }
+  if(tc_aes128_set_encrypt_key(&key->sched, value) != TC_CRYPTO_SUCCESS){
+    return NDN_SEC_CRYPTO_ALGO_FAILURE;
+  }
+  // tinycrypt keeps the schedule as big-endian words
+  for(r = 0; r <= ROUNDS; r ++){
+    for(i = 0; i < 4; i ++){
+      ndn_pkt_store_be32(key->enc[r] + 4 * i, key->sched.words[4 * r + i]);
+    }
+  }
+  memcpy(key->dec[0], key->enc[ROUNDS], BLOCK);
+  for(r = 1; r < ROUNDS; r ++){
+    inv_mix_columns(key->enc[ROUNDS - r], key->dec[r]);
+  }
+  memcpy(key->dec[ROUNDS], key->enc[0], BLOCK);
+  return NDN_SUCCESS;
+}
+
+static void
+cbc_encrypt_software(const ndn_aes_kernels_key_t* key, uint8_t* chain,
+                     const uint8_t* in, uint8_t* out, uint32_t blocks){
+  uint8_t block[BLOCK];
+  uint32_t i;
+
+  for(i = 0; i < blocks; i ++){
+    xor_block(block, chain, in + i * BLOCK);
+    tc_aes_encrypt(chain, block, (TCAesKeySched_t)&key->sched);
+    if(out != NULL){
+      memcpy(out + i * BLOCK, chain, BLOCK);
+    }
+  }
+}
+
+static void
+cbc_decrypt_software(const ndn_aes_kernels_key_t* key, uint8_t* chain,
+                     const uint8_t* in, uint8_t* out, uint32_t blocks){
+  uint8_t block[BLOCK], cipher[BLOCK];
+  uint32_t i;
+
+  for(i = 0; i < blocks; i ++){
+    memcpy(cipher, in + i * BLOCK, BLOCK);
+    tc_aes_decrypt(block, cipher, (TCAesKeySched_t)&key->sched);
+    xor_block(out + i * BLOCK, block, chain);
+    memcpy(chain, cipher, BLOCK);
+  }
+}
+
+static void
+ctr_software(const ndn_aes_kernels_key_t* key, uint8_t* counter,
+             const uint8_t* in, uint8_t* out, uint32_t blocks){
+  uint8_t stream[BLOCK];
+  uint32_t i;
+
+  for(i = 0; i < blocks; i ++){
+    tc_aes_encrypt(stream, counter, (TCAesKeySched_t)&key->sched);
+    xor_block(out + i * BLOCK, in + i * BLOCK, stream);
+    ctr_increment(counter);
+  }
+}
+
+#ifdef AES_KERNELS_X86
+__attribute__((target("aes,sse4.1")))
+static inline __m128i
+aesni_encrypt(const __m128i* k, __m128i x){
+  int r;
+
+  x = _mm_xor_si128(x, k[0]);
+  for(r = 1; r < ROUNDS; r ++){
+    x = _mm_aesenc_si128(x, k[r]);
+  }
+  return _mm_aesenclast_si128(x, k[ROUNDS]);
+}
+
+__attribute__((target("aes,sse4.1")))
+static void
+cbc_encrypt_aesni(const ndn_aes_kernels_key_t* key, uint8_t* chain,
+                  const uint8_t* in, uint8_t* out, uint32_t blocks){
+  __m128i k[ROUNDS + 1], x;
+  uint32_t i;
+
+  for(i = 0; i <= ROUNDS; i ++){
+    k[i] = _mm_load_si128((const __m128i*)key->enc[i]);
+  }
+  // Each block depends on the previous one: no interleaving
+  x = _mm_loadu_si128((const __m128i*)chain);
+  for(i = 0; i < blocks; i ++){
+    x = aesni_encrypt(k, _mm_xor_si128(x, _mm_loadu_si128((const __m128i*)(in + i * BLOCK))));
+    if(out != NULL){
+      _mm_storeu_si128((__m128i*)(out + i * BLOCK), x);
+    }
+  }
+  _mm_storeu_si128((__m128i*)chain, x);
+}
+
+__attribute__((target("aes,sse4.1")))
+static void
+cbc_decrypt_aesni(const ndn_aes_kernels_key_t* key, uint8_t* chain,
+                  const uint8_t* in, uint8_t* out, uint32_t blocks){
+  __m128i k[ROUNDS + 1], c0, c1, c2, c3, x0, x1, x2, x3, prev;
+  uint32_t i, r;
+
+  for(i = 0; i <= ROUNDS; i ++){
+    k[i] = _mm_load_si128((const __m128i*)key->dec[i]);
+  }
+  prev = _mm_loadu_si128((const __m128i*)chain);
+  // Blocks are independent: four in flight hide the AESDEC latency
+  for(i = 0; i + 4 <= blocks; i += 4){
+    c0 = _mm_loadu_si128((const __m128i*)(in + (i + 0) * BLOCK));
+    c1 = _mm_loadu_si128((const __m128i*)(in + (i + 1) * BLOCK));
+    c2 = _mm_loadu_si128((const __m128i*)(in + (i + 2) * BLOCK));
+    c3 = _mm_loadu_si128((const __m128i*)(in + (i + 3) * BLOCK));
+    x0 = _mm_xor_si128(c0, k[0]);
+    x1 = _mm_xor_si128(c1, k[0]);
+    x2 = _mm_xor_si128(c2, k[0]);
+    x3 = _mm_xor_si128(c3, k[0]);
+    for(r = 1; r < ROUNDS; r ++){
+      x0 = _mm_aesdec_si128(x0, k[r]);
+      x1 = _mm_aesdec_si128(x1, k[r]);
+      x2 = _mm_aesdec_si128(x2, k[r]);
+      x3 = _mm_aesdec_si128(x3, k[r]);
+    }
+    x0 = _mm_xor_si128(_mm_aesdeclast_si128(x0, k[ROUNDS]), prev);
+    x1 = _mm_xor_si128(_mm_aesdeclast_si128(x1, k[ROUNDS]), c0);
+    x2 = _mm_xor_si128(_mm_aesdeclast_si128(x2, k[ROUNDS]), c1);
+    x3 = _mm_xor_si128(_mm_aesdeclast_si128(x3, k[ROUNDS]), c2);
+    _mm_storeu_si128((__m128i*)(out + (i + 0) * BLOCK), x0);
+    _mm_storeu_si128((__m128i*)(out + (i + 1) * BLOCK), x1);
+    _mm_storeu_si128((__m128i*)(out + (i + 2) * BLOCK), x2);
+    _mm_storeu_si128((__m128i*)(out + (i + 3) * BLOCK), x3);
+    prev = c3;
+  }
+  for(; i < blocks; i ++){
+    c0 = _mm_loadu_si128((const __m128i*)(in + i * BLOCK));
+    x0 = _mm_xor_si128(c0, k[0]);
+    for(r = 1; r < ROUNDS; r ++){
+      x0 = _mm_aesdec_si128(x0, k[r]);
+    }
+    x0 = _mm_xor_si128(_mm_aesdeclast_si128(x0, k[ROUNDS]), prev);
+    _mm_storeu_si128((__m128i*)(out + i * BLOCK), x0);
+    prev = c0;
+  }
+  _mm_storeu_si128((__m128i*)chain, prev);
+}
+
+__attribute__((target("aes,sse4.1")))
+static void
+ctr_aesni(const ndn_aes_kernels_key_t* key, uint8_t* counter,
+          const uint8_t* in, uint8_t* out, uint32_t blocks){
+  __m128i k[ROUNDS + 1], base, x0, x1, x2, x3;
+  uint32_t i, r, low;
+
+  for(i = 0; i <= ROUNDS; i ++){
+    k[i] = _mm_load_si128((const __m128i*)key->enc[i]);
+  }
+  base = _mm_loadu_si128((const __m128i*)counter);
+  low = ndn_pkt_load_be32(counter + BLOCK - 4);
+  for(i = 0; i + 4 <= blocks; i += 4){
+    x0 = _mm_xor_si128(_mm_insert_epi32(base, (int)__builtin_bswap32(low + 0), 3), k[0]);
+    x1 = _mm_xor_si128(_mm_insert_epi32(base, (int)__builtin_bswap32(low + 1), 3), k[0]);
+    x2 = _mm_xor_si128(_mm_insert_epi32(base, (int)__builtin_bswap32(low + 2), 3), k[0]);
+    x3 = _mm_xor_si128(_mm_insert_epi32(base, (int)__builtin_bswap32(low + 3), 3), k[0]);
+    low += 4;
+    for(r = 1; r < ROUNDS; r ++){
+      x0 = _mm_aesenc_si128(x0, k[r]);
+      x1 = _mm_aesenc_si128(x1, k[r]);
+      x2 = _mm_aesenc_si128(x2, k[r]);
+      x3 = _mm_aesenc_si128(x3, k[r]);
+    }
+    x0 = _mm_aesenclast_si128(x0, k[ROUNDS]);
+    x1 = _mm_aesenclast_si128(x1, k[ROUNDS]);
+    x2 = _mm_aesenclast_si128(x2, k[ROUNDS]);
+    x3 = _mm_aesenclast_si128(x3, k[ROUNDS]);
+    _mm_storeu_si128((__m128i*)(out + (i + 0) * BLOCK),
+                     _mm_xor_si128(x0, _mm_loadu_si128((const __m128i*)(in + (i + 0) * BLOCK))));
+    _mm_storeu_si128((__m128i*)(out + (i + 1) * BLOCK),
+                     _mm_xor_si128(x1, _mm_loadu_si128((const __m128i*)(in + (i + 1) * BLOCK))));
+    _mm_storeu_si128((__m128i*)(out + (i + 2) * BLOCK),
+                     _mm_xor_si128(x2, _mm_loadu_si128((const __m128i*)(in + (i + 2) * BLOCK))));
+    _mm_storeu_si128((__m128i*)(out + (i + 3) * BLOCK),
+                     _mm_xor_si128(x3, _mm_loadu_si128((const __m128i*)(in + (i + 3) * BLOCK))));
+  }
+  for(; i < blocks; i ++){
+    x0 = aesni_encrypt(k, _mm_insert_epi32(base, (int)__builtin_bswap32(low), 3));
+    low ++;
+    _mm_storeu_si128((__m128i*)(out + i * BLOCK),
+                     _mm_xor_si128(x0, _mm_loadu_si128((const __m128i*)(in + i * BLOCK))));
+  }
+  ndn_pkt_store_be32(counter + BLOCK - 4, low);
+}
+#endif
+
+#ifdef AES_KERNELS_ARM
+static inline uint8x16_t
+armv8_encrypt(const uint8x16_t* k, uint8x16_t x){
+  int r;
+
+  for(r = 0; r < ROUNDS - 1; r ++){
+    x = vaesmcq_u8(vaeseq_u8(x, k[r]));
+  }
+  return veorq_u8(vaeseq_u8(x, k[ROUNDS - 1]), k[ROUNDS]);
+}
+
+static inline uint8x16_t
+armv8_decrypt(const uint8x16_t* k, uint8x16_t x){
+  int r;
+
+  for(r = 0; r < ROUNDS - 1; r ++){
+    x = vaesimcq_u8(vaesdq_u8(x, k[r]));
+  }
+  return veorq_u8(vaesdq_u8(x, k[ROUNDS - 1]), k[ROUNDS]);
+}
+
+static void
+cbc_encrypt_armv8(const ndn_aes_kernels_key_t* key, uint8_t* chain,
+                  const uint8_t* in, uint8_t* out, uint32_t blocks){
+  uint8x16_t k[ROUNDS + 1], x;
+  uint32_t i;
+
+  for(i = 0; i <= ROUNDS; i ++){
+    k[i] = vld1q_u8(key->enc[i]);
+  }
+  x = vld1q_u8(chain);
+  for(i = 0; i < blocks; i ++){
+    x = armv8_encrypt(k, veorq_u8(x, vld1q_u8(in + i * BLOCK)));
+    if(out != NULL){
+      vst1q_u8(out + i * BLOCK, x);
+    }
+  }
+  vst1q_u8(chain, x);
+}
+
+static void
+cbc_decrypt_armv8(const ndn_aes_kernels_key_t* key, uint8_t* chain,
+                  const uint8_t* in, uint8_t* out, uint32_t blocks){
+  uint8x16_t k[ROUNDS + 1], c0, c1, c2, c3, prev;
+  uint32_t i;
+
+  for(i = 0; i <= ROUNDS; i ++){
+    k[i] = vld1q_u8(key->dec[i]);
+  }
+  prev = vld1q_u8(chain);
+  for(i = 0; i + 4 <= blocks; i += 4){
+    c0 = vld1q_u8(in + (i + 0) * BLOCK);
+    c1 = vld1q_u8(in + (i + 1) * BLOCK);
+    c2 = vld1q_u8(in + (i + 2) * BLOCK);
+    c3 = vld1q_u8(in + (i + 3) * BLOCK);
+    vst1q_u8(out + (i + 0) * BLOCK, veorq_u8(armv8_decrypt(k, c0), prev));
+    vst1q_u8(out + (i + 1) * BLOCK, veorq_u8(armv8_decrypt(k, c1), c0));
+    vst1q_u8(out + (i + 2) * BLOCK, veorq_u8(armv8_decrypt(k, c2), c1));
+    vst1q_u8(out + (i + 3) * BLOCK, veorq_u8(armv8_decrypt(k, c3), c2));
+    prev = c3;
+  }
+  for(; i < blocks; i ++){
+    c0 = vld1q_u8(in + i * BLOCK);
+    vst1q_u8(out + i * BLOCK, veorq_u8(armv8_decrypt(k, c0), prev));
+    prev = c0;
+  }
+  vst1q_u8(chain, prev);
+}
+
+static void
+ctr_armv8(const ndn_aes_kernels_key_t* key, uint8_t* counter,
+          const uint8_t* in, uint8_t* out, uint32_t blocks){
+  uint8x16_t k[ROUNDS + 1];
+  uint8_t ctr[4][BLOCK];
+  uint32_t i, j, low;
+
+  for(i = 0; i <= ROUNDS; i ++){
+    k[i] = vld1q_u8(key->enc[i]);
+  }
+  for(j = 0; j < 4; j ++){
+    memcpy(ctr[j], counter, BLOCK);
+  }
+  low = ndn_pkt_load_be32(counter + BLOCK - 4);
+  for(i = 0; i + 4 <= blocks; i += 4){
+    for(j = 0; j < 4; j ++){
+      ndn_pkt_store_be32(ctr[j] + BLOCK - 4, low + j);
+    }
+    low += 4;
+    // Independent calls are interleaved by the compiler once inlined
+    for(j = 0; j < 4; j ++){
+      vst1q_u8(out + (i + j) * BLOCK,
+               veorq_u8(armv8_encrypt(k, vld1q_u8(ctr[j])), vld1q_u8(in + (i + j) * BLOCK)));
+    }
+  }
+  for(; i < blocks; i ++){
+    ndn_pkt_store_be32(ctr[0] + BLOCK - 4, low);
+    low ++;
+    vst1q_u8(out + i * BLOCK, veorq_u8(armv8_encrypt(k, vld1q_u8(ctr[0])), vld1q_u8(in + i * BLOCK)));
+  }
+  ndn_pkt_store_be32(counter + BLOCK - 4, low);
+}
+#endif
+
+static int
+aes_kernels_best_level(void){
+#ifdef AES_KERNELS_X86
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("aes") && __builtin_cpu_supports("sse4.1")){
+    return NDN_AES_KERNELS_AESNI;
+  }
+#endif
+#ifdef AES_KERNELS_ARM
+#ifdef __linux__
+  if((getauxval(AT_HWCAP) & HWCAP_AES) == 0){
+    return NDN_AES_KERNELS_SOFTWARE;
+  }
+#endif
+  return NDN_AES_KERNELS_ARMV8;
+#endif
+  return NDN_AES_KERNELS_SOFTWARE;
+}
+
+int
+ndn_aes_kernels_select(int level){
+  int best = aes_kernels_best_level();
+
+  // The hardware levels are exclusive, so only the best one may be picked
+  if(level != best){
+    level = NDN_AES_KERNELS_SOFTWARE;
+  }
+  kernels.level = NDN_AES_KERNELS_SOFTWARE;
+  kernels.cbc_encrypt = cbc_encrypt_software;
+  kernels.cbc_decrypt = cbc_decrypt_software;
+  kernels.ctr = ctr_software;
+#ifdef AES_KERNELS_X86
+  if(level == NDN_AES_KERNELS_AESNI){
+    kernels.level = NDN_AES_KERNELS_AESNI;
+    kernels.cbc_encrypt = cbc_encrypt_aesni;
+    kernels.cbc_decrypt = cbc_decrypt_aesni;
+    kernels.ctr = ctr_aesni;
+  }
+#endif
+#ifdef AES_KERNELS_ARM
+  if(level == NDN_AES_KERNELS_ARMV8){
+    kernels.level = NDN_AES_KERNELS_ARMV8;
+    kernels.cbc_encrypt = cbc_encrypt_armv8;
+    kernels.cbc_decrypt = cbc_decrypt_armv8;
+    kernels.ctr = ctr_armv8;
+  }
+#endif
+  return kernels.level;
+}
+
+__attribute__((constructor))
+static void
+aes_kernels_init(void){
+  ndn_aes_kernels_select(aes_kernels_best_level());
+}
+
+int
+ndn_aes_kernels_get_level(void){
+  return kernels.level;
+}
+
+int
+ndn_aes_kernels_cbc_encrypt(const ndn_aes_kernels_key_t* key, const uint8_t* iv,
+                            const uint8_t* in, uint8_t* out, uint32_t size){
+  uint8_t chain[BLOCK];
+
+  if(size % BLOCK != 0){
+    return NDN_SEC_CRYPTO_ALGO_FAILURE;
+  }
+  memcpy(chain, iv, BLOCK);
+  kernels.cbc_encrypt(key, chain, in, out, size / BLOCK);
+  return NDN_SUCCESS;
+}
+
+int
+ndn_aes_kernels_cbc_decrypt(const ndn_aes_kernels_key_t* key, const uint8_t* iv,
+                            const uint8_t* in, uint8_t* out, uint32_t size){
+  uint8_t chain[BLOCK];
+
+  if(size % BLOCK != 0){
+    return NDN_SEC_CRYPTO_ALGO_FAILURE;
+  }
+  memcpy(chain, iv, BLOCK);
+  kernels.cbc_decrypt(key, chain, in, out, size / BLOCK);
+  return NDN_SUCCESS;
+}
+
+void
+ndn_aes_kernels_ctr(const ndn_aes_kernels_key_t* key, uint8_t* counter,
+                    const uint8_t* in, uint8_t* out, uint32_t size){
+  uint8_t block[BLOCK];
+  uint32_t full = size - size % BLOCK;
+
+  kernels.ctr(key, counter, in, out, full / BLOCK);
+  if(full < size){
+    memset(block, 0, BLOCK);
+    memcpy(block, in + full, size - full);
+    kernels.ctr(key, counter, block, block, 1);
+    memcpy(out + full, block, size - full);
+  }
+}
+
+static void
+ccm_mac_update(const ndn_aes_kernels_key_t* key, ccm_mac_t* mac, const uint8_t* data, uint32_t size){
+  uint32_t n;
+
+  if(mac->used > 0){
+    n = (size < BLOCK - mac->used) ? size : BLOCK - mac->used;
+    memcpy(mac->block + mac->used, data, n);
+    mac->used += n;
+    data += n;
+    size -= n;
+    if(mac->used < BLOCK){
+      return;
+    }
+    kernels.cbc_encrypt(key, mac->chain, mac->block, NULL, 1);
+    mac->used = 0;
+  }
+  if(size >= BLOCK){
+    kernels.cbc_encrypt(key, mac->chain, data, NULL, size / BLOCK);
+    data += size - size % BLOCK;
+    size %= BLOCK;
+  }
+  memcpy(mac->block, data, size);
+  mac->used = size;
+}
+
+static void
+ccm_mac_pad(const ndn_aes_kernels_key_t* key, ccm_mac_t* mac){
+  if(mac->used > 0){
+    memset(mac->block + mac->used, 0, BLOCK - mac->used);
+    kernels.cbc_encrypt(key, mac->chain, mac->block, NULL, 1);
+    mac->used = 0;
+  }
+}
+
+// MAC B0 and the associated data, and set the counter to A0
+static int
+ccm_start(const ndn_aes_kernels_key_t* key, const uint8_t* nonce, uint32_t nonce_size,
+          const uint8_t* aad, uint32_t aad_size, uint32_t size, uint32_t tag_size,
+          ccm_mac_t* mac, uint8_t* counter){
+  uint8_t b0[BLOCK], header[CCM_MAX_AAD_HEADER];
+  uint32_t length_size = 15 - nonce_size, header_size;
+
+  if(nonce_size < 7 || nonce_size > 13 || tag_size < 4 || tag_size > 16 || tag_size % 2 != 0){
+    return NDN_SEC_CRYPTO_ALGO_FAILURE;
+  }
+  if(length_size < 4 && (size >> (8 * length_size)) != 0){
+    return NDN_OVERSIZE;
+  }
+
+  // The size fits in length_size bytes, so the nonce only overwrites zeros
+  memset(b0, 0, BLOCK);
+  ndn_pkt_store_be32(b0 + BLOCK - 4, size);
+  b0[0] = (uint8_t)(((aad_size > 0) ? 0x40 : 0) | (((tag_size - 2) / 2) << 3) | (length_size - 1));
+  memcpy(b0 + 1, nonce, nonce_size);
+  memset(mac, 0, sizeof(ccm_mac_t));
+  ccm_mac_update(key, mac, b0, BLOCK);
+  if(aad_size > 0){
+    if(aad_size < 0xFF00){
+      ndn_pkt_store_be16(header, (uint16_t)aad_size);
+      header_size = 2;
+    }else{
+      header[0] = 0xFF;
+      header[1] = 0xFE;
+      ndn_pkt_store_be32(header + 2, aad_size);
+      header_size = 6;
+    }
+    ccm_mac_update(key, mac, header, header_size);
+    ccm_mac_update(key, mac, aad, aad_size);
+    ccm_mac_pad(key, mac);
+  }
+
+  memset(counter, 0, BLOCK);
+  counter[0] = (uint8_t)(length_size - 1);
+  memcpy(counter + 1, nonce, nonce_size);
+  return NDN_SUCCESS;
+}
+
+int
+ndn_aes_kernels_ccm_encrypt(const ndn_aes_kernels_key_t* key,
+                            const uint8_t* nonce, uint32_t nonce_size,
+                            const uint8_t* aad, uint32_t aad_size,
+                            const uint8_t* in, uint32_t size, uint8_t* out, uint32_t tag_size){
+  uint8_t counter[BLOCK], s0[BLOCK];
+  ccm_mac_t mac;
+  uint32_t i;
+  int ret;
+
+  ret = ccm_start(key, nonce, nonce_size, aad, aad_size, size, tag_size, &mac, counter);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  // The MAC covers the plaintext, so it comes first when in and out are the same
+  ccm_mac_update(key, &mac, in, size);
+  ccm_mac_pad(key, &mac);
+
+  memset(s0, 0, BLOCK);
+  kernels.ctr(key, counter, s0, s0, 1);
+  ndn_aes_kernels_ctr(key, counter, in, out, size);
+  for(i = 0; i < tag_size; i ++){
+    out[size + i] = mac.chain[i] ^ s0[i];
+  }
+  return NDN_SUCCESS;
+}
+
+int
+ndn_aes_kernels_ccm_decrypt(const ndn_aes_kernels_key_t* key,
+                            const uint8_t* nonce, uint32_t nonce_size,
+                            const uint8_t* aad, uint32_t aad_size,
+                            const uint8_t* in, uint32_t size, uint8_t* out, uint32_t tag_size){
+  uint8_t counter[BLOCK], s0[BLOCK], tag[BLOCK];
+  uint8_t diff = 0;
+  ccm_mac_t mac;
+  uint32_t i;
+  int ret;
+
+  if(size < tag_size){
+    return NDN_SEC_CRYPTO_ALGO_FAILURE;
+  }
+  size -= tag_size;
+  ret = ccm_start(key, nonce, nonce_size, aad, aad_size, size, tag_size, &mac, counter);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  memcpy(tag, in + size, tag_size);
+
+  memset(s0, 0, BLOCK);
+  kernels.ctr(key, counter, s0, s0, 1);
+  ndn_aes_kernels_ctr(key, counter, in, out, size);
+  ccm_mac_update(key, &mac, out, size);
+  ccm_mac_pad(key, &mac);
+
+  // Constant time, so the tag cannot be guessed byte by byte
+  for(i = 0; i < tag_size; i ++){
+    diff |= (uint8_t)(tag[i] ^ mac.chain[i] ^ s0[i]);
+  }
+  if(diff != 0){
+    memset(out, 0, size);
+    return NDN_SEC_FAIL_VERIFY_SIG;
+  }
+  return NDN_SUCCESS;
+}
+
+// Output is IV || ciphertext, as tinycrypt writes it
+static int
+aes_kernels_backend_encrypt(const uint8_t* input_value, uint32_t input_size,
+                            uint8_t* output_value, uint32_t output_size,
+                            const uint8_t* aes_iv, const abstract_aes_key_t* aes_key){
+  ndn_aes_kernels_key_t key;
+  int ret;
+
+  if(aes_key->key_size != NDN_AES_KERNELS_KEY_SIZE){
+    return default_cbc_encrypt(input_value, input_size, output_value, output_size, aes_iv, aes_key);
+  }
+  if(output_size < input_size + BLOCK){
+    return NDN_OVERSIZE;
+  }
+  ret = ndn_aes_kernels_set_key(&key, aes_key->key_value, aes_key->key_size);
+  if(ret == NDN_SUCCESS){
+    ret = ndn_aes_kernels_cbc_encrypt(&key, aes_iv, input_value, output_value + BLOCK, input_size);
+    memcpy(output_value, aes_iv, BLOCK);
+  }
+  memset(&key, 0, sizeof(key));
+  return ret;
+}
+
+// Input is IV || ciphertext; the IV argument is not used, as in tinycrypt
+static int
+aes_kernels_backend_decrypt(const uint8_t* input_value, uint32_t input_size,
+                            uint8_t* output_value, uint32_t output_size,
+                            const uint8_t* aes_iv, const abstract_aes_key_t* aes_key){
+  ndn_aes_kernels_key_t key;
+  int ret;
+
+  if(aes_key->key_size != NDN_AES_KERNELS_KEY_SIZE){
+    return default_cbc_decrypt(input_value, input_size, output_value, output_size, aes_iv, aes_key);
+  }
+  if(input_size < 2 * BLOCK){
+    return NDN_SEC_CRYPTO_ALGO_FAILURE;
+  }
+  if(output_size < input_size - BLOCK){
+    return NDN_OVERSIZE;
+  }
+  ret = ndn_aes_kernels_set_key(&key, aes_key->key_value, aes_key->key_size);
+  if(ret == NDN_SUCCESS){
+    ret = ndn_aes_kernels_cbc_decrypt(&key, input_value, input_value + BLOCK, output_value,
+                                      input_size - BLOCK);
+  }
+  memset(&key, 0, sizeof(key));
+  return ret;
+}
+
+void
+ndn_aes_kernels_load_backend(void){
+  ndn_aes_backend_t* backend = ndn_aes_get_backend();
+
+  if(kernels.level == NDN_AES_KERNELS_SOFTWARE){
+    return;
+  }
+  if(default_cbc_encrypt == NULL){
+    default_cbc_encrypt = backend->aes_cbc_encrypt;
+    default_cbc_decrypt = backend->aes_cbc_decrypt;
+  }
+  backend->aes_cbc_encrypt = aes_kernels_backend_encrypt;
+  backend->aes_cbc_decrypt = aes_kernels_backend_decrypt;
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#ifndef NDN_AES_KERNELS_H_
+#define NDN_AES_KERNELS_H_
+
+#include <stdint.h>
+#include "ndn-lite/security/default-backend/sec-lib/tinycrypt/tc_aes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Instruction sets of the AES kernels.
+ * The best one supported by the CPU is selected at startup.
+ */
+#define NDN_AES_KERNELS_SOFTWARE 0
+#define NDN_AES_KERNELS_AESNI 1
+#define NDN_AES_KERNELS_ARMV8 2
+
+#define NDN_AES_KERNELS_BLOCK_SIZE 16
+// AES-128, as the default backend
+#define NDN_AES_KERNELS_KEY_SIZE 16
+#define NDN_AES_KERNELS_ROUNDS 10
+
+/**
+ * An expanded key, usable by every level.
+ */
+typedef struct ndn_aes_kernels_key {
+  uint8_t enc[NDN_AES_KERNELS_ROUNDS + 1][NDN_AES_KERNELS_BLOCK_SIZE] __attribute__((aligned(16)));
+  /**
+   * Round keys of the equivalent inverse cipher, as AESDEC and AESD take them.
+   */
+  uint8_t dec[NDN_AES_KERNELS_ROUNDS + 1][NDN_AES_KERNELS_BLOCK_SIZE] __attribute__((aligned(16)));
+  /**
+   * Used by the software level.
+   */
+  struct tc_aes_key_sched_struct sched;
+} ndn_aes_kernels_key_t;
+
+/**
+ * Select the kernels, e.g. to compare them.
+ * @return The level in use, which is lower than @p level if the CPU lacks it.
+ */
+int
+ndn_aes_kernels_select(int level);
+
+int
+ndn_aes_kernels_get_level(void);
+
+int
+ndn_aes_kernels_set_key(ndn_aes_kernels_key_t* key, const uint8_t* value, uint32_t size);
+
+/**
+ * CBC without padding. @p in and @p out may be the same buffer.
+ * @param size A multiple of NDN_AES_KERNELS_BLOCK_SIZE.
+ */
+int
+ndn_aes_kernels_cbc_encrypt(const ndn_aes_kernels_key_t* key, const uint8_t* iv,
+                            const uint8_t* in, uint8_t* out, uint32_t size);
+
+int
+ndn_aes_kernels_cbc_decrypt(const ndn_aes_kernels_key_t* key, const uint8_t* iv,
+                            const uint8_t* in, uint8_t* out, uint32_t size);
+
+/**
+ * CTR of any size; encryption and decryption are the same.
+ * The last 32 bits of @p counter are incremented per block, as in tinycrypt,
+ * and it is left at the block after the last one used.
+ */
+void
+ndn_aes_kernels_ctr(const ndn_aes_kernels_key_t* key, uint8_t* counter,
+                    const uint8_t* in, uint8_t* out, uint32_t size);
+
+/**
+ * CCM as in NIST SP 800-38C.
+ * @param nonce_size 7 to 13.
+ * @param out The ciphertext followed by a tag of @p tag_size bytes: 4, 6, ..., 16.
+ */
+int
+ndn_aes_kernels_ccm_encrypt(const ndn_aes_kernels_key_t* key,
+                            const uint8_t* nonce, uint32_t nonce_size,
+                            const uint8_t* aad, uint32_t aad_size,
+                            const uint8_t* in, uint32_t size, uint8_t* out, uint32_t tag_size);
+
+/**
+ * @param in The ciphertext followed by the tag; @p size includes the tag.
+ * @param out Receives size - tag_size bytes, zeroed if the tag is wrong.
+ * @return NDN_SUCCESS, or NDN_SEC_FAIL_VERIFY_SIG for a wrong tag.
+ */
+int
+ndn_aes_kernels_ccm_decrypt(const ndn_aes_kernels_key_t* key,
+                            const uint8_t* nonce, uint32_t nonce_size,
+                            const uint8_t* aad, uint32_t aad_size,
+                            const uint8_t* in, uint32_t size, uint8_t* out, uint32_t tag_size);
+
+/**
+ * Route AES-CBC of the ndn-lite backend through the kernels.
+ * Does nothing without AES instructions, leaving tinycrypt in place.
+ */
+void
+ndn_aes_kernels_load_backend(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
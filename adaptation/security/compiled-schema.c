@@ -0,0 +1,755 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "compiled-schema.h"
+#include "key-store.h"
+#include "../forwarder/name-kernels.h"
+#include "../forwarder/pkt-peek.h"
+#include "../forwarder/pkt-view.h"
+#include "ndn-lite/ndn-enums.h"
+#include "ndn-lite/ndn-error-code.h"
+
+#define SCHEMA_MIN_SLOTS 16
+#define SCHEMA_MIN_STATES 64
+#define SCHEMA_SYMBOL_OTHER 0
+#define SCHEMA_STATE_DEAD 0
+
+/**
+ * A name component, split once per check.
+ */
+typedef struct schema_comp {
+  const uint8_t* tlv;
+  const uint8_t* value;
+  uint32_t type;
+  uint32_t size;
+} schema_comp_t;
+
+/**
+ * Components captured by a group: count components from begin, which are
+ * end - begin bytes of the wire.
+ */
+typedef struct schema_span {
+  const uint8_t* begin;
+  const uint8_t* end;
+  uint32_t count;
+} schema_span_t;
+
+/**
+ * DFA states being built: the NFA positions of each state, indexed by a
+ * hash of the set so that a new set is found without comparing it to every
+ * state. Row state_count of sets holds the set being looked up.
+ */
+typedef struct schema_subsets {
+  uint64_t* sets;
+  uint32_t words;
+  uint32_t capacity;
+  // State + 1 in each slot, 0 if free
+  uint32_t* index;
+  uint32_t index_mask;
+} schema_subsets_t;
+
+static int
+schema_parse(ndn_compiled_schema_t* self, const char* pattern, bool is_key,
+             ndn_compiled_schema_token_t* tokens, uint8_t* count, ndn_compiled_schema_rule_t* rule);
+
+static int
+schema_split(const uint8_t* name, uint32_t name_size, schema_comp_t* comps, uint32_t* count);
+
+static uint16_t
+schema_symbol(const ndn_compiled_schema_t* self, const uint8_t* value, uint32_t size);
+
+static void
+schema_closure(const ndn_compiled_schema_t* self, const uint32_t* base, uint64_t* set);
+
+static uint32_t*
+schema_subsets_slot(const schema_subsets_t* subsets, const uint64_t* set);
+
+static int
+schema_subsets_grow(ndn_compiled_schema_t* self, schema_subsets_t* subsets, uint32_t symbols);
+
+static bool
+schema_segment(const ndn_compiled_schema_t* self, const ndn_compiled_schema_token_t* tokens,
+               uint32_t begin, uint32_t end, const schema_comp_t* comps, uint32_t at,
+               const schema_span_t* spans, uint32_t* pos);
+
+static bool
+schema_place(const ndn_compiled_schema_t* self, const ndn_compiled_schema_token_t* tokens, uint32_t count,
+             const schema_comp_t* comps, uint32_t comp_count, const schema_span_t* spans,
+             uint32_t* pos);
+
+static bool
+schema_check_rule(const ndn_compiled_schema_t* self, const ndn_compiled_schema_rule_t* rule,
+                  const schema_comp_t* data, uint32_t data_count,
+                  const schema_comp_t* key, uint32_t key_count);
+
+static ndn_compiled_schema_memo_t*
+schema_memo_set(const ndn_compiled_schema_t* self, const uint8_t* data_name, uint32_t data_name_size,
+                const uint8_t* key_name, uint32_t key_name_size);
+
+static void
+schema_reset(ndn_compiled_schema_t* self);
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+int
+ndn_compiled_schema_init(ndn_compiled_schema_t* self, uint32_t memo_capacity){
+  uint32_t sets = 1;
+
+  while(sets * NDN_COMPILED_SCHEMA_MEMO_WAYS < memo_capacity){
+    sets <<= 1;
+  }
+  memset(self, 0, sizeof(ndn_compiled_schema_t));
+  self->memo = (ndn_compiled_schema_memo_t*)calloc(sets * NDN_COMPILED_SCHEMA_MEMO_WAYS,
+                                                   sizeof(ndn_compiled_schema_memo_t));
+  if(self->memo == NULL){
+    return NDN_FWD_NO_MEM;
+  }
+  self->memo_set_mask = sets - 1;
+  return NDN_SUCCESS;
+}
+
+static void
+schema_reset(ndn_compiled_schema_t* self){
+  free(self->symbols);
+  free(self->transitions);
+  free(self->accept_offsets);
+  free(self->accepts);
+  self->symbols = NULL;
+  self->transitions = NULL;
+  self->accept_offsets = NULL;
+  self->accepts = NULL;
+  self->symbol_count = self->state_count = 0;
+  self->compiled = false;
+  self->oversize = false;
+  memset(self->memo, 0, sizeof(ndn_compiled_schema_memo_t) * (self->memo_set_mask + 1) * NDN_COMPILED_SCHEMA_MEMO_WAYS);
+}
+
+void
+ndn_compiled_schema_destroy(ndn_compiled_schema_t* self){
+  schema_reset(self);
+  free(self->rules);
+  free(self->literals);
+  free(self->memo);
+  memset(self, 0, sizeof(ndn_compiled_schema_t));
+}
+
+static int
+schema_parse(ndn_compiled_schema_t* self, const char* pattern, bool is_key,
+             ndn_compiled_schema_token_t* tokens, uint8_t* count, ndn_compiled_schema_rule_t* rule){
+  ndn_compiled_schema_token_t* token;
+  const char *p = pattern, *close;
+  uint32_t size, capacity;
+  bool in_group = false;
+  uint8_t* literals;
+
+  *count = 0;
+  while(*p != '\0'){
+    if(!is_key && (*p == '(' || *p == ')')){
+      if((*p == '(') == in_group){
+        return NDN_WRONG_TLV_TYPE;
+      }
+      if(*p == '('){
+        if(rule->group_count >= NDN_COMPILED_SCHEMA_MAX_GROUPS){
+          return NDN_OVERSIZE;
+        }
+        rule->group_begin[rule->group_count] = *count;
+      }else{
+        rule->group_end[rule->group_count ++] = *count;
+      }
+      in_group = !in_group;
+      p ++;
+      continue;
+    }
+
+    if(*count >= NDN_COMPILED_SCHEMA_MAX_TOKENS){
+      return NDN_OVERSIZE;
+    }
+    token = &tokens[(*count) ++];
+    memset(token, 0, sizeof(ndn_compiled_schema_token_t));
+    if(is_key && *p == '\\'){
+      // Groups are numbered from 1 like in regular expressions
+      if(p[1] < '1' || p[1] > '0' + NDN_COMPILED_SCHEMA_MAX_GROUPS){
+        return NDN_WRONG_TLV_TYPE;
+      }
+      token->kind = NDN_COMPILED_SCHEMA_TOKEN_BACKREF;
+      token->group = (uint8_t)(p[1] - '1');
+      p += 2;
+      continue;
+    }
+    if(*p != '<'){
+      return NDN_WRONG_TLV_TYPE;
+    }
+    close = strchr(p, '>');
+    if(close == NULL){
+      return NDN_WRONG_TLV_TYPE;
+    }
+    size = (uint32_t)(close - p - 1);
+    if(size == 0 && close[1] == '*'){
+      token->kind = NDN_COMPILED_SCHEMA_TOKEN_STAR;
+      p = close + 2;
+      continue;
+    }
+    if(size == 0){
+      token->kind = NDN_COMPILED_SCHEMA_TOKEN_ANY;
+      p = close + 1;
+      continue;
+    }
+
+    if(self->literals_size + size > self->literals_capacity){
+      capacity = self->literals_capacity ? self->literals_capacity : 256;
+      while(capacity < self->literals_size + size){
+        capacity <<= 1;
+      }
+      literals = (uint8_t*)realloc(self->literals, capacity);
+      if(literals == NULL){
+        return NDN_FWD_NO_MEM;
+      }
+      self->literals = literals;
+      self->literals_capacity = capacity;
+    }
+    memcpy(self->literals + self->literals_size, p + 1, size);
+    token->kind = NDN_COMPILED_SCHEMA_TOKEN_LITERAL;
+    token->offset = self->literals_size;
+    token->size = size;
+    self->literals_size += size;
+    p = close + 1;
+  }
+  return in_group ? NDN_WRONG_TLV_TYPE : NDN_SUCCESS;
+}
+
+int
+ndn_compiled_schema_add_rule(ndn_compiled_schema_t* self, const char* data_pattern,
+                             const char* key_pattern){
+  ndn_compiled_schema_rule_t *rule, *rules;
+  uint32_t capacity, literals_size = self->literals_size, i;
+  int ret;
+
+  if(self->rule_count == self->rule_capacity){
+    capacity = self->rule_capacity ? self->rule_capacity * 2 : 8;
+    rules = (ndn_compiled_schema_rule_t*)realloc(self->rules, capacity * sizeof(ndn_compiled_schema_rule_t));
+    if(rules == NULL){
+      return NDN_FWD_NO_MEM;
+    }
+    self->rules = rules;
+    self->rule_capacity = capacity;
+  }
+  rule = &self->rules[self->rule_count];
+  memset(rule, 0, sizeof(ndn_compiled_schema_rule_t));
+  ret = schema_parse(self, data_pattern, false, rule->data, &rule->data_count, rule);
+  if(ret == NDN_SUCCESS){
+    ret = schema_parse(self, key_pattern, true, rule->key, &rule->key_count, rule);
+  }
+  for(i = 0; ret == NDN_SUCCESS && i < rule->key_count; i ++){
+    if(rule->key[i].kind == NDN_COMPILED_SCHEMA_TOKEN_BACKREF && rule->key[i].group >= rule->group_count){
+      ret = NDN_WRONG_TLV_TYPE;
+    }
+  }
+  if(ret != NDN_SUCCESS){
+    self->literals_size = literals_size;
+    return ret;
+  }
+  self->rule_count ++;
+  schema_reset(self);
+  return NDN_SUCCESS;
+}
+
+static uint16_t
+schema_symbol(const ndn_compiled_schema_t* self, const uint8_t* value, uint32_t size){
+  const ndn_compiled_schema_symbol_t* entry;
+  uint64_t hash = ndn_name_kernels_hash(value, size) | 1;
+  uint32_t i;
+
+  for(i = hash & self->symbol_mask; self->symbols[i].hash != 0; i = (i + 1) & self->symbol_mask){
+    entry = &self->symbols[i];
+    if(entry->hash == hash && entry->size == size &&
+       memcmp(self->literals + entry->offset, value, size) == 0){
+      return entry->symbol;
+    }
+  }
+  return SCHEMA_SYMBOL_OTHER;
+}
+
+static void
+schema_closure(const ndn_compiled_schema_t* self, const uint32_t* base, uint64_t* set){
+  uint32_t r, p, bit;
+
+  // <>* may match nothing, so its successor is active as well
+  for(r = 0; r < self->rule_count; r ++){
+    for(p = 0; p < self->rules[r].data_count; p ++){
+      bit = base[r] + p;
+      if((set[bit / 64] >> (bit % 64) & 1) && self->rules[r].data[p].kind == NDN_COMPILED_SCHEMA_TOKEN_STAR){
+        set[(bit + 1) / 64] |= 1ULL << ((bit + 1) % 64);
+      }
+    }
+  }
+}
+
+static uint32_t*
+schema_subsets_slot(const schema_subsets_t* subsets, const uint64_t* set){
+  size_t size = subsets->words * sizeof(uint64_t);
+  uint32_t i;
+
+  i = (uint32_t)ndn_name_kernels_hash((const uint8_t*)set, size) & subsets->index_mask;
+  while(subsets->index[i] != 0 &&
+        memcmp(&subsets->sets[(size_t)(subsets->index[i] - 1) * subsets->words], set, size) != 0){
+    i = (i + 1) & subsets->index_mask;
+  }
+  return &subsets->index[i];
+}
+
+// Doubles the sets, the transitions and the index, which is rebuilt
+static int
+schema_subsets_grow(ndn_compiled_schema_t* self, schema_subsets_t* subsets, uint32_t symbols){
+  uint32_t capacity, state;
+  uint64_t* sets;
+  uint16_t* transitions;
+
+  capacity = (subsets->capacity > 0) ? subsets->capacity * 2 : SCHEMA_MIN_STATES;
+  if(capacity > NDN_COMPILED_SCHEMA_MAX_STATES){
+    capacity = NDN_COMPILED_SCHEMA_MAX_STATES;
+  }
+  sets = (uint64_t*)realloc(subsets->sets, (size_t)capacity * subsets->words * sizeof(uint64_t));
+  if(sets == NULL){
+    return NDN_FWD_NO_MEM;
+  }
+  memset(&sets[(size_t)subsets->capacity * subsets->words], 0,
+         (size_t)(capacity - subsets->capacity) * subsets->words * sizeof(uint64_t));
+  subsets->sets = sets;
+  transitions = (uint16_t*)realloc(self->transitions, (size_t)capacity * symbols * sizeof(uint16_t));
+  if(transitions == NULL){
+    return NDN_FWD_NO_MEM;
+  }
+  memset(&transitions[(size_t)subsets->capacity * symbols], 0,
+         (size_t)(capacity - subsets->capacity) * symbols * sizeof(uint16_t));
+  self->transitions = transitions;
+  subsets->capacity = capacity;
+
+  // At most half full
+  free(subsets->index);
+  subsets->index_mask = capacity * 2 - 1;
+  subsets->index = (uint32_t*)calloc(capacity * 2, sizeof(uint32_t));
+  if(subsets->index == NULL){
+    return NDN_FWD_NO_MEM;
+  }
+  for(state = 0; state < self->state_count; state ++){
+    *schema_subsets_slot(subsets, &subsets->sets[(size_t)state * subsets->words]) = state + 1;
+  }
+  return NDN_SUCCESS;
+}
+
+int
+ndn_compiled_schema_compile(ndn_compiled_schema_t* self){
+  uint32_t *base, words, positions = 0, symbols, slots = SCHEMA_MIN_SLOTS;
+  uint32_t r, p, i, s, state, next, accepts = 0, bit;
+  uint32_t* slot;
+  uint64_t *sets, *set, hash;
+  uint16_t* transitions;
+  schema_subsets_t subsets = {NULL, 0, 0, NULL, 0};
+  const ndn_compiled_schema_token_t* token;
+  ndn_compiled_schema_rule_t* rule;
+  int ret = NDN_SUCCESS;
+
+  if(self->compiled){
+    return NDN_SUCCESS;
+  }
+  if(self->oversize){
+    return NDN_OVERSIZE;
+  }
+  schema_reset(self);
+
+  // NFA position p of rule r is bit base[r] + p; bit base[r] + data_count accepts
+  base = (uint32_t*)malloc((self->rule_count + 1) * sizeof(uint32_t));
+  if(base == NULL){
+    return NDN_FWD_NO_MEM;
+  }
+  for(r = 0; r < self->rule_count; r ++){
+    base[r] = positions;
+    positions += self->rules[r].data_count + 1;
+  }
+  base[r] = positions;
+  words = (positions + 63) / 64;
+
+  // Every distinct literal of the data patterns is a symbol
+  for(r = 0, symbols = 1; r < self->rule_count; r ++){
+    symbols += self->rules[r].data_count;
+  }
+  while(slots / 4 * 3 < symbols){
+    slots <<= 1;
+  }
+  self->symbols = (ndn_compiled_schema_symbol_t*)calloc(slots, sizeof(ndn_compiled_schema_symbol_t));
+  if(self->symbols == NULL){
+    free(base);
+    return NDN_FWD_NO_MEM;
+  }
+  self->symbol_mask = slots - 1;
+  self->symbol_count = 1;
+  for(r = 0; r < self->rule_count; r ++){
+    rule = &self->rules[r];
+    for(p = 0; p < rule->data_count; p ++){
+      if(rule->data[p].kind != NDN_COMPILED_SCHEMA_TOKEN_LITERAL){
+        continue;
+      }
+      rule->data[p].symbol = schema_symbol(self, self->literals + rule->data[p].offset, rule->data[p].size);
+      if(rule->data[p].symbol != SCHEMA_SYMBOL_OTHER){
+        continue;
+      }
+      if(self->symbol_count == UINT16_MAX){
+        free(base);
+        schema_reset(self);
+        self->oversize = true;
+        return NDN_OVERSIZE;
+      }
+      hash = ndn_name_kernels_hash(self->literals + rule->data[p].offset, rule->data[p].size) | 1;
+      for(i = hash & self->symbol_mask; self->symbols[i].hash != 0; i = (i + 1) & self->symbol_mask);
+      self->symbols[i].hash = hash;
+      self->symbols[i].offset = rule->data[p].offset;
+      self->symbols[i].size = rule->data[p].size;
+      self->symbols[i].symbol = rule->data[p].symbol = (uint16_t)self->symbol_count ++;
+    }
+  }
+  symbols = self->symbol_count;
+
+  // Subset construction; state 0 is the empty set
+  subsets.words = words;
+  ret = schema_subsets_grow(self, &subsets, symbols);
+  if(ret != NDN_SUCCESS){
+    goto cleanup;
+  }
+  sets = subsets.sets;
+  set = &sets[words];
+  for(r = 0; r < self->rule_count; r ++){
+    set[base[r] / 64] |= 1ULL << (base[r] % 64);
+  }
+  schema_closure(self, base, set);
+  *schema_subsets_slot(&subsets, &sets[0]) = 1;
+  *schema_subsets_slot(&subsets, set) = 2;
+  self->start = 1;
+  self->state_count = 2;
+  for(state = 1; state < self->state_count; state ++){
+    for(s = 0; s < symbols; s ++){
+      // Room for the set being looked up
+      if(self->state_count == subsets.capacity){
+        ret = schema_subsets_grow(self, &subsets, symbols);
+        if(ret != NDN_SUCCESS){
+          goto cleanup;
+        }
+        sets = subsets.sets;
+      }
+      set = &sets[(size_t)self->state_count * words];
+      memset(set, 0, words * sizeof(uint64_t));
+      for(r = 0; r < self->rule_count; r ++){
+        rule = &self->rules[r];
+        for(p = 0; p < rule->data_count; p ++){
+          bit = base[r] + p;
+          if(!(sets[(size_t)state * words + bit / 64] >> (bit % 64) & 1)){
+            continue;
+          }
+          token = &rule->data[p];
+          if(token->kind == NDN_COMPILED_SCHEMA_TOKEN_STAR){
+            set[bit / 64] |= 1ULL << (bit % 64);
+          }else if(token->kind == NDN_COMPILED_SCHEMA_TOKEN_ANY ||
+                   (token->kind == NDN_COMPILED_SCHEMA_TOKEN_LITERAL && token->symbol == s)){
+            set[(bit + 1) / 64] |= 1ULL << ((bit + 1) % 64);
+          }
+        }
+      }
+      schema_closure(self, base, set);
+      slot = schema_subsets_slot(&subsets, set);
+      if(*slot != 0){
+        next = *slot - 1;
+      }else{
+        if(self->state_count == NDN_COMPILED_SCHEMA_MAX_STATES - 1){
+          ret = NDN_OVERSIZE;
+          goto cleanup;
+        }
+        next = self->state_count ++;
+        *slot = next + 1;
+      }
+      self->transitions[(size_t)state * symbols + s] = (uint16_t)next;
+    }
+  }
+
+  // Rules whose data pattern is fully matched in each state
+  self->accept_offsets = (uint32_t*)calloc(self->state_count + 1, sizeof(uint32_t));
+  for(state = 0; self->accept_offsets != NULL && state < self->state_count; state ++){
+    for(r = 0; r < self->rule_count; r ++){
+      bit = base[r] + self->rules[r].data_count;
+      accepts += sets[(size_t)state * words + bit / 64] >> (bit % 64) & 1;
+    }
+    self->accept_offsets[state + 1] = accepts;
+  }
+  self->accepts = (uint32_t*)malloc((accepts + 1) * sizeof(uint32_t));
+  if(self->accept_offsets == NULL || self->accepts == NULL){
+    ret = NDN_FWD_NO_MEM;
+    goto cleanup;
+  }
+  for(state = 0, i = 0; state < self->state_count; state ++){
+    for(r = 0; r < self->rule_count; r ++){
+      bit = base[r] + self->rules[r].data_count;
+      if(sets[(size_t)state * words + bit / 64] >> (bit % 64) & 1){
+        self->accepts[i ++] = r;
+      }
+    }
+  }
+  transitions = (uint16_t*)realloc(self->transitions, (size_t)self->state_count * symbols * sizeof(uint16_t));
+  if(transitions != NULL){
+    self->transitions = transitions;
+  }
+  self->compiled = true;
+
+cleanup:
+  free(base);
+  free(subsets.sets);
+  free(subsets.index);
+  if(ret != NDN_SUCCESS){
+    schema_reset(self);
+    // Not compiled again until a rule is added, as it would fail again
+    self->oversize = (ret == NDN_OVERSIZE);
+  }
+  return ret;
+}
+
+static int
+schema_split(const uint8_t* name, uint32_t name_size, schema_comp_t* comps, uint32_t* count){
+  const uint8_t *ptr, *end;
+  uint32_t type, length;
+
+  ptr = ndn_pkt_read_tl(name, name + name_size, &type, &length);
+  if(ptr == NULL){
+    return NDN_WRONG_TLV_LENGTH;
+  }
+  if(type != TLV_Name){
+    return NDN_WRONG_TLV_TYPE;
+  }
+  end = ptr + length;
+  for(*count = 0; ptr < end; (*count) ++){
+    if(*count >= NDN_COMPILED_SCHEMA_MAX_COMPONENTS){
+      return NDN_OVERSIZE;
+    }
+    comps[*count].tlv = ptr;
+    comps[*count].value = ndn_pkt_read_tl(ptr, end, &comps[*count].type, &comps[*count].size);
+    if(comps[*count].value == NULL){
+      return NDN_WRONG_TLV_LENGTH;
+    }
+    ptr = comps[*count].value + comps[*count].size;
+  }
+  return NDN_SUCCESS;
+}
+
+static bool
+schema_segment(const ndn_compiled_schema_t* self, const ndn_compiled_schema_token_t* tokens,
+               uint32_t begin, uint32_t end, const schema_comp_t* comps, uint32_t at,
+               const schema_span_t* spans, uint32_t* pos){
+  const schema_span_t* span;
+  const schema_comp_t* last;
+  uint32_t i;
+
+  for(i = begin; i < end; i ++){
+    pos[i] = at;
+    switch(tokens[i].kind){
+      case NDN_COMPILED_SCHEMA_TOKEN_LITERAL:
+        if(comps[at].type != TLV_GenericNameComponent || comps[at].size != tokens[i].size ||
+           memcmp(comps[at].value, self->literals + tokens[i].offset, tokens[i].size) != 0){
+          return false;
+        }
+        at ++;
+        break;
+      case NDN_COMPILED_SCHEMA_TOKEN_ANY:
+        at ++;
+        break;
+      case NDN_COMPILED_SCHEMA_TOKEN_BACKREF:
+        span = &spans[tokens[i].group];
+        if(span->count > 0){
+          last = &comps[at + span->count - 1];
+          if((size_t)(last->value + last->size - comps[at].tlv) != (size_t)(span->end - span->begin) ||
+             memcmp(comps[at].tlv, span->begin, span->end - span->begin) != 0){
+            return false;
+          }
+        }
+        at += span->count;
+        break;
+    }
+  }
+  return true;
+}
+
+static bool
+schema_place(const ndn_compiled_schema_t* self, const ndn_compiled_schema_token_t* tokens, uint32_t count,
+             const schema_comp_t* comps, uint32_t comp_count, const schema_span_t* spans,
+             uint32_t* pos){
+  uint32_t width[NDN_COMPILED_SCHEMA_MAX_TOKENS + 1];
+  uint32_t first = count, last = count, i, next, cursor, limit, at;
+
+  // Every token but <>* matches a known number of components
+  for(i = 0; i < count; i ++){
+    if(tokens[i].kind == NDN_COMPILED_SCHEMA_TOKEN_STAR){
+      first = (first == count) ? i : first;
+      last = i;
+    }
+  }
+  for(i = count, width[count] = 0; i > 0; i --){
+    width[i - 1] = width[i];
+    if(tokens[i - 1].kind == NDN_COMPILED_SCHEMA_TOKEN_BACKREF){
+      width[i - 1] += spans[tokens[i - 1].group].count;
+    }else if(tokens[i - 1].kind != NDN_COMPILED_SCHEMA_TOKEN_STAR){
+      width[i - 1] ++;
+    }
+  }
+  pos[count] = comp_count;
+  if(first == count){
+    return width[0] == comp_count && schema_segment(self, tokens, 0, count, comps, 0, spans, pos);
+  }
+
+  // The parts before the first and after the last <>* are anchored
+  limit = comp_count - width[last + 1];
+  if(width[0] - width[first] + width[last + 1] > comp_count ||
+     !schema_segment(self, tokens, 0, first, comps, 0, spans, pos) ||
+     !schema_segment(self, tokens, last + 1, count, comps, limit, spans, pos)){
+    return false;
+  }
+  // Each part in between is placed at its leftmost match
+  cursor = width[0] - width[first];
+  for(i = first; i < last; i = next){
+    pos[i] = cursor;
+    for(next = i + 1; tokens[next].kind != NDN_COMPILED_SCHEMA_TOKEN_STAR; next ++);
+    for(at = cursor; at + width[i + 1] - width[next] <= limit; at ++){
+      if(schema_segment(self, tokens, i + 1, next, comps, at, spans, pos)){
+        break;
+      }
+    }
+    if(at + width[i + 1] - width[next] > limit){
+      return false;
+    }
+    cursor = at + width[i + 1] - width[next];
+  }
+  pos[last] = cursor;
+  return true;
+}
+
+static bool
+schema_check_rule(const ndn_compiled_schema_t* self, const ndn_compiled_schema_rule_t* rule,
+                  const schema_comp_t* data, uint32_t data_count,
+                  const schema_comp_t* key, uint32_t key_count){
+  schema_span_t spans[NDN_COMPILED_SCHEMA_MAX_GROUPS];
+  uint32_t pos[NDN_COMPILED_SCHEMA_MAX_TOKENS + 1];
+  uint32_t g, begin, end;
+
+  if(!schema_place(self, rule->data, rule->data_count, data, data_count, NULL, pos)){
+    return false;
+  }
+  for(g = 0; g < rule->group_count; g ++){
+    begin = pos[rule->group_begin[g]];
+    end = pos[rule->group_end[g]];
+    spans[g].count = end - begin;
+    spans[g].begin = spans[g].end = NULL;
+    if(end > begin){
+      spans[g].begin = data[begin].tlv;
+      spans[g].end = data[end - 1].value + data[end - 1].size;
+    }
+  }
+  return schema_place(self, rule->key, rule->key_count, key, key_count, spans, pos);
+}
+
+static ndn_compiled_schema_memo_t*
+schema_memo_set(const ndn_compiled_schema_t* self, const uint8_t* data_name, uint32_t data_name_size,
+                const uint8_t* key_name, uint32_t key_name_size){
+  uint64_t hash;
+
+  hash = ndn_name_kernels_hash(data_name, data_name_size) ^
+         ndn_name_kernels_hash(key_name, key_name_size) * 0x9E3779B97F4A7C15ULL;
+  return &self->memo[((hash >> 32) & self->memo_set_mask) * NDN_COMPILED_SCHEMA_MEMO_WAYS];
+}
+
+int
+ndn_compiled_schema_check(ndn_compiled_schema_t* self, const uint8_t* data_name, uint32_t data_name_size,
+                          const uint8_t* key_name, uint32_t key_name_size){
+  schema_comp_t data[NDN_COMPILED_SCHEMA_MAX_COMPONENTS], key[NDN_COMPILED_SCHEMA_MAX_COMPONENTS];
+  uint32_t data_count, key_count, state, i;
+  ndn_compiled_schema_memo_t *set = NULL, *victim;
+  int ret;
+
+  ret = ndn_compiled_schema_compile(self);
+  if(ret != NDN_SUCCESS && ret != NDN_OVERSIZE){
+    return ret;
+  }
+  if(data_name_size <= NDN_COMPILED_SCHEMA_MEMO_NAME_SIZE && key_name_size <= NDN_COMPILED_SCHEMA_MEMO_NAME_SIZE){
+    set = schema_memo_set(self, data_name, data_name_size, key_name, key_name_size);
+    for(i = 0; i < NDN_COMPILED_SCHEMA_MEMO_WAYS; i ++){
+      if(set[i].in_use && set[i].data_name_size == data_name_size && set[i].key_name_size == key_name_size &&
+         memcmp(set[i].data_name, data_name, data_name_size) == 0 &&
+         memcmp(set[i].key_name, key_name, key_name_size) == 0){
+        self->hits ++;
+        return set[i].result;
+      }
+    }
+  }
+  self->misses ++;
+
+  ret = schema_split(data_name, data_name_size, data, &data_count);
+  if(ret == NDN_SUCCESS){
+    ret = schema_split(key_name, key_name_size, key, &key_count);
+  }
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  ret = NDN_SEC_FAIL_VERIFY_SIG;
+  if(self->oversize){
+    for(i = 0; i < self->rule_count; i ++){
+      if(schema_check_rule(self, &self->rules[i], data, data_count, key, key_count)){
+        ret = NDN_SUCCESS;
+        break;
+      }
+    }
+  }else{
+    state = self->start;
+    for(i = 0; i < data_count && state != SCHEMA_STATE_DEAD; i ++){
+      state = self->transitions[(size_t)state * self->symbol_count +
+                                (data[i].type == TLV_GenericNameComponent ?
+                                 schema_symbol(self, data[i].value, data[i].size) : SCHEMA_SYMBOL_OTHER)];
+    }
+    for(i = self->accept_offsets[state]; i < self->accept_offsets[state + 1]; i ++){
+      if(schema_check_rule(self, &self->rules[self->accepts[i]], data, data_count, key, key_count)){
+        ret = NDN_SUCCESS;
+        break;
+      }
+    }
+  }
+
+  if(set != NULL){
+    // Results stay valid until a rule is added, so only the oldest way is dropped
+    memmove(&set[1], &set[0], sizeof(ndn_compiled_schema_memo_t) * (NDN_COMPILED_SCHEMA_MEMO_WAYS - 1));
+    victim = &set[0];
+    memcpy(victim->data_name, data_name, data_name_size);
+    memcpy(victim->key_name, key_name, key_name_size);
+    victim->data_name_size = (uint8_t)data_name_size;
+    victim->key_name_size = (uint8_t)key_name_size;
+    victim->result = ret;
+    victim->in_use = true;
+  }
+  return ret;
+}
+
+int
+ndn_compiled_schema_check_packet(ndn_compiled_schema_t* self, const uint8_t* packet, uint32_t size){
+  const uint8_t* key_name;
+  uint32_t key_name_size;
+  ndn_pkt_peek_t peek;
+  int ret;
+
+  ret = ndn_pkt_peek(packet, size, &peek);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  ret = ndn_key_store_get_key_locator(packet, size, &key_name, &key_name_size);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  return ndn_compiled_schema_check(self, peek.name, peek.name_size, key_name, key_name_size);
+}
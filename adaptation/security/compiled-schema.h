@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#ifndef NDN_COMPILED_SCHEMA_H_
+#define NDN_COMPILED_SCHEMA_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Tokens of a pattern, capture groups of a data pattern
+#define NDN_COMPILED_SCHEMA_MAX_TOKENS 16
+#define NDN_COMPILED_SCHEMA_MAX_GROUPS 4
+// Longest name checked
+#define NDN_COMPILED_SCHEMA_MAX_COMPONENTS 32
+// Bound on the DFA built from the data patterns
+#define NDN_COMPILED_SCHEMA_MAX_STATES 4096
+#define NDN_COMPILED_SCHEMA_DEFAULT_MEMO_CAPACITY 1024
+// Encoded names longer than this are checked but not memoised
+#define NDN_COMPILED_SCHEMA_MEMO_NAME_SIZE 128
+// Entries compared per memo lookup
+#define NDN_COMPILED_SCHEMA_MEMO_WAYS 4
+
+#define NDN_COMPILED_SCHEMA_TOKEN_LITERAL 0
+#define NDN_COMPILED_SCHEMA_TOKEN_ANY 1
+#define NDN_COMPILED_SCHEMA_TOKEN_STAR 2
+#define NDN_COMPILED_SCHEMA_TOKEN_BACKREF 3
+
+typedef struct ndn_compiled_schema_token {
+  uint8_t kind;
+  /**
+   * Group of a BACKREF.
+   */
+  uint8_t group;
+  /**
+   * DFA symbol of a LITERAL in a data pattern.
+   */
+  uint16_t symbol;
+  /**
+   * Value of a LITERAL in the literal pool.
+   */
+  uint32_t offset;
+  uint32_t size;
+} ndn_compiled_schema_token_t;
+
+typedef struct ndn_compiled_schema_rule {
+  ndn_compiled_schema_token_t data[NDN_COMPILED_SCHEMA_MAX_TOKENS];
+  uint8_t data_count;
+  ndn_compiled_schema_token_t key[NDN_COMPILED_SCHEMA_MAX_TOKENS];
+  uint8_t key_count;
+  /**
+   * Data tokens [begin, end) of each group.
+   */
+  uint8_t group_begin[NDN_COMPILED_SCHEMA_MAX_GROUPS];
+  uint8_t group_end[NDN_COMPILED_SCHEMA_MAX_GROUPS];
+  uint8_t group_count;
+} ndn_compiled_schema_rule_t;
+
+typedef struct ndn_compiled_schema_symbol {
+  uint64_t hash;
+  uint32_t offset;
+  uint32_t size;
+  uint16_t symbol;
+} ndn_compiled_schema_symbol_t;
+
+typedef struct ndn_compiled_schema_memo {
+  uint8_t data_name[NDN_COMPILED_SCHEMA_MEMO_NAME_SIZE];
+  uint8_t key_name[NDN_COMPILED_SCHEMA_MEMO_NAME_SIZE];
+  uint8_t data_name_size;
+  uint8_t key_name_size;
+  bool in_use;
+  int result;
+} ndn_compiled_schema_memo_t;
+
+/**
+ * Trust schema whose rules are compiled into one DFA.
+ * Unrelated to the rule-by-rule trust schema of ndn-lite; this one is a
+ * library that nothing in the forwarder calls, and is not included by
+ * ndn-lite.h.
+ *
+ * A rule allows a Data name matching its data pattern to be signed by a key
+ * whose name matches its key pattern. Patterns are written as
+ *
+ *   <lit>  a GenericNameComponent equal to lit
+ *   <>     any one component
+ *   <>*    any number of components
+ *   ( )    in a data pattern, capture the components matched inside
+ *   \N     in a key pattern, the components captured by group N, from 1
+ *
+ * e.g. data "(<>*)<sensor><>" and key "\1<KEY><>".
+ *
+ * Before the first check, the data patterns are compiled into a DFA over the
+ * literal components of all rules. A data name is then matched in one pass
+ * whatever the number of rules, and the DFA state reached lists the rules
+ * whose data pattern matches. Only those rules resolve their groups and
+ * check the key name. If the DFA exceeds NDN_COMPILED_SCHEMA_MAX_STATES, it is
+ * not built and every rule is checked in turn.
+ *
+ * A group is resolved without backtracking: the parts between the first and
+ * the last <>* are placed at their leftmost match, and the key pattern is
+ * checked against that split only. Unlike the greedy regular expressions of
+ * ndn-lite, data "(<>*)<x><>*" on /a/x/b/x/c captures /a rather than
+ * /a/x/b, so key "\1<KEY><>" allows /a/KEY/1 but not /a/x/b/KEY/1.
+ *
+ * Results of (data name, key name) pairs are memoised until a rule is added.
+ */
+typedef struct ndn_compiled_schema {
+  ndn_compiled_schema_rule_t* rules;
+  uint32_t rule_count;
+  uint32_t rule_capacity;
+  uint8_t* literals;
+  uint32_t literals_size;
+  uint32_t literals_capacity;
+
+  /**
+   * Compiled DFA. Symbol 0 stands for components no data pattern names,
+   * and state 0 is the dead state.
+   */
+  bool compiled;
+  /**
+   * The DFA did not fit; rules are checked one by one until a rule is added.
+   */
+  bool oversize;
+  ndn_compiled_schema_symbol_t* symbols;
+  uint32_t symbol_mask;
+  uint32_t symbol_count;
+  uint16_t* transitions;
+  uint32_t state_count;
+  uint16_t start;
+  uint32_t* accept_offsets;
+  uint32_t* accepts;
+
+  ndn_compiled_schema_memo_t* memo;
+  uint32_t memo_set_mask;
+
+  uint64_t hits;
+  uint64_t misses;
+} ndn_compiled_schema_t;
+
+/**
+ * @param memo_capacity Number of memoised results, rounded up to a power of 2.
+ */
+int
+ndn_compiled_schema_init(ndn_compiled_schema_t* self, uint32_t memo_capacity);
+
+void
+ndn_compiled_schema_destroy(ndn_compiled_schema_t* self);
+
+/**
+ * Add a rule. The schema is compiled again on the next check.
+ * @return NDN_SUCCESS, NDN_WRONG_TLV_TYPE if a pattern is malformed,
+ *   or NDN_OVERSIZE if it has too many tokens or groups.
+ */
+int
+ndn_compiled_schema_add_rule(ndn_compiled_schema_t* self, const char* data_pattern,
+                             const char* key_pattern);
+
+/**
+ * Build the DFA now rather than on the first check.
+ * @return NDN_SUCCESS, or NDN_OVERSIZE if the DFA exceeds
+ *   NDN_COMPILED_SCHEMA_MAX_STATES, which checks still work with.
+ */
+int
+ndn_compiled_schema_compile(ndn_compiled_schema_t* self);
+
+/**
+ * Check whether some rule allows a Data to be signed by a key.
+ * @param data_name Whole Name TLV of the Data.
+ * @param key_name Whole Name TLV of the key, e.g. of a KeyLocator.
+ * @return NDN_SUCCESS, NDN_SEC_FAIL_VERIFY_SIG if no rule allows it,
+ *   or an error.
+ */
+int
+ndn_compiled_schema_check(ndn_compiled_schema_t* self, const uint8_t* data_name, uint32_t data_name_size,
+                          const uint8_t* key_name, uint32_t key_name_size);
+
+/**
+ * ndn_compiled_schema_check on the name and KeyLocator of a Data or signed
+ * Interest.
+ */
+int
+ndn_compiled_schema_check_packet(ndn_compiled_schema_t* self, const uint8_t* packet, uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,512 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "crypto-pool.h"
+#include "verify-cache.h"
+#include "../forwarder/submit-queue.h"
+#include "ndn-lite/ndn-error-code.h"
+#include "ndn-lite/util/msg-queue.h"
+
+enum {
+  CRYPTO_JOB_SEGMENT,
+  CRYPTO_JOB_NAMED,
+  CRYPTO_JOB_VERIFY,
+};
+
+/**
+ * A job, from submission on the forwarder thread to its callback.
+ * The input is followed by room for the output in data.
+ */
+typedef struct ndn_crypto_job {
+  struct ndn_crypto_job* next;
+  struct ndn_crypto_job* stream_next;
+  ndn_crypto_stream_t* stream;
+  uint8_t type;
+  bool done;
+  bool cached;
+  int result;
+  const ndn_data_template_t* tpl;
+  uint64_t segno;
+  ndn_ecc_pub_t pub_key;
+  uint8_t cache_key[NDN_SEC_SHA256_HASH_SIZE];
+  ndn_crypto_on_data_func on_data;
+  ndn_crypto_on_verify_func on_verify;
+  void* userdata;
+  uint32_t name_size;
+  uint32_t input_size;
+  uint32_t output_size;
+  uint32_t output_max;
+  uint8_t data[];
+} ndn_crypto_job_t;
+
+typedef struct ndn_crypto_pool {
+  pthread_t threads[NDN_CRYPTO_POOL_MAX_THREADS];
+  int thread_count;
+
+  // Jobs waiting for a worker
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  ndn_crypto_job_t* head;
+  ndn_crypto_job_t* tail;
+  bool stopping;
+
+  // Jobs done, back to the forwarder thread
+  ndn_mpsc_ring_t done;
+  atomic_bool signaled;
+  int fd;
+  int wake_fd;
+
+  // Forwarder thread only. The ring never overflows since it is bounded too.
+  uint32_t in_flight;
+  // Jobs answered without a worker, e.g. by the verify cache
+  ndn_crypto_job_t* ready_head;
+  ndn_crypto_job_t* ready_tail;
+  // Posted while jobs are in flight
+  struct ndn_msg* process_event;
+} ndn_crypto_pool_t;
+
+static ndn_crypto_pool_t crypto_pool = {.fd = -1, .wake_fd = -1};
+
+static ndn_crypto_job_t*
+crypto_job_create(uint8_t type, const uint8_t* first, uint32_t first_size,
+                  const uint8_t* second, uint32_t second_size, uint32_t output_max);
+
+static void
+crypto_job_run(ndn_crypto_job_t* job);
+
+static void
+crypto_job_deliver(ndn_crypto_job_t* job);
+
+static int
+crypto_pool_submit(ndn_crypto_stream_t* stream, ndn_crypto_job_t* job);
+
+static void*
+crypto_pool_worker(void* arg);
+
+static void
+crypto_pool_complete(ndn_crypto_job_t* job);
+
+static void
+crypto_stream_flush(ndn_crypto_stream_t* stream);
+
+static void
+crypto_pool_finish(ndn_crypto_job_t* job);
+
+static int
+crypto_pool_collect(void);
+
+static void
+crypto_pool_schedule(void);
+
+static void
+crypto_pool_drain(void *self, size_t param_len, void *param);
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+static ndn_crypto_job_t*
+crypto_job_create(uint8_t type, const uint8_t* first, uint32_t first_size,
+                  const uint8_t* second, uint32_t second_size, uint32_t output_max){
+  ndn_crypto_job_t* job;
+
+  job = (ndn_crypto_job_t*)malloc(sizeof(ndn_crypto_job_t) + first_size + second_size + output_max);
+  if(job == NULL){
+    return NULL;
+  }
+  memset(job, 0, sizeof(ndn_crypto_job_t));
+  job->type = type;
+  job->input_size = first_size + second_size;
+  job->output_max = output_max;
+  if(first_size > 0){
+    memcpy(job->data, first, first_size);
+  }
+  if(second_size > 0){
+    memcpy(job->data + first_size, second, second_size);
+  }
+  return job;
+}
+
+static void
+crypto_job_run(ndn_crypto_job_t* job){
+  uint8_t* output = job->data + job->input_size;
+
+  switch(job->type){
+  case CRYPTO_JOB_SEGMENT:
+    job->result = ndn_data_template_make_segment(job->tpl, output, job->output_max, job->segno,
+                                                 job->data, job->input_size, &job->output_size);
+    break;
+
+  case CRYPTO_JOB_NAMED:
+    job->result = ndn_data_template_make_named(job->tpl, output, job->output_max,
+                                               job->data, job->name_size,
+                                               job->data + job->name_size,
+                                               job->input_size - job->name_size,
+                                               &job->output_size);
+    break;
+
+  case CRYPTO_JOB_VERIFY:
+    job->result = ndn_verify_cache_ecdsa_verify_packet(job->data, job->input_size, &job->pub_key);
+    break;
+  }
+}
+
+static void
+crypto_job_deliver(ndn_crypto_job_t* job){
+  if(job->type == CRYPTO_JOB_VERIFY){
+    if(job->on_verify != NULL){
+      job->on_verify(job->result, job->data, job->input_size, job->userdata);
+    }
+  }else if(job->on_data != NULL){
+    if(job->result == NDN_SUCCESS){
+      job->on_data(NDN_SUCCESS, job->data + job->input_size, job->output_size, job->userdata);
+    }else{
+      job->on_data(job->result, NULL, 0, job->userdata);
+    }
+  }
+}
+
+static void*
+crypto_pool_worker(void* arg){
+  ndn_crypto_pool_t* pool = (ndn_crypto_pool_t*)arg;
+  ndn_crypto_job_t* job;
+
+  while(true){
+    pthread_mutex_lock(&pool->lock);
+    while(pool->head == NULL && !pool->stopping){
+      pthread_cond_wait(&pool->cond, &pool->lock);
+    }
+    job = pool->head;
+    if(job != NULL){
+      pool->head = job->next;
+      if(pool->head == NULL){
+        pool->tail = NULL;
+      }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    if(job == NULL){
+      // Stopping, and the queue is empty
+      return NULL;
+    }
+
+    crypto_job_run(job);
+    crypto_pool_complete(job);
+  }
+}
+
+static void
+crypto_pool_complete(ndn_crypto_job_t* job){
+  job->next = NULL;
+  // Cannot fail: in_flight bounds the ring
+  ndn_mpsc_ring_push(&crypto_pool.done, job);
+  ndn_wakeup_signal(&crypto_pool.signaled, crypto_pool.wake_fd);
+}
+
+static int
+crypto_pool_submit(ndn_crypto_stream_t* stream, ndn_crypto_job_t* job){
+  job->stream = stream;
+  if(stream != NULL){
+    if(stream->tail != NULL){
+      stream->tail->stream_next = job;
+    }else{
+      stream->head = job;
+    }
+    stream->tail = job;
+  }
+  crypto_pool.in_flight ++;
+
+  job->next = NULL;
+  if(job->cached){
+    // Delivered by the next collect, after earlier jobs of its stream
+    if(crypto_pool.ready_tail != NULL){
+      crypto_pool.ready_tail->next = job;
+    }else{
+      crypto_pool.ready_head = job;
+    }
+    crypto_pool.ready_tail = job;
+  }else{
+    pthread_mutex_lock(&crypto_pool.lock);
+    if(crypto_pool.tail != NULL){
+      crypto_pool.tail->next = job;
+    }else{
+      crypto_pool.head = job;
+    }
+    crypto_pool.tail = job;
+    pthread_cond_signal(&crypto_pool.cond);
+    pthread_mutex_unlock(&crypto_pool.lock);
+  }
+  crypto_pool_schedule();
+  return NDN_SUCCESS;
+}
+
+static void
+crypto_stream_flush(ndn_crypto_stream_t* stream){
+  ndn_crypto_job_t* job;
+
+  // A callback destroyed the stream; the flush below it frees the stream
+  if(stream->flushing){
+    return;
+  }
+  stream->flushing = true;
+  while(stream->head != NULL && stream->head->done){
+    job = stream->head;
+    stream->head = job->stream_next;
+    if(stream->head == NULL){
+      stream->tail = NULL;
+    }
+    if(!stream->closed){
+      crypto_job_deliver(job);
+    }
+    free(job);
+    crypto_pool.in_flight --;
+  }
+  stream->flushing = false;
+  if(stream->closed && stream->head == NULL){
+    free(stream);
+  }
+}
+
+static void
+crypto_pool_finish(ndn_crypto_job_t* job){
+  // The only place a job becomes done, so it is flushed once
+  job->done = true;
+  if(job->type == CRYPTO_JOB_VERIFY && !job->cached && job->result != NDN_FWD_NO_MEM &&
+     ndn_verify_cache_get_instance() != NULL){
+    ndn_verify_cache_insert(ndn_verify_cache_get_instance(), job->cache_key, job->result);
+  }
+  if(job->stream != NULL){
+    crypto_stream_flush(job->stream);
+  }else{
+    crypto_job_deliver(job);
+    free(job);
+    crypto_pool.in_flight --;
+  }
+}
+
+static int
+crypto_pool_collect(void){
+  ndn_crypto_job_t* job;
+  int count = 0;
+
+  ndn_wakeup_clear(&crypto_pool.signaled, crypto_pool.fd);
+  while((job = (ndn_crypto_job_t*)ndn_mpsc_ring_pop(&crypto_pool.done)) != NULL){
+    crypto_pool_finish(job);
+    count ++;
+  }
+  // Callbacks may submit more; they are appended and taken in this loop
+  while((job = crypto_pool.ready_head) != NULL){
+    crypto_pool.ready_head = job->next;
+    if(crypto_pool.ready_head == NULL){
+      crypto_pool.ready_tail = NULL;
+    }
+    crypto_pool_finish(job);
+    count ++;
+  }
+  return count;
+}
+
+static void
+crypto_pool_schedule(void){
+  if(crypto_pool.process_event == NULL){
+    crypto_pool.process_event = ndn_msgqueue_post(&crypto_pool, crypto_pool_drain, 0, NULL);
+  }
+}
+
+static void
+crypto_pool_drain(void *self, size_t param_len, void *param){
+  ndn_crypto_pool_t* pool = (ndn_crypto_pool_t*)self;
+
+  pool->process_event = NULL;
+  crypto_pool_collect();
+  // Idle once every job is delivered; the next submission posts it again
+  if(pool->in_flight > 0){
+    crypto_pool_schedule();
+  }
+}
+
+int
+ndn_crypto_pool_init(int threads){
+  int fds[2];
+  int ret, i;
+
+  if(crypto_pool.fd != -1){
+    return NDN_SUCCESS;
+  }
+  if(threads <= 0){
+    threads = (int)sysconf(_SC_NPROCESSORS_ONLN) - 1;
+  }
+  if(threads < 1){
+    threads = 1;
+  }else if(threads > NDN_CRYPTO_POOL_MAX_THREADS){
+    threads = NDN_CRYPTO_POOL_MAX_THREADS;
+  }
+
+  ret = ndn_mpsc_ring_init(&crypto_pool.done, NDN_CRYPTO_POOL_QUEUE_SIZE);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  if(ndn_wakeup_fd_open(fds) == -1){
+    ndn_mpsc_ring_destroy(&crypto_pool.done);
+    return NDN_FWD_NO_MEM;
+  }
+  atomic_init(&crypto_pool.signaled, false);
+  crypto_pool.fd = fds[0];
+  crypto_pool.wake_fd = fds[1];
+  crypto_pool.head = crypto_pool.tail = NULL;
+  crypto_pool.stopping = false;
+  crypto_pool.in_flight = 0;
+  crypto_pool.ready_head = crypto_pool.ready_tail = NULL;
+  crypto_pool.process_event = NULL;
+  pthread_mutex_init(&crypto_pool.lock, NULL);
+  pthread_cond_init(&crypto_pool.cond, NULL);
+
+  for(i = 0; i < threads; i ++){
+    if(pthread_create(&crypto_pool.threads[i], NULL, crypto_pool_worker, &crypto_pool) != 0){
+      break;
+    }
+  }
+  crypto_pool.thread_count = i;
+  if(i == 0){
+    ndn_crypto_pool_shutdown();
+    return NDN_FWD_NO_MEM;
+  }
+  return NDN_SUCCESS;
+}
+
+void
+ndn_crypto_pool_shutdown(void){
+  int i;
+
+  if(crypto_pool.fd == -1){
+    return;
+  }
+  // Workers finish the queue before they exit
+  pthread_mutex_lock(&crypto_pool.lock);
+  crypto_pool.stopping = true;
+  pthread_cond_broadcast(&crypto_pool.cond);
+  pthread_mutex_unlock(&crypto_pool.lock);
+  for(i = 0; i < crypto_pool.thread_count; i ++){
+    pthread_join(crypto_pool.threads[i], NULL);
+  }
+  crypto_pool.thread_count = 0;
+  crypto_pool_collect();
+
+  if(crypto_pool.process_event != NULL){
+    ndn_msgqueue_cancel(crypto_pool.process_event);
+    crypto_pool.process_event = NULL;
+  }
+  pthread_cond_destroy(&crypto_pool.cond);
+  pthread_mutex_destroy(&crypto_pool.lock);
+  ndn_wakeup_fd_close(crypto_pool.fd, crypto_pool.wake_fd);
+  ndn_mpsc_ring_destroy(&crypto_pool.done);
+  crypto_pool.fd = crypto_pool.wake_fd = -1;
+}
+
+int
+ndn_crypto_pool_get_fd(void){
+  return crypto_pool.fd;
+}
+
+ndn_crypto_stream_t*
+ndn_crypto_stream_create(void){
+  ndn_crypto_stream_t* ret;
+
+  ret = (ndn_crypto_stream_t*)malloc(sizeof(ndn_crypto_stream_t));
+  if(ret == NULL){
+    return NULL;
+  }
+  ret->head = ret->tail = NULL;
+  ret->closed = false;
+  ret->flushing = false;
+  return ret;
+}
+
+void
+ndn_crypto_stream_destroy(ndn_crypto_stream_t* self){
+  self->closed = true;
+  crypto_stream_flush(self);
+}
+
+int
+ndn_crypto_pool_make_segment(ndn_crypto_stream_t* stream, const ndn_data_template_t* tpl,
+                             uint64_t segno, const uint8_t* content, uint32_t content_size,
+                             ndn_crypto_on_data_func on_data, void* userdata){
+  ndn_crypto_job_t* job;
+
+  if(crypto_pool.fd == -1 || crypto_pool.in_flight >= NDN_CRYPTO_POOL_QUEUE_SIZE){
+    return NDN_FWD_MSGQUEUE_FULL;
+  }
+  job = crypto_job_create(CRYPTO_JOB_SEGMENT, content, content_size, NULL, 0,
+                          content_size + NDN_CRYPTO_POOL_DATA_OVERHEAD);
+  if(job == NULL){
+    return NDN_FWD_NO_MEM;
+  }
+  job->tpl = tpl;
+  job->segno = segno;
+  job->on_data = on_data;
+  job->userdata = userdata;
+  return crypto_pool_submit(stream, job);
+}
+
+int
+ndn_crypto_pool_make_named(ndn_crypto_stream_t* stream, const ndn_data_template_t* tpl,
+                           const uint8_t* name, uint32_t name_size,
+                           const uint8_t* content, uint32_t content_size,
+                           ndn_crypto_on_data_func on_data, void* userdata){
+  ndn_crypto_job_t* job;
+
+  if(crypto_pool.fd == -1 || crypto_pool.in_flight >= NDN_CRYPTO_POOL_QUEUE_SIZE){
+    return NDN_FWD_MSGQUEUE_FULL;
+  }
+  job = crypto_job_create(CRYPTO_JOB_NAMED, name, name_size, content, content_size,
+                          name_size + content_size + NDN_CRYPTO_POOL_DATA_OVERHEAD);
+  if(job == NULL){
+    return NDN_FWD_NO_MEM;
+  }
+  job->tpl = tpl;
+  job->name_size = name_size;
+  job->on_data = on_data;
+  job->userdata = userdata;
+  return crypto_pool_submit(stream, job);
+}
+
+int
+ndn_crypto_pool_ecdsa_verify(ndn_crypto_stream_t* stream, const uint8_t* packet, uint32_t size,
+                             const ndn_ecc_pub_t* pub_key,
+                             ndn_crypto_on_verify_func on_verify, void* userdata){
+  ndn_verify_cache_t* cache = ndn_verify_cache_get_instance();
+  ndn_crypto_job_t* job;
+  int ret;
+
+  if(crypto_pool.fd == -1 || crypto_pool.in_flight >= NDN_CRYPTO_POOL_QUEUE_SIZE){
+    return NDN_FWD_MSGQUEUE_FULL;
+  }
+  job = crypto_job_create(CRYPTO_JOB_VERIFY, packet, size, NULL, 0, 0);
+  if(job == NULL){
+    return NDN_FWD_NO_MEM;
+  }
+  job->pub_key = *pub_key;
+  job->on_verify = on_verify;
+  job->userdata = userdata;
+
+  // The cache is not thread-safe, so it is only used here and on completion
+  ret = ndn_verify_cache_key(packet, size, pub_key, job->cache_key);
+  if(ret != NDN_SUCCESS){
+    job->result = ret;
+    job->cached = true;
+  }else if(cache != NULL){
+    ret = ndn_verify_cache_lookup(cache, job->cache_key);
+    if(ret != NDN_VERIFY_CACHE_MISS){
+      job->result = ret;
+      job->cached = true;
+    }
+  }
+  return crypto_pool_submit(stream, job);
+}
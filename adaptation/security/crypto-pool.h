@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#ifndef NDN_CRYPTO_POOL_H_
+#define NDN_CRYPTO_POOL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ndn-lite/security/ndn-lite-ecc.h"
+#include "../forwarder/data-template.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NDN_CRYPTO_POOL_MAX_THREADS 16
+// Jobs submitted and not yet delivered, a power of 2
+#define NDN_CRYPTO_POOL_QUEUE_SIZE 1024
+// Room for everything ndn_data_template_make_* adds around the content
+#define NDN_CRYPTO_POOL_DATA_OVERHEAD \
+  (NDN_DATA_TEMPLATE_NAME_SIZE + NDN_DATA_TEMPLATE_META_INFO_SIZE + \
+   NDN_DATA_TEMPLATE_SIGNATURE_INFO_SIZE + NDN_DATA_TEMPLATE_MAX_SIGNATURE_SIZE + 64)
+
+/**
+ * Called on the forwarder thread with a signed Data.
+ * @param result NDN_SUCCESS, or the error of encoding or signing.
+ * @param data The packet, valid only during the call. NULL on error.
+ */
+typedef void (*ndn_crypto_on_data_func)(int result, const uint8_t* data, uint32_t size,
+                                        void* userdata);
+
+/**
+ * Called on the forwarder thread with a verified packet.
+ * @param result NDN_SUCCESS, NDN_SEC_FAIL_VERIFY_SIG, or a decoding error.
+ * @param packet The packet submitted, valid only during the call.
+ */
+typedef void (*ndn_crypto_on_verify_func)(int result, const uint8_t* packet, uint32_t size,
+                                          void* userdata);
+
+/**
+ * Completions of one producer or consumer.
+ * Callbacks of a stream run in the order the jobs were submitted, however
+ * the workers finish them.
+ */
+typedef struct ndn_crypto_stream {
+  struct ndn_crypto_job* head;
+  struct ndn_crypto_job* tail;
+  bool closed;
+  // Delivering callbacks, which may destroy the stream
+  bool flushing;
+} ndn_crypto_stream_t;
+
+/**
+ * Start the workers and deliver their completions on the forwarder thread.
+ * Call once from the forwarder thread, after ndn_forwarder_init.
+ * @param threads Number of workers; 0 uses all cores but the forwarder's.
+ */
+int
+ndn_crypto_pool_init(int threads);
+
+/**
+ * Stop the workers once they have run every queued job, then deliver the
+ * callbacks of all jobs, except those of destroyed streams.
+ */
+void
+ndn_crypto_pool_shutdown(void);
+
+/**
+ * The fd readable when completions are waiting.
+ * A forwarder loop may poll it instead of sleeping.
+ */
+int
+ndn_crypto_pool_get_fd(void);
+
+ndn_crypto_stream_t*
+ndn_crypto_stream_create(void);
+
+/**
+ * Drop the pending callbacks of the stream.
+ * It is freed once its jobs in progress finish. It may be destroyed from one
+ * of its own callbacks; it is then freed after that callback returns.
+ */
+void
+ndn_crypto_stream_destroy(ndn_crypto_stream_t* self);
+
+/**
+ * ndn_data_template_make_segment on a worker. The content is copied.
+ * @param stream Orders the callback after earlier jobs of the stream.
+ *   NULL delivers it as soon as it is done.
+ * @remark The template and its key must not change until the callback.
+ * @return NDN_SUCCESS, or NDN_FWD_MSGQUEUE_FULL if too many jobs are pending.
+ */
+int
+ndn_crypto_pool_make_segment(ndn_crypto_stream_t* stream, const ndn_data_template_t* tpl,
+                             uint64_t segno, const uint8_t* content, uint32_t content_size,
+                             ndn_crypto_on_data_func on_data, void* userdata);
+
+/**
+ * ndn_data_template_make_named on a worker. The name and content are copied.
+ */
+int
+ndn_crypto_pool_make_named(ndn_crypto_stream_t* stream, const ndn_data_template_t* tpl,
+                           const uint8_t* name, uint32_t name_size,
+                           const uint8_t* content, uint32_t content_size,
+                           ndn_crypto_on_data_func on_data, void* userdata);
+
+/**
+ * Verify the ECDSA signature of a Data or signed Interest on a worker.
+ * The packet and key are copied. Results already in the verify cache are
+ * delivered without a worker, and new results are added to it.
+ */
+int
+ndn_crypto_pool_ecdsa_verify(ndn_crypto_stream_t* stream, const uint8_t* packet, uint32_t size,
+                             const ndn_ecc_pub_t* pub_key,
+                             ndn_crypto_on_verify_func on_verify, void* userdata);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,606 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "key-store.h"
+#include "verify-cache.h"
+#include "../forwarder/name-kernels.h"
+#include "../forwarder/pkt-peek.h"
+#include "../forwarder/pkt-view.h"
+#include "ndn-lite/ndn-enums.h"
+#include "ndn-lite/ndn-error-code.h"
+
+#define KEY_STORE_MIN_SLOTS 16
+// The component before the key id
+#define KEY_STORE_KEY_COMPONENT "KEY"
+#define KEY_STORE_KEY_COMPONENT_SIZE 3
+// ISO 8601 basic format of NotBefore and NotAfter, e.g. 20190101T000000
+#define KEY_STORE_TIME_SIZE 15
+
+static ndn_key_store_t key_store_instance;
+static bool key_store_instance_ready = false;
+
+static int
+key_store_key_name(const uint8_t* name, uint32_t name_size, const uint8_t** comps, uint32_t* comps_size);
+
+static ndn_key_store_entry_t*
+key_store_lookup(ndn_key_store_t* self, const uint8_t* comps, uint32_t comps_size, uint64_t hash);
+
+static ndn_key_store_entry_t*
+key_store_find(ndn_key_store_t* self, const uint8_t* name, uint32_t name_size);
+
+static ndn_key_store_entry_t*
+key_store_lookup_hash(ndn_key_store_t* self, uint64_t hash);
+
+static bool
+key_store_chains_to(ndn_key_store_t* self, uint64_t issuer, uint64_t hash);
+
+static void
+key_store_erase(ndn_key_store_t* self, ndn_key_store_entry_t* entry);
+
+static uint32_t
+key_store_erase_issued(ndn_key_store_t* self, uint64_t issuer);
+
+static uint32_t
+key_store_identity_size(const uint8_t* comps, uint32_t comps_size);
+
+static bool
+key_store_same_key(const ndn_key_store_entry_t* entry, const uint8_t* value, uint32_t size);
+
+static int
+key_store_insert(ndn_key_store_t* self, const uint8_t* comps, uint32_t comps_size,
+                 const ndn_ecc_pub_t* pub_key, ndn_time_ms_t not_before, ndn_time_ms_t not_after,
+                 uint64_t issuer);
+
+static int
+key_store_validity(const uint8_t* signature_info, uint32_t size,
+                   ndn_time_ms_t* not_before, ndn_time_ms_t* not_after);
+
+static bool
+key_store_parse_time(const uint8_t* val, uint32_t length, ndn_time_ms_t* time);
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+int
+ndn_key_store_init(ndn_key_store_t* self, uint32_t capacity){
+  uint32_t slots = KEY_STORE_MIN_SLOTS;
+
+  // At most 3/4 full, to keep probe sequences short
+  while(slots / 4 * 3 < capacity){
+    slots <<= 1;
+  }
+  memset(self, 0, sizeof(ndn_key_store_t));
+  self->entries = (ndn_key_store_entry_t*)calloc(slots, sizeof(ndn_key_store_entry_t));
+  if(self->entries == NULL){
+    return NDN_FWD_NO_MEM;
+  }
+  self->mask = slots - 1;
+  self->capacity = capacity;
+  return NDN_SUCCESS;
+}
+
+void
+ndn_key_store_destroy(ndn_key_store_t* self){
+  free(self->entries);
+  self->entries = NULL;
+  self->count = 0;
+}
+
+ndn_key_store_t*
+ndn_key_store_get_instance(void){
+  if(!key_store_instance_ready){
+    if(ndn_key_store_init(&key_store_instance, NDN_KEY_STORE_DEFAULT_CAPACITY) != NDN_SUCCESS){
+      return NULL;
+    }
+    key_store_instance_ready = true;
+  }
+  return &key_store_instance;
+}
+
+static int
+key_store_key_name(const uint8_t* name, uint32_t name_size, const uint8_t** comps, uint32_t* comps_size){
+  ndn_name_iter_t iter;
+  ndn_component_view_t comp;
+  bool after_key = false;
+  int ret;
+
+  ret = ndn_name_iter_init(&iter, name, name_size);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  *comps = iter.pos;
+  *comps_size = (uint32_t)(iter.end - iter.pos);
+  // A certificate name is the key name followed by the issuer and version
+  while(ndn_name_iter_next(&iter, &comp)){
+    if(after_key){
+      *comps_size = (uint32_t)(comp.value + comp.size - *comps);
+    }
+    after_key = (comp.type == TLV_GenericNameComponent && comp.size == KEY_STORE_KEY_COMPONENT_SIZE &&
+                 memcmp(comp.value, KEY_STORE_KEY_COMPONENT, KEY_STORE_KEY_COMPONENT_SIZE) == 0);
+  }
+  if(*comps_size > NDN_KEY_STORE_KEY_NAME_SIZE){
+    return NDN_OVERSIZE;
+  }
+  return NDN_SUCCESS;
+}
+
+static ndn_key_store_entry_t*
+key_store_lookup(ndn_key_store_t* self, const uint8_t* comps, uint32_t comps_size, uint64_t hash){
+  ndn_key_store_entry_t* entry;
+  uint32_t i;
+
+  for(i = hash & self->mask; self->entries[i].hash != 0; i = (i + 1) & self->mask){
+    entry = &self->entries[i];
+    if(entry->hash == hash && entry->name_size == comps_size &&
+       memcmp(entry->name, comps, comps_size) == 0){
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+// Issuers are kept by hash only, so a collision may find another key
+static ndn_key_store_entry_t*
+key_store_lookup_hash(ndn_key_store_t* self, uint64_t hash){
+  uint32_t i;
+
+  for(i = hash & self->mask; self->entries[i].hash != 0; i = (i + 1) & self->mask){
+    if(self->entries[i].hash == hash){
+      return &self->entries[i];
+    }
+  }
+  return NULL;
+}
+
+// Whether @p hash is @p issuer or one of the keys that certified it
+static bool
+key_store_chains_to(ndn_key_store_t* self, uint64_t issuer, uint64_t hash){
+  const ndn_key_store_entry_t* entry;
+  uint32_t depth;
+
+  // Bounded in case of a cycle
+  for(depth = 0; issuer != 0 && depth < self->count; depth ++){
+    if(issuer == hash){
+      return true;
+    }
+    entry = key_store_lookup_hash(self, issuer);
+    if(entry == NULL){
+      return false;
+    }
+    issuer = entry->issuer;
+  }
+  return false;
+}
+
+static void
+key_store_erase(ndn_key_store_t* self, ndn_key_store_entry_t* entry){
+  uint32_t i = (uint32_t)(entry - self->entries), j = i, home;
+
+  // Shift back the entries that probed past the hole
+  for(j = (j + 1) & self->mask; self->entries[j].hash != 0; j = (j + 1) & self->mask){
+    home = self->entries[j].hash & self->mask;
+    if((i < j) ? (home <= i || home > j) : (home <= i && home > j)){
+      self->entries[i] = self->entries[j];
+      i = j;
+    }
+  }
+  self->entries[i].hash = 0;
+  self->count --;
+}
+
+static uint32_t
+key_store_erase_issued(ndn_key_store_t* self, uint64_t issuer){
+  uint32_t i = 0, removed = 0;
+  uint64_t hash;
+
+  while(i <= self->mask){
+    if(self->entries[i].hash != 0 && !self->entries[i].pinned && self->entries[i].issuer == issuer){
+      hash = self->entries[i].hash;
+      key_store_erase(self, &self->entries[i]);
+      removed += 1 + key_store_erase_issued(self, hash);
+      // Erasing may shift entries before slot i, so scan again
+      i = 0;
+    }else{
+      i ++;
+    }
+  }
+  return removed;
+}
+
+static uint32_t
+key_store_identity_size(const uint8_t* comps, uint32_t comps_size){
+  const uint8_t *ptr, *val, *end = comps + comps_size;
+  uint32_t type, length, ret = comps_size;
+
+  // A name without a KEY component is an identity of its own
+  for(ptr = comps; ptr < end; ptr = val + length){
+    val = ndn_pkt_read_tl(ptr, end, &type, &length);
+    if(val == NULL){
+      break;
+    }
+    if(type == TLV_GenericNameComponent && length == KEY_STORE_KEY_COMPONENT_SIZE &&
+       memcmp(val, KEY_STORE_KEY_COMPONENT, KEY_STORE_KEY_COMPONENT_SIZE) == 0){
+      ret = (uint32_t)(ptr - comps);
+    }
+  }
+  return ret;
+}
+
+static bool
+key_store_same_key(const ndn_key_store_entry_t* entry, const uint8_t* value, uint32_t size){
+  return ndn_ecc_get_pub_key_size(&entry->pub_key) == size &&
+         memcmp(ndn_ecc_get_pub_key_value(&entry->pub_key), value, size) == 0;
+}
+
+static int
+key_store_insert(ndn_key_store_t* self, const uint8_t* comps, uint32_t comps_size,
+                 const ndn_ecc_pub_t* pub_key, ndn_time_ms_t not_before, ndn_time_ms_t not_after,
+                 uint64_t issuer){
+  uint64_t hash = ndn_name_kernels_hash(comps, comps_size) | 1;
+  ndn_key_store_entry_t *entry, *victim;
+  uint64_t victim_hash;
+  uint32_t i;
+
+  entry = key_store_lookup(self, comps, comps_size, hash);
+  if(entry != NULL && !key_store_same_key(entry, ndn_ecc_get_pub_key_value(pub_key),
+                                          ndn_ecc_get_pub_key_size(pub_key))){
+    // What the old key certified is not certified by the new one
+    self->evictions += key_store_erase_issued(self, hash);
+    entry = key_store_lookup(self, comps, comps_size, hash);
+  }
+  if(entry == NULL && self->count >= self->capacity){
+    ndn_key_store_evict_expired(self);
+  }
+  if(entry == NULL && self->count >= self->capacity){
+    // Evict the cached key closest to expiry. The issuer expires no earlier
+    // than the new key, so it would often be chosen, and evicting it or a key
+    // above it would remove it.
+    victim = NULL;
+    for(i = 0; i <= self->mask; i ++){
+      if(self->entries[i].hash != 0 && !self->entries[i].pinned &&
+         (victim == NULL || self->entries[i].not_after < victim->not_after) &&
+         !key_store_chains_to(self, issuer, self->entries[i].hash)){
+        victim = &self->entries[i];
+      }
+    }
+    if(victim == NULL){
+      return NDN_OVERSIZE;
+    }
+    victim_hash = victim->hash;
+    key_store_erase(self, victim);
+    self->evictions += 1 + key_store_erase_issued(self, victim_hash);
+  }
+  // Erasing moves entries, so the issuer is looked up again rather than kept
+  if(issuer != 0 && key_store_lookup_hash(self, issuer) == NULL){
+    return NDN_KEY_STORE_NO_KEY;
+  }
+  if(entry == NULL){
+    for(i = hash & self->mask; self->entries[i].hash != 0; i = (i + 1) & self->mask);
+    entry = &self->entries[i];
+    entry->hash = hash;
+    memcpy(entry->name, comps, comps_size);
+    entry->name_size = comps_size;
+    self->count ++;
+  }
+  entry->pub_key = *pub_key;
+  entry->not_before = not_before;
+  entry->not_after = not_after;
+  entry->issuer = issuer;
+  entry->pinned = (issuer == 0);
+  return NDN_SUCCESS;
+}
+
+int
+ndn_key_store_add(ndn_key_store_t* self, const uint8_t* name, uint32_t name_size,
+                  const ndn_ecc_pub_t* pub_key){
+  const uint8_t* comps;
+  uint32_t comps_size;
+  int ret;
+
+  ret = key_store_key_name(name, name_size, &comps, &comps_size);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  return key_store_insert(self, comps, comps_size, pub_key, 0, NDN_KEY_STORE_NEVER, 0);
+}
+
+static bool
+key_store_parse_time(const uint8_t* val, uint32_t length, ndn_time_ms_t* time){
+  static const uint8_t widths[] = {4, 2, 2, 0, 2, 2, 2};
+  uint32_t fields[sizeof(widths)], i, j, pos = 0;
+  int64_t year, month, era, yoe, doy, doe, days;
+
+  if(length != KEY_STORE_TIME_SIZE || val[8] != 'T'){
+    return false;
+  }
+  for(i = 0; i < sizeof(widths); i ++){
+    fields[i] = 0;
+    for(j = 0; j < widths[i]; j ++, pos ++){
+      if(val[pos] < '0' || val[pos] > '9'){
+        return false;
+      }
+      fields[i] = fields[i] * 10 + (val[pos] - '0');
+    }
+    if(widths[i] == 0){
+      pos ++;
+    }
+  }
+  if(fields[1] < 1 || fields[1] > 12 || fields[2] < 1 || fields[2] > 31 ||
+     fields[4] > 23 || fields[5] > 59 || fields[6] > 60){
+    return false;
+  }
+
+  // Days since 1970-01-01 of a proleptic Gregorian date
+  month = fields[1];
+  year = (int64_t)fields[0] - (month <= 2);
+  era = year / 400;
+  yoe = year - era * 400;
+  doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + fields[2] - 1;
+  doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  days = era * 146097 + doe - 719468;
+  if(days < 0){
+    return false;
+  }
+  *time = ((ndn_time_ms_t)days * 86400 + fields[4] * 3600 + fields[5] * 60 + fields[6]) * 1000;
+  return true;
+}
+
+static int
+key_store_validity(const uint8_t* signature_info, uint32_t size,
+                   ndn_time_ms_t* not_before, ndn_time_ms_t* not_after){
+  const uint8_t *ptr, *val, *end, *period = NULL;
+  uint32_t type, length, period_size = 0;
+  bool has_not_before = false, has_not_after = false;
+
+  end = signature_info + size;
+  for(ptr = signature_info; ptr < end; ptr = val + length){
+    val = ndn_pkt_read_tl(ptr, end, &type, &length);
+    if(val == NULL){
+      return NDN_WRONG_TLV_LENGTH;
+    }
+    if(type == TLV_ValidityPeriod){
+      period = val;
+      period_size = length;
+    }
+  }
+  if(period == NULL){
+    return NDN_WRONG_TLV_TYPE;
+  }
+
+  end = period + period_size;
+  for(ptr = period; ptr < end; ptr = val + length){
+    val = ndn_pkt_read_tl(ptr, end, &type, &length);
+    if(val == NULL){
+      return NDN_WRONG_TLV_LENGTH;
+    }
+    if(type == TLV_NotBefore){
+      has_not_before = key_store_parse_time(val, length, not_before);
+    }else if(type == TLV_NotAfter){
+      has_not_after = key_store_parse_time(val, length, not_after);
+    }
+  }
+  return (has_not_before && has_not_after) ? NDN_SUCCESS : NDN_WRONG_TLV_TYPE;
+}
+
+int
+ndn_key_store_add_cert(ndn_key_store_t* self, const uint8_t* cert, uint32_t size){
+  ndn_time_ms_t now = ndn_time_now_ms(), not_before, not_after;
+  const ndn_key_store_entry_t* issuer;
+  const uint8_t *issuer_name, *comps;
+  uint32_t issuer_name_size, comps_size, identity_size;
+  ndn_key_store_entry_t* entry;
+  ndn_data_view_t data;
+  ndn_ecc_pub_t pub_key;
+  uint64_t hash;
+  int ret;
+
+  ret = ndn_data_view_parse(&data, cert, size);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  if(data.signature_info == NULL || data.content == NULL){
+    return NDN_WRONG_TLV_TYPE;
+  }
+  ret = key_store_key_name(data.name, data.name_size, &comps, &comps_size);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  ret = key_store_validity(data.signature_info, data.signature_info_size, &not_before, &not_after);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  if(now < not_before || now >= not_after){
+    return NDN_SEC_FAIL_VERIFY_SIG;
+  }
+
+  ret = ndn_key_store_get_key_locator(cert, size, &issuer_name, &issuer_name_size);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  issuer = key_store_find(self, issuer_name, issuer_name_size);
+  if(issuer == NULL){
+    return NDN_KEY_STORE_NO_KEY;
+  }
+  // An issuer only certifies keys under its own identity
+  identity_size = key_store_identity_size(issuer->name, issuer->name_size);
+  if(comps_size < identity_size || memcmp(comps, issuer->name, identity_size) != 0){
+    return NDN_SEC_FAIL_VERIFY_SIG;
+  }
+  ret = ndn_verify_cache_ecdsa_verify_packet(cert, size, &issuer->pub_key);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  // A key is trusted no longer than the key that certified it
+  if(not_before < issuer->not_before){
+    not_before = issuer->not_before;
+  }
+  if(not_after > issuer->not_after){
+    not_after = issuer->not_after;
+  }
+
+  hash = ndn_name_kernels_hash(comps, comps_size) | 1;
+  entry = key_store_lookup(self, comps, comps_size, hash);
+  if(entry != NULL && entry->pinned){
+    // e.g. the self-signed certificate of the trust anchor
+    return NDN_SUCCESS;
+  }
+  if(entry != NULL && entry->not_after > now &&
+     !key_store_same_key(entry, data.content, data.content_size)){
+    return NDN_KEY_STORE_CONFLICT;
+  }
+  // The id is informative: the verify cache tells keys apart by their bytes
+  ret = ndn_ecc_pub_init(&pub_key, data.content, data.content_size, NDN_ECDSA_CURVE_SECP256R1,
+                         (uint32_t)(hash >> 32));
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  return key_store_insert(self, comps, comps_size, &pub_key, not_before, not_after, issuer->hash);
+}
+
+static ndn_key_store_entry_t*
+key_store_find(ndn_key_store_t* self, const uint8_t* name, uint32_t name_size){
+  ndn_key_store_entry_t* entry;
+  const uint8_t* comps;
+  uint32_t comps_size;
+
+  if(key_store_key_name(name, name_size, &comps, &comps_size) != NDN_SUCCESS){
+    return NULL;
+  }
+  entry = key_store_lookup(self, comps, comps_size, ndn_name_kernels_hash(comps, comps_size) | 1);
+  if(entry != NULL && !entry->pinned && entry->not_after <= ndn_time_now_ms()){
+    key_store_erase(self, entry);
+    self->evictions ++;
+    entry = NULL;
+  }
+  if(entry == NULL){
+    self->misses ++;
+    return NULL;
+  }
+  self->hits ++;
+  return entry;
+}
+
+const ndn_ecc_pub_t*
+ndn_key_store_find(ndn_key_store_t* self, const uint8_t* name, uint32_t name_size){
+  ndn_key_store_entry_t* entry = key_store_find(self, name, name_size);
+
+  return (entry != NULL) ? &entry->pub_key : NULL;
+}
+
+int
+ndn_key_store_remove(ndn_key_store_t* self, const uint8_t* name, uint32_t name_size){
+  ndn_key_store_entry_t* entry;
+  const uint8_t* comps;
+  uint32_t comps_size;
+  uint64_t hash;
+  int ret;
+
+  ret = key_store_key_name(name, name_size, &comps, &comps_size);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  hash = ndn_name_kernels_hash(comps, comps_size) | 1;
+  entry = key_store_lookup(self, comps, comps_size, hash);
+  if(entry != NULL){
+    key_store_erase(self, entry);
+    self->evictions += key_store_erase_issued(self, hash);
+  }
+  return NDN_SUCCESS;
+}
+
+uint32_t
+ndn_key_store_evict_expired(ndn_key_store_t* self){
+  ndn_time_ms_t now = ndn_time_now_ms();
+  uint32_t i = 0, removed = 0;
+
+  while(i <= self->mask){
+    // Erasing shifts a later entry into slot i, so check it again
+    if(self->entries[i].hash != 0 && !self->entries[i].pinned && self->entries[i].not_after <= now){
+      key_store_erase(self, &self->entries[i]);
+      removed ++;
+    }else{
+      i ++;
+    }
+  }
+  self->evictions += removed;
+  return removed;
+}
+
+int
+ndn_key_store_get_key_locator(const uint8_t* packet, uint32_t size,
+                              const uint8_t** name, uint32_t* name_size){
+  const uint8_t *ptr, *val, *end, *info = NULL;
+  uint32_t type, length, info_size = 0;
+  ndn_data_view_t data;
+  int ret;
+
+  ptr = ndn_pkt_read_tl(packet, packet + size, &type, &length);
+  if(ptr == NULL){
+    return NDN_WRONG_TLV_LENGTH;
+  }
+  if(type == TLV_Data){
+    ret = ndn_data_view_parse(&data, packet, size);
+    if(ret != NDN_SUCCESS){
+      return ret;
+    }
+    info = data.signature_info;
+    info_size = data.signature_info_size;
+  }else if(type == TLV_Interest){
+    end = ptr + length;
+    for(; ptr < end; ptr = val + length){
+      val = ndn_pkt_read_tl(ptr, end, &type, &length);
+      if(val == NULL){
+        return NDN_WRONG_TLV_LENGTH;
+      }
+      if(type == NDN_VERIFY_CACHE_INTEREST_SIGNATURE_INFO){
+        info = val;
+        info_size = length;
+      }
+    }
+  }
+  if(info == NULL){
+    return NDN_WRONG_TLV_TYPE;
+  }
+
+  end = info + info_size;
+  for(ptr = info; ptr < end; ptr = val + length){
+    val = ndn_pkt_read_tl(ptr, end, &type, &length);
+    if(val == NULL){
+      return NDN_WRONG_TLV_LENGTH;
+    }
+    if(type == TLV_KeyLocator){
+      // A KeyDigest cannot be looked up
+      if(ndn_pkt_read_tl(val, val + length, &type, name_size) == NULL || type != TLV_Name){
+        return NDN_WRONG_TLV_TYPE;
+      }
+      *name = val;
+      *name_size = length;
+      return NDN_SUCCESS;
+    }
+  }
+  return NDN_WRONG_TLV_TYPE;
+}
+
+int
+ndn_key_store_verify(ndn_key_store_t* self, const uint8_t* packet, uint32_t size){
+  const ndn_ecc_pub_t* pub_key;
+  const uint8_t* name;
+  uint32_t name_size;
+  int ret;
+
+  ret = ndn_key_store_get_key_locator(packet, size, &name, &name_size);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  pub_key = ndn_key_store_find(self, name, name_size);
+  if(pub_key == NULL){
+    return NDN_KEY_STORE_NO_KEY;
+  }
+  return ndn_verify_cache_ecdsa_verify(ndn_verify_cache_get_instance(), packet, size, pub_key);
+}
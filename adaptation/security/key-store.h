@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#ifndef NDN_KEY_STORE_H_
+#define NDN_KEY_STORE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ndn-lite/util/uniform-time.h"
+#include "ndn-lite/security/ndn-lite-ecc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NDN_KEY_STORE_DEFAULT_CAPACITY 1024
+// Encoded components of a key name, without the Name TLV header
+#define NDN_KEY_STORE_KEY_NAME_SIZE 128
+// not_after of keys added without a certificate
+#define NDN_KEY_STORE_NEVER UINT64_MAX
+// Returned when the signing key is not in the store
+#define NDN_KEY_STORE_NO_KEY 1
+// Returned when a certificate names a cached key but holds another key
+#define NDN_KEY_STORE_CONFLICT 2
+
+typedef struct ndn_key_store_entry {
+  /**
+   * Hash of the key name; 0 marks an empty slot.
+   */
+  uint64_t hash;
+  ndn_time_ms_t not_before;
+  ndn_time_ms_t not_after;
+  ndn_ecc_pub_t pub_key;
+  uint8_t name[NDN_KEY_STORE_KEY_NAME_SIZE];
+  uint32_t name_size;
+  /**
+   * Hash of the key that certified it; 0 if pinned.
+   */
+  uint64_t issuer;
+  /**
+   * Added with ndn_key_store_add, e.g. a trust anchor; never evicted.
+   */
+  bool pinned;
+} ndn_key_store_entry_t;
+
+/**
+ * Public keys indexed by key name.
+ *
+ * A key is found by the name of the key, /<identity>/KEY/<key-id>, or of any
+ * of its certificates, so a KeyLocator of either kind is looked up directly.
+ * Open addressing with linear probing makes lookups O(1) whatever the
+ * number of keys.
+ *
+ * Besides pinned keys such as the trust anchor, the store caches the keys of
+ * verified certificates with their validity period. A certificate is only
+ * accepted if its issuer is in the store and its key is under the identity
+ * of the issuer, e.g. /home/KEY/1 certifies /home/room/KEY/2 but not
+ * /office/KEY/3; finer policies are left to a trust schema. A cached key is
+ * kept no longer than its issuer, and removing, evicting or replacing a key
+ * removes the keys it certified, so every cached key chains to a pinned one.
+ * Expired keys are dropped when looked up, and when the store is full.
+ *
+ * The store is a library: nothing in the forwarder calls it. Applications
+ * verify with ndn_key_store_verify where they would call the sig-verifier
+ * of ndn-lite.
+ */
+typedef struct ndn_key_store {
+  ndn_key_store_entry_t* entries;
+  uint32_t mask;
+  uint32_t count;
+  uint32_t capacity;
+
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+} ndn_key_store_t;
+
+/**
+ * @param capacity Maximum number of keys.
+ */
+int
+ndn_key_store_init(ndn_key_store_t* self, uint32_t capacity);
+
+void
+ndn_key_store_destroy(ndn_key_store_t* self);
+
+/**
+ * Process-wide store with default capacity. Allocated on first use.
+ */
+ndn_key_store_t*
+ndn_key_store_get_instance(void);
+
+/**
+ * Add or replace a key that never expires, such as a trust anchor.
+ * Replacing it with another key removes the keys it certified.
+ * @param name Whole Name TLV of the key or of its certificate.
+ */
+int
+ndn_key_store_add(ndn_key_store_t* self, const uint8_t* name, uint32_t name_size,
+                  const ndn_ecc_pub_t* pub_key);
+
+/**
+ * Verify a certificate with the key of its issuer, found in the store by its
+ * KeyLocator, and cache its key until it or its issuer expires.
+ * @return NDN_SUCCESS, NDN_KEY_STORE_NO_KEY if the issuer is unknown,
+ *   NDN_SEC_FAIL_VERIFY_SIG if the signature is wrong, the certificate is
+ *   not valid now or its name is outside the identity of the issuer,
+ *   NDN_KEY_STORE_CONFLICT if an unexpired cached key of that name differs,
+ *   NDN_OVERSIZE if the store is full of pinned keys and the keys the
+ *   issuer chains to, which are not evicted for it, or a decoding error.
+ */
+int
+ndn_key_store_add_cert(ndn_key_store_t* self, const uint8_t* cert, uint32_t size);
+
+/**
+ * @param name Whole Name TLV of the key or of one of its certificates.
+ * @return The key, or NULL if it is unknown or expired.
+ */
+const ndn_ecc_pub_t*
+ndn_key_store_find(ndn_key_store_t* self, const uint8_t* name, uint32_t name_size);
+
+/**
+ * Remove a key, pinned or not, and the keys it certified.
+ * Results cached by the verify cache stay until it is cleared.
+ */
+int
+ndn_key_store_remove(ndn_key_store_t* self, const uint8_t* name, uint32_t name_size);
+
+/**
+ * Remove every expired key.
+ * @return Number of keys removed.
+ */
+uint32_t
+ndn_key_store_evict_expired(ndn_key_store_t* self);
+
+/**
+ * Verify the ECDSA signature of a Data or signed Interest with the key named
+ * by its KeyLocator, through the verify cache.
+ * @return NDN_SUCCESS, NDN_KEY_STORE_NO_KEY if the key must be fetched first,
+ *   NDN_SEC_FAIL_VERIFY_SIG, or a decoding error.
+ */
+int
+ndn_key_store_verify(ndn_key_store_t* self, const uint8_t* packet, uint32_t size);
+
+/**
+ * Find the Name in the KeyLocator of a Data or signed Interest.
+ * @param[out] name Whole Name TLV, pointing into the packet.
+ */
+int
+ndn_key_store_get_key_locator(const uint8_t* packet, uint32_t size,
+                              const uint8_t** name, uint32_t* name_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
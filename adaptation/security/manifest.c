@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "manifest.h"
+#include "sha256-kernels.h"
+#include "verify-cache.h"
+#include "../forwarder/pkt-peek.h"
+#include "../forwarder/pkt-view.h"
+#include "ndn-lite/ndn-enums.h"
+#include "ndn-lite/ndn-error-code.h"
+
+// TLV type of ImplicitSha256DigestComponent
+#define MANIFEST_DIGEST_TYPE 0x01
+// Everything a segment has besides its content
+#define MANIFEST_SEGMENT_OVERHEAD (NDN_DATA_TEMPLATE_NAME_SIZE + NDN_DATA_TEMPLATE_META_INFO_SIZE + \
+                                   NDN_DATA_TEMPLATE_SIGNATURE_INFO_SIZE + \
+                                   NDN_DATA_TEMPLATE_MAX_SIGNATURE_SIZE + 64)
+
+static int
+manifest_make_one(const ndn_data_template_t* segment_template,
+                  const ndn_data_template_t* manifest_template,
+                  const uint8_t* content, uint64_t content_size, uint32_t segment_size,
+                  uint64_t index, uint8_t* scratch, uint32_t scratch_size, uint8_t* entries,
+                  uint8_t* packet, uint32_t* packet_size);
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+int
+ndn_manifest_template_init(ndn_data_template_t* manifest_template, const ndn_name_t* prefix,
+                           const ndn_ecc_prv_t* key, const ndn_name_t* key_name){
+  ndn_name_t name = *prefix;
+  int ret;
+
+  ret = ndn_name_append_string_component(&name, NDN_MANIFEST_COMPONENT, NDN_MANIFEST_COMPONENT_SIZE);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  ret = ndn_data_template_init(manifest_template, &name, NDN_CONTENT_TYPE_BLOB, 0);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  return ndn_data_template_set_ecdsa_signer(manifest_template, key, key_name);
+}
+
+int
+ndn_manifest_encode(const uint8_t* const* packets, const uint32_t* sizes, uint32_t count,
+                    uint8_t* buf, uint32_t size, uint32_t* used){
+  uint8_t* digests[NDN_DATA_TEMPLATE_BATCH_SIZE];
+  uint32_t i, j, n;
+
+  if(count > size / NDN_MANIFEST_ENTRY_SIZE){
+    return NDN_OVERSIZE;
+  }
+  // Digests go straight behind their TL
+  for(i = 0; i < count; i += n){
+    n = (count - i < NDN_DATA_TEMPLATE_BATCH_SIZE) ? count - i : NDN_DATA_TEMPLATE_BATCH_SIZE;
+    for(j = 0; j < n; j ++){
+      buf[(i + j) * NDN_MANIFEST_ENTRY_SIZE] = MANIFEST_DIGEST_TYPE;
+      buf[(i + j) * NDN_MANIFEST_ENTRY_SIZE + 1] = NDN_SHA256_KERNELS_DIGEST_SIZE;
+      digests[j] = buf + (i + j) * NDN_MANIFEST_ENTRY_SIZE + 2;
+    }
+    ndn_sha256_kernels_digest_many(packets + i, sizes + i, digests, n);
+  }
+  *used = count * NDN_MANIFEST_ENTRY_SIZE;
+  return NDN_SUCCESS;
+}
+
+static int
+manifest_make_one(const ndn_data_template_t* segment_template,
+                  const ndn_data_template_t* manifest_template,
+                  const uint8_t* content, uint64_t content_size, uint32_t segment_size,
+                  uint64_t index, uint8_t* scratch, uint32_t scratch_size, uint8_t* entries,
+                  uint8_t* packet, uint32_t* packet_size){
+  const uint8_t* contents[NDN_DATA_TEMPLATE_BATCH_SIZE];
+  uint32_t content_sizes[NDN_DATA_TEMPLATE_BATCH_SIZE];
+  uint8_t* segments[NDN_DATA_TEMPLATE_BATCH_SIZE];
+  uint32_t used[NDN_DATA_TEMPLATE_BATCH_SIZE];
+  uint64_t segno, first, last, offset;
+  uint32_t j, n, entries_size = 0, written;
+  int ret;
+
+  first = index * NDN_MANIFEST_ENTRIES;
+  last = (content_size > 0) ? (content_size + segment_size - 1) / segment_size : 1;
+  if(last > first + NDN_MANIFEST_ENTRIES){
+    last = first + NDN_MANIFEST_ENTRIES;
+  }
+  for(j = 0; j < NDN_DATA_TEMPLATE_BATCH_SIZE; j ++){
+    segments[j] = scratch + j * scratch_size;
+  }
+  // The segments are made in batches only to be digested
+  for(segno = first; segno < last; segno += n){
+    n = (last - segno < NDN_DATA_TEMPLATE_BATCH_SIZE) ? (uint32_t)(last - segno) : NDN_DATA_TEMPLATE_BATCH_SIZE;
+    for(j = 0; j < n; j ++){
+      offset = (segno + j) * segment_size;
+      contents[j] = content + offset;
+      content_sizes[j] = (content_size - offset < segment_size) ? (uint32_t)(content_size - offset) : segment_size;
+    }
+    ret = ndn_data_template_make_segments(segment_template, segments, scratch_size, segno,
+                                          contents, content_sizes, n, used);
+    if(ret != NDN_SUCCESS){
+      return ret;
+    }
+    ret = ndn_manifest_encode((const uint8_t* const*)segments, used, n, entries + entries_size,
+                              NDN_MANIFEST_CONTENT_SIZE - entries_size, &written);
+    if(ret != NDN_SUCCESS){
+      return ret;
+    }
+    entries_size += written;
+  }
+  return ndn_data_template_make_segment(manifest_template, packet, NDN_MANIFEST_PACKET_SIZE, index,
+                                        entries, entries_size, packet_size);
+}
+
+int
+ndn_manifest_set_make(ndn_manifest_set_t* self, const ndn_data_template_t* segment_template,
+                      const ndn_data_template_t* manifest_template,
+                      const uint8_t* content, uint64_t content_size, uint32_t segment_size){
+  uint32_t scratch_size = segment_size + MANIFEST_SEGMENT_OVERHEAD;
+  uint64_t segments, i;
+  uint8_t *scratch, *entries;
+  int ret = NDN_SUCCESS;
+
+  memset(self, 0, sizeof(ndn_manifest_set_t));
+  if(segment_size == 0){
+    return NDN_OVERSIZE;
+  }
+  segments = (content_size > 0) ? (content_size + segment_size - 1) / segment_size : 1;
+  self->count = (uint32_t)ndn_manifest_index(segments - 1) + 1;
+  self->packets = (uint8_t*)malloc((size_t)self->count * NDN_MANIFEST_PACKET_SIZE);
+  self->sizes = (uint32_t*)malloc(self->count * sizeof(uint32_t));
+  scratch = (uint8_t*)malloc((size_t)NDN_DATA_TEMPLATE_BATCH_SIZE * scratch_size);
+  entries = (uint8_t*)malloc(NDN_MANIFEST_CONTENT_SIZE);
+  if(self->packets == NULL || self->sizes == NULL || scratch == NULL || entries == NULL){
+    ret = NDN_FWD_NO_MEM;
+  }
+  for(i = 0; i < self->count && ret == NDN_SUCCESS; i ++){
+    ret = manifest_make_one(segment_template, manifest_template, content, content_size, segment_size,
+                            i, scratch, scratch_size, entries,
+                            self->packets + i * NDN_MANIFEST_PACKET_SIZE, &self->sizes[i]);
+  }
+  free(scratch);
+  free(entries);
+  if(ret != NDN_SUCCESS){
+    ndn_manifest_set_destroy(self);
+  }
+  return ret;
+}
+
+void
+ndn_manifest_set_destroy(ndn_manifest_set_t* self){
+  free(self->packets);
+  free(self->sizes);
+  memset(self, 0, sizeof(ndn_manifest_set_t));
+}
+
+const uint8_t*
+ndn_manifest_set_get(const ndn_manifest_set_t* self, uint64_t index, uint32_t* size){
+  if(index >= self->count){
+    return NULL;
+  }
+  *size = self->sizes[index];
+  return self->packets + index * NDN_MANIFEST_PACKET_SIZE;
+}
+
+int
+ndn_manifest_view_parse(ndn_manifest_view_t* view, const uint8_t* content, uint32_t size){
+  uint32_t i;
+
+  if(size % NDN_MANIFEST_ENTRY_SIZE != 0 || size > NDN_MANIFEST_CONTENT_SIZE){
+    return NDN_WRONG_TLV_LENGTH;
+  }
+  for(i = 0; i < size; i += NDN_MANIFEST_ENTRY_SIZE){
+    if(content[i] != MANIFEST_DIGEST_TYPE){
+      return NDN_WRONG_TLV_TYPE;
+    }
+    if(content[i + 1] != NDN_SHA256_KERNELS_DIGEST_SIZE){
+      return NDN_WRONG_TLV_LENGTH;
+    }
+  }
+  view->entries = content;
+  view->count = size / NDN_MANIFEST_ENTRY_SIZE;
+  return NDN_SUCCESS;
+}
+
+int
+ndn_manifest_view_verify(ndn_manifest_view_t* view, const uint8_t* packet, uint32_t size,
+                         const ndn_ecc_pub_t* pub_key){
+  ndn_data_view_t data;
+  int ret;
+
+  ret = ndn_data_view_parse(&data, packet, size);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  ret = ndn_verify_cache_ecdsa_verify(ndn_verify_cache_get_instance(), packet, size, pub_key);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  return ndn_manifest_view_parse(view, data.content, data.content_size);
+}
+
+int
+ndn_manifest_view_check_segment(const ndn_manifest_view_t* view, uint64_t segno,
+                                const uint8_t* packet, uint32_t size){
+  uint8_t digest[NDN_SHA256_KERNELS_DIGEST_SIZE];
+  uint32_t entry = (uint32_t)(segno % NDN_MANIFEST_ENTRIES);
+
+  if(entry >= view->count){
+    return NDN_SEC_FAIL_VERIFY_SIG;
+  }
+  ndn_sha256_kernels_digest(packet, size, digest);
+  if(memcmp(digest, view->entries + entry * NDN_MANIFEST_ENTRY_SIZE + 2, sizeof(digest)) != 0){
+    return NDN_SEC_FAIL_VERIFY_SIG;
+  }
+  return NDN_SUCCESS;
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#ifndef NDN_MANIFEST_H_
+#define NDN_MANIFEST_H_
+
+#include <stdint.h>
+#include "ndn-lite/encode/name.h"
+#include "ndn-lite/security/ndn-lite-ecc.h"
+#include "../forwarder/data-template.h"
+#include "../forwarder/pktbuf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Manifests authenticate segmented content with one signature per
+ * NDN_MANIFEST_ENTRIES segments instead of one per segment.
+ *
+ * Segments are signed with DigestSha256. Manifest k is the Data
+ * prefix/manifest/<seg=k>, signed with ECDSA, whose content lists the
+ * implicit digests of segments k * NDN_MANIFEST_ENTRIES onwards as
+ * ImplicitSha256DigestComponent TLVs. A consumer verifies the manifest
+ * once, then checks each segment against its digest.
+ */
+#define NDN_MANIFEST_ENTRIES 100
+// ImplicitSha256DigestComponent TLV of a digest
+#define NDN_MANIFEST_ENTRY_SIZE 34
+#define NDN_MANIFEST_CONTENT_SIZE (NDN_MANIFEST_ENTRIES * NDN_MANIFEST_ENTRY_SIZE)
+// The manifest component between the prefix and the segment number
+#define NDN_MANIFEST_COMPONENT "manifest"
+#define NDN_MANIFEST_COMPONENT_SIZE 8
+// A manifest fits in a packet buffer
+#define NDN_MANIFEST_PACKET_SIZE NDN_PKTBUF_SIZE
+
+/**
+ * The signed manifests of an object, kept by its producer.
+ */
+typedef struct ndn_manifest_set {
+  uint8_t* packets;
+  uint32_t* sizes;
+  uint32_t count;
+} ndn_manifest_set_t;
+
+/**
+ * A verified manifest, pointing into the packet.
+ */
+typedef struct ndn_manifest_view {
+  const uint8_t* entries;
+  uint32_t count;
+} ndn_manifest_view_t;
+
+static inline uint64_t
+ndn_manifest_index(uint64_t segno){
+  return segno / NDN_MANIFEST_ENTRIES;
+}
+
+/**
+ * Start a template for the manifests of the object under @p prefix.
+ * The key must outlive the template.
+ */
+int
+ndn_manifest_template_init(ndn_data_template_t* manifest_template, const ndn_name_t* prefix,
+                           const ndn_ecc_prv_t* key, const ndn_name_t* key_name);
+
+/**
+ * Write the implicit digests of @p count Data packets as manifest entries.
+ */
+int
+ndn_manifest_encode(const uint8_t* const* packets, const uint32_t* sizes, uint32_t count,
+                    uint8_t* buf, uint32_t size, uint32_t* used);
+
+/**
+ * Make and sign every manifest of an object.
+ * The segments are made as ndn_data_template_make_segment would make them,
+ * which must be how they are served, and are not kept.
+ * @param segment_template A DigestSha256 template of the segments.
+ * @param segment_size Content size of every segment but the last.
+ *        Empty content is one empty segment, so it still has a manifest.
+ */
+int
+ndn_manifest_set_make(ndn_manifest_set_t* self, const ndn_data_template_t* segment_template,
+                      const ndn_data_template_t* manifest_template,
+                      const uint8_t* content, uint64_t content_size, uint32_t segment_size);
+
+void
+ndn_manifest_set_destroy(ndn_manifest_set_t* self);
+
+/**
+ * @return Manifest @p index, or NULL past the last one.
+ */
+const uint8_t*
+ndn_manifest_set_get(const ndn_manifest_set_t* self, uint64_t index, uint32_t* size);
+
+/**
+ * Verify the signature of a manifest Data and read its entries.
+ * The signature is checked through the verify cache, so call it from the
+ * forwarder thread.
+ * @return NDN_SUCCESS, NDN_SEC_FAIL_VERIFY_SIG, or a decoding error.
+ */
+int
+ndn_manifest_view_verify(ndn_manifest_view_t* view, const uint8_t* packet, uint32_t size,
+                         const ndn_ecc_pub_t* pub_key);
+
+/**
+ * Read the entries of a manifest without verifying it.
+ */
+int
+ndn_manifest_view_parse(ndn_manifest_view_t* view, const uint8_t* content, uint32_t size);
+
+/**
+ * Check segment @p segno against manifest ndn_manifest_index(segno).
+ * @return NDN_SUCCESS, or NDN_SEC_FAIL_VERIFY_SIG if the digest differs or
+ *   the manifest has no entry for it.
+ */
+int
+ndn_manifest_view_check_segment(const ndn_manifest_view_t* view, uint64_t segno,
+                                const uint8_t* packet, uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
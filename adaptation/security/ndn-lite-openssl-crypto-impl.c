@@ -0,0 +1,312 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+// SHA256_CTX and EC_KEY are deprecated by OpenSSL 3.0, but also work with 1.1
+#define OPENSSL_SUPPRESS_DEPRECATED
+
+#include <string.h>
+#include <openssl/sha.h>
+#include <openssl/hmac.h>
+#include <openssl/evp.h>
+#include <openssl/ec.h>
+#include <openssl/ecdsa.h>
+#include <openssl/obj_mac.h>
+#include "ndn-lite-openssl-crypto-impl.h"
+#include "ndn-lite/ndn-enums.h"
+#include "ndn-lite/ndn-error-code.h"
+#include "ndn-lite/security/ndn-lite-sha.h"
+#include "ndn-lite/security/ndn-lite-hmac.h"
+#include "ndn-lite/security/ndn-lite-aes.h"
+#include "ndn-lite/security/ndn-lite-ecc.h"
+
+#define OPENSSL_AES_BLOCK_SIZE 16
+// Uncompressed point: 0x04, X, Y
+#define OPENSSL_P256_POINT_SIZE 65
+
+_Static_assert(sizeof(SHA256_CTX) <= sizeof(abstract_sha256_state_t),
+               "SHA256_CTX must fit in the state of the default backend");
+
+// P-256 parameters, shared read-only by all threads
+static EC_GROUP* openssl_p256;
+// The default operations, for curves OpenSSL is not used for
+static ndn_ecdsa_sign_impl default_ecdsa_sign;
+static ndn_ecdsa_verify_impl default_ecdsa_verify;
+
+static int
+openssl_sha256(const uint8_t* data, uint32_t datalen, uint8_t* hash_result);
+
+static int
+openssl_sha256_init(abstract_sha256_state_t* state);
+
+static int
+openssl_sha256_update(abstract_sha256_state_t* state, const uint8_t* data, uint32_t datalen);
+
+static int
+openssl_sha256_finish(abstract_sha256_state_t* state, uint8_t* hash_result);
+
+static int
+openssl_hmac_sha256(const void* payload, uint32_t payload_length,
+                    const abstract_hmac_key_t* hmac_key, uint8_t* hmac_result);
+
+static const EVP_CIPHER*
+openssl_aes_cipher(const abstract_aes_key_t* aes_key);
+
+static int
+openssl_aes_cbc(const EVP_CIPHER* cipher, int encrypt, const uint8_t* input_value,
+                uint32_t input_size, uint8_t* output_value, const uint8_t* aes_iv,
+                const abstract_aes_key_t* aes_key);
+
+static int
+openssl_aes_cbc_encrypt(const uint8_t* input_value, uint32_t input_size,
+                        uint8_t* output_value, uint32_t output_size,
+                        const uint8_t* aes_iv, const abstract_aes_key_t* aes_key);
+
+static int
+openssl_aes_cbc_decrypt(const uint8_t* input_value, uint32_t input_size,
+                        uint8_t* output_value, uint32_t output_size,
+                        const uint8_t* aes_iv, const abstract_aes_key_t* aes_key);
+
+static int
+openssl_ecdsa_sign(const uint8_t* input_value, uint32_t input_size,
+                   uint8_t* output_value, uint32_t output_max_size,
+                   const abstract_ecc_prv_t* prv_key, uint8_t ecdsa_type,
+                   uint32_t* output_used_size);
+
+static int
+openssl_ecdsa_verify(const uint8_t* input_value, uint32_t input_size,
+                     const uint8_t* sig_value, uint32_t sig_size,
+                     const abstract_ecc_pub_t* pub_key, uint8_t ecdsa_type);
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+static int
+openssl_sha256(const uint8_t* data, uint32_t datalen, uint8_t* hash_result){
+  SHA256(data, datalen, hash_result);
+  return NDN_SUCCESS;
+}
+
+static int
+openssl_sha256_init(abstract_sha256_state_t* state){
+  return SHA256_Init((SHA256_CTX*)state) == 1 ? NDN_SUCCESS : NDN_SEC_CRYPTO_ALGO_FAILURE;
+}
+
+static int
+openssl_sha256_update(abstract_sha256_state_t* state, const uint8_t* data, uint32_t datalen){
+  return SHA256_Update((SHA256_CTX*)state, data, datalen) == 1 ? NDN_SUCCESS : NDN_SEC_CRYPTO_ALGO_FAILURE;
+}
+
+static int
+openssl_sha256_finish(abstract_sha256_state_t* state, uint8_t* hash_result){
+  return SHA256_Final(hash_result, (SHA256_CTX*)state) == 1 ? NDN_SUCCESS : NDN_SEC_CRYPTO_ALGO_FAILURE;
+}
+
+static int
+openssl_hmac_sha256(const void* payload, uint32_t payload_length,
+                    const abstract_hmac_key_t* hmac_key, uint8_t* hmac_result){
+  unsigned int used;
+
+  if(HMAC(EVP_sha256(), hmac_key->key_value, (int)hmac_key->key_size,
+          (const uint8_t*)payload, payload_length, hmac_result, &used) == NULL){
+    return NDN_SEC_CRYPTO_ALGO_FAILURE;
+  }
+  return NDN_SUCCESS;
+}
+
+static const EVP_CIPHER*
+openssl_aes_cipher(const abstract_aes_key_t* aes_key){
+  switch(aes_key->key_size){
+  case 16:
+    return EVP_aes_128_cbc();
+  case 24:
+    return EVP_aes_192_cbc();
+  case 32:
+    return EVP_aes_256_cbc();
+  default:
+    return NULL;
+  }
+}
+
+static int
+openssl_aes_cbc(const EVP_CIPHER* cipher, int encrypt, const uint8_t* input_value,
+                uint32_t input_size, uint8_t* output_value, const uint8_t* aes_iv,
+                const abstract_aes_key_t* aes_key){
+  EVP_CIPHER_CTX* ctx;
+  int used, ret = NDN_SEC_CRYPTO_ALGO_FAILURE;
+
+  ctx = EVP_CIPHER_CTX_new();
+  if(ctx == NULL){
+    return NDN_SEC_CRYPTO_ALGO_FAILURE;
+  }
+  // The caller pads, as with the default backend
+  if(EVP_CipherInit_ex(ctx, cipher, NULL, aes_key->key_value, aes_iv, encrypt) == 1 &&
+     EVP_CIPHER_CTX_set_padding(ctx, 0) == 1 &&
+     EVP_CipherUpdate(ctx, output_value, &used, input_value, (int)input_size) == 1 &&
+     EVP_CipherFinal_ex(ctx, output_value + used, &used) == 1){
+    ret = NDN_SUCCESS;
+  }
+  EVP_CIPHER_CTX_free(ctx);
+  return ret;
+}
+
+// Output is IV || ciphertext, as tinycrypt writes it
+static int
+openssl_aes_cbc_encrypt(const uint8_t* input_value, uint32_t input_size,
+                        uint8_t* output_value, uint32_t output_size,
+                        const uint8_t* aes_iv, const abstract_aes_key_t* aes_key){
+  const EVP_CIPHER* cipher = openssl_aes_cipher(aes_key);
+
+  if(cipher == NULL || input_size % OPENSSL_AES_BLOCK_SIZE != 0){
+    return NDN_SEC_CRYPTO_ALGO_FAILURE;
+  }
+  if(output_size < input_size + OPENSSL_AES_BLOCK_SIZE){
+    return NDN_OVERSIZE;
+  }
+  memcpy(output_value, aes_iv, OPENSSL_AES_BLOCK_SIZE);
+  return openssl_aes_cbc(cipher, 1, input_value, input_size,
+                         output_value + OPENSSL_AES_BLOCK_SIZE, aes_iv, aes_key);
+}
+
+// Input is IV || ciphertext; the IV argument is not used, as in tinycrypt
+static int
+openssl_aes_cbc_decrypt(const uint8_t* input_value, uint32_t input_size,
+                        uint8_t* output_value, uint32_t output_size,
+                        const uint8_t* aes_iv, const abstract_aes_key_t* aes_key){
+  const EVP_CIPHER* cipher = openssl_aes_cipher(aes_key);
+
+  (void)aes_iv;
+  if(cipher == NULL || input_size % OPENSSL_AES_BLOCK_SIZE != 0 ||
+     input_size < 2 * OPENSSL_AES_BLOCK_SIZE){
+    return NDN_SEC_CRYPTO_ALGO_FAILURE;
+  }
+  if(output_size < input_size - OPENSSL_AES_BLOCK_SIZE){
+    return NDN_OVERSIZE;
+  }
+  return openssl_aes_cbc(cipher, 0, input_value + OPENSSL_AES_BLOCK_SIZE,
+                         input_size - OPENSSL_AES_BLOCK_SIZE, output_value, input_value, aes_key);
+}
+
+static int
+openssl_ecdsa_sign(const uint8_t* input_value, uint32_t input_size,
+                   uint8_t* output_value, uint32_t output_max_size,
+                   const abstract_ecc_prv_t* prv_key, uint8_t ecdsa_type,
+                   uint32_t* output_used_size){
+  uint8_t digest[SHA256_DIGEST_LENGTH];
+  EC_KEY* key = NULL;
+  BIGNUM* secret = NULL;
+  ECDSA_SIG* sig = NULL;
+  uint8_t* ptr = output_value;
+  int size, ret = NDN_SEC_CRYPTO_ALGO_FAILURE;
+
+  if(ecdsa_type != NDN_ECDSA_CURVE_SECP256R1 || openssl_p256 == NULL){
+    return default_ecdsa_sign(input_value, input_size, output_value, output_max_size,
+                              prv_key, ecdsa_type, output_used_size);
+  }
+  key = EC_KEY_new();
+  secret = BN_bin2bn(prv_key->key_value, (int)prv_key->key_size, NULL);
+  if(key == NULL || secret == NULL ||
+     EC_KEY_set_group(key, openssl_p256) != 1 || EC_KEY_set_private_key(key, secret) != 1){
+    goto cleanup;
+  }
+  SHA256(input_value, input_size, digest);
+  sig = ECDSA_do_sign(digest, sizeof(digest), key);
+  if(sig == NULL){
+    goto cleanup;
+  }
+  // DER-encoded, like the default backend
+  size = i2d_ECDSA_SIG(sig, NULL);
+  if(size <= 0 || (uint32_t)size > output_max_size){
+    ret = NDN_OVERSIZE;
+    goto cleanup;
+  }
+  i2d_ECDSA_SIG(sig, &ptr);
+  *output_used_size = (uint32_t)size;
+  ret = NDN_SUCCESS;
+
+cleanup:
+  ECDSA_SIG_free(sig);
+  BN_clear_free(secret);
+  EC_KEY_free(key);
+  return ret;
+}
+
+static int
+openssl_ecdsa_verify(const uint8_t* input_value, uint32_t input_size,
+                     const uint8_t* sig_value, uint32_t sig_size,
+                     const abstract_ecc_pub_t* pub_key, uint8_t ecdsa_type){
+  uint8_t digest[SHA256_DIGEST_LENGTH];
+  uint8_t point_value[OPENSSL_P256_POINT_SIZE];
+  const uint8_t* ptr = sig_value;
+  EC_KEY* key = NULL;
+  EC_POINT* point = NULL;
+  ECDSA_SIG* sig = NULL;
+  int ret = NDN_SEC_FAIL_VERIFY_SIG;
+
+  if(ecdsa_type != NDN_ECDSA_CURVE_SECP256R1 || openssl_p256 == NULL){
+    return default_ecdsa_verify(input_value, input_size, sig_value, sig_size, pub_key, ecdsa_type);
+  }
+  // Keys of the default backend are X || Y
+  if(pub_key->key_size == OPENSSL_P256_POINT_SIZE - 1){
+    point_value[0] = POINT_CONVERSION_UNCOMPRESSED;
+    memcpy(point_value + 1, pub_key->key_value, OPENSSL_P256_POINT_SIZE - 1);
+  }else if(pub_key->key_size == OPENSSL_P256_POINT_SIZE){
+    memcpy(point_value, pub_key->key_value, OPENSSL_P256_POINT_SIZE);
+  }else{
+    return NDN_SEC_FAIL_VERIFY_SIG;
+  }
+
+  key = EC_KEY_new();
+  point = EC_POINT_new(openssl_p256);
+  sig = d2i_ECDSA_SIG(NULL, &ptr, (long)sig_size);
+  if(key == NULL || point == NULL || sig == NULL ||
+     EC_POINT_oct2point(openssl_p256, point, point_value, sizeof(point_value), NULL) != 1 ||
+     EC_KEY_set_group(key, openssl_p256) != 1 || EC_KEY_set_public_key(key, point) != 1){
+    goto cleanup;
+  }
+  SHA256(input_value, input_size, digest);
+  if(ECDSA_do_verify(digest, sizeof(digest), sig, key) == 1){
+    ret = NDN_SUCCESS;
+  }
+
+cleanup:
+  ECDSA_SIG_free(sig);
+  EC_POINT_free(point);
+  EC_KEY_free(key);
+  return ret;
+}
+
+void
+ndn_lite_openssl_load_backend(void){
+  ndn_sha_backend_t* sha_backend = ndn_sha_get_backend();
+  ndn_hmac_backend_t* hmac_backend = ndn_hmac_get_backend();
+  ndn_aes_backend_t* aes_backend = ndn_aes_get_backend();
+  ndn_ecc_backend_t* ecc_backend = ndn_ecc_get_backend();
+
+  sha_backend->sha256 = openssl_sha256;
+  sha_backend->sha256_init = openssl_sha256_init;
+  sha_backend->sha256_update = openssl_sha256_update;
+  sha_backend->sha256_finish = openssl_sha256_finish;
+
+  hmac_backend->hmac_sha256 = openssl_hmac_sha256;
+
+  aes_backend->aes_cbc_encrypt = openssl_aes_cbc_encrypt;
+  aes_backend->aes_cbc_decrypt = openssl_aes_cbc_decrypt;
+
+  if(openssl_p256 == NULL){
+    openssl_p256 = EC_GROUP_new_by_curve_name(NID_X9_62_prime256v1);
+    default_ecdsa_sign = ecc_backend->ecdsa_sign;
+    default_ecdsa_verify = ecc_backend->ecdsa_verify;
+  }
+  ecc_backend->ecdsa_sign = openssl_ecdsa_sign;
+  ecc_backend->ecdsa_verify = openssl_ecdsa_verify;
+}
+
+void
+ndn_lite_openssl_get_default_ecdsa(ndn_ecdsa_sign_impl* sign, ndn_ecdsa_verify_impl* verify){
+  *sign = default_ecdsa_sign;
+  *verify = default_ecdsa_verify;
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#ifndef NDN_OPENSSL_CRYPTO_IMPL_H_
+#define NDN_OPENSSL_CRYPTO_IMPL_H_
+
+#include "ndn-lite/security/ndn-lite-ecc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Route SHA-256, HMAC-SHA256, AES-CBC and ECDSA through OpenSSL libcrypto.
+ *
+ * Only the operations are replaced: keys keep the format of the default
+ * backend, so key generation, loading and encoding are unchanged.
+ * Curves other than P-256 fall back to the default backend.
+ * Call from the platform security init, after the default backend is loaded.
+ */
+void
+ndn_lite_openssl_load_backend(void);
+
+/**
+ * The ECDSA functions of the backend OpenSSL replaced, which it still uses
+ * for other curves. Both are NULL before ndn_lite_openssl_load_backend.
+ * Lets a test check that signatures of one backend verify with the other.
+ */
+void
+ndn_lite_openssl_get_default_ecdsa(ndn_ecdsa_sign_impl* sign, ndn_ecdsa_verify_impl* verify);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
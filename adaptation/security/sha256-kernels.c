@@ -0,0 +1,571 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include "sha256-kernels.h"
+#include "../forwarder/pkt-peek.h"
+#include "ndn-lite/ndn-error-code.h"
+#include "ndn-lite/security/ndn-lite-sha.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#include <cpuid.h>
+#define SHA256_KERNELS_X86
+#endif
+#if defined(__aarch64__) && (defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO))
+#include <arm_neon.h>
+#ifdef __linux__
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#define SHA256_KERNELS_ARM
+#endif
+
+#define BLOCK NDN_SHA256_KERNELS_BLOCK_SIZE
+#define LANES NDN_SHA256_KERNELS_MAX_LANES
+// With fewer busy lanes, the single-message kernel is faster
+#define SHA256_LANES_MIN_ACTIVE 2
+
+_Static_assert(sizeof(ndn_sha256_kernels_state_t) <= sizeof(abstract_sha256_state_t),
+               "The kernel state must fit in the state of the default backend");
+
+typedef void (*sha256_compress_func)(uint32_t* h, const uint8_t* data, uint32_t blocks);
+// One block of each lane; st[i][j] is word i of lane j
+typedef void (*sha256_lanes_func)(uint32_t (*st)[LANES], const uint8_t* const* blocks);
+
+typedef struct sha256_kernels {
+  int level;
+  uint32_t lanes;
+  sha256_compress_func compress;
+  sha256_lanes_func compress_lanes;
+} sha256_kernels_t;
+
+/**
+ * A message in a lane of the multi-buffer kernel.
+ */
+typedef struct sha256_lane {
+  const uint8_t* data;
+  // Full blocks left in data, then padding blocks left in tail
+  uint32_t blocks;
+  uint32_t tail_blocks;
+  uint32_t tail_next;
+  uint32_t index;
+  bool busy;
+  uint8_t tail[2 * BLOCK];
+} sha256_lane_t;
+
+static const uint32_t sha256_k[64] __attribute__((aligned(16))) = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static const uint32_t sha256_iv[8] = {
+  0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+static sha256_kernels_t kernels;
+
+static void
+compress_software(uint32_t* h, const uint8_t* data, uint32_t blocks);
+
+static uint32_t
+sha256_write_tail(uint8_t* tail, const uint8_t* rest, uint32_t rest_size, uint64_t total);
+
+static int
+sha256_kernels_best_level(void);
+
+static int
+sha256_backend_digest(const uint8_t* data, uint32_t datalen, uint8_t* hash_result);
+
+static int
+sha256_backend_init(abstract_sha256_state_t* state);
+
+static int
+sha256_backend_update(abstract_sha256_state_t* state, const uint8_t* data, uint32_t datalen);
+
+static int
+sha256_backend_finish(abstract_sha256_state_t* state, uint8_t* hash_result);
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+static inline uint32_t
+rotr(uint32_t x, int n){
+  return (x >> n) | (x << (32 - n));
+}
+
+static void
+compress_software(uint32_t* h, const uint8_t* data, uint32_t blocks){
+  uint32_t w[64], s[8], t1, t2;
+  int t;
+
+  for(; blocks > 0; blocks --, data += BLOCK){
+    for(t = 0; t < 16; t ++){
+      w[t] = ndn_pkt_load_be32(data + 4 * t);
+    }
+    for(t = 16; t < 64; t ++){
+      w[t] = (rotr(w[t - 2], 17) ^ rotr(w[t - 2], 19) ^ (w[t - 2] >> 10)) + w[t - 7] +
+             (rotr(w[t - 15], 7) ^ rotr(w[t - 15], 18) ^ (w[t - 15] >> 3)) + w[t - 16];
+    }
+    memcpy(s, h, sizeof(s));
+    for(t = 0; t < 64; t ++){
+      t1 = s[7] + (rotr(s[4], 6) ^ rotr(s[4], 11) ^ rotr(s[4], 25)) +
+           ((s[4] & s[5]) ^ (~s[4] & s[6])) + sha256_k[t] + w[t];
+      t2 = (rotr(s[0], 2) ^ rotr(s[0], 13) ^ rotr(s[0], 22)) +
+           ((s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]));
+      s[7] = s[6];
+      s[6] = s[5];
+      s[5] = s[4];
+      s[4] = s[3] + t1;
+      s[3] = s[2];
+      s[2] = s[1];
+      s[1] = s[0];
+      s[0] = t1 + t2;
+    }
+    for(t = 0; t < 8; t ++){
+      h[t] += s[t];
+    }
+  }
+}
+
+#ifdef SHA256_KERNELS_X86
+__attribute__((target("sha,sse4.1")))
+static void
+compress_shani(uint32_t* h, const uint8_t* data, uint32_t blocks){
+  const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+  __m128i state0, state1, msg, tmp, w[4], abef, cdgh;
+  int g;
+
+  // The instructions keep the state as ABEF and CDGH
+  tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&h[0]), 0xB1);
+  state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&h[4]), 0x1B);
+  state0 = _mm_alignr_epi8(tmp, state1, 8);
+  state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+  for(; blocks > 0; blocks --, data += BLOCK){
+    abef = state0;
+    cdgh = state1;
+    for(g = 0; g < 4; g ++){
+      w[g] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 16 * g)), mask);
+    }
+    // Four rounds per group, with the schedule of later groups interleaved
+    for(g = 0; g < 16; g ++){
+      msg = _mm_add_epi32(w[g % 4], _mm_load_si128((const __m128i*)&sha256_k[4 * g]));
+      state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+      if(g >= 3 && g <= 14){
+        tmp = _mm_alignr_epi8(w[g % 4], w[(g + 3) % 4], 4);
+        w[(g + 1) % 4] = _mm_sha256msg2_epu32(_mm_add_epi32(w[(g + 1) % 4], tmp), w[g % 4]);
+      }
+      state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(msg, 0x0E));
+      if(g >= 1 && g <= 12){
+        w[(g + 3) % 4] = _mm_sha256msg1_epu32(w[(g + 3) % 4], w[g % 4]);
+      }
+    }
+    state0 = _mm_add_epi32(state0, abef);
+    state1 = _mm_add_epi32(state1, cdgh);
+  }
+
+  tmp = _mm_shuffle_epi32(state0, 0x1B);
+  state1 = _mm_shuffle_epi32(state1, 0xB1);
+  _mm_storeu_si128((__m128i*)&h[0], _mm_blend_epi16(tmp, state1, 0xF0));
+  _mm_storeu_si128((__m128i*)&h[4], _mm_alignr_epi8(state1, tmp, 8));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i
+rotr_x8(__m256i x, int n){
+  return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+__attribute__((target("avx2")))
+static void
+compress_x8(uint32_t (*st)[LANES], const uint8_t* const* blocks){
+  const __m256i bswap = _mm256_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+                                        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+  __m256i s[8], w[16], r[8], t[8], u[8], t1, t2;
+  int i, half;
+
+  // Transpose the blocks, so that w[i] holds word i of every lane
+  for(half = 0; half < 2; half ++){
+    for(i = 0; i < LANES; i ++){
+      r[i] = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(blocks[i] + 32 * half)), bswap);
+    }
+    for(i = 0; i < LANES; i += 2){
+      t[i] = _mm256_unpacklo_epi32(r[i], r[i + 1]);
+      t[i + 1] = _mm256_unpackhi_epi32(r[i], r[i + 1]);
+    }
+    for(i = 0; i < LANES; i += 4){
+      u[i] = _mm256_unpacklo_epi64(t[i], t[i + 2]);
+      u[i + 1] = _mm256_unpackhi_epi64(t[i], t[i + 2]);
+      u[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+      u[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+    }
+    for(i = 0; i < 4; i ++){
+      w[8 * half + i] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x20);
+      w[8 * half + i + 4] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x31);
+    }
+  }
+
+  for(i = 0; i < 8; i ++){
+    s[i] = _mm256_load_si256((const __m256i*)st[i]);
+  }
+  for(i = 0; i < 64; i ++){
+    if(i >= 16){
+      t1 = w[(i - 2) & 15];
+      t2 = w[(i - 15) & 15];
+      t1 = _mm256_xor_si256(_mm256_xor_si256(rotr_x8(t1, 17), rotr_x8(t1, 19)), _mm256_srli_epi32(t1, 10));
+      t2 = _mm256_xor_si256(_mm256_xor_si256(rotr_x8(t2, 7), rotr_x8(t2, 18)), _mm256_srli_epi32(t2, 3));
+      w[i & 15] = _mm256_add_epi32(_mm256_add_epi32(w[i & 15], w[(i - 7) & 15]), _mm256_add_epi32(t1, t2));
+    }
+    t1 = _mm256_add_epi32(s[7], _mm256_xor_si256(_mm256_xor_si256(rotr_x8(s[4], 6), rotr_x8(s[4], 11)),
+                                                 rotr_x8(s[4], 25)));
+    t1 = _mm256_add_epi32(t1, _mm256_xor_si256(_mm256_and_si256(s[4], s[5]), _mm256_andnot_si256(s[4], s[6])));
+    t1 = _mm256_add_epi32(t1, _mm256_add_epi32(_mm256_set1_epi32((int)sha256_k[i]), w[i & 15]));
+    t2 = _mm256_xor_si256(_mm256_xor_si256(rotr_x8(s[0], 2), rotr_x8(s[0], 13)), rotr_x8(s[0], 22));
+    t2 = _mm256_add_epi32(t2, _mm256_or_si256(_mm256_and_si256(_mm256_or_si256(s[0], s[1]), s[2]),
+                                              _mm256_and_si256(s[0], s[1])));
+    s[7] = s[6];
+    s[6] = s[5];
+    s[5] = s[4];
+    s[4] = _mm256_add_epi32(s[3], t1);
+    s[3] = s[2];
+    s[2] = s[1];
+    s[1] = s[0];
+    s[0] = _mm256_add_epi32(t1, t2);
+  }
+  for(i = 0; i < 8; i ++){
+    _mm256_store_si256((__m256i*)st[i], _mm256_add_epi32(s[i], _mm256_load_si256((const __m256i*)st[i])));
+  }
+}
+#endif
+
+#ifdef SHA256_KERNELS_ARM
+static void
+compress_armv8(uint32_t* h, const uint8_t* data, uint32_t blocks){
+  uint32x4_t state0, state1, abcd, efgh, msg, tmp, w[4];
+  int g;
+
+  state0 = vld1q_u32(&h[0]);
+  state1 = vld1q_u32(&h[4]);
+  for(; blocks > 0; blocks --, data += BLOCK){
+    abcd = state0;
+    efgh = state1;
+    for(g = 0; g < 4; g ++){
+      w[g] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16 * g)));
+    }
+    for(g = 0; g < 16; g ++){
+      msg = vaddq_u32(w[g % 4], vld1q_u32(&sha256_k[4 * g]));
+      if(g < 12){
+        w[g % 4] = vsha256su0q_u32(w[g % 4], w[(g + 1) % 4]);
+      }
+      tmp = state0;
+      state0 = vsha256hq_u32(state0, state1, msg);
+      state1 = vsha256h2q_u32(state1, tmp, msg);
+      if(g < 12){
+        w[g % 4] = vsha256su1q_u32(w[g % 4], w[(g + 2) % 4], w[(g + 3) % 4]);
+      }
+    }
+    state0 = vaddq_u32(state0, abcd);
+    state1 = vaddq_u32(state1, efgh);
+  }
+  vst1q_u32(&h[0], state0);
+  vst1q_u32(&h[4], state1);
+}
+#endif
+
+static int
+sha256_kernels_best_level(void){
+#ifdef SHA256_KERNELS_X86
+  unsigned int eax, ebx, ecx, edx;
+
+  __builtin_cpu_init();
+  // Older compilers do not know "sha" in __builtin_cpu_supports
+  if(__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & bit_SHA) != 0 &&
+     __builtin_cpu_supports("sse4.1")){
+    return NDN_SHA256_KERNELS_SHANI;
+  }
+#endif
+#ifdef SHA256_KERNELS_ARM
+#ifdef __linux__
+  if((getauxval(AT_HWCAP) & HWCAP_SHA2) == 0){
+    return NDN_SHA256_KERNELS_SOFTWARE;
+  }
+#endif
+  return NDN_SHA256_KERNELS_ARMV8;
+#endif
+  return NDN_SHA256_KERNELS_SOFTWARE;
+}
+
+int
+ndn_sha256_kernels_select(int level){
+  int best = sha256_kernels_best_level();
+
+  // The hardware levels are exclusive, so only the best one may be picked
+  if(level != best){
+    level = NDN_SHA256_KERNELS_SOFTWARE;
+  }
+  kernels.level = NDN_SHA256_KERNELS_SOFTWARE;
+  kernels.lanes = 1;
+  kernels.compress = compress_software;
+  kernels.compress_lanes = NULL;
+#ifdef SHA256_KERNELS_X86
+  // SHA-NI on one message outruns eight AVX2 lanes
+  if(level == NDN_SHA256_KERNELS_SHANI){
+    kernels.level = NDN_SHA256_KERNELS_SHANI;
+    kernels.compress = compress_shani;
+  }else if(__builtin_cpu_supports("avx2")){
+    kernels.lanes = LANES;
+    kernels.compress_lanes = compress_x8;
+  }
+#endif
+#ifdef SHA256_KERNELS_ARM
+  if(level == NDN_SHA256_KERNELS_ARMV8){
+    kernels.level = NDN_SHA256_KERNELS_ARMV8;
+    kernels.compress = compress_armv8;
+  }
+#endif
+  return kernels.level;
+}
+
+int
+ndn_sha256_kernels_get_level(void){
+  return kernels.level;
+}
+
+uint32_t
+ndn_sha256_kernels_get_lanes(void){
+  return kernels.lanes;
+}
+
+__attribute__((constructor))
+static void
+sha256_kernels_init(void){
+  ndn_sha256_kernels_select(sha256_kernels_best_level());
+}
+
+// Pad the last partial block; returns the number of blocks in tail
+static uint32_t
+sha256_write_tail(uint8_t* tail, const uint8_t* rest, uint32_t rest_size, uint64_t total){
+  uint32_t blocks = (rest_size < BLOCK - 8) ? 1 : 2;
+  uint64_t bits = total * 8;
+
+  memcpy(tail, rest, rest_size);
+  tail[rest_size] = 0x80;
+  memset(tail + rest_size + 1, 0, blocks * BLOCK - rest_size - 1);
+  ndn_pkt_store_be32(tail + blocks * BLOCK - 8, (uint32_t)(bits >> 32));
+  ndn_pkt_store_be32(tail + blocks * BLOCK - 4, (uint32_t)bits);
+  return blocks;
+}
+
+void
+ndn_sha256_kernels_init(ndn_sha256_kernels_state_t* state){
+  memcpy(state->h, sha256_iv, sizeof(sha256_iv));
+  state->total = 0;
+  state->used = 0;
+}
+
+void
+ndn_sha256_kernels_update(ndn_sha256_kernels_state_t* state, const uint8_t* data, uint32_t size){
+  uint32_t n;
+
+  state->total += size;
+  if(state->used > 0){
+    n = (size < BLOCK - state->used) ? size : BLOCK - state->used;
+    memcpy(state->block + state->used, data, n);
+    state->used += n;
+    data += n;
+    size -= n;
+    if(state->used < BLOCK){
+      return;
+    }
+    kernels.compress(state->h, state->block, 1);
+    state->used = 0;
+  }
+  if(size >= BLOCK){
+    kernels.compress(state->h, data, size / BLOCK);
+    data += size - size % BLOCK;
+    size %= BLOCK;
+  }
+  memcpy(state->block, data, size);
+  state->used = size;
+}
+
+void
+ndn_sha256_kernels_finish(ndn_sha256_kernels_state_t* state, uint8_t* digest){
+  uint8_t tail[2 * BLOCK];
+  int i;
+
+  kernels.compress(state->h, tail, sha256_write_tail(tail, state->block, state->used, state->total));
+  for(i = 0; i < 8; i ++){
+    ndn_pkt_store_be32(digest + 4 * i, state->h[i]);
+  }
+}
+
+void
+ndn_sha256_kernels_digest(const uint8_t* data, uint32_t size, uint8_t* digest){
+  ndn_sha256_kernels_state_t state;
+
+  ndn_sha256_kernels_init(&state);
+  ndn_sha256_kernels_update(&state, data, size);
+  ndn_sha256_kernels_finish(&state, digest);
+}
+
+#ifdef SHA256_KERNELS_X86
+static void
+lane_assign(sha256_lane_t* lane, uint32_t (*st)[LANES], uint32_t j, uint32_t index,
+            const uint8_t* data, uint32_t size){
+  uint32_t i;
+
+  lane->data = data;
+  lane->blocks = size / BLOCK;
+  lane->tail_blocks = sha256_write_tail(lane->tail, data + size - size % BLOCK, size % BLOCK, size);
+  lane->tail_next = 0;
+  lane->index = index;
+  lane->busy = true;
+  for(i = 0; i < 8; i ++){
+    st[i][j] = sha256_iv[i];
+  }
+}
+
+// Finish lane j with the single-message kernel
+static void
+lane_finish(sha256_lane_t* lane, uint32_t (*st)[LANES], uint32_t j, uint8_t* digest){
+  uint32_t h[8], i;
+
+  for(i = 0; i < 8; i ++){
+    h[i] = st[i][j];
+  }
+  if(lane->blocks > 0){
+    kernels.compress(h, lane->data, lane->blocks);
+  }
+  if(lane->tail_next < lane->tail_blocks){
+    kernels.compress(h, lane->tail + lane->tail_next * BLOCK, lane->tail_blocks - lane->tail_next);
+  }
+  for(i = 0; i < 8; i ++){
+    ndn_pkt_store_be32(digest + 4 * i, h[i]);
+  }
+  lane->busy = false;
+}
+
+static void
+digest_many_lanes(const uint8_t* const* data, const uint32_t* sizes,
+                  uint8_t* const* digests, uint32_t count){
+  static const uint8_t idle[BLOCK];
+  uint32_t st[8][LANES] __attribute__((aligned(32)));
+  sha256_lane_t lanes[LANES];
+  const uint8_t* blocks[LANES];
+  sha256_lane_t* lane;
+  uint32_t next = 0, active = 0, i, j;
+
+  for(j = 0; j < kernels.lanes; j ++){
+    lanes[j].busy = false;
+    if(next < count){
+      lane_assign(&lanes[j], st, j, next, data[next], sizes[next]);
+      next ++;
+      active ++;
+    }
+  }
+  while(active >= SHA256_LANES_MIN_ACTIVE || (active > 0 && next < count)){
+    for(j = 0; j < kernels.lanes; j ++){
+      lane = &lanes[j];
+      if(!lane->busy){
+        blocks[j] = idle;
+      }else if(lane->blocks > 0){
+        blocks[j] = lane->data;
+        lane->data += BLOCK;
+        lane->blocks --;
+      }else{
+        blocks[j] = lane->tail + lane->tail_next * BLOCK;
+        lane->tail_next ++;
+      }
+    }
+    kernels.compress_lanes(st, blocks);
+    for(j = 0; j < kernels.lanes; j ++){
+      lane = &lanes[j];
+      if(!lane->busy || lane->blocks > 0 || lane->tail_next < lane->tail_blocks){
+        continue;
+      }
+      for(i = 0; i < 8; i ++){
+        ndn_pkt_store_be32(digests[lane->index] + 4 * i, st[i][j]);
+      }
+      lane->busy = false;
+      active --;
+      if(next < count){
+        lane_assign(lane, st, j, next, data[next], sizes[next]);
+        next ++;
+        active ++;
+      }
+    }
+  }
+  // Too few messages are left to fill the lanes
+  for(j = 0; j < kernels.lanes; j ++){
+    if(lanes[j].busy){
+      lane_finish(&lanes[j], st, j, digests[lanes[j].index]);
+    }
+  }
+}
+#endif
+
+void
+ndn_sha256_kernels_digest_many(const uint8_t* const* data, const uint32_t* sizes,
+                               uint8_t* const* digests, uint32_t count){
+  uint32_t i;
+
+#ifdef SHA256_KERNELS_X86
+  if(kernels.lanes > 1 && count >= SHA256_LANES_MIN_ACTIVE){
+    digest_many_lanes(data, sizes, digests, count);
+    return;
+  }
+#endif
+  for(i = 0; i < count; i ++){
+    ndn_sha256_kernels_digest(data[i], sizes[i], digests[i]);
+  }
+}
+
+static int
+sha256_backend_digest(const uint8_t* data, uint32_t datalen, uint8_t* hash_result){
+  ndn_sha256_kernels_digest(data, datalen, hash_result);
+  return NDN_SUCCESS;
+}
+
+static int
+sha256_backend_init(abstract_sha256_state_t* state){
+  ndn_sha256_kernels_init((ndn_sha256_kernels_state_t*)state);
+  return NDN_SUCCESS;
+}
+
+static int
+sha256_backend_update(abstract_sha256_state_t* state, const uint8_t* data, uint32_t datalen){
+  ndn_sha256_kernels_update((ndn_sha256_kernels_state_t*)state, data, datalen);
+  return NDN_SUCCESS;
+}
+
+static int
+sha256_backend_finish(abstract_sha256_state_t* state, uint8_t* hash_result){
+  ndn_sha256_kernels_finish((ndn_sha256_kernels_state_t*)state, hash_result);
+  return NDN_SUCCESS;
+}
+
+void
+ndn_sha256_kernels_load_backend(void){
+  ndn_sha_backend_t* backend = ndn_sha_get_backend();
+
+  if(kernels.level == NDN_SHA256_KERNELS_SOFTWARE){
+    return;
+  }
+  backend->sha256 = sha256_backend_digest;
+  backend->sha256_init = sha256_backend_init;
+  backend->sha256_update = sha256_backend_update;
+  backend->sha256_finish = sha256_backend_finish;
+}
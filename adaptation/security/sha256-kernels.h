@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#ifndef NDN_SHA256_KERNELS_H_
+#define NDN_SHA256_KERNELS_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Instruction sets of the single-message SHA-256 kernels.
+ * The best one supported by the CPU is selected at startup.
+ */
+#define NDN_SHA256_KERNELS_SOFTWARE 0
+#define NDN_SHA256_KERNELS_SHANI 1
+#define NDN_SHA256_KERNELS_ARMV8 2
+
+#define NDN_SHA256_KERNELS_BLOCK_SIZE 64
+#define NDN_SHA256_KERNELS_DIGEST_SIZE 32
+// Messages hashed side by side by the AVX2 kernel
+#define NDN_SHA256_KERNELS_MAX_LANES 8
+
+typedef struct ndn_sha256_kernels_state {
+  uint32_t h[8];
+  uint64_t total;
+  uint8_t block[NDN_SHA256_KERNELS_BLOCK_SIZE];
+  uint32_t used;
+} ndn_sha256_kernels_state_t;
+
+/**
+ * Select the kernels, e.g. to compare them.
+ * @return The level in use, which is lower than @p level if the CPU lacks it.
+ */
+int
+ndn_sha256_kernels_select(int level);
+
+int
+ndn_sha256_kernels_get_level(void);
+
+/**
+ * The lanes of ndn_sha256_kernels_digest_many: NDN_SHA256_KERNELS_MAX_LANES
+ * with AVX2, unless SHA-NI is selected, which is faster on one message.
+ */
+uint32_t
+ndn_sha256_kernels_get_lanes(void);
+
+void
+ndn_sha256_kernels_init(ndn_sha256_kernels_state_t* state);
+
+void
+ndn_sha256_kernels_update(ndn_sha256_kernels_state_t* state, const uint8_t* data, uint32_t size);
+
+void
+ndn_sha256_kernels_finish(ndn_sha256_kernels_state_t* state, uint8_t* digest);
+
+void
+ndn_sha256_kernels_digest(const uint8_t* data, uint32_t size, uint8_t* digest);
+
+/**
+ * Digest @p count independent messages, e.g. the signed portions of segments.
+ * With several lanes, each lane takes the next message as soon as it is done,
+ * so messages of different sizes keep all lanes busy.
+ * @param digests @p count buffers of NDN_SHA256_KERNELS_DIGEST_SIZE.
+ */
+void
+ndn_sha256_kernels_digest_many(const uint8_t* const* data, const uint32_t* sizes,
+                               uint8_t* const* digests, uint32_t count);
+
+/**
+ * Route SHA-256 of the ndn-lite backend through the kernels.
+ * Does nothing without SHA instructions, leaving tinycrypt in place.
+ */
+void
+ndn_sha256_kernels_load_backend(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,330 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "verify-cache.h"
+#include "../forwarder/pkt-peek.h"
+#include "../forwarder/pkt-view.h"
+#include "../forwarder/pktbuf.h"
+#include "ndn-lite/ndn-enums.h"
+#include "ndn-lite/ndn-error-code.h"
+
+// Name before and after the digest component, and parameters to SignatureInfo
+#define VERIFY_CACHE_MAX_PARTS 3
+
+static ndn_verify_cache_t verify_cache_instance;
+static bool verify_cache_instance_ready = false;
+
+static int
+verify_cache_signed_portion(const uint8_t* packet, uint32_t size, struct iovec* parts, int* count,
+                            const uint8_t** signature, uint32_t* signature_size);
+
+static void
+verify_cache_digest(const struct iovec* parts, int count, const uint8_t* signature,
+                    uint32_t signature_size, const ndn_ecc_pub_t* pub_key, uint8_t* key);
+
+static ndn_verify_cache_entry_t*
+verify_cache_set(ndn_verify_cache_t* self, const uint8_t* key);
+
+static int
+verify_cache_ecdsa(const struct iovec* parts, int count, const uint8_t* signature,
+                   uint32_t signature_size, const ndn_ecc_pub_t* pub_key);
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+int
+ndn_verify_cache_init(ndn_verify_cache_t* self, uint32_t capacity, ndn_time_ms_t ttl){
+  uint32_t sets = 1;
+
+  while(sets * NDN_VERIFY_CACHE_WAYS < capacity){
+    sets <<= 1;
+  }
+  memset(self, 0, sizeof(ndn_verify_cache_t));
+  self->entries = (ndn_verify_cache_entry_t*)calloc(sets * NDN_VERIFY_CACHE_WAYS,
+                                                    sizeof(ndn_verify_cache_entry_t));
+  if(self->entries == NULL){
+    return NDN_FWD_NO_MEM;
+  }
+  self->set_mask = sets - 1;
+  self->ttl = ttl;
+  return NDN_SUCCESS;
+}
+
+void
+ndn_verify_cache_destroy(ndn_verify_cache_t* self){
+  free(self->entries);
+  self->entries = NULL;
+}
+
+void
+ndn_verify_cache_clear(ndn_verify_cache_t* self){
+  memset(self->entries, 0, sizeof(ndn_verify_cache_entry_t) * (self->set_mask + 1) * NDN_VERIFY_CACHE_WAYS);
+}
+
+int
+ndn_verify_cache_startup(void){
+  int ret;
+
+  if(verify_cache_instance_ready){
+    return NDN_SUCCESS;
+  }
+  ret = ndn_verify_cache_init(&verify_cache_instance, NDN_VERIFY_CACHE_DEFAULT_CAPACITY,
+                              NDN_VERIFY_CACHE_DEFAULT_TTL);
+  verify_cache_instance_ready = (ret == NDN_SUCCESS);
+  return ret;
+}
+
+ndn_verify_cache_t*
+ndn_verify_cache_get_instance(void){
+  return verify_cache_instance_ready ? &verify_cache_instance : NULL;
+}
+
+static int
+verify_cache_signed_portion(const uint8_t* packet, uint32_t size, struct iovec* parts, int* count,
+                            const uint8_t** signature, uint32_t* signature_size){
+  ndn_data_view_t data;
+  const uint8_t *ptr, *val, *end, *name, *name_end, *rest = NULL, *rest_end = NULL;
+  uint32_t type, length;
+
+  ptr = ndn_pkt_read_tl(packet, packet + size, &type, &length);
+  if(ptr == NULL){
+    return NDN_WRONG_TLV_LENGTH;
+  }
+  if(type == TLV_Data){
+    if(ndn_data_view_parse(&data, packet, size) != NDN_SUCCESS || data.signature_value == NULL){
+      return NDN_WRONG_TLV_TYPE;
+    }
+    parts[0].iov_base = (void*)data.signed_portion;
+    parts[0].iov_len = data.signed_portion_size;
+    *count = 1;
+    *signature = data.signature_value;
+    *signature_size = data.signature_value_size;
+    return NDN_SUCCESS;
+  }
+  if(type != TLV_Interest){
+    return NDN_WRONG_TLV_TYPE;
+  }
+
+  // Signed Interest: name components except the parameters digest, then
+  // ApplicationParameters through InterestSignatureInfo
+  end = ptr + length;
+  name = ndn_pkt_read_tl(ptr, end, &type, &length);
+  if(name == NULL || type != TLV_Name){
+    return NDN_WRONG_TLV_TYPE;
+  }
+  name_end = name + length;
+  parts[0].iov_base = (void*)name;
+  parts[0].iov_len = length;
+  *count = 1;
+  *signature = NULL;
+  for(ptr = name; ptr < name_end; ptr = val + length){
+    val = ndn_pkt_read_tl(ptr, name_end, &type, &length);
+    if(val == NULL){
+      return NDN_WRONG_TLV_LENGTH;
+    }
+    if(type == NDN_VERIFY_CACHE_PARAMETERS_DIGEST_COMPONENT){
+      parts[0].iov_len = (size_t)(ptr - name);
+      if(val + length < name_end){
+        parts[1].iov_base = (void*)(val + length);
+        parts[1].iov_len = (size_t)(name_end - (val + length));
+        *count = 2;
+      }
+      break;
+    }
+  }
+
+  for(ptr = name_end; ptr < end; ptr = val + length){
+    val = ndn_pkt_read_tl(ptr, end, &type, &length);
+    if(val == NULL){
+      return NDN_WRONG_TLV_LENGTH;
+    }
+    if(type == TLV_ApplicationParameters){
+      rest = ptr;
+    }else if(type == NDN_VERIFY_CACHE_INTEREST_SIGNATURE_INFO){
+      rest_end = val + length;
+    }else if(type == NDN_VERIFY_CACHE_INTEREST_SIGNATURE_VALUE){
+      *signature = val;
+      *signature_size = length;
+    }
+  }
+  if(rest == NULL || rest_end == NULL || rest_end < rest || *signature == NULL){
+    return NDN_WRONG_TLV_TYPE;
+  }
+  parts[*count].iov_base = (void*)rest;
+  parts[*count].iov_len = (size_t)(rest_end - rest);
+  (*count) ++;
+  return NDN_SUCCESS;
+}
+
+static void
+verify_cache_digest(const struct iovec* parts, int count, const uint8_t* signature,
+                    uint32_t signature_size, const ndn_ecc_pub_t* pub_key, uint8_t* key){
+  ndn_sha256_state_t state;
+  uint8_t curve_type;
+  int i;
+
+  ndn_sha256_init(&state);
+  for(i = 0; i < count; i ++){
+    ndn_sha256_update(&state, (const uint8_t*)parts[i].iov_base, (uint32_t)parts[i].iov_len);
+  }
+  ndn_sha256_update(&state, signature, signature_size);
+  // The key itself rather than its id, which a new key may reuse
+  if(pub_key != NULL){
+    curve_type = pub_key->curve_type;
+    ndn_sha256_update(&state, &curve_type, sizeof(curve_type));
+    ndn_sha256_update(&state, ndn_ecc_get_pub_key_value(pub_key), ndn_ecc_get_pub_key_size(pub_key));
+  }
+  ndn_sha256_finish(&state, key);
+}
+
+int
+ndn_verify_cache_key(const uint8_t* packet, uint32_t size, const ndn_ecc_pub_t* pub_key,
+                     uint8_t key[NDN_SEC_SHA256_HASH_SIZE]){
+  struct iovec parts[VERIFY_CACHE_MAX_PARTS];
+  const uint8_t* signature;
+  uint32_t signature_size;
+  int ret, count;
+
+  ret = verify_cache_signed_portion(packet, size, parts, &count, &signature, &signature_size);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  verify_cache_digest(parts, count, signature, signature_size, pub_key, key);
+  return NDN_SUCCESS;
+}
+
+static ndn_verify_cache_entry_t*
+verify_cache_set(ndn_verify_cache_t* self, const uint8_t* key){
+  uint32_t set;
+
+  // The key is a digest, so any of its bytes are uniformly distributed
+  memcpy(&set, key, sizeof(set));
+  return &self->entries[(set & self->set_mask) * NDN_VERIFY_CACHE_WAYS];
+}
+
+int
+ndn_verify_cache_lookup(ndn_verify_cache_t* self, const uint8_t key[NDN_SEC_SHA256_HASH_SIZE]){
+  ndn_verify_cache_entry_t* set = verify_cache_set(self, key);
+  ndn_time_ms_t now = ndn_time_now_ms();
+  int i;
+
+  for(i = 0; i < NDN_VERIFY_CACHE_WAYS; i ++){
+    if(set[i].in_use && memcmp(set[i].key, key, NDN_SEC_SHA256_HASH_SIZE) == 0){
+      if(set[i].expires <= now){
+        set[i].in_use = false;
+        break;
+      }
+      self->hits ++;
+      return set[i].result;
+    }
+  }
+  self->misses ++;
+  return NDN_VERIFY_CACHE_MISS;
+}
+
+void
+ndn_verify_cache_insert(ndn_verify_cache_t* self, const uint8_t key[NDN_SEC_SHA256_HASH_SIZE],
+                        int result){
+  ndn_verify_cache_entry_t *set = verify_cache_set(self, key), *victim = NULL;
+  ndn_time_ms_t now = ndn_time_now_ms();
+  int i;
+
+  for(i = 0; i < NDN_VERIFY_CACHE_WAYS; i ++){
+    if(set[i].in_use && memcmp(set[i].key, key, NDN_SEC_SHA256_HASH_SIZE) == 0){
+      victim = &set[i];
+      break;
+    }
+  }
+  for(i = 0; victim == NULL && i < NDN_VERIFY_CACHE_WAYS; i ++){
+    if(!set[i].in_use || set[i].expires <= now){
+      victim = &set[i];
+    }
+  }
+  if(victim == NULL){
+    // Evict the entry closest to expiry
+    victim = &set[0];
+    for(i = 1; i < NDN_VERIFY_CACHE_WAYS; i ++){
+      if(set[i].expires < victim->expires){
+        victim = &set[i];
+      }
+    }
+    self->evictions ++;
+  }
+  memcpy(victim->key, key, NDN_SEC_SHA256_HASH_SIZE);
+  victim->expires = now + self->ttl;
+  victim->result = result;
+  victim->in_use = true;
+}
+
+static int
+verify_cache_ecdsa(const struct iovec* parts, int count, const uint8_t* signature,
+                   uint32_t signature_size, const ndn_ecc_pub_t* pub_key){
+  uint32_t input_size;
+  uint8_t* input;
+  int ret;
+
+  if(count == 1){
+    ret = ndn_ecdsa_verify((const uint8_t*)parts[0].iov_base, (uint32_t)parts[0].iov_len,
+                           signature, signature_size, pub_key);
+  }else{
+    // Only signed Interests are split; they are small
+    input_size = ndn_iov_size(parts, count);
+    input = (uint8_t*)malloc(input_size);
+    if(input == NULL){
+      return NDN_FWD_NO_MEM;
+    }
+    ndn_iov_gather(parts, count, input, input_size);
+    ret = ndn_ecdsa_verify(input, input_size, signature, signature_size, pub_key);
+    free(input);
+  }
+  return (ret == NDN_SUCCESS) ? NDN_SUCCESS : NDN_SEC_FAIL_VERIFY_SIG;
+}
+
+int
+ndn_verify_cache_ecdsa_verify(ndn_verify_cache_t* self, const uint8_t* packet, uint32_t size,
+                              const ndn_ecc_pub_t* pub_key){
+  struct iovec parts[VERIFY_CACHE_MAX_PARTS];
+  uint8_t key[NDN_SEC_SHA256_HASH_SIZE];
+  const uint8_t* signature;
+  uint32_t signature_size;
+  int ret, count;
+
+  ret = verify_cache_signed_portion(packet, size, parts, &count, &signature, &signature_size);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  if(self == NULL){
+    return verify_cache_ecdsa(parts, count, signature, signature_size, pub_key);
+  }
+  verify_cache_digest(parts, count, signature, signature_size, pub_key, key);
+  ret = ndn_verify_cache_lookup(self, key);
+  if(ret != NDN_VERIFY_CACHE_MISS){
+    return ret;
+  }
+  ret = verify_cache_ecdsa(parts, count, signature, signature_size, pub_key);
+  if(ret != NDN_FWD_NO_MEM){
+    ndn_verify_cache_insert(self, key, ret);
+  }
+  return ret;
+}
+
+int
+ndn_verify_cache_ecdsa_verify_packet(const uint8_t* packet, uint32_t size,
+                                     const ndn_ecc_pub_t* pub_key){
+  struct iovec parts[VERIFY_CACHE_MAX_PARTS];
+  const uint8_t* signature;
+  uint32_t signature_size;
+  int ret, count;
+
+  ret = verify_cache_signed_portion(packet, size, parts, &count, &signature, &signature_size);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  return verify_cache_ecdsa(parts, count, signature, signature_size, pub_key);
+}
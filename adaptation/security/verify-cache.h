@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+#ifndef NDN_VERIFY_CACHE_H_
+#define NDN_VERIFY_CACHE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ndn-lite/util/uniform-time.h"
+#include "ndn-lite/security/ndn-lite-sha.h"
+#include "ndn-lite/security/ndn-lite-ecc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NDN_VERIFY_CACHE_DEFAULT_CAPACITY 1024
+// How long a result is trusted, in ms
+#define NDN_VERIFY_CACHE_DEFAULT_TTL 60000
+// Entries compared per lookup
+#define NDN_VERIFY_CACHE_WAYS 4
+// Returned by ndn_verify_cache_lookup when there is no fresh entry
+#define NDN_VERIFY_CACHE_MISS 1
+
+// Signed Interest TLV types not in ndn-enums.h
+#define NDN_VERIFY_CACHE_PARAMETERS_DIGEST_COMPONENT 2
+#define NDN_VERIFY_CACHE_INTEREST_SIGNATURE_INFO 44
+#define NDN_VERIFY_CACHE_INTEREST_SIGNATURE_VALUE 46
+
+typedef struct ndn_verify_cache_entry {
+  uint8_t key[NDN_SEC_SHA256_HASH_SIZE];
+  ndn_time_ms_t expires;
+  int result;
+  bool in_use;
+} ndn_verify_cache_entry_t;
+
+/**
+ * Bounded cache of signature verification results.
+ *
+ * An entry is keyed by the digest of the signed portion, which includes the
+ * KeyLocator naming the signing key, the signature value, and the public
+ * key used. A repeated packet thus skips the verification, while a
+ * packet differing in any signed byte or in its signature misses.
+ * Both successes and failures are cached, so replayed forgeries are cheap
+ * to reject too.
+ */
+typedef struct ndn_verify_cache {
+  ndn_verify_cache_entry_t* entries;
+  uint32_t set_mask;
+  ndn_time_ms_t ttl;
+
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+} ndn_verify_cache_t;
+
+/**
+ * @param capacity Number of entries, rounded up to a power of 2.
+ * @param ttl How long a result is kept, in ms.
+ */
+int
+ndn_verify_cache_init(ndn_verify_cache_t* self, uint32_t capacity, ndn_time_ms_t ttl);
+
+void
+ndn_verify_cache_destroy(ndn_verify_cache_t* self);
+
+/**
+ * Forget every result, e.g. after a certificate is revoked or replaced.
+ */
+void
+ndn_verify_cache_clear(ndn_verify_cache_t* self);
+
+/**
+ * Allocate the process-wide cache with default limits.
+ * Called by ndn_lite_startup, before other threads may look it up.
+ */
+int
+ndn_verify_cache_startup(void);
+
+/**
+ * Process-wide cache, or NULL before ndn_verify_cache_startup.
+ */
+ndn_verify_cache_t*
+ndn_verify_cache_get_instance(void);
+
+/**
+ * Compute the cache key of a signed Data or signed Interest.
+ * The key covers the signed portion (for an Interest, without its
+ * ParametersSha256DigestComponent), the signature value, and the bytes and
+ * curve of the public key.
+ * @param pub_key The key it is verified with. NULL keys the entry by the
+ *   KeyLocator alone, for callers that resolve the key themselves.
+ */
+int
+ndn_verify_cache_key(const uint8_t* packet, uint32_t size, const ndn_ecc_pub_t* pub_key,
+                     uint8_t key[NDN_SEC_SHA256_HASH_SIZE]);
+
+/**
+ * @return The cached result (NDN_SUCCESS or an error),
+ *   or NDN_VERIFY_CACHE_MISS.
+ */
+int
+ndn_verify_cache_lookup(ndn_verify_cache_t* self, const uint8_t key[NDN_SEC_SHA256_HASH_SIZE]);
+
+void
+ndn_verify_cache_insert(ndn_verify_cache_t* self, const uint8_t key[NDN_SEC_SHA256_HASH_SIZE],
+                        int result);
+
+/**
+ * Verify the ECDSA signature of a Data or signed Interest with a known key,
+ * consulting the cache first.
+ * @param self The cache, or NULL to verify without one.
+ * @return NDN_SUCCESS, NDN_SEC_FAIL_VERIFY_SIG, or a decoding error.
+ */
+int
+ndn_verify_cache_ecdsa_verify(ndn_verify_cache_t* self, const uint8_t* packet, uint32_t size,
+                              const ndn_ecc_pub_t* pub_key);
+
+/**
+ * ndn_verify_cache_ecdsa_verify without the cache.
+ * Unlike the cache, it may be called from any thread.
+ */
+int
+ndn_verify_cache_ecdsa_verify_packet(const uint8_t* packet, uint32_t size,
+                                     const ndn_ecc_pub_t* pub_key);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
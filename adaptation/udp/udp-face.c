@@ -13,7 +13,11 @@
 #include <fcntl.h>
 #include <string.h>
 #include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include "udp-face.h"
+#include "../forwarder/ingress.h"
+#include "../forwarder/nack.h"
 #include "ndn-lite/ndn-error-code.h"
 #include "ndn-lite/ndn-constants.h"
 
@@ -40,6 +44,30 @@ ndn_udp_face_construct(
 static void
 ndn_udp_face_recv(void *self, size_t param_len, void *param);
 
+static bool
+ndn_udp_face_writable(ndn_udp_face_t* self);
+
+static inline void
+ndn_udp_face_consume(ndn_udp_face_t* self, uint32_t size);
+
+static ssize_t
+ndn_udp_face_transmit(ndn_udp_face_t* self, const uint8_t* packet, uint32_t size, uint64_t congestion_mark);
+
+static int
+ndn_udp_face_enqueue(ndn_udp_face_t* self, uint8_t traffic_class, const uint8_t* packet, uint32_t size);
+
+static ndn_udp_txq_t*
+ndn_udp_face_schedule(ndn_udp_face_t* self);
+
+static void
+ndn_udp_face_flush(ndn_udp_face_t* self);
+
+static void
+ndn_udp_face_release(ndn_udp_face_t* self);
+
+static bool
+ndn_udp_face_prepare_rx(ndn_udp_face_t* self, int count);
+
 /////////////////////////// /////////////////////////// ///////////////////////////
 
 static int
@@ -109,6 +137,7 @@ ndn_udp_face_down(struct ndn_face_intf* self){
     ptr->process_event = NULL;
   }
 
+  ndn_udp_face_release(ptr);
   return NDN_SUCCESS;
 }
 
@@ -116,22 +145,246 @@ static void
 ndn_udp_face_destroy(ndn_face_intf_t* self){
   ndn_face_down(self);
   ndn_forwarder_unregister_face(self);
+  ndn_nack_forget_face(self);
+  ndn_face_slab_remove(ndn_face_slab_get_instance(), ((ndn_udp_face_t*)self)->handle);
   free(self);
 }
 
 static int
 ndn_udp_face_send(ndn_face_intf_t* self, const uint8_t* packet, uint32_t size){
   ndn_udp_face_t* ptr = (ndn_udp_face_t*)self;
+  ndn_dead_nonce_list_t* dnl = ndn_ingress_get_dead_nonce_list();
   ssize_t ret;
-  ret = sendto(ptr->sock, packet, size, 0, 
-               (struct sockaddr*)&ptr->remote_addr, sizeof(ptr->remote_addr));
-  if(ret != size){
+  int iret;
+
+  if(dnl != NULL){
+    // Our own multicast Interests are looped back to us
+    ndn_dead_nonce_list_record(dnl, packet, size);
+  }
+  if(ptr->txq_total == 0 && ndn_udp_face_writable(ptr)){
+    ret = ndn_udp_face_transmit(ptr, packet, size, 0);
+    if(ret == size){
+      ndn_udp_face_consume(ptr, size);
+      ptr->counters->tx_packets ++;
+      ptr->counters->tx_bytes += size;
+      return NDN_SUCCESS;
+    }else if(ret != -1 || (errno != EWOULDBLOCK && errno != EAGAIN)){
+      return NDN_UDP_FACE_SOCKET_ERROR;
+    }
+    ptr->outq_budget = 0;
+  }
+  // A control packet may still leave before queued bulk packets
+  iret = ndn_udp_face_enqueue(ptr, ndn_traffic_class_of(packet, size), packet, size);
+  ndn_udp_face_flush(ptr);
+  return iret;
+}
+
+static bool
+ndn_udp_face_writable(ndn_udp_face_t* self){
+#if defined(__linux__) && defined(TIOCOUTQ)
+  int pending;
+
+  // Sample the send buffer only once the bytes sent since the last sample
+  // could have filled it
+  if(self->outq_budget > 0){
+    return true;
+  }
+  if(ioctl(self->sock, TIOCOUTQ, &pending) != 0){
+    return true;
+  }
+  if(pending >= NDN_UDP_SNDBUF_LIMIT){
+    return false;
+  }
+  self->outq_budget = NDN_UDP_SNDBUF_LIMIT - pending;
+#endif
+  return true;
+}
+
+static inline void
+ndn_udp_face_consume(ndn_udp_face_t* self, uint32_t size){
+  self->outq_budget = (size < self->outq_budget) ? self->outq_budget - size : 0;
+}
+
+static ssize_t
+ndn_udp_face_transmit(ndn_udp_face_t* self, const uint8_t* packet, uint32_t size, uint64_t congestion_mark){
+  uint8_t header[NDN_LP_HEADER_MAX_SIZE];
+  struct iovec iov[2];
+  struct msghdr msg;
+  ssize_t ret;
+
+  if(congestion_mark == 0){
+    return sendto(self->sock, packet, size, 0,
+                  (struct sockaddr*)&self->remote_addr, sizeof(self->remote_addr));
+  }
+
+  // Wrap in an LpPacket without copying the packet
+  iov[0].iov_base = header;
+  iov[0].iov_len = ndn_pkt_write_lp_header(header, size, congestion_mark);
+  iov[1].iov_base = (void*)packet;
+  iov[1].iov_len = size;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_name = &self->remote_addr;
+  msg.msg_namelen = sizeof(self->remote_addr);
+  msg.msg_iov = iov;
+  msg.msg_iovlen = 2;
+  ret = sendmsg(self->sock, &msg, 0);
+  if(ret > 0){
+    // Report the size of the packet itself
+    ret = (ret == (ssize_t)(iov[0].iov_len + size)) ? (ssize_t)size : 0;
+  }
+  return ret;
+}
+
+static int
+ndn_udp_face_enqueue(ndn_udp_face_t* self, uint8_t traffic_class, const uint8_t* packet, uint32_t size){
+  ndn_udp_txq_t* txq = &self->txq[traffic_class];
+  ndn_udp_tx_entry_t* entry;
+  ndn_pktbuf_t* buf;
+  ndn_pkt_peek_t peek;
+
+  if(txq->count >= NDN_UDP_TXQ_SIZE){
+    self->counters->tx_dropped ++;
+    // Tell the consumer now instead of letting its Interest time out
+    if(ndn_pkt_peek(packet, size, &peek) == NDN_SUCCESS){
+      ndn_nack_return(&peek, NDN_NACK_CONGESTION, &self->intf);
+    }
     return NDN_UDP_FACE_SOCKET_ERROR;
-  }else{
-    return NDN_SUCCESS;
+  }
+  // Shares the buffer being forwarded; copies only packets from elsewhere
+  buf = ndn_pktbuf_acquire(packet, size);
+  if(buf == NULL){
+    self->counters->tx_dropped ++;
+    return NDN_UDP_FACE_SOCKET_ERROR;
+  }
+  entry = &txq->entries[(txq->head + txq->count) % NDN_UDP_TXQ_SIZE];
+  entry->buf = buf;
+  entry->packet = (packet >= buf->data && packet < buf->data + buf->capacity) ? packet : buf->data;
+  entry->size = size;
+  txq->count ++;
+  self->txq_total ++;
+  self->counters->queue_depth = self->txq_total;
+  return NDN_SUCCESS;
+}
+
+static ndn_udp_txq_t*
+ndn_udp_face_schedule(ndn_udp_face_t* self){
+  ndn_udp_txq_t* txq = &self->txq[NDN_TRAFFIC_CLASS_CONTROL];
+
+  if(txq->count > 0){
+    return txq;
+  }
+  // Deficit round robin over the other classes. Requires txq_total > 0.
+  while(true){
+    txq = &self->txq[self->drr_cursor];
+    if(txq->count > 0 && txq->entries[txq->head].size <= txq->deficit){
+      return txq;
+    }
+    if(txq->count == 0){
+      txq->deficit = 0;
+    }
+    self->drr_cursor ++;
+    if(self->drr_cursor >= NDN_TRAFFIC_CLASS_COUNT){
+      self->drr_cursor = NDN_TRAFFIC_CLASS_CONTROL + 1;
+    }
+    txq = &self->txq[self->drr_cursor];
+    if(txq->count > 0){
+      txq->deficit += ndn_traffic_class_quantum(self->drr_cursor);
+    }
   }
 }
 
+static void
+ndn_udp_face_flush(ndn_udp_face_t* self){
+  ndn_udp_txq_t* txq;
+  ndn_udp_tx_entry_t* entry;
+  ndn_time_ms_t now;
+  uint64_t mark;
+  ssize_t ret;
+
+  while(self->txq_total > 0 && ndn_udp_face_writable(self)){
+    txq = ndn_udp_face_schedule(self);
+    entry = &txq->entries[txq->head];
+
+    // Signal the consumers of a standing queue, at most once per interval
+    mark = 0;
+    if(txq->count >= NDN_UDP_MARK_THRESHOLD){
+      now = ndn_time_now_ms();
+      if(now - self->last_mark >= NDN_UDP_MARK_INTERVAL){
+        mark = 1;
+        self->last_mark = now;
+      }
+    }
+
+    ret = ndn_udp_face_transmit(self, entry->packet, entry->size, mark);
+    if(ret == -1 && (errno == EWOULDBLOCK || errno == EAGAIN)){
+      self->outq_budget = 0;
+      return;
+    }
+    ndn_udp_face_consume(self, entry->size);
+    if(ret != entry->size){
+      self->counters->tx_dropped ++;
+    }else{
+      self->counters->tx_packets ++;
+      self->counters->tx_bytes += entry->size;
+      if(mark != 0){
+        self->counters->tx_marked ++;
+      }
+    }
+    if(txq != &self->txq[NDN_TRAFFIC_CLASS_CONTROL]){
+      txq->deficit -= entry->size;
+    }
+    ndn_pktbuf_unref(entry->buf);
+    txq->head = (txq->head + 1) % NDN_UDP_TXQ_SIZE;
+    txq->count --;
+    self->txq_total --;
+    self->counters->queue_depth = self->txq_total;
+  }
+}
+
+static void
+ndn_udp_face_release(ndn_udp_face_t* self){
+  ndn_udp_txq_t* txq;
+  int i;
+
+  for(i = 0; i < NDN_TRAFFIC_CLASS_COUNT; i ++){
+    txq = &self->txq[i];
+    while(txq->count > 0){
+      ndn_pktbuf_unref(txq->entries[txq->head].buf);
+      txq->head = (txq->head + 1) % NDN_UDP_TXQ_SIZE;
+      txq->count --;
+    }
+    txq->deficit = 0;
+  }
+  self->txq_total = 0;
+  self->counters->queue_depth = 0;
+  for(i = 0; i < NDN_UDP_BATCH_SIZE; i ++){
+    if(self->rx[i] != NULL){
+      ndn_pktbuf_unref(self->rx[i]);
+      self->rx[i] = NULL;
+    }
+  }
+}
+
+static bool
+ndn_udp_face_prepare_rx(ndn_udp_face_t* self, int count){
+  int i;
+
+  for(i = 0; i < count; i ++){
+    if(self->rx[i] != NULL && self->rx[i]->refcount > 1){
+      // Still queued on some face; leave it to them
+      ndn_pktbuf_unref(self->rx[i]);
+      self->rx[i] = NULL;
+    }
+    if(self->rx[i] == NULL){
+      self->rx[i] = ndn_pktbuf_alloc(NDN_UDP_BUFFER_SIZE);
+      if(self->rx[i] == NULL){
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 static ndn_udp_face_t*
 ndn_udp_face_construct(
   in_addr_t local_addr,
@@ -154,6 +407,13 @@ ndn_udp_face_construct(
     free(ret);
     return NULL;
   }
+  ret->handle = ndn_face_slab_insert(ndn_face_slab_get_instance(), &ret->intf);
+  if(ret->handle == NDN_FACE_HANDLE_INVALID){
+    ndn_forwarder_unregister_face(&ret->intf);
+    free(ret);
+    return NULL;
+  }
+  ret->counters = ndn_face_slab_get_counters(ndn_face_slab_get_instance(), ret->handle);
 
   ret->intf.type = NDN_FACE_TYPE_NET;
   ret->intf.state = NDN_FACE_STATE_DOWN;
@@ -174,6 +434,12 @@ ndn_udp_face_construct(
 
   ret->sock = -1;
   ret->multicast = multicast;
+  memset(ret->rx, 0, sizeof(ret->rx));
+  memset(ret->txq, 0, sizeof(ret->txq));
+  ret->txq_total = 0;
+  ret->drr_cursor = NDN_TRAFFIC_CLASS_CONTROL + 1;
+  ret->last_mark = 0;
+  ret->outq_budget = 0;
   ret->process_event = NULL;
   ndn_face_up(&ret->intf);
 
@@ -199,20 +465,78 @@ ndn_udp_multicast_face_construct(
   return ndn_udp_face_construct(local_addr, port, group_addr, port, true);
 }
 
+#if defined(__linux__)
+static void
+ndn_udp_face_recv(void *self, size_t param_len, void *param){
+  struct mmsghdr msgs[NDN_UDP_BATCH_SIZE];
+  struct iovec iovs[NDN_UDP_BATCH_SIZE];
+  ndn_udp_face_t* ptr = (ndn_udp_face_t*)self;
+  int i, count;
+
+  ndn_udp_face_flush(ptr);
+
+  while(true){
+    if(!ndn_udp_face_prepare_rx(ptr, NDN_UDP_BATCH_SIZE)){
+      break;
+    }
+    memset(msgs, 0, sizeof(msgs));
+    for(i = 0; i < NDN_UDP_BATCH_SIZE; i ++){
+      iovs[i].iov_base = ptr->rx[i]->data;
+      iovs[i].iov_len = ptr->rx[i]->capacity;
+      msgs[i].msg_hdr.msg_iov = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    count = recvmmsg(ptr->sock, msgs, NDN_UDP_BATCH_SIZE, 0, NULL);
+    if(count > 0){
+      // Some packets recved
+      for(i = 0; i < count; i ++){
+        ptr->rx[i]->size = msgs[i].msg_len;
+        ptr->counters->rx_bytes += msgs[i].msg_len;
+      }
+      ptr->counters->rx_packets += count;
+      if(ptr->multicast){
+        ndn_ingress_receive_multicast_pktbufs(&ptr->intf, ptr->rx, count);
+      }else{
+        ndn_ingress_receive_pktbufs(&ptr->intf, ptr->rx, count);
+      }
+      if(count < NDN_UDP_BATCH_SIZE){
+        break;
+      }
+    }else if(count == -1 && (errno == EWOULDBLOCK || errno == EAGAIN)){
+      // No more packet
+      break;
+    }else{
+      ndn_face_down(&ptr->intf);
+      return;
+    }
+  }
+
+  ptr->process_event = ndn_msgqueue_post(self, ndn_udp_face_recv, param_len, param);
+}
+#else
 static void
 ndn_udp_face_recv(void *self, size_t param_len, void *param){
   struct sockaddr_in client_addr;
   socklen_t addr_len = sizeof(client_addr);
   ssize_t size;
-  int ret;
   ndn_udp_face_t* ptr = (ndn_udp_face_t*)self;
 
-  while(true){
-    size = recvfrom(ptr->sock, ptr->buf, sizeof(ptr->buf), 0,
+  ndn_udp_face_flush(ptr);
+
+  while(ndn_udp_face_prepare_rx(ptr, 1)){
+    size = recvfrom(ptr->sock, ptr->rx[0]->data, ptr->rx[0]->capacity, 0,
                     (struct sockaddr*)&client_addr, &addr_len);
     if(size >= 0){
       // A packet recved
-      ret = ndn_forwarder_receive(&ptr->intf, ptr->buf, size);
+      ptr->rx[0]->size = size;
+      ptr->counters->rx_packets ++;
+      ptr->counters->rx_bytes += size;
+      if(ptr->multicast){
+        ndn_ingress_receive_multicast_pktbufs(&ptr->intf, ptr->rx, 1);
+      }else{
+        ndn_ingress_receive_pktbufs(&ptr->intf, ptr->rx, 1);
+      }
     }else if(size == -1 && (errno == EWOULDBLOCK || errno == EAGAIN)){
       // No more packet
       break;
@@ -224,3 +548,4 @@ ndn_udp_face_recv(void *self, size_t param_len, void *param){
 
   ptr->process_event = ndn_msgqueue_post(self, ndn_udp_face_recv, param_len, param);
 }
+#endif
@@ -13,6 +13,10 @@
 #include "ndn-lite/forwarder/forwarder.h"
 #include "ndn-lite/util/msg-queue.h"
 #include "../adapt-consts.h"
+#include "../forwarder/pktbuf.h"
+#include "../forwarder/face-slab.h"
+#include "../forwarder/traffic-class.h"
+#include "ndn-lite/util/uniform-time.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -23,6 +27,36 @@ extern "C" {
 // Generally MTU < 2048
 // Given that we don't cache
 #define NDN_UDP_BUFFER_SIZE 4096
+// Datagrams read per recvmmsg call
+#define NDN_UDP_BATCH_SIZE 16
+// Packets held per traffic class while the socket is busy
+#define NDN_UDP_TXQ_SIZE 64
+// Bytes allowed in the socket send buffer. Beyond that, packets wait in
+// the face, where the scheduler rather than the kernel FIFO orders them.
+#define NDN_UDP_SNDBUF_LIMIT 16384
+// Queue length at which departing packets carry a CongestionMark
+#define NDN_UDP_MARK_THRESHOLD 16
+// Minimum interval between two marks, in ms
+#define NDN_UDP_MARK_INTERVAL 100
+
+/**
+ * A queued packet: a reference to the buffer holding it.
+ */
+typedef struct ndn_udp_tx_entry {
+  ndn_pktbuf_t* buf;
+  const uint8_t* packet;
+  uint32_t size;
+} ndn_udp_tx_entry_t;
+
+/**
+ * Transmit queue of one traffic class.
+ */
+typedef struct ndn_udp_txq {
+  ndn_udp_tx_entry_t entries[NDN_UDP_TXQ_SIZE];
+  uint16_t head;
+  uint16_t count;
+  uint32_t deficit;
+} ndn_udp_txq_t;
 
 /**
  * Udp face
@@ -32,13 +66,33 @@ typedef struct ndn_udp_face {
    * The inherited interface.
    */
   ndn_face_intf_t intf;
+  ndn_face_handle_t handle;
+  ndn_face_counters_t* counters;
 
   struct sockaddr_in local_addr;
   struct sockaddr_in remote_addr;
   struct ndn_msg* process_event;
   int sock;
   bool multicast;
-  uint8_t buf[NDN_UDP_BUFFER_SIZE];
+
+  /**
+   * Receive buffers, handed to the forwarder in place.
+   */
+  ndn_pktbuf_t* rx[NDN_UDP_BATCH_SIZE];
+
+  /**
+   * Transmit queues, used only when the socket is busy.
+   * CONTROL has strict priority; the others are served by deficit round robin.
+   */
+  ndn_udp_txq_t txq[NDN_TRAFFIC_CLASS_COUNT];
+  uint32_t txq_total;
+  uint8_t drr_cursor;
+  ndn_time_ms_t last_mark;
+  /**
+   * Bytes that may still be sent before the socket send buffer is sampled
+   * again. Only reaches 0 near NDN_UDP_SNDBUF_LIMIT or after EAGAIN.
+   */
+  uint32_t outq_budget;
 } ndn_udp_face_t;
 
 ndn_udp_face_t*
@@ -14,6 +14,8 @@
 #include <fcntl.h>
 #include <string.h>
 #include "unix-face.h"
+#include "../forwarder/ingress.h"
+#include "../forwarder/nack.h"
 #include "ndn-lite/ndn-error-code.h"
 #include "ndn-lite/ndn-constants.h"
 #include "ndn-lite/encode/forwarder-helper.h"
@@ -42,12 +44,31 @@ ndn_unix_face_send(ndn_face_intf_t* self, const uint8_t* packet, uint32_t size);
 static void
 ndn_unix_face_recv(void *self, size_t param_len, void *param);
 
+static void
+ndn_unix_face_dispatch(ndn_unix_face_t* self, uint8_t* packets[], uint32_t sizes[], int count);
+
 static void
 ndn_unix_face_accept(void *self, size_t param_len, void *param);
 
 static ndn_unix_face_t*
 ndn_unix_slave_face_construct(int sock);
 
+static int
+ndn_unix_slave_face_admit(ndn_unix_face_t* self);
+
+static void
+ndn_unix_face_admit_pending(void);
+
+static void
+ndn_unix_face_watch_pending(void *self, size_t param_len, void *param);
+
+static void
+ndn_unix_face_unlink_pending(ndn_unix_face_t* face);
+
+static ndn_unix_face_t* unix_pending_head = NULL;
+static ndn_unix_face_t* unix_pending_tail = NULL;
+static uint32_t unix_pending_count = 0;
+
 /////////////////////////// /////////////////////////// ///////////////////////////
 
 static int
@@ -161,7 +182,10 @@ static void
 ndn_unix_face_destroy(ndn_face_intf_t* self){
   ndn_face_down(self);
   ndn_forwarder_unregister_face(self);
+  ndn_nack_forget_face(self);
+  ndn_face_slab_remove(ndn_face_slab_get_instance(), container_of(self, ndn_unix_face_t, intf)->handle);
   free(self);
+  ndn_unix_face_admit_pending();
 }
 
 static int
@@ -170,8 +194,11 @@ ndn_unix_face_send(ndn_face_intf_t* self, const uint8_t* packet, uint32_t size){
   ssize_t ret;
   ret = send(ptr->sock, packet, size, 0);
   if(ret != size){
+    ptr->counters->tx_dropped ++;
     return NDN_UNIX_FACE_SOCKET_ERROR;
   }else{
+    ptr->counters->tx_packets ++;
+    ptr->counters->tx_bytes += size;
     return NDN_SUCCESS;
   }
 }
@@ -192,6 +219,13 @@ ndn_unix_face_construct(const char* addr, bool client){
     free(ret);
     return NULL;
   }
+  ret->handle = ndn_face_slab_insert(ndn_face_slab_get_instance(), &ret->intf);
+  if(ret->handle == NDN_FACE_HANDLE_INVALID){
+    ndn_forwarder_unregister_face(&ret->intf);
+    free(ret);
+    return NULL;
+  }
+  ret->counters = ndn_face_slab_get_counters(ndn_face_slab_get_instance(), ret->handle);
 
   ret->intf.type = NDN_FACE_TYPE_APP;
   ret->intf.state = NDN_FACE_STATE_DOWN;
@@ -217,6 +251,7 @@ ndn_unix_face_construct(const char* addr, bool client){
   ret->sock = -1;
   ret->offset = 0;
   ret->process_event = NULL;
+  ret->next_pending = NULL;
   ndn_face_up(&ret->intf);
 
   return ret;
@@ -225,23 +260,22 @@ ndn_unix_face_construct(const char* addr, bool client){
 static ndn_unix_face_t*
 ndn_unix_slave_face_construct(int sock){
   ndn_unix_face_t* ret;
-  int iret;
 
   ret = (ndn_unix_face_t*)malloc(sizeof(ndn_unix_face_t));
   if(!ret){
     return NULL;
   }
 
-  ret->intf.face_id = NDN_INVALID_ID;
-  iret = ndn_forwarder_register_face(&ret->intf);
-  if(iret != NDN_SUCCESS){
+  ret->handle = ndn_face_slab_insert(ndn_face_slab_get_instance(), &ret->intf);
+  if(ret->handle == NDN_FACE_HANDLE_INVALID){
     free(ret);
     return NULL;
   }
-  //printf("New face registered %d\n", ret->intf.face_id);
+  ret->counters = ndn_face_slab_get_counters(ndn_face_slab_get_instance(), ret->handle);
 
+  ret->intf.face_id = NDN_INVALID_ID;
   ret->intf.type = NDN_FACE_TYPE_APP;
-  ret->intf.state = NDN_FACE_STATE_UP;
+  ret->intf.state = NDN_FACE_STATE_DOWN;
   ret->intf.up = NULL;
   ret->intf.down = ndn_unix_slave_face_down;
   ret->intf.send = ndn_unix_face_send;
@@ -250,30 +284,165 @@ ndn_unix_slave_face_construct(int sock){
   ret->client = false;
   ret->sock = sock;
   ret->offset = 0;
-  ret->process_event = ndn_msgqueue_post(ret, ndn_unix_face_recv, 0, NULL);
+  ret->process_event = NULL;
+  ret->next_pending = NULL;
+
+  if(unix_pending_count == 0 && ndn_unix_slave_face_admit(ret) == NDN_SUCCESS){
+    return ret;
+  }
+
+  // No face id available: keep the connection and admit it later.
+  // Its packets wait in the socket; only a hangup is watched for.
+  if(unix_pending_count >= NDN_UNIX_MAX_PENDING){
+    ndn_face_slab_remove(ndn_face_slab_get_instance(), ret->handle);
+    free(ret);
+    return NULL;
+  }
+  ret->process_event = ndn_msgqueue_post(ret, ndn_unix_face_watch_pending, 0, NULL);
   if(ret->process_event == NULL){
-    ndn_face_down(&ret->intf);
+    ndn_face_slab_remove(ndn_face_slab_get_instance(), ret->handle);
+    free(ret);
     return NULL;
   }
-
+  if(unix_pending_tail != NULL){
+    unix_pending_tail->next_pending = ret;
+  }else{
+    unix_pending_head = ret;
+  }
+  unix_pending_tail = ret;
+  unix_pending_count ++;
   return ret;
 }
 
+static int
+ndn_unix_slave_face_admit(ndn_unix_face_t* self){
+  struct ndn_msg* event;
+  int ret;
+
+  self->intf.face_id = NDN_INVALID_ID;
+  ret = ndn_forwarder_register_face(&self->intf);
+  if(ret != NDN_SUCCESS){
+    return ret;
+  }
+  //printf("New face registered %d\n", self->intf.face_id);
+
+  event = ndn_msgqueue_post(self, ndn_unix_face_recv, 0, NULL);
+  if(event == NULL){
+    ndn_forwarder_unregister_face(&self->intf);
+    self->intf.face_id = NDN_INVALID_ID;
+    return NDN_FWD_MSGQUEUE_FULL;
+  }
+  // Replace the hangup watch of a pending connection
+  if(self->process_event != NULL){
+    ndn_msgqueue_cancel(self->process_event);
+  }
+  self->process_event = event;
+  self->intf.state = NDN_FACE_STATE_UP;
+  return NDN_SUCCESS;
+}
+
+static void
+ndn_unix_face_admit_pending(void){
+  ndn_unix_face_t* face;
+
+  while(unix_pending_head != NULL){
+    face = unix_pending_head;
+    if(ndn_unix_slave_face_admit(face) != NDN_SUCCESS){
+      return;
+    }
+    unix_pending_head = face->next_pending;
+    if(unix_pending_head == NULL){
+      unix_pending_tail = NULL;
+    }
+    face->next_pending = NULL;
+    unix_pending_count --;
+  }
+}
+
+static void
+ndn_unix_face_unlink_pending(ndn_unix_face_t* face){
+  ndn_unix_face_t** link = &unix_pending_head;
+  ndn_unix_face_t* prev = NULL;
+
+  while(*link != NULL && *link != face){
+    prev = *link;
+    link = &prev->next_pending;
+  }
+  if(*link == NULL){
+    return;
+  }
+  *link = face->next_pending;
+  if(unix_pending_tail == face){
+    unix_pending_tail = prev;
+  }
+  face->next_pending = NULL;
+  unix_pending_count --;
+}
+
+static void
+ndn_unix_face_watch_pending(void *self, size_t param_len, void *param){
+  ndn_unix_face_t* ptr = (ndn_unix_face_t*)self;
+  uint8_t byte;
+  ssize_t size;
+
+  ptr->process_event = NULL;
+
+  // Peek so that the packets sent meanwhile are received once admitted
+  size = recv(ptr->sock, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+  if(size == 0 || (size == -1 && errno != EWOULDBLOCK && errno != EINTR)){
+    // The client hung up before it was admitted
+    ndn_unix_face_unlink_pending(ptr);
+    close(ptr->sock);
+    ndn_face_slab_remove(ndn_face_slab_get_instance(), ptr->handle);
+    free(ptr);
+    return;
+  }
+
+  ptr->process_event = ndn_msgqueue_post(self, ndn_unix_face_watch_pending, param_len, param);
+}
+
+uint32_t
+ndn_unix_face_get_pending(void){
+  return unix_pending_count;
+}
+
 static int
 ndn_unix_slave_face_down(struct ndn_face_intf* self){
   ndn_unix_face_down(self);
   ndn_forwarder_unregister_face(self);
+  ndn_face_slab_remove(ndn_face_slab_get_instance(), container_of(self, ndn_unix_face_t, intf)->handle);
   free(container_of(self, ndn_unix_face_t, intf));
   //printf("Unix face deleted %d\n", container_of(self, ndn_unix_face_t, intf)->sock);
+  ndn_unix_face_admit_pending();
   return NDN_SUCCESS;
 }
 
+static void
+ndn_unix_face_dispatch(ndn_unix_face_t* self, uint8_t* packets[], uint32_t sizes[], int count){
+  int ret, i;
+
+  if(count == 0){
+    return;
+  }
+  for(i = 0; i < count; i ++){
+    self->counters->rx_bytes += sizes[i];
+  }
+  self->counters->rx_packets += count;
+  ret = ndn_ingress_receive_batch(&self->intf, packets, sizes, count);
+  if(ret != NDN_SUCCESS){
+    printf("forwarder receive fail, error code = %d\n", ret);
+  }
+}
+
 static void
 ndn_unix_face_recv(void *self, size_t param_len, void *param){
   ndn_unix_face_t* ptr = (ndn_unix_face_t*)self;
   ssize_t size;
   uint8_t *buf, *valptr;
   uint32_t cur_type, cur_size;
+  uint8_t* packets[NDN_INGRESS_BATCH_SIZE];
+  uint32_t sizes[NDN_INGRESS_BATCH_SIZE];
+  int count;
 
   // It works without this line but I think adding is better, following the logic.
   // So ndn_face_down won't cancel a not existing event.
@@ -287,6 +456,7 @@ ndn_unix_face_recv(void *self, size_t param_len, void *param){
     printf("Some packets recved\n");
     // Some packets recved
     size += ptr->offset;
+    count = 0;
     for(buf = ptr->buf; buf < ptr->buf + size; buf += cur_size){
       valptr = tlv_get_type_length(buf, ptr->buf + size - buf, &cur_type, &cur_size);
       if(valptr == NULL){
@@ -296,10 +466,15 @@ ndn_unix_face_recv(void *self, size_t param_len, void *param){
       if(buf + cur_size > ptr->buf + size){
         break;
       }
-      int ret = ndn_forwarder_receive(&ptr->intf, buf, cur_size);
-      if (ret != NDN_SUCCESS)
-          printf("forwarder receive fail, error code = %d\n", ret);
+      packets[count] = buf;
+      sizes[count] = cur_size;
+      count ++;
+      if(count == NDN_INGRESS_BATCH_SIZE){
+        ndn_unix_face_dispatch(ptr, packets, sizes, count);
+        count = 0;
+      }
     }
+    ndn_unix_face_dispatch(ptr, packets, sizes, count);
     if(buf < ptr->buf + size){
       // TODO: Too large packets will block the receive.
       memcpy(ptr->buf, buf, ptr->buf + size - buf);
@@ -325,6 +500,10 @@ ndn_unix_face_accept(void *self, size_t param_len, void *param){
 
   ptr->process_event = NULL;
 
+  if(unix_pending_head != NULL){
+    ndn_unix_face_admit_pending();
+  }
+
   ret = accept(ptr->sock, NULL, NULL);
   if(ret >= 0){
     //printf("New face created %d\n", ret);
@@ -14,6 +14,7 @@
 #include "ndn-lite/forwarder/forwarder.h"
 #include "ndn-lite/util/msg-queue.h"
 #include "../adapt-consts.h"
+#include "../forwarder/face-slab.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -23,6 +24,9 @@ extern "C" {
 // Given that we don't cache
 #define NDN_UNIX_BUFFER_SIZE 4096
 
+// Maximum number of accepted connections waiting for a forwarder face id
+#define NDN_UNIX_MAX_PENDING 256
+
 /**
  * Unix Socket face (client)
  */
@@ -31,6 +35,8 @@ typedef struct ndn_unix_face {
    * The inherited interface.
    */
   ndn_face_intf_t intf;
+  ndn_face_handle_t handle;
+  ndn_face_counters_t* counters;
 
   struct sockaddr_un addr;
   struct ndn_msg* process_event;
@@ -40,11 +46,25 @@ typedef struct ndn_unix_face {
   uint32_t offset;
 
   bool client;
+
+  /**
+   * Next accepted connection waiting for admission.
+   */
+  struct ndn_unix_face* next_pending;
 } ndn_unix_face_t;
 
 ndn_unix_face_t*
 ndn_unix_face_construct(const char* addr, bool client);
 
+/**
+ * Number of accepted connections waiting for a free forwarder face id.
+ * They are admitted in order as other faces are unregistered, and their
+ * packets are read from the socket then. A connection closed by its client
+ * while waiting is dropped.
+ */
+uint32_t
+ndn_unix_face_get_pending(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * AES kernel microbenchmark.
+ * Runs CBC, CTR and CCM over one buffer at each level of aes-kernels the CPU
+ * supports. Each level is first checked against the NIST SP 800-38A and
+ * SP 800-38C examples.
+ *
+ *   aes-bench [buffer size]
+ *
+ * Build with CMAKE_BUILD_TYPE=RELEASE; intrinsics are not inlined at -O0.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ndn-lite.h"
+#include "ndn-lite/ndn-error-code.h"
+
+#define BENCH_DEFAULT_SIZE (1024 * 1024)
+#define BENCH_ROUNDS 20
+#define BENCH_TAG_SIZE 16
+#define BENCH_NONCE_SIZE 12
+
+static uint32_t buffer_size = BENCH_DEFAULT_SIZE;
+static uint8_t* plain;
+static uint8_t* cipher;
+static ndn_aes_kernels_key_t bench_key;
+
+static const char* const level_names[] = {"software", "aes-ni", "armv8"};
+
+// SP 800-38A F.2.1 and F.5.1, AES-128
+static const uint8_t kat_key[] = {
+  0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c,
+};
+static const uint8_t kat_plain[] = {
+  0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+  0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+  0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+  0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10,
+};
+static const uint8_t kat_cbc_iv[] = {
+  0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+};
+static const uint8_t kat_cbc[] = {
+  0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46, 0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d,
+  0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee, 0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2,
+  0x73, 0xbe, 0xd6, 0xb8, 0xe3, 0xc1, 0x74, 0x3b, 0x71, 0x16, 0xe6, 0x9e, 0x22, 0x22, 0x95, 0x16,
+  0x3f, 0xf1, 0xca, 0xa1, 0x68, 0x1f, 0xac, 0x09, 0x12, 0x0e, 0xca, 0x30, 0x75, 0x86, 0xe1, 0xa7,
+};
+static const uint8_t kat_ctr_counter[] = {
+  0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff,
+};
+static const uint8_t kat_ctr[] = {
+  0x87, 0x4d, 0x61, 0x91, 0xb6, 0x20, 0xe3, 0x26, 0x1b, 0xef, 0x68, 0x64, 0x99, 0x0d, 0xb6, 0xce,
+  0x98, 0x06, 0xf6, 0x6b, 0x79, 0x70, 0xfd, 0xff, 0x86, 0x17, 0x18, 0x7b, 0xb9, 0xff, 0xfd, 0xff,
+  0x5a, 0xe4, 0xdf, 0x3e, 0xdb, 0xd5, 0xd3, 0x5e, 0x5b, 0x4f, 0x09, 0x02, 0x0d, 0xb0, 0x3e, 0xab,
+  0x1e, 0x03, 0x1d, 0xda, 0x2f, 0xbe, 0x03, 0xd1, 0x79, 0x21, 0x70, 0xa0, 0xf3, 0x00, 0x9c, 0xee,
+};
+
+// SP 800-38C C.2, Example 2
+static const uint8_t kat_ccm_key[] = {
+  0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0x4f,
+};
+static const uint8_t kat_ccm_nonce[] = {
+  0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+};
+static const uint8_t kat_ccm_aad[] = {
+  0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+};
+static const uint8_t kat_ccm_plain[] = {
+  0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f,
+};
+// Ciphertext and a 6-byte tag
+static const uint8_t kat_ccm[] = {
+  0xd2, 0xa1, 0xf0, 0xe0, 0x51, 0xea, 0x5f, 0x62, 0x08, 0x1a, 0x77, 0x92, 0x07, 0x3d, 0x59, 0x3d,
+  0x1f, 0xc6, 0x4f, 0xbf, 0xac, 0xcd,
+};
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+static double
+bench_now(void){
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static int
+bench_check(void){
+  ndn_aes_kernels_key_t key;
+  uint8_t out[sizeof(kat_plain)], back[sizeof(kat_plain)], counter[NDN_AES_KERNELS_BLOCK_SIZE];
+  uint32_t tag_size = sizeof(kat_ccm) - sizeof(kat_ccm_plain);
+  int ret = 0;
+
+  if(ndn_aes_kernels_set_key(&key, kat_key, sizeof(kat_key)) != NDN_SUCCESS){
+    return -1;
+  }
+  ret |= ndn_aes_kernels_cbc_encrypt(&key, kat_cbc_iv, kat_plain, out, sizeof(kat_plain));
+  ret |= memcmp(out, kat_cbc, sizeof(kat_cbc));
+  ret |= ndn_aes_kernels_cbc_decrypt(&key, kat_cbc_iv, kat_cbc, back, sizeof(kat_cbc));
+  ret |= memcmp(back, kat_plain, sizeof(kat_plain));
+
+  // Two calls, so that the counter is carried over
+  memcpy(counter, kat_ctr_counter, sizeof(counter));
+  ndn_aes_kernels_ctr(&key, counter, kat_plain, out, NDN_AES_KERNELS_BLOCK_SIZE);
+  ndn_aes_kernels_ctr(&key, counter, kat_plain + NDN_AES_KERNELS_BLOCK_SIZE,
+                      out + NDN_AES_KERNELS_BLOCK_SIZE, sizeof(kat_plain) - NDN_AES_KERNELS_BLOCK_SIZE);
+  ret |= memcmp(out, kat_ctr, sizeof(kat_ctr));
+
+  if(ndn_aes_kernels_set_key(&key, kat_ccm_key, sizeof(kat_ccm_key)) != NDN_SUCCESS){
+    return -1;
+  }
+  ret |= ndn_aes_kernels_ccm_encrypt(&key, kat_ccm_nonce, sizeof(kat_ccm_nonce),
+                                     kat_ccm_aad, sizeof(kat_ccm_aad),
+                                     kat_ccm_plain, sizeof(kat_ccm_plain), out, tag_size);
+  ret |= memcmp(out, kat_ccm, sizeof(kat_ccm));
+  ret |= ndn_aes_kernels_ccm_decrypt(&key, kat_ccm_nonce, sizeof(kat_ccm_nonce),
+                                     kat_ccm_aad, sizeof(kat_ccm_aad),
+                                     kat_ccm, sizeof(kat_ccm), back, tag_size);
+  ret |= memcmp(back, kat_ccm_plain, sizeof(kat_ccm_plain));
+  return ret ? -1 : 0;
+}
+
+static void
+bench_cbc_encrypt(void){
+  ndn_aes_kernels_cbc_encrypt(&bench_key, kat_cbc_iv, plain, cipher, buffer_size);
+}
+
+static void
+bench_cbc_decrypt(void){
+  ndn_aes_kernels_cbc_decrypt(&bench_key, kat_cbc_iv, cipher, plain, buffer_size);
+}
+
+static void
+bench_ctr(void){
+  uint8_t counter[NDN_AES_KERNELS_BLOCK_SIZE];
+
+  memcpy(counter, kat_ctr_counter, sizeof(counter));
+  ndn_aes_kernels_ctr(&bench_key, counter, plain, cipher, buffer_size);
+}
+
+static void
+bench_ccm_encrypt(void){
+  ndn_aes_kernels_ccm_encrypt(&bench_key, kat_cbc_iv, BENCH_NONCE_SIZE, NULL, 0,
+                              plain, buffer_size, cipher, BENCH_TAG_SIZE);
+}
+
+static void
+bench_row(const char* title, void (*func)(void)){
+  double begin, elapsed;
+  int r;
+
+  func();
+  begin = bench_now();
+  for(r = 0; r < BENCH_ROUNDS; r ++){
+    func();
+  }
+  elapsed = bench_now() - begin;
+  printf("  %-16s %10.1f MB/s\n", title, (double)buffer_size * BENCH_ROUNDS / elapsed / 1e6);
+}
+
+int
+main(int argc, char *argv[]){
+  uint32_t i;
+  int best, level;
+
+  if(argc > 1){
+    buffer_size = (uint32_t)strtoul(argv[1], NULL, 10);
+  }
+  if(buffer_size == 0 || buffer_size % NDN_AES_KERNELS_BLOCK_SIZE != 0){
+    fprintf(stderr, "Usage: %s [buffer size, a multiple of %d]\n", argv[0], NDN_AES_KERNELS_BLOCK_SIZE);
+    return -1;
+  }
+
+  plain = (uint8_t*)malloc(buffer_size);
+  cipher = (uint8_t*)malloc(buffer_size + BENCH_TAG_SIZE);
+  if(plain == NULL || cipher == NULL){
+    fprintf(stderr, "ERROR: out of memory\n");
+    return -1;
+  }
+  for(i = 0; i < buffer_size; i ++){
+    plain[i] = (uint8_t)(i * 131);
+  }
+  if(ndn_aes_kernels_set_key(&bench_key, kat_key, sizeof(kat_key)) != NDN_SUCCESS){
+    fprintf(stderr, "ERROR: cannot set the key\n");
+    return -1;
+  }
+
+  best = ndn_aes_kernels_get_level();
+  printf("%u bytes, %d rounds\n", buffer_size, BENCH_ROUNDS);
+  for(level = NDN_AES_KERNELS_SOFTWARE; level <= best; level ++){
+    if(ndn_aes_kernels_select(level) != level){
+      continue;
+    }
+    printf("%s\n", level_names[level]);
+    if(bench_check() != 0){
+      fprintf(stderr, "ERROR: %s gives wrong results\n", level_names[level]);
+      return -1;
+    }
+    bench_row("cbc encrypt", bench_cbc_encrypt);
+    bench_row("cbc decrypt", bench_cbc_decrypt);
+    bench_row("ctr", bench_ctr);
+    bench_row("ccm encrypt", bench_ccm_encrypt);
+  }
+  ndn_aes_kernels_select(best);
+  return 0;
+}
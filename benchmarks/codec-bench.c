@@ -0,0 +1,361 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * TLV codec microbenchmark.
+ * Compares the byte-at-a-time varint codec and if-chain field lookup that
+ * pkt-peek and pkt-view used to have against the current implementation.
+ *
+ *   codec-bench [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ndn-lite/ndn-enums.h"
+#include "ndn-lite/ndn-error-code.h"
+#include "ndn-lite/security/ndn-lite-sha.h"
+#include "adaptation/forwarder/pkt-peek.h"
+#include "adaptation/forwarder/pkt-view.h"
+
+#define BENCH_DEFAULT_ITERATIONS 2000000
+
+typedef uint32_t (*bench_func)(uint32_t i);
+
+static uint8_t interest_wire[256];
+static uint32_t interest_size;
+static uint8_t data_wire[1400];
+static uint32_t data_size;
+static uint8_t encode_buf[256];
+// Keeps the compiler from dropping the measured work
+static volatile uint32_t bench_sink;
+
+// The old codec lived in another translation unit, so it is not inlined here either
+static const uint8_t*
+legacy_read_var(const uint8_t* buf, const uint8_t* end, uint64_t* value) __attribute__((noinline));
+
+static const uint8_t*
+legacy_read_tl(const uint8_t* buf, const uint8_t* end, uint32_t* type, uint32_t* length) __attribute__((noinline));
+
+static uint32_t
+legacy_write_var(uint8_t* buf, uint64_t value) __attribute__((noinline));
+
+static uint32_t
+legacy_write_uint(uint8_t* buf, uint32_t type, uint64_t value) __attribute__((noinline));
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+static const uint8_t*
+legacy_read_var(const uint8_t* buf, const uint8_t* end, uint64_t* value){
+  int i, len;
+
+  if(buf >= end){
+    return NULL;
+  }
+  if(*buf < 253){
+    *value = *buf;
+    return buf + 1;
+  }
+  len = (*buf == 253) ? 2 : (*buf == 254) ? 4 : 8;
+  buf ++;
+  if(end - buf < len){
+    return NULL;
+  }
+  *value = 0;
+  for(i = 0; i < len; i ++){
+    *value = (*value << 8) | buf[i];
+  }
+  return buf + len;
+}
+
+static const uint8_t*
+legacy_read_tl(const uint8_t* buf, const uint8_t* end, uint32_t* type, uint32_t* length){
+  uint64_t t, l;
+
+  buf = legacy_read_var(buf, end, &t);
+  if(buf == NULL){
+    return NULL;
+  }
+  buf = legacy_read_var(buf, end, &l);
+  if(buf == NULL || l > (uint64_t)(end - buf)){
+    return NULL;
+  }
+  *type = (uint32_t)t;
+  *length = (uint32_t)l;
+  return buf;
+}
+
+static uint32_t
+legacy_write_var(uint8_t* buf, uint64_t value){
+  int i, len;
+
+  if(value < 253){
+    buf[0] = (uint8_t)value;
+    return 1;
+  }
+  if(value <= 0xFFFF){
+    buf[0] = 253;
+    len = 2;
+  }else if(value <= 0xFFFFFFFFu){
+    buf[0] = 254;
+    len = 4;
+  }else{
+    buf[0] = 255;
+    len = 8;
+  }
+  for(i = len; i > 0; i --){
+    buf[i] = (uint8_t)value;
+    value >>= 8;
+  }
+  return len + 1;
+}
+
+static uint32_t
+legacy_write_uint(uint8_t* buf, uint32_t type, uint64_t value){
+  uint32_t ret, i, size = 1;
+
+  while(size < 8 && (value >> (8 * size)) != 0){
+    size ++;
+  }
+  size = (size <= 2) ? size : (size <= 4) ? 4 : 8;
+  ret = legacy_write_var(buf, type);
+  ret += legacy_write_var(buf + ret, size);
+  for(i = size; i > 0; i --){
+    buf[ret + i - 1] = (uint8_t)value;
+    value >>= 8;
+  }
+  return ret + size;
+}
+
+static uint32_t
+legacy_decode_interest(uint32_t i){
+  const uint8_t *ptr, *val, *end;
+  uint32_t type, length, ret = 0;
+  int j;
+
+  (void)i;
+  ptr = legacy_read_tl(interest_wire, interest_wire + interest_size, &type, &length);
+  end = ptr + length;
+  for(; ptr < end; ptr = val + length){
+    val = legacy_read_tl(ptr, end, &type, &length);
+    if(val == NULL){
+      return 0;
+    }
+    if(type == TLV_Name){
+      ret += length;
+    }else if(type == TLV_CanBePrefix || type == TLV_MustBeFresh){
+      ret ++;
+    }else if(type == TLV_Nonce && length == 4){
+      ret += ((uint32_t)val[0] << 24) | ((uint32_t)val[1] << 16) | ((uint32_t)val[2] << 8) | val[3];
+    }else if(type == TLV_InterestLifetime){
+      for(j = 0; j < (int)length; j ++){
+        ret += val[j];
+      }
+    }else if(type == TLV_HopLimit){
+      ret += val[0];
+    }else if(type == TLV_ApplicationParameters){
+      ret += length;
+      break;
+    }
+  }
+  return ret;
+}
+
+static uint32_t
+view_decode_interest(uint32_t i){
+  ndn_interest_view_t view;
+
+  (void)i;
+  if(ndn_interest_view_parse(&view, interest_wire, interest_size) != NDN_SUCCESS){
+    return 0;
+  }
+  return view.name_size + view.can_be_prefix + view.must_be_fresh + view.nonce +
+         (uint32_t)view.lifetime + view.hop_limit + view.parameters_size;
+}
+
+static uint32_t
+legacy_decode_data(uint32_t i){
+  const uint8_t *ptr, *val, *end;
+  uint32_t type, length, ret = 0;
+
+  (void)i;
+  ptr = legacy_read_tl(data_wire, data_wire + data_size, &type, &length);
+  end = ptr + length;
+  for(; ptr < end; ptr = val + length){
+    val = legacy_read_tl(ptr, end, &type, &length);
+    if(val == NULL){
+      return 0;
+    }
+    if(type == TLV_Name){
+      ret += length;
+    }else if(type == TLV_MetaInfo){
+      ret += length;
+    }else if(type == TLV_Content){
+      ret += length;
+    }else if(type == TLV_SignatureInfo){
+      ret += length;
+    }else if(type == TLV_SignatureValue){
+      ret += length;
+    }
+  }
+  return ret;
+}
+
+static uint32_t
+view_decode_data(uint32_t i){
+  ndn_data_view_t view;
+
+  (void)i;
+  if(ndn_data_view_parse(&view, data_wire, data_size) != NDN_SUCCESS){
+    return 0;
+  }
+  return view.name_size + view.meta_info_size + view.content_size +
+         view.signature_info_size + view.signature_value_size;
+}
+
+static uint32_t
+legacy_encode_interest(uint32_t i){
+  uint32_t ret;
+
+  ret = legacy_write_var(encode_buf, TLV_Interest);
+  ret += legacy_write_var(encode_buf + ret, 300 + (i & 0xFF));
+  ret += legacy_write_uint(encode_buf + ret, TLV_Nonce, 0x10000000u + i);
+  ret += legacy_write_uint(encode_buf + ret, TLV_InterestLifetime, 4000);
+  ret += legacy_write_uint(encode_buf + ret, TLV_HopLimit, i & 0x3F);
+  ret += legacy_write_var(encode_buf + ret, TLV_ApplicationParameters);
+  ret += legacy_write_var(encode_buf + ret, 70000 + i);
+  return ret + encode_buf[i & 0x1F];
+}
+
+static uint32_t
+fast_encode_interest(uint32_t i){
+  uint32_t ret;
+
+  ret = ndn_pkt_write_var(encode_buf, TLV_Interest);
+  ret += ndn_pkt_write_var(encode_buf + ret, 300 + (i & 0xFF));
+  ret += ndn_pkt_write_uint(encode_buf + ret, TLV_Nonce, 0x10000000u + i);
+  ret += ndn_pkt_write_uint(encode_buf + ret, TLV_InterestLifetime, 4000);
+  ret += ndn_pkt_write_uint(encode_buf + ret, TLV_HopLimit, i & 0x3F);
+  ret += ndn_pkt_write_var(encode_buf + ret, TLV_ApplicationParameters);
+  ret += ndn_pkt_write_var(encode_buf + ret, 70000 + i);
+  return ret + encode_buf[i & 0x1F];
+}
+
+static double
+bench_run(bench_func func, uint32_t iterations){
+  struct timespec begin, end;
+  uint32_t i, sum = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &begin);
+  for(i = 0; i < iterations; i ++){
+    sum += func(i);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  bench_sink = sum;
+  return ((end.tv_sec - begin.tv_sec) * 1e9 + (end.tv_nsec - begin.tv_nsec)) / iterations;
+}
+
+static void
+bench_compare(const char* title, bench_func before, bench_func after, uint32_t iterations){
+  double before_ns = bench_run(before, iterations);
+  double after_ns = bench_run(after, iterations);
+
+  printf("%-18s %10.1f %10.1f %8.2fx\n", title, before_ns, after_ns, before_ns / after_ns);
+}
+
+static uint32_t
+bench_write_name(uint8_t* buf){
+  const char* comps[] = {"ndn", "edu", "ucla", "bench", "codec", "file.bin", "v=1572300000"};
+  uint8_t value[128];
+  uint32_t i, len, size = 0, ret;
+
+  for(i = 0; i < sizeof(comps) / sizeof(comps[0]); i ++){
+    len = (uint32_t)strlen(comps[i]);
+    size += ndn_pkt_write_var(value + size, TLV_GenericNameComponent);
+    size += ndn_pkt_write_var(value + size, len);
+    memcpy(value + size, comps[i], len);
+    size += len;
+  }
+  size += ndn_pkt_write_uint(value + size, NDN_PKT_VIEW_SEGMENT_COMPONENT, 42);
+  ret = ndn_pkt_write_var(buf, TLV_Name);
+  ret += ndn_pkt_write_var(buf + ret, size);
+  memcpy(buf + ret, value, size);
+  return ret + size;
+}
+
+static void
+bench_prepare(void){
+  uint8_t body[1400];
+  uint32_t size;
+
+  // Interest: Name CanBePrefix MustBeFresh Nonce InterestLifetime HopLimit
+  size = bench_write_name(body);
+  body[size ++] = TLV_CanBePrefix;
+  body[size ++] = 0;
+  body[size ++] = TLV_MustBeFresh;
+  body[size ++] = 0;
+  size += ndn_pkt_write_var(body + size, TLV_Nonce);
+  size += ndn_pkt_write_var(body + size, 4);
+  ndn_pkt_store_be32(body + size, 0x12345678);
+  size += 4;
+  size += ndn_pkt_write_uint(body + size, TLV_InterestLifetime, 4000);
+  size += ndn_pkt_write_uint(body + size, TLV_HopLimit, 32);
+  interest_size = ndn_pkt_write_var(interest_wire, TLV_Interest);
+  interest_size += ndn_pkt_write_var(interest_wire + interest_size, size);
+  memcpy(interest_wire + interest_size, body, size);
+  interest_size += size;
+
+  // Data: Name MetaInfo Content(1 KB) SignatureInfo SignatureValue(digest)
+  size = bench_write_name(body);
+  body[size ++] = TLV_MetaInfo;
+  body[size ++] = 6;
+  size += ndn_pkt_write_uint(body + size, TLV_ContentType, NDN_CONTENT_TYPE_BLOB);
+  size += ndn_pkt_write_uint(body + size, TLV_FreshnessPeriod, 10);
+  size += ndn_pkt_write_var(body + size, TLV_Content);
+  size += ndn_pkt_write_var(body + size, 1024);
+  memset(body + size, 0xA5, 1024);
+  size += 1024;
+  size += ndn_pkt_write_var(body + size, TLV_SignatureInfo);
+  size += ndn_pkt_write_var(body + size, 3);
+  size += ndn_pkt_write_uint(body + size, TLV_SignatureType, NDN_SIG_TYPE_DIGEST_SHA256);
+  size += ndn_pkt_write_var(body + size, TLV_SignatureValue);
+  size += ndn_pkt_write_var(body + size, NDN_SEC_SHA256_HASH_SIZE);
+  memset(body + size, 0x5A, NDN_SEC_SHA256_HASH_SIZE);
+  size += NDN_SEC_SHA256_HASH_SIZE;
+  data_size = ndn_pkt_write_var(data_wire, TLV_Data);
+  data_size += ndn_pkt_write_var(data_wire + data_size, size);
+  memcpy(data_wire + data_size, body, size);
+  data_size += size;
+}
+
+int
+main(int argc, char *argv[]){
+  uint32_t iterations = BENCH_DEFAULT_ITERATIONS;
+
+  if(argc > 1){
+    iterations = (uint32_t)strtoul(argv[1], NULL, 10);
+    if(iterations == 0){
+      fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+      return -1;
+    }
+  }
+  bench_prepare();
+  if(legacy_decode_interest(0) == 0 || view_decode_interest(0) == 0 ||
+     legacy_decode_data(0) == 0 || view_decode_data(0) == 0){
+    fprintf(stderr, "ERROR: malformed benchmark packets\n");
+    return -1;
+  }
+
+  printf("%u iterations, ns/packet\n", iterations);
+  printf("%-18s %10s %10s %9s\n", "", "before", "after", "speedup");
+  bench_compare("encode Interest", legacy_encode_interest, fast_encode_interest, iterations);
+  bench_compare("decode Interest", legacy_decode_interest, view_decode_interest, iterations);
+  bench_compare("decode Data", legacy_decode_data, view_decode_data, iterations);
+  return 0;
+}
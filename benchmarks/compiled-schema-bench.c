@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * Compiled trust schema microbenchmark.
+ * Checks (data name, key name) pairs against schemas with more and more
+ * rules, once with every pair new to the memo and once with a repeated pair.
+ * Checks first that the matcher gives the documented results.
+ *
+ *   compiled-schema-bench [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ndn-lite/ndn-error-code.h"
+#include "adaptation/forwarder/name-kernels.h"
+#include "adaptation/security/compiled-schema.h"
+
+#define BENCH_DEFAULT_ITERATIONS 1000000
+// Distinct pairs cycled through; more than the memo holds
+#define BENCH_PAIRS 64
+#define BENCH_URI_SIZE 128
+
+static const uint32_t rule_counts[] = {1, 16, 64, 256};
+static uint8_t data_wires[BENCH_PAIRS][NDN_NAME_KERNELS_URI_BUFFER_SIZE];
+static uint32_t data_sizes[BENCH_PAIRS];
+static uint8_t key_wires[BENCH_PAIRS][NDN_NAME_KERNELS_URI_BUFFER_SIZE];
+static uint32_t key_sizes[BENCH_PAIRS];
+// Keeps the compiler from dropping the measured work
+static volatile uint32_t bench_sink;
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+static int
+bench_encode(uint8_t* wire, uint32_t* size, const char* format, uint32_t room, uint32_t device){
+  char uri[BENCH_URI_SIZE];
+  int length;
+
+  length = snprintf(uri, sizeof(uri), format, room, device);
+  return ndn_name_kernels_parse_uri(uri, (uint32_t)length, wire, NDN_NAME_KERNELS_URI_BUFFER_SIZE, size);
+}
+
+static int
+bench_expect(ndn_compiled_schema_t* schema, const char* data_uri, const char* key_uri, int expected){
+  uint8_t data[NDN_NAME_KERNELS_URI_BUFFER_SIZE], key[NDN_NAME_KERNELS_URI_BUFFER_SIZE];
+  uint32_t data_size, key_size;
+  int ret;
+
+  if(ndn_name_kernels_parse_uri(data_uri, strlen(data_uri), data, sizeof(data), &data_size) != NDN_SUCCESS ||
+     ndn_name_kernels_parse_uri(key_uri, strlen(key_uri), key, sizeof(key), &key_size) != NDN_SUCCESS){
+    fprintf(stderr, "ERROR: cannot encode %s or %s\n", data_uri, key_uri);
+    return -1;
+  }
+  ret = ndn_compiled_schema_check(schema, data, data_size, key, key_size);
+  if(ret != expected){
+    fprintf(stderr, "ERROR: %s signed by %s: %d, expected %d\n", data_uri, key_uri, ret, expected);
+    return -1;
+  }
+  return 0;
+}
+
+static int
+bench_check(void){
+  ndn_compiled_schema_t schema;
+  int ret = 0;
+
+  if(ndn_compiled_schema_init(&schema, NDN_COMPILED_SCHEMA_MEMO_WAYS) != NDN_SUCCESS){
+    return -1;
+  }
+  // Parts between the first and the last <>* take their leftmost match
+  ndn_compiled_schema_add_rule(&schema, "(<>*)<x><>*", "\\1<KEY><>");
+  ndn_compiled_schema_add_rule(&schema, "<home>(<room-1><>)<sensor><>*", "<home>\\1<KEY><>");
+  ret |= bench_expect(&schema, "/a/x/b/x/c", "/a/KEY/1", NDN_SUCCESS);
+  ret |= bench_expect(&schema, "/a/x/b/x/c", "/a/x/b/KEY/1", NDN_SEC_FAIL_VERIFY_SIG);
+  ret |= bench_expect(&schema, "/home/room-1/tv/sensor/light", "/home/room-1/tv/KEY/1", NDN_SUCCESS);
+  ret |= bench_expect(&schema, "/home/room-1/tv/sensor/light", "/home/room-1/fan/KEY/1", NDN_SEC_FAIL_VERIFY_SIG);
+  ret |= bench_expect(&schema, "/home/room-2/tv/sensor/light", "/home/room-2/tv/KEY/1", NDN_SEC_FAIL_VERIFY_SIG);
+  ndn_compiled_schema_destroy(&schema);
+
+  // 2^13 states: not compiled, and every rule is checked instead
+  if(ndn_compiled_schema_init(&schema, NDN_COMPILED_SCHEMA_MEMO_WAYS) != NDN_SUCCESS){
+    return -1;
+  }
+  ndn_compiled_schema_add_rule(&schema, "<>*<a><><><><><><><><><><><><><>", "<>*");
+  if(ndn_compiled_schema_compile(&schema) != NDN_OVERSIZE || !schema.oversize){
+    fprintf(stderr, "ERROR: oversized schema compiled\n");
+    ret = -1;
+  }
+  ret |= bench_expect(&schema, "/z/a/1/2/3/4/5/6/7/8/9/10/11/12/13", "/k", NDN_SUCCESS);
+  ret |= bench_expect(&schema, "/z/b/1/2/3/4/5/6/7/8/9/10/11/12/13", "/k", NDN_SEC_FAIL_VERIFY_SIG);
+  ndn_compiled_schema_destroy(&schema);
+  return ret;
+}
+
+static double
+bench_run(ndn_compiled_schema_t* schema, uint32_t iterations, uint32_t pairs){
+  struct timespec begin, end;
+  uint32_t i, j, sum = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &begin);
+  for(i = 0; i < iterations; i ++){
+    j = i % pairs;
+    sum += (ndn_compiled_schema_check(schema, data_wires[j], data_sizes[j],
+                                      key_wires[j], key_sizes[j]) == NDN_SUCCESS);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  bench_sink = sum;
+  return ((end.tv_sec - begin.tv_sec) * 1e9 + (end.tv_nsec - begin.tv_nsec)) / iterations;
+}
+
+int
+main(int argc, char *argv[]){
+  uint32_t iterations = BENCH_DEFAULT_ITERATIONS, rules, r, i;
+  char data_pattern[BENCH_URI_SIZE], key_pattern[BENCH_URI_SIZE];
+  ndn_compiled_schema_t schema;
+  double fresh, memoised;
+
+  if(argc > 1){
+    iterations = (uint32_t)strtoul(argv[1], NULL, 10);
+    if(iterations == 0){
+      fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+      return -1;
+    }
+  }
+
+  if(bench_check() != 0){
+    return -1;
+  }
+  printf("%u iterations, ns/check\n", iterations);
+  printf("%-8s %8s %10s %10s\n", "rules", "states", "fresh", "memoised");
+  for(r = 0; r < sizeof(rule_counts) / sizeof(rule_counts[0]); r ++){
+    rules = rule_counts[r];
+    // A single set, so that cycling through the pairs always misses
+    if(ndn_compiled_schema_init(&schema, NDN_COMPILED_SCHEMA_MEMO_WAYS) != NDN_SUCCESS){
+      fprintf(stderr, "ERROR: out of memory\n");
+      return -1;
+    }
+    for(i = 0; i < rules; i ++){
+      snprintf(data_pattern, sizeof(data_pattern), "<home>(<room-%u><>)<sensor><>*", i);
+      snprintf(key_pattern, sizeof(key_pattern), "<home>\\1<KEY><>");
+      if(ndn_compiled_schema_add_rule(&schema, data_pattern, key_pattern) != NDN_SUCCESS){
+        fprintf(stderr, "ERROR: cannot add rule %u\n", i);
+        return -1;
+      }
+    }
+    if(ndn_compiled_schema_compile(&schema) != NDN_SUCCESS){
+      fprintf(stderr, "ERROR: cannot compile %u rules\n", rules);
+      return -1;
+    }
+    // The pairs hit the last rule added
+    for(i = 0; i < BENCH_PAIRS; i ++){
+      if(bench_encode(data_wires[i], &data_sizes[i], "/home/room-%u/device-%u/sensor/temperature/seq=1",
+                      rules - 1, i) != NDN_SUCCESS ||
+         bench_encode(key_wires[i], &key_sizes[i], "/home/room-%u/device-%u/KEY/%%01%%02",
+                      rules - 1, i) != NDN_SUCCESS){
+        fprintf(stderr, "ERROR: cannot encode the benchmark names\n");
+        return -1;
+      }
+    }
+
+    fresh = bench_run(&schema, iterations, BENCH_PAIRS);
+    memoised = bench_run(&schema, iterations, 1);
+    printf("%-8u %8u %10.1f %10.1f\n", rules, schema.state_count, fresh, memoised);
+    ndn_compiled_schema_destroy(&schema);
+  }
+  return 0;
+}
@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * Crypto pool microbenchmark.
+ * Makes DigestSha256 segments on the workers, with and without a stream,
+ * and delivers them on this thread.
+ * Checks first that a stream delivers its callbacks in order, and that a
+ * callback may destroy its own stream, after which the stream delivers nothing.
+ *
+ *   crypto-pool-bench [segments]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ndn-lite.h"
+#include "ndn-lite/ndn-error-code.h"
+#include "adaptation/forwarder/data-template.h"
+#include "adaptation/forwarder/pkt-view.h"
+#include "adaptation/security/crypto-pool.h"
+
+#define BENCH_DEFAULT_SEGMENTS 100000
+#define BENCH_CONTENT_SIZE 1024
+// Segments behind the callback that destroys their stream
+#define BENCH_CHECK_JOBS 64
+
+static ndn_data_template_t bench_template;
+static uint8_t content[BENCH_CONTENT_SIZE];
+static ndn_crypto_stream_t* bench_stream;
+static uint64_t next_segno;
+static uint32_t delivered;
+static uint32_t errors;
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+static double
+bench_now(void){
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static void
+bench_on_data(int result, const uint8_t* data, uint32_t size, void* userdata){
+  delivered ++;
+  if(result != NDN_SUCCESS){
+    errors ++;
+  }
+}
+
+// Counts the segments that come out of order
+static void
+bench_on_ordered(int result, const uint8_t* data, uint32_t size, void* userdata){
+  ndn_data_view_t view;
+  uint64_t segno;
+
+  delivered ++;
+  if(result != NDN_SUCCESS || ndn_data_view_parse(&view, data, size) != NDN_SUCCESS ||
+     ndn_name_view_segment(view.name, view.name_size, &segno) != NDN_SUCCESS ||
+     segno != next_segno){
+    errors ++;
+  }
+  next_segno ++;
+}
+
+static void
+bench_on_destroy(int result, const uint8_t* packet, uint32_t size, void* userdata){
+  delivered ++;
+  ndn_crypto_stream_destroy(bench_stream);
+}
+
+// Submits segments 0 to count - 1, and processes until they are delivered
+static int
+bench_run(ndn_crypto_stream_t* stream, uint32_t count, ndn_crypto_on_data_func on_data){
+  uint32_t i = 0;
+  int ret;
+
+  delivered = 0;
+  while(i < count){
+    ret = ndn_crypto_pool_make_segment(stream, &bench_template, i, content, sizeof(content),
+                                       on_data, NULL);
+    if(ret == NDN_SUCCESS){
+      i ++;
+    }else if(ret == NDN_FWD_MSGQUEUE_FULL){
+      ndn_forwarder_process();
+    }else{
+      return ret;
+    }
+  }
+  while(delivered < count){
+    ndn_forwarder_process();
+  }
+  return NDN_SUCCESS;
+}
+
+static int
+bench_check(void){
+  ndn_ecc_pub_t pub_key;
+  uint32_t i;
+  int ret = 0;
+
+  bench_stream = ndn_crypto_stream_create();
+  next_segno = 0;
+  errors = 0;
+  if(bench_stream == NULL ||
+     bench_run(bench_stream, NDN_CRYPTO_POOL_QUEUE_SIZE * 4, bench_on_ordered) != NDN_SUCCESS){
+    return -1;
+  }
+  if(errors > 0){
+    fprintf(stderr, "ERROR: %u segments of a stream are wrong or out of order\n", errors);
+    ret = -1;
+  }
+  ndn_crypto_stream_destroy(bench_stream);
+
+  // A malformed packet is answered without a worker, after the jobs of the
+  // workers, so its callback comes first with the segments behind it done.
+  // Shutting down runs every job before it delivers them.
+  bench_stream = ndn_crypto_stream_create();
+  delivered = 0;
+  memset(&pub_key, 0, sizeof(pub_key));
+  if(bench_stream == NULL ||
+     ndn_crypto_pool_ecdsa_verify(bench_stream, content, 1, &pub_key,
+                                  bench_on_destroy, NULL) != NDN_SUCCESS){
+    return -1;
+  }
+  for(i = 0; i < BENCH_CHECK_JOBS; i ++){
+    if(ndn_crypto_pool_make_segment(bench_stream, &bench_template, i, content, sizeof(content),
+                                    bench_on_data, NULL) != NDN_SUCCESS){
+      return -1;
+    }
+  }
+  ndn_crypto_pool_shutdown();
+  if(delivered != 1){
+    fprintf(stderr, "ERROR: %u callbacks of a stream destroyed by its first one\n", delivered);
+    ret = -1;
+  }
+  if(ndn_crypto_pool_init(0) != NDN_SUCCESS){
+    return -1;
+  }
+  return ret;
+}
+
+static int
+bench_row(const char* title, ndn_crypto_stream_t* stream, uint32_t count){
+  double begin, elapsed;
+
+  errors = 0;
+  begin = bench_now();
+  if(bench_run(stream, count, bench_on_data) != NDN_SUCCESS || errors > 0){
+    fprintf(stderr, "ERROR: cannot make the segments\n");
+    return -1;
+  }
+  elapsed = bench_now() - begin;
+  printf("  %-10s %12.0f segments/s\n", title, count / elapsed);
+  return 0;
+}
+
+int
+main(int argc, char *argv[]){
+  uint32_t segments = BENCH_DEFAULT_SEGMENTS, i;
+  ndn_name_t prefix;
+  int ret = 0;
+
+  if(argc > 1){
+    segments = (uint32_t)strtoul(argv[1], NULL, 10);
+  }
+  if(segments == 0){
+    fprintf(stderr, "Usage: %s [segments]\n", argv[0]);
+    return -1;
+  }
+
+  ndn_lite_startup();
+  for(i = 0; i < sizeof(content); i ++){
+    content[i] = (uint8_t)(i * 131);
+  }
+  ndn_name_from_string(&prefix, "/bench/crypto-pool", strlen("/bench/crypto-pool"));
+  if(ndn_data_template_init(&bench_template, &prefix, NDN_CONTENT_TYPE_BLOB, 0) != NDN_SUCCESS ||
+     ndn_crypto_pool_init(0) != NDN_SUCCESS){
+    fprintf(stderr, "ERROR: cannot start the pool\n");
+    return -1;
+  }
+  if(bench_check() != 0){
+    ndn_crypto_pool_shutdown();
+    return -1;
+  }
+
+  bench_stream = ndn_crypto_stream_create();
+  if(bench_stream == NULL){
+    ndn_crypto_pool_shutdown();
+    return -1;
+  }
+  printf("%u segments of %d bytes\n", segments, BENCH_CONTENT_SIZE);
+  if(bench_row("unordered", NULL, segments) != 0 ||
+     bench_row("stream", bench_stream, segments) != 0){
+    ret = -1;
+  }
+  ndn_crypto_stream_destroy(bench_stream);
+  ndn_crypto_pool_shutdown();
+  return ret;
+}
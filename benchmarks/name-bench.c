@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * Name kernel microbenchmark.
+ * Runs URI parsing, prefix comparison and name hashing at each level of
+ * name-kernels the CPU supports.
+ *
+ *   name-bench [iterations]
+ *
+ * Build with CMAKE_BUILD_TYPE=RELEASE; intrinsics are not inlined at -O0.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ndn-lite/ndn-error-code.h"
+#include "adaptation/forwarder/name-kernels.h"
+#include "adaptation/forwarder/pkt-peek.h"
+
+#define BENCH_DEFAULT_ITERATIONS 1000000
+
+typedef uint32_t (*bench_func)(uint32_t i);
+
+static const char bench_uri[] =
+  "/ndn/edu/ucla/cs/irl/building-4731/floor-3/room-317/temperature-sensor%2F02"
+  "/readings/2019-10-28T12%3A00%3A00/v=1572264000000/seg=42";
+static const char bench_prefix_uri[] =
+  "/ndn/edu/ucla/cs/irl/building-4731/floor-3/room-317/temperature-sensor%2F02/readings";
+static uint8_t name_wire[NDN_NAME_KERNELS_URI_BUFFER_SIZE];
+static uint32_t name_size;
+static uint8_t prefix_wire[NDN_NAME_KERNELS_URI_BUFFER_SIZE];
+static uint32_t prefix_size;
+// Keeps the compiler from dropping the measured work
+static volatile uint32_t bench_sink;
+
+static const char* const level_names[] = {"scalar", "sse4.2", "avx2"};
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+static uint32_t
+bench_parse_uri(uint32_t i){
+  uint8_t wire[NDN_NAME_KERNELS_URI_BUFFER_SIZE];
+  uint32_t used = 0;
+
+  ndn_name_kernels_parse_uri(bench_uri, sizeof(bench_uri) - 1, wire, sizeof(wire), &used);
+  return used + wire[i % used];
+}
+
+static uint32_t
+bench_is_prefix(uint32_t i){
+  (void)i;
+  return ndn_pkt_name_is_prefix(prefix_wire, prefix_size, name_wire, name_size);
+}
+
+static uint32_t
+bench_common_prefix(uint32_t i){
+  (void)i;
+  return (uint32_t)ndn_name_kernels_common_prefix(prefix_wire, prefix_size, name_wire, name_size);
+}
+
+static uint32_t
+bench_hash(uint32_t i){
+  (void)i;
+  return (uint32_t)ndn_pkt_name_hash(name_wire, name_size);
+}
+
+static double
+bench_run(bench_func func, uint32_t iterations){
+  struct timespec begin, end;
+  uint32_t i, sum = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &begin);
+  for(i = 0; i < iterations; i ++){
+    sum += func(i);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  bench_sink = sum;
+  return ((end.tv_sec - begin.tv_sec) * 1e9 + (end.tv_nsec - begin.tv_nsec)) / iterations;
+}
+
+static void
+bench_row(const char* title, bench_func func, int best, uint32_t iterations){
+  int level;
+
+  printf("%-16s", title);
+  for(level = NDN_NAME_KERNELS_SCALAR; level <= best; level ++){
+    ndn_name_kernels_select(level);
+    printf(" %10.1f", bench_run(func, iterations));
+  }
+  printf("\n");
+}
+
+int
+main(int argc, char *argv[]){
+  uint32_t iterations = BENCH_DEFAULT_ITERATIONS;
+  int best, level;
+
+  if(argc > 1){
+    iterations = (uint32_t)strtoul(argv[1], NULL, 10);
+    if(iterations == 0){
+      fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+      return -1;
+    }
+  }
+  if(ndn_name_kernels_parse_uri(bench_uri, sizeof(bench_uri) - 1, name_wire, sizeof(name_wire),
+                                &name_size) != NDN_SUCCESS ||
+     ndn_name_kernels_parse_uri(bench_prefix_uri, sizeof(bench_prefix_uri) - 1, prefix_wire,
+                                sizeof(prefix_wire), &prefix_size) != NDN_SUCCESS){
+    fprintf(stderr, "ERROR: cannot encode the benchmark names\n");
+    return -1;
+  }
+
+  best = ndn_name_kernels_get_level();
+  printf("%u iterations, ns/call, name of %u bytes\n", iterations, name_size);
+  printf("%-16s", "");
+  for(level = NDN_NAME_KERNELS_SCALAR; level <= best; level ++){
+    printf(" %10s", level_names[level]);
+  }
+  printf("\n");
+  bench_row("parse URI", bench_parse_uri, best, iterations);
+  bench_row("is prefix", bench_is_prefix, best, iterations);
+  bench_row("common prefix", bench_common_prefix, best, iterations);
+  bench_row("hash", bench_hash, best, iterations);
+  ndn_name_kernels_select(best);
+  return 0;
+}
@@ -0,0 +1,328 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * SHA-256 kernel microbenchmark.
+ * Digests segments one by one and in batches at each level of sha256-kernels
+ * the CPU supports, then makes DigestSha256 segments with a data template.
+ * Each level is first checked against the FIPS 180-2 test vectors, and the
+ * backend loaded by ndn_lite_startup, e.g. OpenSSL, against them, RFC 4231
+ * and SP 800-38A. With OpenSSL, ECDSA signatures are also checked across it
+ * and the default backend, both ways.
+ *
+ *   sha256-bench [segments] [segment size]
+ *
+ * Build with CMAKE_BUILD_TYPE=RELEASE; intrinsics are not inlined at -O0.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ndn-lite.h"
+#include "ndn-lite/ndn-error-code.h"
+#include "ndn-lite/ndn-enums.h"
+#include "ndn-lite/security/ndn-lite-sha.h"
+#include "ndn-lite/security/ndn-lite-hmac.h"
+#include "ndn-lite/security/ndn-lite-aes.h"
+#include "ndn-lite/security/ndn-lite-ecc.h"
+#ifdef NDN_LITE_OPENSSL_BACKEND
+#include "adaptation/security/ndn-lite-openssl-crypto-impl.h"
+#endif
+
+#define BENCH_DEFAULT_SEGMENTS 4096
+#define BENCH_DEFAULT_SEGMENT_SIZE 1024
+#define BENCH_ROUNDS 10
+// Room for the name, MetaInfo and signature around the content
+#define BENCH_PACKET_OVERHEAD 512
+#define BENCH_KAT_COUNT 4
+// Enough messages for every lane of digest_many, twice, and a remainder
+#define BENCH_KAT_BATCH (BENCH_KAT_COUNT * 5)
+
+static uint32_t segments = BENCH_DEFAULT_SEGMENTS;
+static uint32_t segment_size = BENCH_DEFAULT_SEGMENT_SIZE;
+static uint8_t* content;
+static const uint8_t** contents;
+static uint32_t* content_sizes;
+static uint8_t* digests;
+static uint8_t** digest_ptrs;
+static uint8_t* packets;
+static uint8_t** packet_ptrs;
+static uint32_t* packet_sizes;
+static ndn_data_template_t data_template;
+
+static const char* const level_names[] = {"software", "sha-ni", "armv8"};
+
+// FIPS 180-2 appendix B; lengths cross the 55 and 64 byte padding limits
+static const char* const kat_messages[BENCH_KAT_COUNT] = {
+  "",
+  "abc",
+  "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+  "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+};
+// RFC 4231 test case 2
+static const char kat_hmac_key[] = "Jefe";
+static const char kat_hmac_message[] = "what do ya want for nothing?";
+static const char kat_hmac[] = "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843";
+static const char* const kat_digests[BENCH_KAT_COUNT] = {
+  "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+  "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+  "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+  "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1",
+};
+// SP 800-38A F.2.1, AES-128 CBC. The backend writes IV || ciphertext.
+static const uint8_t kat_aes_key[] = {
+  0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c,
+};
+static const uint8_t kat_aes_plain[] = {
+  0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+  0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+};
+static const uint8_t kat_aes_cbc[] = {
+  0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+  0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46, 0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d,
+  0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee, 0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2,
+};
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+static double
+bench_now(void){
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static bool
+bench_kat_equal(const uint8_t* digest, const char* hex){
+  unsigned int byte;
+  uint32_t i;
+
+  for(i = 0; i < NDN_SHA256_KERNELS_DIGEST_SIZE; i ++){
+    if(sscanf(hex + i * 2, "%2x", &byte) != 1 || digest[i] != byte){
+      return false;
+    }
+  }
+  return true;
+}
+
+static int
+bench_check(void){
+  const uint8_t* data[BENCH_KAT_BATCH];
+  uint32_t sizes[BENCH_KAT_BATCH], i, k;
+  uint8_t digest_buf[BENCH_KAT_BATCH][NDN_SHA256_KERNELS_DIGEST_SIZE];
+  uint8_t* digest_list[BENCH_KAT_BATCH];
+  ndn_sha256_kernels_state_t state;
+  int ret = 0;
+
+  for(i = 0; i < BENCH_KAT_COUNT; i ++){
+    ndn_sha256_kernels_digest((const uint8_t*)kat_messages[i], strlen(kat_messages[i]), digest_buf[0]);
+    ret |= !bench_kat_equal(digest_buf[0], kat_digests[i]);
+    // Split so that the second part starts mid-block
+    k = strlen(kat_messages[i]) / 3;
+    ndn_sha256_kernels_init(&state);
+    ndn_sha256_kernels_update(&state, (const uint8_t*)kat_messages[i], k);
+    ndn_sha256_kernels_update(&state, (const uint8_t*)kat_messages[i] + k, strlen(kat_messages[i]) - k);
+    ndn_sha256_kernels_finish(&state, digest_buf[0]);
+    ret |= !bench_kat_equal(digest_buf[0], kat_digests[i]);
+  }
+  for(i = 0; i < BENCH_KAT_BATCH; i ++){
+    data[i] = (const uint8_t*)kat_messages[i % BENCH_KAT_COUNT];
+    sizes[i] = strlen(kat_messages[i % BENCH_KAT_COUNT]);
+    digest_list[i] = digest_buf[i];
+  }
+  ndn_sha256_kernels_digest_many(data, sizes, digest_list, BENCH_KAT_BATCH);
+  for(i = 0; i < BENCH_KAT_BATCH; i ++){
+    ret |= !bench_kat_equal(digest_buf[i], kat_digests[i % BENCH_KAT_COUNT]);
+  }
+  return ret ? -1 : 0;
+}
+
+static int
+bench_check_backend(void){
+  uint8_t digest[NDN_SHA256_KERNELS_DIGEST_SIZE];
+  uint8_t cipher[sizeof(kat_aes_cbc)], plain[sizeof(kat_aes_plain)];
+  ndn_hmac_key_t hmac_key;
+  ndn_aes_key_t aes_key;
+  uint32_t i, used;
+  int ret = 0;
+
+  for(i = 0; i < BENCH_KAT_COUNT; i ++){
+    ret |= ndn_sha256((const uint8_t*)kat_messages[i], strlen(kat_messages[i]), digest);
+    ret |= !bench_kat_equal(digest, kat_digests[i]);
+  }
+  ret |= ndn_hmac_key_init(&hmac_key, (const uint8_t*)kat_hmac_key, strlen(kat_hmac_key), 0);
+  ret |= ndn_hmac_sign((const uint8_t*)kat_hmac_message, strlen(kat_hmac_message),
+                       digest, sizeof(digest), &hmac_key, &used);
+  ret |= (used != sizeof(digest)) || !bench_kat_equal(digest, kat_hmac);
+
+  ret |= ndn_aes_key_init(&aes_key, kat_aes_key, sizeof(kat_aes_key), 0);
+  ret |= ndn_aes_cbc_encrypt(kat_aes_plain, sizeof(kat_aes_plain), cipher, sizeof(cipher),
+                             kat_aes_cbc, &aes_key);
+  ret |= memcmp(cipher, kat_aes_cbc, sizeof(kat_aes_cbc));
+  ret |= ndn_aes_cbc_decrypt(kat_aes_cbc, sizeof(kat_aes_cbc), plain, sizeof(plain),
+                             kat_aes_cbc, &aes_key);
+  ret |= memcmp(plain, kat_aes_plain, sizeof(kat_aes_plain));
+  return ret ? -1 : 0;
+}
+
+#ifdef NDN_LITE_OPENSSL_BACKEND
+// OpenSSL produces and takes DER signatures; so must the default backend
+static int
+bench_check_ecdsa(void){
+  const uint8_t* message = (const uint8_t*)kat_messages[2];
+  uint32_t size = strlen(kat_messages[2]);
+  uint8_t sig[NDN_DATA_TEMPLATE_MAX_SIGNATURE_SIZE];
+  ndn_ecdsa_sign_impl default_sign;
+  ndn_ecdsa_verify_impl default_verify;
+  ndn_ecc_pub_t pub;
+  ndn_ecc_prv_t prv;
+  uint32_t used;
+  int ret = 0;
+
+  ndn_lite_openssl_get_default_ecdsa(&default_sign, &default_verify);
+  if(default_sign == NULL || default_verify == NULL ||
+     ndn_ecc_make_key(&pub, &prv, NDN_ECDSA_CURVE_SECP256R1, 1) != NDN_SUCCESS){
+    return -1;
+  }
+
+  // OpenSSL signs, the default backend verifies
+  ret |= ndn_ecdsa_sign(message, size, sig, sizeof(sig), &prv, &used);
+  ret |= default_verify(message, size, sig, used, &pub.abs_key, NDN_ECDSA_CURVE_SECP256R1);
+  ret |= (default_verify(message, size - 1, sig, used, &pub.abs_key, NDN_ECDSA_CURVE_SECP256R1) == NDN_SUCCESS);
+
+  // The default backend signs, OpenSSL verifies
+  ret |= default_sign(message, size, sig, sizeof(sig), &prv.abs_key, NDN_ECDSA_CURVE_SECP256R1, &used);
+  ret |= ndn_ecdsa_verify(message, size, sig, used, &pub);
+  ret |= (ndn_ecdsa_verify(message, size - 1, sig, used, &pub) == NDN_SUCCESS);
+  return ret ? -1 : 0;
+}
+#endif
+
+static void
+bench_digest_one(void){
+  uint32_t i;
+
+  for(i = 0; i < segments; i ++){
+    ndn_sha256_kernels_digest(contents[i], content_sizes[i], digest_ptrs[i]);
+  }
+}
+
+static void
+bench_digest_many(void){
+  ndn_sha256_kernels_digest_many(contents, content_sizes, digest_ptrs, segments);
+}
+
+static void
+bench_make_segment(void){
+  uint32_t i;
+
+  for(i = 0; i < segments; i ++){
+    ndn_data_template_make_segment(&data_template, packet_ptrs[i], segment_size + BENCH_PACKET_OVERHEAD,
+                                   i, contents[i], content_sizes[i], &packet_sizes[i]);
+  }
+}
+
+static void
+bench_make_segments(void){
+  ndn_data_template_make_segments(&data_template, packet_ptrs, segment_size + BENCH_PACKET_OVERHEAD,
+                                  0, contents, content_sizes, segments, packet_sizes);
+}
+
+static void
+bench_row(const char* title, void (*func)(void)){
+  double begin, elapsed;
+  int r;
+
+  func();
+  begin = bench_now();
+  for(r = 0; r < BENCH_ROUNDS; r ++){
+    func();
+  }
+  elapsed = bench_now() - begin;
+  printf("  %-16s %10.1f MB/s %10.0f segments/s\n", title,
+         (double)segments * segment_size * BENCH_ROUNDS / elapsed / 1e6,
+         (double)segments * BENCH_ROUNDS / elapsed);
+}
+
+int
+main(int argc, char *argv[]){
+  uint32_t i;
+  int best, level;
+
+  if(argc > 1){
+    segments = (uint32_t)strtoul(argv[1], NULL, 10);
+  }
+  if(argc > 2){
+    segment_size = (uint32_t)strtoul(argv[2], NULL, 10);
+  }
+  if(segments == 0 || segment_size == 0){
+    fprintf(stderr, "Usage: %s [segments] [segment size]\n", argv[0]);
+    return -1;
+  }
+
+  content = (uint8_t*)malloc((size_t)segments * segment_size);
+  contents = (const uint8_t**)malloc(segments * sizeof(uint8_t*));
+  content_sizes = (uint32_t*)malloc(segments * sizeof(uint32_t));
+  digests = (uint8_t*)malloc((size_t)segments * NDN_SHA256_KERNELS_DIGEST_SIZE);
+  digest_ptrs = (uint8_t**)malloc(segments * sizeof(uint8_t*));
+  packets = (uint8_t*)malloc((size_t)segments * (segment_size + BENCH_PACKET_OVERHEAD));
+  packet_ptrs = (uint8_t**)malloc(segments * sizeof(uint8_t*));
+  packet_sizes = (uint32_t*)malloc(segments * sizeof(uint32_t));
+  if(content == NULL || contents == NULL || content_sizes == NULL || digests == NULL ||
+     digest_ptrs == NULL || packets == NULL || packet_ptrs == NULL || packet_sizes == NULL){
+    fprintf(stderr, "ERROR: out of memory\n");
+    return -1;
+  }
+  for(i = 0; i < segments * segment_size; i ++){
+    content[i] = (uint8_t)(i * 131);
+  }
+  for(i = 0; i < segments; i ++){
+    contents[i] = content + (size_t)i * segment_size;
+    content_sizes[i] = segment_size;
+    digest_ptrs[i] = digests + (size_t)i * NDN_SHA256_KERNELS_DIGEST_SIZE;
+    packet_ptrs[i] = packets + (size_t)i * (segment_size + BENCH_PACKET_OVERHEAD);
+  }
+  // Loads the kernels into the backend that make_segment signs with
+  ndn_lite_startup();
+  if(ndn_data_template_init(&data_template, NULL, NDN_CONTENT_TYPE_BLOB, 10000) != NDN_SUCCESS){
+    fprintf(stderr, "ERROR: cannot make the data template\n");
+    return -1;
+  }
+
+  if(bench_check_backend() != 0){
+    fprintf(stderr, "ERROR: the security backend gives wrong results\n");
+    return -1;
+  }
+#ifdef NDN_LITE_OPENSSL_BACKEND
+  if(bench_check_ecdsa() != 0){
+    fprintf(stderr, "ERROR: OpenSSL and the default backend disagree on ECDSA\n");
+    return -1;
+  }
+#endif
+
+  best = ndn_sha256_kernels_get_level();
+  printf("%u segments of %u bytes, %d rounds\n", segments, segment_size, BENCH_ROUNDS);
+  for(level = NDN_SHA256_KERNELS_SOFTWARE; level <= best; level ++){
+    if(ndn_sha256_kernels_select(level) != level){
+      continue;
+    }
+    printf("%s, %u lanes\n", level_names[level], ndn_sha256_kernels_get_lanes());
+    if(bench_check() != 0){
+      fprintf(stderr, "ERROR: %s gives wrong digests\n", level_names[level]);
+      return -1;
+    }
+    bench_row("digest", bench_digest_one);
+    bench_row("digest many", bench_digest_many);
+    bench_row("make segment", bench_make_segment);
+    bench_row("make segments", bench_make_segments);
+  }
+  ndn_sha256_kernels_select(best);
+  return 0;
+}
@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ */
+
+/**
+ * Status dataset microbenchmark.
+ * Encodes the dataset with more and more faces in the face table.
+ * Checks first that the dataset is not served on a network face, and that it
+ * is still served once the face table outgrows the initial segments.
+ *
+ *   status-bench [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ndn-lite.h"
+#include "ndn-lite/ndn-error-code.h"
+#include "ndn-lite/encode/interest.h"
+#include "adaptation/forwarder/face-slab.h"
+#include "adaptation/forwarder/ingress.h"
+#include "adaptation/forwarder/pkt-view.h"
+#include "adaptation/forwarder/status.h"
+
+#define BENCH_DEFAULT_ITERATIONS 1000
+// Enough faces for the dataset to need more than NDN_STATUS_INITIAL_SEGMENTS
+#define BENCH_MAX_FACES 2048
+
+static const uint32_t face_counts[] = {16, 256, BENCH_MAX_FACES};
+
+typedef struct bench_face {
+  ndn_face_intf_t intf;
+  uint32_t data_count;
+} bench_face_t;
+
+static bench_face_t fillers[BENCH_MAX_FACES];
+static ndn_face_handle_t filler_handles[BENCH_MAX_FACES];
+static uint8_t dataset[BENCH_MAX_FACES * 128 + 4096];
+
+/////////////////////////// /////////////////////////// ///////////////////////////
+
+static double
+bench_now(void){
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static int
+bench_face_up(ndn_face_intf_t* self){
+  self->state = NDN_FACE_STATE_UP;
+  return NDN_SUCCESS;
+}
+
+static int
+bench_face_down(ndn_face_intf_t* self){
+  self->state = NDN_FACE_STATE_DOWN;
+  return NDN_SUCCESS;
+}
+
+static int
+bench_face_send(ndn_face_intf_t* self, const uint8_t* packet, uint32_t size){
+  bench_face_t* face = container_of(self, bench_face_t, intf);
+  ndn_data_view_t data;
+
+  if(ndn_data_view_parse(&data, packet, size) == NDN_SUCCESS){
+    face->data_count ++;
+  }
+  return NDN_SUCCESS;
+}
+
+static void
+bench_face_init(bench_face_t* face, uint8_t type){
+  memset(face, 0, sizeof(*face));
+  face->intf.face_id = NDN_INVALID_ID;
+  face->intf.type = type;
+  face->intf.state = NDN_FACE_STATE_UP;
+  face->intf.up = bench_face_up;
+  face->intf.down = bench_face_down;
+  face->intf.send = bench_face_send;
+  face->intf.destroy = NULL;
+}
+
+// Sends a status request on the face and returns the number of Data it got back
+static uint32_t
+bench_request(bench_face_t* face){
+  ndn_interest_t interest;
+  ndn_encoder_t encoder;
+  uint8_t wire[256];
+
+  ndn_name_from_string(&interest.name, NDN_STATUS_PREFIX, strlen(NDN_STATUS_PREFIX));
+  ndn_interest_from_name(&interest, &interest.name);
+  ndn_interest_set_CanBePrefix(&interest, true);
+  interest.nonce = random();
+  encoder_init(&encoder, wire, sizeof(wire));
+  if(ndn_interest_tlv_encode(&encoder, &interest) != NDN_SUCCESS){
+    return 0;
+  }
+  face->data_count = 0;
+  ndn_ingress_receive(&face->intf, wire, encoder.offset);
+  return face->data_count;
+}
+
+static void
+bench_add_fillers(uint32_t count){
+  ndn_face_slab_t* slab = ndn_face_slab_get_instance();
+  uint32_t i;
+
+  for(i = 0; i < count; i ++){
+    filler_handles[i] = ndn_face_slab_insert(slab, &fillers[i].intf);
+  }
+}
+
+static void
+bench_remove_fillers(uint32_t count){
+  ndn_face_slab_t* slab = ndn_face_slab_get_instance();
+  uint32_t i;
+
+  for(i = 0; i < count; i ++){
+    ndn_face_slab_remove(slab, filler_handles[i]);
+  }
+}
+
+static int
+bench_check(void){
+  bench_face_t net, app;
+  uint32_t used;
+  int ret = 0;
+
+  bench_face_init(&net, NDN_FACE_TYPE_NET);
+  bench_face_init(&app, NDN_FACE_TYPE_APP);
+  if(ndn_forwarder_register_face(&net.intf) != NDN_SUCCESS ||
+     ndn_forwarder_register_face(&app.intf) != NDN_SUCCESS){
+    return -1;
+  }
+
+  // /localhost scope
+  if(bench_request(&net) != 0){
+    fprintf(stderr, "ERROR: the dataset is served on a network face\n");
+    ret = -1;
+  }
+
+  // More than the initial segments hold
+  bench_add_fillers(BENCH_MAX_FACES);
+  if(ndn_status_encode(dataset, NDN_STATUS_INITIAL_SEGMENTS * NDN_STATUS_SEGMENT_SIZE, &used) != NDN_OVERSIZE){
+    fprintf(stderr, "ERROR: too few faces to outgrow the initial segments\n");
+    ret = -1;
+  }
+  if(bench_request(&app) != 1){
+    fprintf(stderr, "ERROR: the dataset is not served on a local face\n");
+    ret = -1;
+  }
+  bench_remove_fillers(BENCH_MAX_FACES);
+
+  ndn_forwarder_unregister_face(&net.intf);
+  ndn_forwarder_unregister_face(&app.intf);
+  return ret;
+}
+
+int
+main(int argc, char *argv[]){
+  uint32_t iterations = BENCH_DEFAULT_ITERATIONS, i, c, used = 0;
+  double begin, elapsed;
+
+  if(argc > 1){
+    iterations = (uint32_t)strtoul(argv[1], NULL, 10);
+  }
+  if(iterations == 0){
+    fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+    return -1;
+  }
+
+  ndn_lite_startup();
+  srandom(time(0));
+  for(i = 0; i < BENCH_MAX_FACES; i ++){
+    bench_face_init(&fillers[i], NDN_FACE_TYPE_NET);
+    fillers[i].intf.face_id = (uint16_t)(i + 1000);
+  }
+  if(ndn_status_serve() != NDN_SUCCESS){
+    fprintf(stderr, "ERROR: cannot serve the dataset\n");
+    return -1;
+  }
+  if(bench_check() != 0){
+    return -1;
+  }
+
+  printf("%u iterations\n", iterations);
+  printf("  %-8s %10s %14s\n", "faces", "bytes", "us/encode");
+  for(c = 0; c < sizeof(face_counts) / sizeof(face_counts[0]); c ++){
+    bench_add_fillers(face_counts[c]);
+    begin = bench_now();
+    for(i = 0; i < iterations; i ++){
+      if(ndn_status_encode(dataset, sizeof(dataset), &used) != NDN_SUCCESS){
+        fprintf(stderr, "ERROR: cannot encode the dataset\n");
+        return -1;
+      }
+    }
+    elapsed = bench_now() - begin;
+    printf("  %-8u %10u %14.2f\n", face_counts[c], used, elapsed / iterations * 1e6);
+    bench_remove_fillers(face_counts[c]);
+  }
+  return 0;
+}
@@ -101,30 +101,33 @@ int parseArgs(int argc, char *argv[]){
   return 0;
 }
 
-int save_file(uint8_t* file_data);
+int save_file(const uint8_t* file_data, uint32_t file_size);
 
 void
 on_data(const uint8_t* rawdata, uint32_t data_size, void* userdata)
 {
+  ndn_data_view_t view;
+
   printf("Receiving data\n");
-  // char data_buf[1024];
-  char* data_buf;
-  int data_off;
-  tlv_parse_data(rawdata,data_size,2,TLV_DATAARG_CONTENT_BUF,(uint8_t**)&data_buf,TLV_DATAARG_CONTENT_SIZE,&data_off);
-  //printf("data\n%s\n",data_buf);
-  save_file(data_buf);
+  if(ndn_data_view_parse(&view, rawdata, data_size) != NDN_SUCCESS){
+    fprintf(stderr, "ERROR: malformed data.\n");
+    return;
+  }
+  save_file(view.content, view.content_size);
 }
 
 int
-save_file(uint8_t* file_data)
+save_file(const uint8_t* file_data, uint32_t file_size)
 {
   FILE * fp = fopen(file_name,"w");
   if(fp == NULL){
     fprintf(stderr, "ERROR: fail to open a file when writing.\n");
     return 1;
   }
-  if(fputs((char*)file_data,fp) == EOF){
+  // The content is not NUL-terminated
+  if(file_size > 0 && fwrite(file_data, file_size, 1, fp) != 1){
     fprintf(stderr, "ERROR: fail to write data.\n");
+    fclose(fp);
     return 1;
   }
   fclose(fp);
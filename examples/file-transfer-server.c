@@ -125,12 +125,14 @@ on_success(ndn_interest_t* interest)
   //printf("The content of the file is: %s, %lu\n",temp_buffer,strlen(temp_buffer) );
 
   uint8_t data_buf[4096];
-  size_t data_off;
-
-  tlv_make_data(data_buf,4096,&data_off,
-  3,TLV_DATAARG_NAME_PTR,&interest->name,
-  TLV_DATAARG_CONTENT_BUF,(uint8_t*)temp_buffer,TLV_DATAARG_CONTENT_SIZE,strlen(temp_buffer));
+  uint32_t data_off;
 
+  if(NDN_DATA_BUILD(data_buf, sizeof(data_buf), &data_off, .name = &interest->name,
+                    .content = (uint8_t*)temp_buffer,
+                    .content_size = (uint32_t)strlen(temp_buffer)) != NDN_SUCCESS){
+    fprintf(stderr, "ERROR: fail to encode data.\n");
+    return;
+  }
   ndn_forwarder_put_data(data_buf,data_off);
   return;
 }
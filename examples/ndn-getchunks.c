@@ -0,0 +1,265 @@
+/*
+ * Copyright (C) 2019 Xinyu Ma
+ *
+ * This file is subject to the terms and conditions of the GNU Lesser
+ * General Public License v3.0. See the file LICENSE in the top level
+ * directory for more details.
+ *
+ * See AUTHORS.md for complete list of NDN IOT PKG authors and contributors.
+ */
+/*
+ * Fetches an object served by ndn-putchunks --manifest and writes it to stdout.
+ * Each manifest is verified with the key of the producer, and each segment is
+ * checked against its digest in the manifest, so that segments need no
+ * signature verification of their own.
+ * Without <public-key-hex>, the key served under prefix/KEY is trusted as is.
+ */
+#include <stdio.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <time.h>
+#include <ndn-lite.h>
+#include "ndn-lite/encode/name.h"
+#include "ndn-lite/encode/data.h"
+#include "ndn-lite/encode/interest.h"
+
+#define FETCH_RETRIES 3
+#define PUB_KEY_SIZE 64
+
+ndn_name_t name_prefix;
+uint8_t expected_key[PUB_KEY_SIZE];
+bool has_expected_key;
+ndn_ecc_pub_t manifest_pub;
+// The view points into the packet, which is kept until the next manifest
+uint8_t manifest_buf[NDN_MANIFEST_PACKET_SIZE];
+ndn_manifest_view_t manifest;
+uint64_t segno, final_segno;
+// Expressed again on timeout
+ndn_name_t last_name;
+ndn_on_data_func last_on_data;
+int retries;
+bool running;
+int result;
+
+void on_key(const uint8_t* raw_data, uint32_t data_size, void* userdata);
+void on_manifest(const uint8_t* raw_data, uint32_t data_size, void* userdata);
+void on_segment(const uint8_t* raw_data, uint32_t data_size, void* userdata);
+void on_timeout(void* userdata);
+void express(const ndn_name_t* name, ndn_on_data_func on_data);
+
+int
+parse_args(int argc, char *argv[])
+{
+  uint32_t i;
+  unsigned int byte;
+
+  if(argc < 2){
+    fprintf(stderr, "ERROR: wrong arguments.\n");
+    fprintf(stderr, "Usage: <name-prefix> [<public-key-hex>]\n");
+    return 1;
+  }
+  if(ndn_name_from_string(&name_prefix, argv[1], strlen(argv[1])) != NDN_SUCCESS){
+    fprintf(stderr, "ERROR: wrong name.\n");
+    return 2;
+  }
+
+  has_expected_key = (argc > 2);
+  if(has_expected_key){
+    if(strlen(argv[2]) != PUB_KEY_SIZE * 2){
+      fprintf(stderr, "ERROR: wrong public key.\n");
+      return 3;
+    }
+    for(i = 0; i < PUB_KEY_SIZE; i ++){
+      if(sscanf(argv[2] + i * 2, "%2x", &byte) != 1){
+        fprintf(stderr, "ERROR: wrong public key.\n");
+        return 3;
+      }
+      expected_key[i] = (uint8_t)byte;
+    }
+  }
+  return 0;
+}
+
+// Segment numbers are generic components with marker 0x00, as the
+// producer names them, so that the Interest is a prefix of the Data name
+void
+append_segment(ndn_name_t* name, uint64_t num)
+{
+  name_component_t* comp = &name->components[name->components_size];
+
+  comp->type = TLV_GenericNameComponent;
+  comp->size = (uint8_t)ndn_data_template_write_segment_value(comp->value, num);
+  name->components_size ++;
+}
+
+void
+express(const ndn_name_t* name, ndn_on_data_func on_data)
+{
+  ndn_interest_t interest;
+
+  last_name = *name;
+  last_on_data = on_data;
+  ndn_interest_from_name(&interest, name);
+  interest.nonce = random();
+  if(ndn_forwarder_express_interest_struct(&interest, on_data, on_timeout, NULL) != NDN_SUCCESS){
+    fprintf(stderr, "ERROR: cannot express interest.\n");
+    result = 4;
+    running = false;
+  }
+}
+
+void
+express_manifest(uint64_t index)
+{
+  ndn_name_t name = name_prefix;
+
+  ndn_name_append_string_component(&name, NDN_MANIFEST_COMPONENT, NDN_MANIFEST_COMPONENT_SIZE);
+  append_segment(&name, index);
+  express(&name, on_manifest);
+}
+
+void
+express_segment(void)
+{
+  ndn_name_t name = name_prefix;
+
+  append_segment(&name, segno);
+  express(&name, on_segment);
+}
+
+void
+fail(const char* reason)
+{
+  fprintf(stderr, "ERROR: segment %llu: %s.\n", (unsigned long long)segno, reason);
+  result = 5;
+  running = false;
+}
+
+void
+on_key(const uint8_t* raw_data, uint32_t data_size, void* userdata)
+{
+  ndn_data_view_t data;
+
+  retries = 0;
+  if(ndn_data_view_parse(&data, raw_data, data_size) != NDN_SUCCESS ||
+     data.content_size != PUB_KEY_SIZE){
+    fail("malformed key");
+    return;
+  }
+  if(has_expected_key && memcmp(data.content, expected_key, PUB_KEY_SIZE) != 0){
+    fail("the producer key differs from the one given");
+    return;
+  }
+  if(!has_expected_key){
+    fprintf(stderr, "WARNING: trusting the key of the producer without checking it.\n");
+  }
+  ndn_ecc_pub_init(&manifest_pub, data.content, data.content_size, NDN_ECDSA_CURVE_SECP256R1, 0);
+  express_manifest(0);
+}
+
+void
+on_manifest(const uint8_t* raw_data, uint32_t data_size, void* userdata)
+{
+  retries = 0;
+  if(data_size > sizeof(manifest_buf)){
+    fail("manifest too large");
+    return;
+  }
+  // The name matched the Interest, so only the signature is left to check
+  memcpy(manifest_buf, raw_data, data_size);
+  if(ndn_manifest_view_verify(&manifest, manifest_buf, data_size, &manifest_pub) != NDN_SUCCESS){
+    fail("wrong manifest signature");
+    return;
+  }
+  express_segment();
+}
+
+void
+on_segment(const uint8_t* raw_data, uint32_t data_size, void* userdata)
+{
+  ndn_data_view_t data;
+  ndn_component_view_t final_block_id;
+  uint64_t last;
+
+  retries = 0;
+  if(ndn_data_view_parse(&data, raw_data, data_size) != NDN_SUCCESS){
+    fail("malformed data");
+    return;
+  }
+  // The digest covers the whole packet, FinalBlockId included
+  if(ndn_manifest_view_check_segment(&manifest, segno, raw_data, data_size) != NDN_SUCCESS){
+    fail("digest not in the manifest");
+    return;
+  }
+  if(ndn_data_view_get_final_block_id(&data, &final_block_id) == NDN_SUCCESS &&
+     ndn_component_view_segment(&final_block_id, &last) == NDN_SUCCESS){
+    final_segno = last;
+  }
+  if(data.content_size > 0 && fwrite(data.content, data.content_size, 1, stdout) != 1){
+    fail("cannot write");
+    return;
+  }
+
+  if(segno >= final_segno){
+    running = false;
+    return;
+  }
+  segno ++;
+  if(ndn_manifest_index(segno) != ndn_manifest_index(segno - 1)){
+    express_manifest(ndn_manifest_index(segno));
+  }else{
+    express_segment();
+  }
+}
+
+void
+on_timeout(void* userdata)
+{
+  ndn_name_t name = last_name;
+
+  retries ++;
+  if(retries > FETCH_RETRIES){
+    fail("timeout");
+    return;
+  }
+  express(&name, last_on_data);
+}
+
+int
+main(int argc, char *argv[])
+{
+  ndn_unix_face_t *face;
+  int ret;
+
+  if((ret = parse_args(argc, argv)) != 0){
+    return ret;
+  }
+
+  ndn_lite_startup();
+  srandom(time(0));
+  face = ndn_unix_face_construct(NDN_NFD_DEFAULT_ADDR, true);
+  if(face->intf.state != NDN_FACE_STATE_UP){
+    fprintf(stderr, "ERROR: Unable to establish unix socket.\n");
+    ndn_face_destroy(&face->intf);
+    return -1;
+  }
+  ndn_forwarder_add_route_by_name(&face->intf, &name_prefix);
+
+  // Fetched one at a time: key, manifest 0, segments 0-99, manifest 1, ...
+  segno = 0;
+  final_segno = UINT64_MAX;
+  result = 0;
+  running = true;
+  last_name = name_prefix;
+  ndn_name_append_string_component(&last_name, "KEY", strlen("KEY"));
+  express(&last_name, on_key);
+  while(running){
+    ndn_forwarder_process();
+    usleep(10);
+  }
+
+  fflush(stdout);
+  ndn_face_destroy(&face->intf);
+  return result;
+}
@@ -13,31 +13,43 @@
 #include <stdlib.h>
 #include <ndn-lite.h>
 #include <sys/time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
 #include <errno.h>
 #include "ndn-lite/encode/name.h"
 #include "ndn-lite/encode/data.h"
 #include "ndn-lite/encode/interest.h"
 
 #define DATA_BLOCK_SIZE 1024
-#define DATA_CHUNK_SIZE (DATA_BLOCK_SIZE + 256)
-#define MAX_CHUNKS_NUM 25610
+#define MANIFEST_KEY_ID 1
 
 ndn_name_t name_prefix, versioned_name;
 uint8_t buf[4096];
-uint8_t chunks[MAX_CHUNKS_NUM][DATA_CHUNK_SIZE];
-size_t chunk_sizes[MAX_CHUNKS_NUM];
+// The file is mapped and each chunk is encoded when requested
+const uint8_t* file_data;
+size_t file_size;
+ndn_data_template_t data_template;
 uint32_t chunks_num = 0;
+// With --manifest, chunks are authenticated by ECDSA-signed manifests
+bool use_manifest;
+ndn_ecc_pub_t manifest_pub;
+ndn_ecc_prv_t manifest_prv;
+ndn_name_t manifest_key_name;
+ndn_data_template_t manifest_template;
+ndn_manifest_set_t manifests;
 ndn_unix_face_t *face;
 bool running;
 
 int parse_args(int argc, char *argv[]){
   struct timeval tv;
 
-  if(argc < 3){
+  if(argc < 3 || (argc > 3 && strcmp(argv[3], "--manifest") != 0)){
     fprintf(stderr, "ERROR: wrong arguments.\n");
-    printf("Usage: <name-prefix> <file>\n");
+    printf("Usage: <name-prefix> <file> [--manifest]\n");
     return 1;
   }
+  use_manifest = (argc > 3);
   if(ndn_name_from_string(&name_prefix, argv[1], strlen(argv[1])) != NDN_SUCCESS){
     fprintf(stderr, "ERROR: wrong name.\n");
     return 2;
@@ -59,58 +71,159 @@ int parse_args(int argc, char *argv[]){
   return 0;
 }
 
-int prepare_data(const char* filename){
-  long filesize, i, cursz;
+int prepare_manifests(void){
+  uint32_t i;
   int ret;
 
-  FILE* file = fopen(filename, "rb");
-  if(file == NULL){
-    fprintf(stderr, "ERROR: file doesn't exist.\n");
+  // A real producer would use its certified identity key instead
+  ret = ndn_ecc_make_key(&manifest_pub, &manifest_prv, NDN_ECDSA_CURVE_SECP256R1, MANIFEST_KEY_ID);
+  if(ret != NDN_SUCCESS){
+    fprintf(stderr, "ERROR: Cannot make manifest key. Error Code: %d.\n", ret);
+    return 3;
+  }
+  manifest_key_name = versioned_name;
+  ndn_name_append_string_component(&manifest_key_name, "KEY", strlen("KEY"));
+  ret = ndn_manifest_template_init(&manifest_template, &versioned_name, &manifest_prv, &manifest_key_name);
+  if(ret == NDN_SUCCESS){
+    ret = ndn_manifest_set_make(&manifests, &data_template, &manifest_template,
+                                file_data, file_size, DATA_BLOCK_SIZE);
+  }
+  if(ret != NDN_SUCCESS){
+    fprintf(stderr, "ERROR: Cannot make manifests. Error Code: %d.\n", ret);
     return 3;
   }
 
-  fseek(file, 0 , SEEK_END);
-  filesize = ftell(file);
-  fseek(file, 0 , SEEK_SET);
-  chunks_num = (filesize + DATA_BLOCK_SIZE - 1) / DATA_BLOCK_SIZE;
-
-  for (i = 0; !feof(file); i++) {
-    cursz = fread(buf, 1, DATA_BLOCK_SIZE, file);
-    ret = tlv_make_data(chunks[i], DATA_CHUNK_SIZE, &chunk_sizes[i], 6,
-                        TLV_DATAARG_NAME_PTR, &versioned_name,
-                        TLV_DATAARG_NAME_SEGNO_U64, (uint64_t)i,
-                        TLV_DATAARG_FRESHNESSPERIOD_U64, (uint64_t)10000,
-                        TLV_DATAARG_FINALBLOCKID_U64, (uint64_t)(chunks_num - 1),
-                        TLV_DATAARG_CONTENT_BUF, buf,
-                        TLV_DATAARG_CONTENT_SIZE, (size_t)cursz);
-    if (ret != NDN_SUCCESS) {
-      fprintf(stderr, "ERROR: Cannot make data. Error Code: %d.\n", ret);
+  printf("%u manifests, public key:\n", manifests.count);
+  for(i = 0; i < ndn_ecc_get_pub_key_size(&manifest_pub); i ++){
+    printf("%02X", ndn_ecc_get_pub_key_value(&manifest_pub)[i]);
+  }
+  printf("\n");
+  return 0;
+}
+
+int prepare_data(const char* filename){
+  struct stat st;
+  int fd, ret;
+
+  fd = open(filename, O_RDONLY);
+  if(fd == -1 || fstat(fd, &st) == -1){
+    fprintf(stderr, "ERROR: file doesn't exist.\n");
+    return 3;
+  }
+  file_size = st.st_size;
+  // An empty file is served as one empty segment, so FinalBlockId is 0
+  chunks_num = (file_size > 0) ? (file_size + DATA_BLOCK_SIZE - 1) / DATA_BLOCK_SIZE : 1;
+  file_data = (const uint8_t*)"";
+  if(file_size > 0){
+    file_data = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(file_data == MAP_FAILED){
+      fprintf(stderr, "ERROR: Cannot map file: %d.\n", errno);
+      close(fd);
+      return 3;
     }
   }
+  close(fd);
 
-  fclose(file);
+  // Name prefix, MetaInfo and SignatureInfo are encoded once for all chunks
+  ret = ndn_data_template_init(&data_template, &versioned_name, NDN_CONTENT_TYPE_BLOB, 10000);
+  if (ret != NDN_SUCCESS) {
+    fprintf(stderr, "ERROR: Cannot make data template. Error Code: %d.\n", ret);
+    return 3;
+  }
+  ndn_data_template_set_final_block_id(&data_template, chunks_num - 1);
+
+  if(use_manifest){
+    return prepare_manifests();
+  }
   return 0;
 }
 
+// prefix/KEY carries the public key of the manifests
+int
+put_manifest_key(const ndn_interest_view_t* interest)
+{
+  uint8_t key_buf[1024];
+  uint32_t key_size;
+  int ret;
+
+  ret = NDN_DATA_BUILD(key_buf, sizeof(key_buf), &key_size,
+                       .name_block = interest->name, .name_block_size = interest->name_size,
+                       .content_type = NDN_CONTENT_TYPE_KEY,
+                       .content = ndn_ecc_get_pub_key_value(&manifest_pub),
+                       .content_size = ndn_ecc_get_pub_key_size(&manifest_pub),
+                       .ecc_key = &manifest_prv, .key_name = &manifest_key_name);
+  if(ret == NDN_SUCCESS){
+    ndn_forwarder_put_data(key_buf, key_size);
+  }
+  return ret;
+}
+
 int
 on_interest(const uint8_t* raw_interest, uint32_t interest_size, void* userdata)
 {
-  ndn_interest_t interest;
-  name_component_t *comp;
-  int ret, i, segno = 0;
+  ndn_interest_view_t interest;
+  ndn_component_view_t comp;
+  ndn_data_iov_buf_t headers;
+  struct iovec content, iov[1 + NDN_DATA_TEMPLATE_IOV_EXTRA];
+  int iov_count = 1 + NDN_DATA_TEMPLATE_IOV_EXTRA;
+  ndn_pktbuf_t* data;
+  uint32_t manifest_size;
+  uint64_t segno;
 
-  ret = ndn_interest_from_block(&interest, raw_interest, interest_size);
-  if(ret != NDN_SUCCESS){
+  if(ndn_interest_view_parse(&interest, raw_interest, interest_size) != NDN_SUCCESS){
     printf("Invalid interest\n");
+    return NDN_FWD_STRATEGY_SUPPRESS;
   }
-  comp = &interest.name.components[interest.name.components_size - 1];
-  if(comp->value[0] == 0){
-    for(i = 0; i < comp->size; i ++){
-      segno = segno * 0x100 + comp->value[i];
+  // The first Interest may carry no segment number
+  if(ndn_name_view_segment(interest.name, interest.name_size, &segno) != NDN_SUCCESS){
+    segno = 0;
+  }
+
+  if(use_manifest &&
+     ndn_name_view_count(interest.name, interest.name_size) == versioned_name.components_size + 1 &&
+     ndn_name_view_component(interest.name, interest.name_size, -1, &comp) == NDN_SUCCESS &&
+     comp.size == strlen("KEY") && memcmp(comp.value, "KEY", strlen("KEY")) == 0){
+    put_manifest_key(&interest);
+    return NDN_FWD_STRATEGY_SUPPRESS;
+  }
+
+  // prefix/manifest/<seg>
+  if(use_manifest &&
+     ndn_name_view_count(interest.name, interest.name_size) == versioned_name.components_size + 2 &&
+     ndn_name_view_component(interest.name, interest.name_size, -2, &comp) == NDN_SUCCESS &&
+     comp.size == NDN_MANIFEST_COMPONENT_SIZE &&
+     memcmp(comp.value, NDN_MANIFEST_COMPONENT, NDN_MANIFEST_COMPONENT_SIZE) == 0){
+    content.iov_base = (void*)ndn_manifest_set_get(&manifests, segno, &manifest_size);
+    content.iov_len = manifest_size;
+    if(content.iov_base == NULL){
+      return NDN_FWD_STRATEGY_SUPPRESS;
+    }
+    data = ndn_pktbuf_gather(&content, 1);
+    if(data != NULL){
+      ndn_pktbuf_put_data(data);
+      ndn_pktbuf_unref(data);
     }
+    return NDN_FWD_STRATEGY_SUPPRESS;
   }
-  if(segno < chunks_num){
-    ndn_forwarder_put_data(chunks[segno], chunk_sizes[segno]);
+
+  if(segno >= chunks_num){
+    return NDN_FWD_STRATEGY_SUPPRESS;
+  }
+
+  // The content is read from the mapping once by the digest and once by
+  // the copy into the packet buffer, which faces then share
+  content.iov_base = (void*)(file_data + segno * DATA_BLOCK_SIZE);
+  content.iov_len = file_size - segno * DATA_BLOCK_SIZE;
+  if(content.iov_len > DATA_BLOCK_SIZE){
+    content.iov_len = DATA_BLOCK_SIZE;
+  }
+  if(ndn_data_template_make_iov(&data_template, &headers, segno, &content, 1, iov, &iov_count) != NDN_SUCCESS){
+    return NDN_FWD_STRATEGY_SUPPRESS;
+  }
+  data = ndn_pktbuf_gather(iov, iov_count);
+  if(data != NULL){
+    ndn_pktbuf_put_data(data);
+    ndn_pktbuf_unref(data);
   }
 
   return NDN_FWD_STRATEGY_SUPPRESS;
@@ -149,6 +262,10 @@ int main(int argc, char *argv[]){
   }
 
   ndn_face_destroy(&face->intf);
+  ndn_manifest_set_destroy(&manifests);
+  if(file_size > 0){
+    munmap((void*)file_data, file_size);
+  }
 
   return 0;
 }
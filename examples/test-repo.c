@@ -112,15 +112,17 @@ load_bootstrapping_info()
 int
 on_interest(const uint8_t* interest, uint32_t interest_size, void* userdata)
 {
-  ndn_interest_t interest_pkt;
-  ndn_interest_from_block(&interest_pkt, interest, interest_size);
+  ndn_interest_view_t interest_view;
   ndn_data_t data;
   ndn_encoder_t encoder;
   char * str = "I'm a Data packet.";
 
+  if(ndn_interest_view_parse(&interest_view, interest, interest_size) != NDN_SUCCESS){
+    return NDN_FWD_STRATEGY_SUPPRESS;
+  }
+  ndn_name_from_block(&data.name, interest_view.name, interest_view.name_size);
   printf("On interest: \n");
-  ndn_name_print(&interest_pkt.name);
-  data.name = interest_pkt.name;
+  ndn_name_print(&data.name);
   ndn_data_set_content(&data, (uint8_t*)str, strlen(str));
   ndn_metainfo_init(&data.metainfo);
   ndn_metainfo_set_content_type(&data.metainfo, NDN_CONTENT_TYPE_BLOB);
@@ -13,6 +13,7 @@
 #include "ndn-lite/encode/name.h"
 #include "ndn-lite/encode/data.h"
 #include "ndn-lite/encode/interest.h"
+#include "adaptation/forwarder/ingress.h"
 
 // 全局变量：端口1、端口2，服务器IP地址，名称前缀，运行状态
 in_port_t port1, port2;
@@ -96,6 +97,10 @@ void on_data(const uint8_t* rawdata, uint32_t data_size, void* userdata)
   }
   // 输出数据内容
   printf("It says: %s\n", data.content_value);
+  // 数据经过拥塞队列时带有 CongestionMark，应当降低发送速率
+  if(ndn_ingress_get_congestion_mark() != 0){
+    printf("Congestion marked\n");
+  }
   running = false; // 停止运行
 }
 
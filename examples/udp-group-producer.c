@@ -21,6 +21,7 @@ in_port_t port;
 in_addr_t multicast_ip;
 ndn_name_t name_prefix;
 uint8_t buf[4096];
+ndn_data_template_t data_template;
 ndn_udp_face_t *face;
 bool running;
 
@@ -79,23 +80,21 @@ int parseArgs(int argc, char *argv[])
 // 处理收到的兴趣包的回调函数
 int on_interest(const uint8_t* interest, uint32_t interest_size, void* userdata)
 {
-  ndn_interest_t interest_pkt;
-  ndn_interest_from_block(&interest_pkt, interest, interest_size);
-  ndn_data_t data;
-  ndn_encoder_t encoder;
+  ndn_interest_view_t interest_view;
+  uint32_t data_size;
   char * str = "I'm a Data packet.'\0'";
 
   printf("On interest\n");
-  // 设置数据包的名称
-  data.name = interest_pkt.name;
-  // 设置数据包内容
-  ndn_data_set_content(&data, (uint8_t*)str, strlen(str));
-  ndn_metainfo_init(&data.metainfo);
-  ndn_metainfo_set_content_type(&data.metainfo, NDN_CONTENT_TYPE_BLOB);
-  // 编码数据包
-  encoder_init(&encoder, buf, 4096);
-  ndn_data_tlv_encode_digest_sign(&encoder, &data);
-  ndn_forwarder_put_data(encoder.output_value, encoder.offset);
+  if(ndn_interest_view_parse(&interest_view, interest, interest_size) != NDN_SUCCESS){
+    return NDN_FWD_STRATEGY_SUPPRESS;
+  }
+  // 用兴趣包的名称和内容填充数据包模板，并编码数据包
+  if(ndn_data_template_make_named(&data_template, buf, sizeof(buf),
+                                  interest_view.name, interest_view.name_size,
+                                  (uint8_t*)str, strlen(str), &data_size) != NDN_SUCCESS){
+    return NDN_FWD_STRATEGY_SUPPRESS;
+  }
+  ndn_forwarder_put_data(buf, data_size);
 
   return NDN_FWD_STRATEGY_SUPPRESS; // 阻止进一步转发
 }
@@ -112,6 +111,8 @@ int main(int argc, char *argv[])
 
   // 启动ndn-lite
   ndn_lite_startup();
+  // 数据包模板：MetaInfo和签名信息只编码一次
+  ndn_data_template_init(&data_template, NULL, NDN_CONTENT_TYPE_BLOB, 0);
   // 创建UDP多播接口
   face = ndn_udp_multicast_face_construct(INADDR_ANY, multicast_ip, port);
   // 注册名称前缀，并设置回调函数处理兴趣包
@@ -18,6 +18,20 @@
 #include "adaptation/adapt-consts.h"
 #include "adaptation/udp/udp-face.h"
 #include "adaptation/unix-socket/unix-face.h"
+#include "adaptation/forwarder/cs-mmap.h"
+#include "adaptation/forwarder/strategy-face.h"
+#include "adaptation/forwarder/status.h"
+#include "adaptation/forwarder/submit-queue.h"
+#include "adaptation/forwarder/nack.h"
+#include "adaptation/forwarder/pkt-view.h"
+#include "adaptation/forwarder/data-template.h"
+#include "adaptation/forwarder/name-kernels.h"
+#include "adaptation/security/verify-cache.h"
+#include "adaptation/security/crypto-pool.h"
+#include "adaptation/security/aes-kernels.h"
+#include "adaptation/security/sha256-kernels.h"
+#include "adaptation/security/manifest.h"
+#include "adaptation/security/key-store.h"
 
 #ifdef __cplusplus
 extern "C" {